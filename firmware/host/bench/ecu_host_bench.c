@@ -0,0 +1,695 @@
+/**
+ * @file ecu_host_bench.c
+ * @brief Runs the real engine_control stack against a synthetic 60-2 + cam
+ *        wheel on the host and reports per-task cost and scheduling figures
+ *
+ * Usage: ecu_host_bench [--rpm N | --sweep] [--seconds S] [--tune-hz N]
+ *                       [--cylinders N [--firing-order 1-3-4-2] [--wasted-spark]]
+ *                       [--split-pct P [--split-gap US]] [--vbat V]
+ *                       [--isr-refine] [--record FILE] [--cyl-scaling] [--cli LINE]...
+ *                       [--verbose]
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "angle_scheduler.h"
+#include "cli_interface.h"
+#include "config_manager.h"
+#include "core_plan.h"
+#include "task_profiler.h"
+#include "engine_control.h"
+#include "engine_layout.h"
+#include "espnow_link.h"
+#include "mcpwm_ignition_hp.h"
+#include "mcpwm_injection_hp.h"
+#include "mcpwm_output.h"
+#include "output_capture.h"
+#include "replay_capture.h"
+#include "s3_control_config.h"
+#include "split_injection.h"
+#include "sync.h"
+#include "timebase.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_sim.h"
+#include "replay_file.h"
+#include "wheel_sim.h"
+
+#define BENCH_WARMUP_US     UINT64_C(1000000)
+// After the wheel stops: sync goes stale and the executor parks the outputs
+#define BENCH_STALL_SETTLE_US UINT64_C(500000)
+#define BENCH_VBAT_ADC_CHANNEL 5U
+// Capture records per virtual second: 60-2 wheel at 7000 rpm plus sensor blocks
+#define BENCH_RECORDS_PER_S 16384U
+#define BENCH_CLI_LINES_MAX 8U
+
+typedef struct {
+    uint16_t rpm;
+    bool sweep;
+    uint32_t seconds;
+    uint32_t tune_hz;
+    bool verbose;
+    bool custom_layout;
+    engine_layout_t layout;
+    bool cyl_scaling;
+    float split_pct;     // first pulse share, 100 = no split
+    uint32_t split_gap_us;
+    float vbat_v;        // battery voltage seen by the sensor task
+    const char *record_path;  // replay capture of the run, NULL for none
+    bool isr_refine;     // last-teeth refine from the tooth ISR
+    const char *cli_lines[BENCH_CLI_LINES_MAX];  // console commands run after the figures
+    uint32_t cli_line_count;
+} bench_args_t;
+
+// Usual firing order per cylinder count (inline 3/5, V6, V8 cross-plane)
+static const uint8_t k_firing_orders[ENGINE_MAX_CYLINDERS][ENGINE_MAX_CYLINDERS] = {
+    {1},
+    {1, 2},
+    {1, 2, 3},
+    {1, 3, 4, 2},
+    {1, 2, 4, 5, 3},
+    {1, 5, 3, 6, 2, 4},
+    {1, 3, 5, 7, 2, 4, 6},
+    {1, 8, 4, 3, 6, 5, 7, 2},
+};
+
+// --cyl-scaling rows; the last one needs 16 outputs and must be refused
+static const struct {
+    uint8_t cylinders;
+    bool wasted_spark;
+} k_scaling_layouts[] = {
+    {3, false}, {4, false}, {5, false}, {6, false}, {4, true}, {6, true}, {8, true}, {8, false},
+};
+
+static uint32_t g_tune_writes = 0;
+static uint32_t g_tune_errors = 0;
+
+// Tuning-tool stand-in: rewrites EOIT map cells at a fixed rate. Each write
+// publishes a new map set and saves the EOIT blob to NVS, so the planner
+// figures can be compared with and without tuning traffic.
+static void tune_task(void *arg) {
+    uint32_t hz = *(const uint32_t *)arg;
+    TickType_t period = pdMS_TO_TICKS(1000U / hz);
+    if (period == 0) {
+        period = 1;
+    }
+    for (uint32_t n = 0;; n++) {
+        float normal = 5.0f + (float)(n % 10U) * 0.1f;
+        if (engine_control_set_eoit_map_cell((uint8_t)(n % 16U), (uint8_t)((n / 16U) % 16U), normal) == ESP_OK) {
+            g_tune_writes++;
+        } else {
+            g_tune_errors++;
+        }
+        vTaskDelay(period);
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--rpm N | --sweep] [--seconds S] [--tune-hz N]\n"
+                    "       [--cylinders N [--firing-order 1-3-4-2] [--wasted-spark]]\n"
+                    "       [--split-pct P [--split-gap US]] [--vbat V] [--isr-refine] [--record FILE]\n"
+                    "       [--cyl-scaling] [--cli LINE]... [--verbose]\n", prog);
+}
+
+static void layout_with_default_order(engine_layout_t *layout, uint8_t cylinders, bool wasted_spark) {
+    memset(layout, 0, sizeof(*layout));
+    layout->cylinders = cylinders;
+    layout->wasted_spark = wasted_spark ? 1U : 0U;
+    if (cylinders >= 1U && cylinders <= ENGINE_MAX_CYLINDERS) {
+        memcpy(layout->firing_order, k_firing_orders[cylinders - 1U], cylinders);
+    }
+}
+
+// "1-5-3-6-2-4" -> firing_order; the count must match --cylinders
+static bool parse_firing_order(const char *text, engine_layout_t *layout) {
+    uint8_t n = 0;
+    const char *p = text;
+    while (*p != '\0') {
+        char *end = NULL;
+        unsigned long cyl = strtoul(p, &end, 10);
+        if (end == p || n >= ENGINE_MAX_CYLINDERS || cyl == 0UL || cyl > ENGINE_MAX_CYLINDERS) {
+            return false;
+        }
+        layout->firing_order[n++] = (uint8_t)cyl;
+        p = (*end == '-') ? end + 1 : end;
+        if (*end != '-' && *end != '\0') {
+            return false;
+        }
+    }
+    return n == layout->cylinders;
+}
+
+static bool parse_args(int argc, char **argv, bench_args_t *args) {
+    args->rpm = 3000;
+    args->sweep = false;
+    args->seconds = 5;
+    args->tune_hz = 0;
+    args->verbose = false;
+    args->custom_layout = false;
+    args->cyl_scaling = false;
+    args->split_pct = 100.0f;
+    args->split_gap_us = SPLIT_INJ_DEFAULT_GAP_US;
+    args->vbat_v = 13.5f;
+    args->record_path = NULL;
+    args->isr_refine = false;
+    args->cli_line_count = 0;
+    engine_layout_default(&args->layout);
+    const char *firing_order = NULL;
+    bool wasted_spark = false;
+    unsigned long cylinders = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rpm") == 0 && i + 1 < argc) {
+            args->rpm = (uint16_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--sweep") == 0) {
+            args->sweep = true;
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            args->seconds = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--tune-hz") == 0 && i + 1 < argc) {
+            args->tune_hz = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--cylinders") == 0 && i + 1 < argc) {
+            cylinders = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--firing-order") == 0 && i + 1 < argc) {
+            firing_order = argv[++i];
+        } else if (strcmp(argv[i], "--wasted-spark") == 0) {
+            wasted_spark = true;
+        } else if (strcmp(argv[i], "--split-pct") == 0 && i + 1 < argc) {
+            args->split_pct = strtof(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--split-gap") == 0 && i + 1 < argc) {
+            args->split_gap_us = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--vbat") == 0 && i + 1 < argc) {
+            args->vbat_v = strtof(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--isr-refine") == 0) {
+            args->isr_refine = true;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            args->record_path = argv[++i];
+        } else if (strcmp(argv[i], "--cli") == 0 && i + 1 < argc && args->cli_line_count < BENCH_CLI_LINES_MAX) {
+            args->cli_lines[args->cli_line_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--cyl-scaling") == 0) {
+            args->cyl_scaling = true;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            args->verbose = true;
+        } else {
+            return false;
+        }
+    }
+    if (cylinders != 0UL || firing_order != NULL || wasted_spark) {
+        if (cylinders == 0UL) {
+            cylinders = args->layout.cylinders;
+        }
+        if (cylinders > ENGINE_MAX_CYLINDERS) {
+            return false;
+        }
+        layout_with_default_order(&args->layout, (uint8_t)cylinders, wasted_spark);
+        if (firing_order != NULL && !parse_firing_order(firing_order, &args->layout)) {
+            return false;
+        }
+        if (!engine_layout_validate(&args->layout)) {
+            return false;
+        }
+        args->custom_layout = true;
+    }
+    if (args->split_pct < SPLIT_INJ_MIN_FIRST_PCT || args->split_pct > SPLIT_INJ_MAX_FIRST_PCT ||
+        args->split_gap_us < SPLIT_INJ_MIN_GAP_US || args->split_gap_us > SPLIT_INJ_MAX_GAP_US) {
+        return false;
+    }
+    // Outside the sensor range the safety monitor goes to limp mode
+    if (!(args->vbat_v >= VBAT_SENSOR_MIN && args->vbat_v <= VBAT_SENSOR_MAX)) {
+        return false;
+    }
+    return args->rpm > 0 && args->seconds > 1 && args->tune_hz <= 1000U;
+}
+
+static void print_task_stats(void) {
+    printf("\n%-14s %4s %4s %9s %10s %9s %9s %9s\n",
+           "task", "prio", "core", "slices", "total(us)", "p50(ns)", "p99(ns)", "max(ns)");
+    for (size_t i = 0; i < host_sim_get_task_count(); i++) {
+        host_task_stats_t st;
+        if (!host_sim_get_task_stats(i, &st)) {
+            continue;
+        }
+        printf("%-14s %4" PRIu32 " %4d %9" PRIu32 " %10" PRIu64 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 "\n",
+               st.name, st.priority, st.core, st.slices, (uint64_t)(st.runtime_ns / 1000U),
+               st.p50_ns, st.p99_ns, st.max_ns);
+    }
+}
+
+// Window opened by the audit taken when measuring started
+static void print_core_audit(void) {
+    core_plan_audit_t audit;
+    esp_err_t err = core_plan_audit(&audit);
+    if (err != ESP_OK) {
+        printf("\ncore plan audit: %s\n", esp_err_to_name(err));
+        return;
+    }
+    printf("\ncore plan: control core %d, load core0=%.1f%% core1=%.1f%% (host wall per virtual time)"
+           " control-core tasks=%" PRIu32 " foreign=%" PRIu32 " violations=%" PRIu32 "\n",
+           CORE_PLAN_CONTROL_CORE,
+           audit.core_load_permille[0] / 10.0, audit.core_load_permille[1] / 10.0,
+           audit.control_core_tasks, audit.foreign_tasks, audit.violations);
+    printf("isr runs core0/core1:");
+    for (int isr = 0; isr < CORE_ISR_COUNT; isr++) {
+        printf(" %s=%" PRIu32 "/%" PRIu32, core_plan_get_isr_name((core_isr_id_t)isr),
+               audit.isr_runs[isr][0], audit.isr_runs[isr][1]);
+    }
+    printf("\n");
+    for (uint32_t i = 0; i < audit.task_count; i++) {
+        const core_plan_task_audit_t *t = &audit.tasks[i];
+        if (t->misplaced || (!t->planned && (t->core < 0 || t->core == CORE_PLAN_CONTROL_CORE))) {
+            printf("  %-14s core %2d %s\n", t->name, t->core, t->misplaced ? "misplaced" : "unplanned");
+        }
+    }
+}
+
+// Last record the monitor task took: loads over its window, stacks as the
+// host stubs report them (the whole stack), wake and ISR times in virtual ns
+static void print_task_profile(void) {
+    espnow_task_profile_t prof;
+    if (task_profiler_get_last(&prof) != ESP_OK) {
+        printf("\ntask profile: none\n");
+        return;
+    }
+    printf("\ntask profile (%zu bytes): window %" PRIu32 " ms, load core0=%.1f%% core1=%.1f%%\n",
+           sizeof(prof), prof.window_ms,
+           prof.core_load_permille[0] / 10.0, prof.core_load_permille[1] / 10.0);
+    for (uint8_t i = 0; i < prof.task_count && i < ESPNOW_PROFILE_TASKS; i++) {
+        const espnow_task_entry_t *t = &prof.tasks[i];
+        printf("  %-12s core %d load %5.1f%% stack %u/%u free\n",
+               core_plan_get_task((core_task_id_t)t->task)->name,
+               (t->core == 0xFFU) ? -1 : (int)t->core, t->load_permille / 10.0,
+               (unsigned)t->stack_free, (unsigned)t->stack_size);
+    }
+    printf("  ");
+    for (uint32_t i = 0; i < ESPNOW_PROFILE_LATENCIES; i++) {
+        printf("%s p99=%" PRIu32 " max=%" PRIu32 "%s",
+               engine_control_perf_stage_name((engine_perf_stage_t)(ENGINE_PERF_PLANNER_WAKE + i)),
+               prof.latency[i].p99_ns, prof.latency[i].max_ns,
+               (i + 1U < ESPNOW_PROFILE_LATENCIES) ? ", " : "\n");
+    }
+}
+
+// Console commands against the running engine, output as on the USB port
+static bool run_cli_lines(const bench_args_t *args) {
+    if (args->cli_line_count == 0U) {
+        return true;
+    }
+    if (cli_init() != ESP_OK) {
+        printf("\ncli: init failed\n");
+        return false;
+    }
+    bool ok = true;
+    for (uint32_t i = 0; i < args->cli_line_count; i++) {
+        printf("\ncli> %s\n", args->cli_lines[i]);
+        fflush(stdout);
+        if (cli_process_line(args->cli_lines[i]) < 0) {
+            printf("cli: '%s' failed\n", args->cli_lines[i]);
+            ok = false;
+        }
+        fflush(stdout);
+    }
+    return ok;
+}
+
+static void print_output_capture(void) {
+    static const char *const kinds[OUTPUT_CAPTURE_KIND_COUNT] = { "inj", "ign" };
+    printf("\n%-6s %5s %7s %7s %6s %4s %5s %7s %7s %7s %9s %9s %9s %5s %5s\n",
+           "output", "stamp", "armed", "matched", "missed", "pend", "stray",
+           "p50(us)", "p99(us)", "max(us)", "p50(cdeg)", "p99(cdeg)", "max(cdeg)", "wrap", "late");
+    for (int k = 0; k < OUTPUT_CAPTURE_KIND_COUNT; k++) {
+        uint8_t channels = (k == OUTPUT_CAPTURE_INJECTION) ? engine_layout_cylinders() : engine_layout_coils();
+        for (uint8_t cyl = 1; cyl <= channels; cyl++) {
+            output_capture_stats_t st;
+            if (output_capture_get_stats((output_capture_kind_t)k, cyl, &st) != ESP_OK) {
+                continue;
+            }
+            // Driver-side accounting: windows across the 30 s wrap, compares refused as late
+            timebase_compare_stats_t sched = {0};
+            if (k == OUTPUT_CAPTURE_INJECTION) {
+                mcpwm_injection_hp_get_sched_stats((uint8_t)(cyl - 1), &sched);
+            } else {
+                mcpwm_ignition_hp_get_sched_stats(cyl, &sched);
+            }
+            printf("%s%-3u %5s %7" PRIu32 " %7" PRIu32 " %6" PRIu32 " %4" PRIu32 " %5" PRIu32
+                   " %7" PRIu32 " %7" PRIu32 " %7" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32
+                   " %5" PRIu32 " %5" PRIu32 "\n",
+                   kinds[k], cyl, st.hw_timestamp ? "etm" : "isr", st.armed, st.matched, st.missed, st.pending,
+                   st.stray,
+                   st.p50_us, st.p99_us, st.max_us, st.p50_cdeg, st.p99_cdeg, st.max_cdeg,
+                   sched.wrapped, sched.dropped_late + sched.dropped_range);
+        }
+    }
+}
+
+static void print_split_injection(const bench_args_t *args) {
+    mcpwm_injection_pulse_stats_t total = {0};
+    for (uint8_t i = 0; i < engine_layout_cylinders(); i++) {
+        mcpwm_injection_pulse_stats_t st;
+        if (mcpwm_injection_hp_get_pulse_stats(i, &st)) {
+            total.lists += st.lists;
+            total.rearmed += st.rearmed;
+            total.dropped += st.dropped;
+            total.deferred += st.deferred;
+        }
+    }
+    engine_injection_diag_t diag = {0};
+    engine_control_get_injection_diag(&diag);
+    printf("split injection: first=%.1f%% gap=%" PRIu32 " us, last plan %u pulse(s) pw=%" PRIu32
+           " us; lists=%" PRIu32 " isr_rearms=%" PRIu32 " dropped=%" PRIu32 " deferred=%" PRIu32 "\n",
+           (double)args->split_pct, args->split_gap_us, diag.pulses[0], diag.pulsewidth_cyl_us[0],
+           total.lists, total.rearmed, total.dropped, total.deferred);
+}
+
+static void print_injector_model(const bench_args_t *args) {
+    engine_injection_diag_t diag = {0};
+    engine_control_get_injection_diag(&diag);
+    printf("injector model: vbat=%.1f V (plan %.1f V) dead_time=%u us, cyl1 fuel=%" PRIu32 " us\n",
+           (double)args->vbat_v, (double)diag.vbat_dv / 10.0, diag.dead_time_us, diag.pulsewidth_cyl_us[0]);
+}
+
+static void print_dwell(void) {
+    engine_injection_diag_t diag = {0};
+    engine_control_get_injection_diag(&diag);
+    mcpwm_ignition_status_t st = {0};
+    mcpwm_ignition_hp_get_status(1, &st);
+    printf("dwell: plan=%u us%s, coil1 last=%" PRIu32 " us\n",
+           diag.dwell_us, diag.dwell_limited ? " (duty limited)" : "", st.last_dwell_us);
+}
+
+static void format_firing_order(const engine_layout_t *layout, char *buf, size_t len) {
+    size_t used = 0;
+    buf[0] = '\0';
+    for (uint8_t i = 0; i < layout->cylinders && used < len; i++) {
+        used += (size_t)snprintf(buf + used, len - used, "%s%u", i ? "-" : "", layout->firing_order[i]);
+    }
+}
+
+static bool task_stats_by_name(const char *name, host_task_stats_t *out) {
+    for (size_t i = 0; i < host_sim_get_task_count(); i++) {
+        if (host_sim_get_task_stats(i, out) && strcmp(out->name, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// One --cyl-scaling row: wall-clock cost of the per-tooth tasks and output accounting
+// Virtual time does not advance inside a task, so the percentiles read 0 on
+// the host; the counts show which stages ran
+static void print_latency_stages(void) {
+    printf("latency stages (virtual ns):");
+    for (uint32_t i = 0; i < ENGINE_PERF_STAGE_COUNT; i++) {
+        latency_summary_t sum;
+        engine_control_get_perf_latency((engine_perf_stage_t)i, &sum);
+        printf(" %s n=%" PRIu32 " p99.9=%" PRIu32, engine_control_perf_stage_name((engine_perf_stage_t)i),
+               sum.count, sum.p999);
+    }
+    printf("\n");
+}
+
+static void print_scaling_row(const engine_layout_t *layout, uint32_t measured_teeth, uint64_t writes) {
+    char order[32];
+    format_firing_order(layout, order, sizeof(order));
+    mcpwm_output_info_t out = {0};
+    mcpwm_output_get_info(&out);
+    host_task_stats_t exec = {0};
+    host_task_stats_t plan = {0};
+    task_stats_by_name("engine_exec", &exec);
+    task_stats_by_name("engine_plan", &plan);
+
+    uint32_t armed = 0;
+    uint32_t matched = 0;
+    uint32_t missed = 0;
+    uint32_t pending = 0;
+    for (int k = 0; k < OUTPUT_CAPTURE_KIND_COUNT; k++) {
+        uint8_t channels = (k == OUTPUT_CAPTURE_INJECTION) ? engine_layout_cylinders() : engine_layout_coils();
+        for (uint8_t ch = 1; ch <= channels; ch++) {
+            output_capture_stats_t st;
+            if (output_capture_get_stats((output_capture_kind_t)k, ch, &st) == ESP_OK) {
+                armed += st.armed;
+                matched += st.matched;
+                missed += st.missed;
+                pending += st.pending;
+            }
+        }
+    }
+    printf("%4u %-16s %5s %7u %6u %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %8.2f %7" PRIu32
+           " %7" PRIu32 " %6" PRIu32 " %4" PRIu32 "\n",
+           layout->cylinders, order, layout->wasted_spark ? "waste" : "cop",
+           out.channels, out.shared_operators, exec.p50_ns, exec.p99_ns, plan.p50_ns, plan.p99_ns,
+           measured_teeth ? (double)writes / (double)measured_teeth : 0.0, armed, matched, missed, pending);
+}
+
+// The capture never overwrites, so its oldest record is already first and
+// the copy back into the same buffer moves nothing
+static bool save_capture(const char *path, replay_record_t *records) {
+    replay_capture_header_t header;
+    uint32_t n = replay_capture_copy(&header, records, UINT32_MAX);
+    printf("replay capture: %" PRIu32 " records, %" PRIu32 " dropped -> %s\n", n, header.dropped, path);
+    return replay_file_write(path, &header, records);
+}
+
+static int run_bench(const bench_args_t *args_in, bool scaling_row) {
+    bench_args_t args = *args_in;
+    esp_log_level_set("*", args.verbose ? ESP_LOG_INFO : ESP_LOG_WARN);
+
+    // Layout is persisted and read back by engine_control_init()
+    esp_err_t err = config_manager_init();
+    if (err == ESP_OK) {
+        err = engine_control_set_engine_layout(&args.layout);
+    }
+    if (err != ESP_OK) {
+        if (scaling_row) {
+            char order[32];
+            format_firing_order(&args.layout, order, sizeof(order));
+            printf("%4u %-16s %5s %7u  %s\n", args.layout.cylinders, order,
+                   args.layout.wasted_spark ? "waste" : "cop",
+                   engine_layout_output_count(&args.layout), esp_err_to_name(err));
+            return 0;
+        }
+        fprintf(stderr, "engine layout rejected: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+
+    // Raw is rounded up so the sensor task's truncation gives back the voltage
+    float vbat_raw = (args.vbat_v - VBAT_SENSOR_MIN) / (VBAT_SENSOR_MAX - VBAT_SENSOR_MIN) * 4095.0f;
+    host_sim_adc_set_raw(BENCH_VBAT_ADC_CHANNEL, (uint16_t)ceilf(vbat_raw));
+
+    err = engine_control_init();
+    if (err != ESP_OK) {
+        fprintf(stderr, "engine_control_init failed: %s\n", esp_err_to_name(err));
+        return 1;
+    }
+    engine_control_set_isr_refine(args.isr_refine);
+    if (args.split_pct < SPLIT_INJ_MAX_FIRST_PCT) {
+        // Same split in every cell of the ratio map
+        err = engine_control_set_split_timing((uint16_t)args.split_gap_us, SPLIT_INJ_DEFAULT_MIN_PULSE_US);
+        for (uint8_t y = 0; y < SPLIT_INJ_BINS && err == ESP_OK; y++) {
+            for (uint8_t x = 0; x < SPLIT_INJ_BINS && err == ESP_OK; x++) {
+                err = engine_control_set_split_ratio_cell(x, y, args.split_pct);
+            }
+        }
+        if (err != ESP_OK) {
+            fprintf(stderr, "split injection setup failed: %s\n", esp_err_to_name(err));
+            return 1;
+        }
+    }
+    engine_control_start();
+    replay_record_t *capture = NULL;
+    if (args.record_path != NULL && !scaling_row) {
+        uint32_t capacity = (args.seconds + 1U) * BENCH_RECORDS_PER_S;
+        capture = malloc((size_t)capacity * sizeof(replay_record_t));
+        if (capture == NULL || replay_capture_start(capture, capacity, false) != ESP_OK) {
+            fprintf(stderr, "cannot start the replay capture\n");
+            free(capture);
+            return 1;
+        }
+    }
+    if (args.tune_hz > 0U) {
+        xTaskCreatePinnedToCore(tune_task, "bench_tune", 4096, &args.tune_hz, 5, NULL, 0);
+    }
+
+    uint64_t start_us = host_sim_now_us();
+    uint64_t end_us = start_us + (uint64_t)args.seconds * 1000000ULL;
+    wheel_rpm_point_t profile[4];
+    size_t profile_len = 0;
+    profile[profile_len++] = (wheel_rpm_point_t){ .at_us = start_us, .rpm = args.sweep ? 800 : args.rpm };
+    if (args.sweep) {
+        uint64_t span = end_us - start_us;
+        profile[profile_len++] = (wheel_rpm_point_t){ .at_us = start_us + span / 2U, .rpm = 7000 };
+        profile[profile_len++] = (wheel_rpm_point_t){ .at_us = end_us, .rpm = 800 };
+    }
+
+    wheel_sim_config_t wcfg;
+    wheel_sim_default_config(&wcfg, CKP_GPIO, CMP_GPIO);
+    wcfg.profile = profile;
+    wcfg.profile_len = profile_len;
+    wheel_sim_t wheel;
+    if (!wheel_sim_init(&wheel, &wcfg)) {
+        fprintf(stderr, "invalid wheel configuration\n");
+        return 1;
+    }
+
+    bool measuring = false;
+    uint32_t measured_teeth = 0;
+    uint64_t writes_at_start = 0;
+    uint64_t edges_at_start = 0;
+    wheel_edge_t edge;
+    while (wheel_sim_next(&wheel, &edge) && edge.time_us < end_us) {
+        if (!measuring && edge.time_us >= start_us + BENCH_WARMUP_US) {
+            host_sim_advance_to(edge.time_us);
+            host_sim_reset_task_stats();
+            writes_at_start = host_sim_mcpwm_compare_writes();
+            angle_scheduler_reset_stats();
+            output_capture_reset_stats();
+            mcpwm_injection_hp_reset_sched_stats();
+            mcpwm_ignition_hp_reset_sched_stats();
+            engine_control_reset_perf_stats();
+            core_plan_audit_t audit;
+            (void)core_plan_audit(&audit);
+            (void)task_profiler_restart();
+            edges_at_start = host_sim_mcpwm_output_edges();
+            measuring = true;
+        }
+        host_sim_advance_to(edge.time_us);
+        host_sim_gpio_edge(edge.gpio, true);
+        if (measuring && edge.gpio == CKP_GPIO) {
+            measured_teeth++;
+        }
+    }
+    host_sim_advance_to(end_us);
+    if (capture != NULL) {
+        replay_capture_stop();
+    }
+
+    sync_data_t sync = {0};
+    sync_get_data(&sync);
+    engine_perf_stats_t perf = {0};
+    engine_control_get_perf_stats(&perf);
+    uint64_t writes = host_sim_mcpwm_compare_writes() - writes_at_start;
+    if (scaling_row) {
+        print_scaling_row(&args.layout, measured_teeth, writes);
+        return sync.sync_acquired ? 0 : 1;
+    }
+
+    printf("ECU host bench: %s, %" PRIu32 " s virtual (%" PRIu64 " us warm-up excluded)\n",
+           args.sweep ? "sweep 800-7000-800 rpm" : "constant rpm", args.seconds, BENCH_WARMUP_US);
+    printf("wheel: %" PRIu32 " crank edges, %" PRIu32 " cam edges, %" PRIu32 " measured teeth\n",
+           wheel.crank_edges, wheel.cam_edges, measured_teeth);
+    printf("sync: acquired=%d valid=%d rpm=%" PRIu32 " tooth_period=%" PRIu32 " us\n",
+           sync.sync_acquired, sync.sync_valid, sync.rpm, sync.tooth_period);
+    printf("engine perf (virtual us): planner p99=%" PRIu32 " exec p99=%" PRIu32
+           " q_ovr=%" PRIu32 " q_peak=%" PRIu32 " superseded=%" PRIu32 " n=%" PRIu32 "\n",
+           perf.planner_p99_us, perf.executor_p99_us, perf.queue_overruns,
+           perf.queue_depth_peak, perf.plans_superseded, perf.sample_count);
+    print_latency_stages();
+    printf("comparator writes: %" PRIu64 " (%.2f per tooth)\n",
+           writes, measured_teeth ? (double)writes / (double)measured_teeth : 0.0);
+    printf("output edges: %" PRIu64 "\n", host_sim_mcpwm_output_edges() - edges_at_start);
+    char order[32];
+    format_firing_order(engine_layout_get(), order, sizeof(order));
+    mcpwm_output_info_t out = {0};
+    mcpwm_output_get_info(&out);
+    printf("layout: %u cylinders, firing order %s, %u coils (%s)\n",
+           engine_layout_cylinders(), order, engine_layout_coils(),
+           engine_layout_get()->wasted_spark ? "wasted spark" : "coil on plug");
+    printf("mcpwm outputs: %u channels, %u timers, %u operators (%u shared) isr_rearms=%" PRIu32
+           " late_ends=%" PRIu32 "\n",
+           out.channels, out.timers, out.operators, out.shared_operators, out.isr_rearms, out.late_ends);
+    print_split_injection(&args);
+    print_injector_model(&args);
+    print_dwell();
+    angle_scheduler_stats_t sched = {0};
+    angle_scheduler_get_stats(&sched);
+    printf("angle scheduler: arms=%" PRIu32 " refines=%" PRIu32 " refine_skips=%" PRIu32
+           " rejected=%" PRIu32 " writes=%" PRIu32 "\n",
+           sched.arms, sched.refines, sched.refines_skipped, sched.rejected, sched.comparator_writes);
+    printf("isr refine: %s refines=%" PRIu32 " refine_skips=%" PRIu32 " rejected=%" PRIu32 "\n",
+           engine_control_get_isr_refine() ? "on" : "off",
+           sched.isr_refines, sched.isr_refines_skipped, sched.isr_rejected);
+    timebase_stats_t tb = {0};
+    timebase_get_stats(&tb);
+    printf("timebase: mcpwm_timers=%" PRIu32 " checks=%" PRIu32 " max_skew=%" PRId32
+           " ticks reanchors=%" PRIu32 "\n",
+           tb.attached, tb.checks, tb.max_skew_ticks, tb.reanchors);
+    printf("espnow: status=%" PRIu32 " sensor=%" PRIu32 " diag=%" PRIu32 " profile=%" PRIu32 "\n",
+           host_sim_espnow_sent(ESPNOW_MSG_ENGINE_STATUS),
+           host_sim_espnow_sent(ESPNOW_MSG_SENSOR_DATA),
+           host_sim_espnow_sent(ESPNOW_MSG_DIAGNOSTIC),
+           host_sim_espnow_sent(ESPNOW_MSG_TASK_PROFILE));
+    if (args.tune_hz > 0U) {
+        printf("tuning: %" PRIu32 " EOIT cell writes, %" PRIu32 " errors\n", g_tune_writes, g_tune_errors);
+    }
+    print_output_capture();
+    print_task_stats();
+    print_core_audit();
+    print_task_profile();
+    bool cli_ok = run_cli_lines(&args);
+
+    // Wheel stopped: nothing may fire again, not even when the MCPWM timers
+    // wrap and reach the last compares written (two periods)
+    uint64_t stop_us = host_sim_now_us() + BENCH_STALL_SETTLE_US;
+    host_sim_advance_to(stop_us);
+    uint64_t edges_at_stop = host_sim_mcpwm_output_edges();
+    host_sim_advance_to(stop_us + 2ULL * MCPWM_OUTPUT_PERIOD_TICKS);
+    uint64_t ghost_edges = host_sim_mcpwm_output_edges() - edges_at_stop;
+    printf("\nwheel stopped: %" PRIu64 " output edges in %lu s after the stall%s\n",
+           ghost_edges, 2UL * MCPWM_OUTPUT_PERIOD_TICKS / 1000000UL, ghost_edges ? " (FAIL)" : "");
+
+    int rc = (sync.sync_acquired && ghost_edges == 0U && cli_ok) ? 0 : 1;
+    if (capture != NULL) {
+        if (!save_capture(args.record_path, capture)) {
+            rc = 1;
+        }
+        free(capture);
+    }
+    return rc;
+}
+
+// Every layout runs in its own process: engine_control and the simulator
+// are process-wide singletons
+static int run_cyl_scaling(const bench_args_t *args) {
+    printf("cylinder scaling: %s, %" PRIu32 " s virtual per layout, host wall-clock ns per task slice\n",
+           args->sweep ? "sweep 800-7000-800 rpm" : "constant rpm", args->seconds);
+    printf("%4s %-16s %5s %7s %6s %9s %9s %9s %9s %8s %7s %7s %6s %4s\n",
+           "cyl", "firing order", "spark", "outputs", "shared", "exec p50", "exec p99",
+           "plan p50", "plan p99", "wr/tooth", "armed", "matched", "missed", "pend");
+    int status = 0;
+    for (size_t i = 0; i < sizeof(k_scaling_layouts) / sizeof(k_scaling_layouts[0]); i++) {
+        bench_args_t row = *args;
+        layout_with_default_order(&row.layout, k_scaling_layouts[i].cylinders, k_scaling_layouts[i].wasted_spark);
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            int rc = run_bench(&row, true);
+            fflush(stdout);
+            _exit(rc);
+        }
+        int wstatus = 0;
+        if (waitpid(pid, &wstatus, 0) < 0 || !WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) {
+            status = 1;
+        }
+    }
+    return status;
+}
+
+int main(int argc, char **argv) {
+    bench_args_t args;
+    if (!parse_args(argc, argv, &args)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (args.cyl_scaling) {
+        return run_cyl_scaling(&args);
+    }
+    return run_bench(&args, false);
+}
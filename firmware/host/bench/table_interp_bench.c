@@ -0,0 +1,392 @@
+/**
+ * @file table_interp_bench.c
+ * @brief Compares the float and fixed-point table_16x16 interpolation paths
+ *        (worst-case difference in LSB, host cost per lookup) and separate vs
+ *        shared-axis lookups of four tables, and checks the configured axis
+ *        search strategy against a linear scan for every 16-bit value. Also
+ *        checks the 1D/2D/3D fixed-size table templates against an exact
+ *        reference
+ *
+ * Usage: table_interp_bench [--tables N]
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "table_16x16.h"
+#include "table_interp.h"
+
+#define BENCH_LOOKUPS 2000000U
+
+TABLE_1D_DEFINE(bench_curve12, 12)
+TABLE_2D_DEFINE(bench_map8, 8, 8)
+TABLE_2D_DEFINE(bench_map32, 32, 32)
+TABLE_3D_DEFINE(bench_map3d, 16, 16, 4)
+
+static const uint16_t BENCH_Z_BINS[4] = { 0, 40, 80, 120 };
+
+static uint32_t g_rng = 0x12345678U;
+
+static uint32_t rng_next(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void random_table(table_16x16_t *table, uint16_t value_range) {
+    table_16x16_init(table, NULL, NULL, 0);
+    for (int y = 0; y < 16; y++) {
+        for (int x = 0; x < 16; x++) {
+            table->values[y][x] = (uint16_t)(rng_next() % ((uint32_t)value_range + 1U));
+        }
+    }
+    table->checksum = table_16x16_checksum(table);
+}
+
+// Worst |fixed - float| over every rpm/load pair on a coarse grid that also
+// covers extrapolation below the first and above the last bin.
+static uint32_t max_error_lsb(const table_16x16_t *table, const table_16x16_recip_t *recip) {
+    uint32_t worst = 0;
+    for (uint32_t rpm = 0; rpm <= 12000U; rpm += 7U) {
+        for (uint32_t load = 0; load <= 1500U; load += 3U) {
+            int32_t a = table_16x16_interpolate_float(table, (uint16_t)rpm, (uint16_t)load);
+            int32_t b = table_16x16_interpolate_fixed(table, recip, (uint16_t)rpm, (uint16_t)load);
+            uint32_t diff = (uint32_t)(a > b ? a - b : b - a);
+            if (diff > worst) {
+                worst = diff;
+            }
+        }
+    }
+    return worst;
+}
+
+// The path table_eval_2d() takes, which table_multi_interpolate() must match
+static uint16_t lookup_configured(const table_16x16_t *table, const table_16x16_recip_t *recip,
+                                  uint16_t rpm, uint16_t load) {
+#if TABLE_FIXED_POINT
+    return table_16x16_interpolate_fixed(table, recip, rpm, load);
+#else
+    (void)recip;
+    return table_16x16_interpolate_float(table, rpm, load);
+#endif
+}
+
+static uint8_t axis_index_reference(const uint16_t *bins, uint16_t value) {
+    for (uint8_t i = 0; i < 15; i++) {
+        if (value < bins[i + 1]) {
+            return i;
+        }
+    }
+    return 14;
+}
+
+static void random_axis(uint16_t *bins) {
+    uint32_t v = rng_next() % 1000U;
+    for (int i = 0; i < 16; i++) {
+        v += 1U + rng_next() % 600U;
+        bins[i] = (uint16_t)v;
+    }
+}
+
+// Exhaustive check of table_16x16_axis_index() with and without the coarse
+// bucket table; returns the number of values that disagree with a linear scan.
+static uint32_t check_axis_search(const uint16_t *bins) {
+    table_16x16_t table;
+    table_16x16_recip_t recip;
+    table_16x16_init(&table, bins, bins, 0);
+    table_16x16_recip_build(&table, &recip);
+    uint32_t errors = 0;
+    for (uint32_t v = 0; v <= 0xFFFFU; v++) {
+        uint8_t ref = axis_index_reference(bins, (uint16_t)v);
+        if (table_axis_index(bins, 16, &recip.axis[0].coarse, (uint16_t)v) != ref ||
+            table_axis_index(bins, 16, NULL, (uint16_t)v) != ref) {
+            errors++;
+        }
+    }
+    return errors;
+}
+
+static double ref_axis(const uint16_t *bins, uint8_t n, uint16_t v, uint8_t *index) {
+    uint8_t i = 0;
+    while (i + 2U < n && v >= bins[i + 1]) {
+        i++;
+    }
+    *index = i;
+    return ((double)v - bins[i]) / (double)(bins[i + 1] - bins[i]);
+}
+
+static double ref_lerp(double a, double b, double f) {
+    return a + f * (b - a);
+}
+
+// Exact (double) reference for any view, rounded like the kernels.
+static uint16_t ref_interpolate(const table_view_t *v, uint16_t x, uint16_t y, uint16_t z) {
+    uint8_t ix = 0, iy = 0, iz = 0;
+    double fx = ref_axis(v->x_bins, v->nx, x, &ix);
+    double fy = v->y_bins ? ref_axis(v->y_bins, v->ny, y, &iy) : 0.0;
+    double fz = v->z_bins ? ref_axis(v->z_bins, v->nz, z, &iz) : 0.0;
+    double layer[2];
+    for (int k = 0; k < 2; k++) {
+        const uint16_t *base = v->values + (size_t)(iz + (v->z_bins ? k : 0)) * v->nx * v->ny;
+        const uint16_t *r0 = base + (size_t)iy * v->nx + ix;
+        double a = ref_lerp(r0[0], r0[1], fx);
+        double b = v->y_bins ? ref_lerp(r0[v->nx], r0[v->nx + 1], fx) : a;
+        layer[k] = ref_lerp(a, b, fy);
+    }
+    double r = ref_lerp(layer[0], layer[1], fz);
+    r = fmin(fmax(r, 0.0), 65535.0);
+    return (uint16_t)floor(r + 0.5);
+}
+
+static void fill_random(uint16_t *values, size_t count, uint16_t range) {
+    for (size_t i = 0; i < count; i++) {
+        values[i] = (uint16_t)(rng_next() % ((uint32_t)range + 1U));
+    }
+}
+
+static uint32_t diff_u16(uint16_t a, uint16_t b) {
+    return (a > b) ? (uint32_t)(a - b) : (uint32_t)(b - a);
+}
+
+// 1D, 8x8, 32x32 and 3D tables from the fixed-size templates against the
+// double reference, over a grid that includes extrapolation.
+static uint32_t check_generic_sizes(void) {
+    static bench_curve12_t curve;
+    static bench_map8_t m8;
+    static bench_map32_t m32;
+    static bench_map3d_t m3;
+    table_cache_t cache;
+    uint32_t worst = 0;
+
+    bench_curve12_init(&curve, DEFAULT_LOAD_BINS, 16, 0);
+    fill_random(curve.values, 12, 4000);
+    bench_curve12_commit(&curve);
+    bench_map8_init(&m8, DEFAULT_RPM_BINS, 16, DEFAULT_LOAD_BINS, 16, 0);
+    fill_random(&m8.values[0][0], 64, 4000);
+    bench_map8_commit(&m8);
+    bench_map32_init(&m32, DEFAULT_RPM_BINS, 16, DEFAULT_LOAD_BINS, 16, 0);
+    fill_random(&m32.values[0][0], 1024, 4000);
+    bench_map32_commit(&m32);
+    bench_map3d_init(&m3, DEFAULT_RPM_BINS, 16, DEFAULT_LOAD_BINS, 16, BENCH_Z_BINS, 4, 0);
+    fill_random(&m3.values[0][0][0], 1024, 4000);
+    bench_map3d_commit(&m3);
+
+    if (!bench_curve12_validate(&curve) || !bench_map8_validate(&m8) ||
+        !bench_map32_validate(&m32) || !bench_map3d_validate(&m3)) {
+        printf("generic sizes: validation failed\n");
+        return UINT32_MAX;
+    }
+
+    table_view_t vc = bench_curve12_view(&curve);
+    table_view_t v8 = bench_map8_view(&m8);
+    table_view_t v32 = bench_map32_view(&m32);
+    table_view_t v3 = bench_map3d_view(&m3);
+    memset(&cache, 0, sizeof(cache));
+    for (uint32_t y = 0; y <= 1500U; y += 11U) {
+        uint32_t e = diff_u16(bench_curve12_interpolate(&curve, &cache, (uint16_t)y),
+                              ref_interpolate(&vc, (uint16_t)y, 0, 0));
+        worst = (e > worst) ? e : worst;
+    }
+    table_cache_t c8 = {0}, c32 = {0}, c3 = {0};
+    for (uint32_t x = 0; x <= 12000U; x += 37U) {
+        for (uint32_t y = 0; y <= 1500U; y += 11U) {
+            uint32_t e8 = diff_u16(bench_map8_interpolate(&m8, &c8, (uint16_t)x, (uint16_t)y),
+                                   ref_interpolate(&v8, (uint16_t)x, (uint16_t)y, 0));
+            uint32_t e32 = diff_u16(bench_map32_interpolate(&m32, &c32, (uint16_t)x, (uint16_t)y),
+                                    ref_interpolate(&v32, (uint16_t)x, (uint16_t)y, 0));
+            uint32_t z = (x / 37U) % 160U;
+            uint32_t e3 = diff_u16(bench_map3d_interpolate(&m3, &c3, (uint16_t)x, (uint16_t)y, (uint16_t)z),
+                                   ref_interpolate(&v3, (uint16_t)x, (uint16_t)y, (uint16_t)z));
+            uint32_t e = (e8 > e32) ? e8 : e32;
+            e = (e3 > e) ? e3 : e;
+            worst = (e > worst) ? e : worst;
+        }
+    }
+    printf("generic sizes (1D 12, 8x8, 32x32, 16x16x4): max error %" PRIu32 " LSB vs exact\n", worst);
+    return worst;
+}
+
+// Random single-cell edits: the delta checksum must equal a full recompute,
+// every edit must move to a new generation and a cached lookup must see the
+// new value. Also counts how often one edit rebuilds the other tables' caches
+// in a shared multi lookup (should be never).
+static uint32_t check_cell_edits(void) {
+    static bench_map8_t tables[3];
+    table_view_t views[3];
+    table_multi_t multi;
+    table_cache_t cache = {0};
+    uint16_t out[3];
+    uint32_t failures = 0;
+    uint32_t foreign_rebuilds = 0;
+
+    for (int i = 0; i < 3; i++) {
+        bench_map8_init(&tables[i], DEFAULT_RPM_BINS, 16, DEFAULT_LOAD_BINS, 16, 0);
+        fill_random(&tables[i].values[0][0], 64, 4000);
+        bench_map8_commit(&tables[i]);
+        views[i] = bench_map8_view(&tables[i]);
+    }
+    table_multi_reset(&multi);
+    table_multi_interpolate(&multi, views, 3, 3000, 500, out);
+
+    for (uint32_t n = 0; n < 10000U; n++) {
+        bench_map8_t *t = &tables[0];
+        uint8_t x = (uint8_t)(rng_next() % 8U);
+        uint8_t y = (uint8_t)(rng_next() % 8U);
+        uint32_t gen = t->generation;
+        uint32_t other_gen[2] = { multi.cache[1].generation, multi.cache[2].generation };
+        bench_map8_set_cell(t, x, y, (uint16_t)(rng_next() & 0xFFFFU));
+        if (t->checksum != bench_map8_checksum(t) || t->generation == gen) {
+            failures++;
+        }
+        if (bench_map8_interpolate(t, &cache, t->x_bins[x], t->y_bins[y]) != t->values[y][x]) {
+            failures++;
+        }
+        table_multi_interpolate(&multi, views, 3, t->x_bins[x], t->y_bins[y], out);
+        if (out[0] != t->values[y][x]) {
+            failures++;
+        }
+        if (multi.cache[1].generation != other_gen[0] || multi.cache[2].generation != other_gen[1]) {
+            foreign_rebuilds++;
+        }
+    }
+    printf("cell edits: %" PRIu32 " checksum/lookup failures, %" PRIu32 " foreign cache rebuilds\n",
+           failures, foreign_rebuilds);
+    return failures + foreign_rebuilds;
+}
+
+int main(int argc, char **argv) {
+    uint32_t tables = 20;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tables") == 0 && i + 1 < argc) {
+            tables = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--tables N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    static const uint16_t ranges[] = { 2000, 65535 };
+    uint32_t worst = 0;
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        uint32_t worst_range = 0;
+        for (uint32_t t = 0; t < tables; t++) {
+            table_16x16_t table;
+            table_16x16_recip_t recip;
+            random_table(&table, ranges[r]);
+            table_16x16_recip_build(&table, &recip);
+            uint32_t err = max_error_lsb(&table, &recip);
+            if (err > worst_range) {
+                worst_range = err;
+            }
+        }
+        printf("values 0..%-5u: max |fixed - float| = %" PRIu32 " LSB over %" PRIu32 " tables\n",
+               ranges[r], worst_range, tables);
+        if (worst_range > worst) {
+            worst = worst_range;
+        }
+    }
+
+    if (check_generic_sizes() > 1U) {
+        worst = UINT32_MAX;
+    }
+    if (check_cell_edits() != 0U) {
+        worst = UINT32_MAX;
+    }
+
+    uint32_t axis_errors = check_axis_search(DEFAULT_RPM_BINS) + check_axis_search(DEFAULT_LOAD_BINS);
+    for (uint32_t t = 0; t < tables; t++) {
+        uint16_t bins[16];
+        random_axis(bins);
+        axis_errors += check_axis_search(bins);
+    }
+    printf("axis search (strategy %d): %" PRIu32 " mismatches vs linear scan\n",
+           TABLE_AXIS_SEARCH, axis_errors);
+
+    table_16x16_t table;
+    table_16x16_recip_t recip;
+    random_table(&table, 2000);
+    table_16x16_recip_build(&table, &recip);
+
+    uint16_t *rpm = malloc(BENCH_LOOKUPS * sizeof(uint16_t));
+    uint16_t *load = malloc(BENCH_LOOKUPS * sizeof(uint16_t));
+    if (!rpm || !load) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < BENCH_LOOKUPS; i++) {
+        rpm[i] = (uint16_t)(500U + rng_next() % 7500U);
+        load[i] = (uint16_t)(200U + rng_next() % 900U);
+    }
+
+    volatile uint32_t sink = 0;
+    uint64_t t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_LOOKUPS; i++) {
+        sink += table_16x16_interpolate_float(&table, rpm[i], load[i]);
+    }
+    uint64_t t1 = now_ns();
+    for (uint32_t i = 0; i < BENCH_LOOKUPS; i++) {
+        sink += table_16x16_interpolate_fixed(&table, &recip, rpm[i], load[i]);
+    }
+    uint64_t t2 = now_ns();
+    for (uint32_t i = 0; i < BENCH_LOOKUPS; i++) {
+        sink += table_16x16_interpolate_fixed(&table, NULL, rpm[i], load[i]);
+    }
+    uint64_t t3 = now_ns();
+
+    // Four tables on the same axes, as in one planner pass: separate cached
+    // lookups against one shared axis search.
+    table_16x16_t maps[4];
+    table_16x16_recip_t recips[4];
+    table_view_t group[4];
+    for (int i = 0; i < 4; i++) {
+        random_table(&maps[i], 2000);
+        table_16x16_recip_build(&maps[i], &recips[i]);
+        group[i] = table_16x16_view(&maps[i]);
+    }
+    table_multi_t multi;
+    table_multi_reset(&multi);
+    uint32_t mismatches = 0;
+    uint16_t out[4];
+    uint64_t t4 = now_ns();
+    for (uint32_t i = 0; i < BENCH_LOOKUPS; i++) {
+        for (int m = 0; m < 4; m++) {
+            sink += lookup_configured(&maps[m], &recips[m], rpm[i], load[i]);
+        }
+    }
+    uint64_t t5 = now_ns();
+    for (uint32_t i = 0; i < BENCH_LOOKUPS; i++) {
+        table_multi_interpolate(&multi, group, 4, rpm[i], load[i], out);
+        sink += out[0] + out[1] + out[2] + out[3];
+    }
+    uint64_t t6 = now_ns();
+    for (uint32_t i = 0; i < BENCH_LOOKUPS; i += 97U) {
+        table_multi_interpolate(&multi, group, 4, rpm[i], load[i], out);
+        for (int m = 0; m < 4; m++) {
+            if (out[m] != lookup_configured(&maps[m], &recips[m], rpm[i], load[i])) {
+                mismatches++;
+            }
+        }
+    }
+    (void)sink;
+
+    printf("float:           %6.1f ns/lookup\n", (double)(t1 - t0) / BENCH_LOOKUPS);
+    printf("fixed (recip):   %6.1f ns/lookup\n", (double)(t2 - t1) / BENCH_LOOKUPS);
+    printf("fixed (divide):  %6.1f ns/lookup\n", (double)(t3 - t2) / BENCH_LOOKUPS);
+    printf("4 tables, separate: %6.1f ns/pass\n", (double)(t5 - t4) / BENCH_LOOKUPS);
+    printf("4 tables, shared:   %6.1f ns/pass (%" PRIu32 " mismatches)\n",
+           (double)(t6 - t5) / BENCH_LOOKUPS, mismatches);
+
+    free(rpm);
+    free(load);
+    return (worst <= 1U && mismatches == 0U && axis_errors == 0U) ? 0 : 1;
+}
@@ -0,0 +1,396 @@
+/**
+ * @file trigger_decoder_bench.c
+ * @brief Conformance and per-edge cost of the trigger wheel decoders
+ *
+ * For every wheel preset, synthetic crank (and cam) waveforms are fed through
+ * the real sync capture path on the host simulator: constant speed, a fast
+ * ramp, a dropped tooth and a noise edge. Once sync is acquired, every edge
+ * must report the crank angle the waveform was generated with, and faults
+ * must be reported as sync losses and recovered from within two cycles.
+ * The decode step alone is then timed against the single-pattern gap rule
+ * it replaced.
+ *
+ * Usage: trigger_decoder_bench [--wheel NAME]
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "s3_control_config.h"
+#include "sync.h"
+#include "trigger_decoder.h"
+#include "esp_log.h"
+#include "host_sim.h"
+
+#define BENCH_EDGES         2000000U
+#define BENCH_CAM_DEG       645.0
+#define BENCH_MAX_CYCLE_EDGES (2U * SYNC_MAX_TEETH + 1U)
+
+typedef struct {
+    double angle;
+    int gpio;
+} cycle_event_t;
+
+typedef struct {
+    cycle_event_t ev[BENCH_MAX_CYCLE_EDGES];
+    uint32_t count;
+    uint32_t crank_edges;
+} cycle_t;
+
+typedef enum {
+    RUN_STEADY = 0,
+    RUN_RAMP,
+    RUN_DROPPED_TOOTH,
+    RUN_NOISE_EDGE,
+} run_kind_t;
+
+typedef struct {
+    uint32_t edges;
+    uint32_t acquire_edges;     // crank edges until sync was first acquired (0 = never)
+    uint32_t losses;
+    uint32_t angle_errors;      // edges with sync acquired and the wrong angle
+    uint32_t detect_edges;      // fault runs: edges from the fault to the sync loss
+    uint32_t recover_edges;     // fault runs: edges from the fault to sync again
+    double rpm_error;           // worst relative RPM error with sync (steady runs)
+} run_result_t;
+
+static uint32_t g_rng = 0x2468ace1U;
+
+static uint32_t rng_next(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int event_cmp(const void *a, const void *b) {
+    double x = ((const cycle_event_t *)a)->angle;
+    double y = ((const cycle_event_t *)b)->angle;
+    return (x > y) - (x < y);
+}
+
+static void cycle_add(cycle_t *c, double angle, int gpio) {
+    c->ev[c->count].angle = angle;
+    c->ev[c->count].gpio = gpio;
+    c->count++;
+    if (gpio == CKP_GPIO) {
+        c->crank_edges++;
+    }
+}
+
+// Physical wheel, written from the wheel description rather than the decoder
+// tables: the first tooth after the gap, or the sync tooth, is crank angle 0.
+static void cycle_build(const sync_config_t *cfg, cycle_t *c) {
+    memset(c, 0, sizeof(*c));
+    double wheel_deg = cfg->cam_speed ? 720.0 : 360.0;
+    uint32_t revolutions = cfg->cam_speed ? 1U : 2U;
+    for (uint32_t r = 0; r < revolutions; r++) {
+        double base = r * wheel_deg;
+        if (cfg->pattern == TRIGGER_PATTERN_MISSING_TOOTH) {
+            double pitch = wheel_deg / (double)(cfg->tooth_count + cfg->missing_teeth);
+            for (uint32_t i = 0; i < cfg->tooth_count; i++) {
+                cycle_add(c, base + i * pitch, CKP_GPIO);
+            }
+        } else {
+            double pitch = wheel_deg / (double)cfg->tooth_count;
+            cycle_add(c, base, CKP_GPIO);
+            for (uint32_t i = 1; i <= cfg->tooth_count; i++) {
+                cycle_add(c, base + i * pitch - (double)cfg->sync_tooth_deg, CKP_GPIO);
+            }
+        }
+    }
+    if (!cfg->cam_speed) {
+        cycle_add(c, BENCH_CAM_DEG, CMP_GPIO);
+    }
+    qsort(c->ev, c->count, sizeof(c->ev[0]), event_cmp);
+}
+
+static double run_rpm(run_kind_t kind, double rpm, double t_s) {
+    if (kind != RUN_RAMP) {
+        return rpm;
+    }
+    // 800 -> 7000 rpm in 0.5 s, back down in the next 0.5 s
+    double phase = fmod(t_s, 1.0);
+    double frac = phase < 0.5 ? phase * 2.0 : (1.0 - phase) * 2.0;
+    return 800.0 + frac * 6200.0;
+}
+
+static uint32_t angle_diff(uint32_t a, uint32_t b) {
+    uint32_t d = (a > b) ? a - b : b - a;
+    return (d > SYNC_ANGLE_CYCLE / 2U) ? SYNC_ANGLE_CYCLE - d : d;
+}
+
+static esp_err_t run_wheel(const sync_config_t *cfg, run_kind_t kind, double rpm, double seconds,
+                           run_result_t *res) {
+    memset(res, 0, sizeof(*res));
+    esp_err_t err = sync_set_config(cfg);
+    if (err != ESP_OK) {
+        return err;
+    }
+    sync_reset();
+
+    cycle_t cycle;
+    cycle_build(cfg, &cycle);
+    // Faults land in the fourth cycle, on a tooth in the middle of the wheel
+    uint32_t fault_edge = (kind >= RUN_DROPPED_TOOTH) ? 3U * cycle.crank_edges + cycle.crank_edges / 3U : UINT32_MAX;
+    uint32_t fault_at = 0;
+
+    uint64_t t0 = host_sim_now_us() + 1000U;
+    double t_us = 0.0;
+    double angle = 0.0;
+    double last_crank_us = 0.0;
+    uint32_t crank = 0;
+    for (uint32_t n = 0; t_us < seconds * 1e6; n++) {
+        const cycle_event_t *ev = &cycle.ev[n % cycle.count];
+        double target = (double)(n / cycle.count) * 720.0 + ev->angle;
+        double deg_per_us = run_rpm(kind, rpm, t_us * 1e-6) * 6e-6;
+        t_us += (target - angle) / deg_per_us;
+        angle = target;
+        if (ev->gpio != CKP_GPIO) {
+            host_sim_advance_to(t0 + (uint64_t)t_us);
+            host_sim_gpio_edge(ev->gpio, true);
+            continue;
+        }
+
+        uint32_t index = crank++;
+        if (index == fault_edge) {
+            fault_at = res->edges;
+            if (kind == RUN_NOISE_EDGE) {
+                host_sim_advance_to(t0 + (uint64_t)((last_crank_us + t_us) * 0.5));
+                host_sim_gpio_edge(CKP_GPIO, true);
+                res->edges++;
+            } else {
+                last_crank_us = t_us;
+                continue;
+            }
+        }
+        last_crank_us = t_us;
+        host_sim_advance_to(t0 + (uint64_t)t_us);
+        host_sim_gpio_edge(CKP_GPIO, true);
+        res->edges++;
+
+        sync_data_t d;
+        sync_get_data(&d);
+        if (fault_at > 0 && res->detect_edges == 0 && d.sync_loss_count > 0) {
+            res->detect_edges = res->edges - fault_at;
+        }
+        if (!d.sync_acquired) {
+            continue;
+        }
+        if (res->acquire_edges == 0) {
+            res->acquire_edges = res->edges;
+        }
+        if (res->detect_edges > 0 && res->recover_edges == 0) {
+            res->recover_edges = res->edges - fault_at;
+        }
+        // Between the fault and its detection the angles are expected to be off
+        if (fault_at > 0 && res->recover_edges == 0) {
+            continue;
+        }
+        uint32_t expected = (uint32_t)lround(fmod(angle, 720.0) * SYNC_ANGLE_SCALE) % SYNC_ANGLE_CYCLE;
+        if (angle_diff(d.cycle_angle, expected) > 1U) {
+            res->angle_errors++;
+        }
+        if (kind == RUN_STEADY && d.rpm > 0) {
+            double e = fabs((double)d.rpm - rpm) / rpm;
+            if (e > res->rpm_error) {
+                res->rpm_error = e;
+            }
+        }
+    }
+    sync_data_t d;
+    sync_get_data(&d);
+    res->losses = d.sync_loss_count;
+    return ESP_OK;
+}
+
+static bool check_wheel(trigger_wheel_preset_t preset) {
+    sync_config_t cfg;
+    sync_get_config(&cfg);
+    trigger_wheel_preset(preset, &cfg);
+    cfg.max_rpm = 8000;
+    cfg.min_rpm = 100;
+
+    cycle_t cycle;
+    cycle_build(&cfg, &cycle);
+    // Sync must be up within two engine cycles of the first edge
+    uint32_t acquire_limit = 2U * cycle.crank_edges;
+
+    static const struct {
+        run_kind_t kind;
+        double rpm;
+        const char *name;
+    } runs[] = {
+        { RUN_STEADY, 600.0, "600 rpm" },
+        { RUN_STEADY, 3000.0, "3000 rpm" },
+        { RUN_STEADY, 7000.0, "7000 rpm" },
+        { RUN_RAMP, 0.0, "ramp 800-7000" },
+        { RUN_DROPPED_TOOTH, 2500.0, "dropped tooth" },
+        { RUN_NOISE_EDGE, 2500.0, "noise edge" },
+    };
+
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        run_result_t r;
+        esp_err_t err = run_wheel(&cfg, runs[i].kind, runs[i].rpm, 2.0, &r);
+        if (err != ESP_OK) {
+            printf("%-6s %-14s config rejected: %s\n", trigger_wheel_preset_name(preset), runs[i].name,
+                   esp_err_to_name(err));
+            ok = false;
+            continue;
+        }
+        bool pass = r.acquire_edges > 0 && r.acquire_edges <= acquire_limit && r.angle_errors == 0;
+        if (runs[i].kind >= RUN_DROPPED_TOOTH) {
+            pass = pass && r.losses > 0 && r.recover_edges > 0 && r.recover_edges <= acquire_limit;
+        } else {
+            pass = pass && r.losses == 0 && r.rpm_error < 0.02;
+        }
+        ok = ok && pass;
+        printf("%-6s %-14s %7" PRIu32 " edges  acquire=%-4" PRIu32 " losses=%-2" PRIu32
+               " angle_err=%-3" PRIu32,
+               trigger_wheel_preset_name(preset), runs[i].name, r.edges, r.acquire_edges, r.losses,
+               r.angle_errors);
+        if (runs[i].kind >= RUN_DROPPED_TOOTH) {
+            printf(" detect=%-3" PRIu32 " recover=%-4" PRIu32, r.detect_edges, r.recover_edges);
+        } else if (runs[i].kind == RUN_STEADY) {
+            printf(" rpm_err=%.2f%%", r.rpm_error * 100.0);
+        }
+        printf("  %s\n", pass ? "ok" : "FAIL");
+    }
+    return ok;
+}
+
+// Gap rule and tooth count of the 60-2-only capture path, for comparison
+static uint32_t legacy_decode(uint32_t *tooth_index, uint32_t *tooth_period, uint32_t period,
+                              uint32_t tooth_count, uint32_t scale_q24) {
+    bool gap = (*tooth_period > 0) && (period > (*tooth_period * 3U) / 2U);
+    if (gap) {
+        *tooth_index = 0;
+        *tooth_period = period / 3U;
+    } else {
+        *tooth_index = (*tooth_index + 1U) % tooth_count;
+        *tooth_period = period;
+    }
+    return (uint32_t)(((uint64_t)*tooth_period * scale_q24) >> 8);
+}
+
+// Tooth periods of the preset at random speeds between 1000 and 6000 rpm
+static void fill_periods(const sync_config_t *cfg, uint32_t *periods) {
+    cycle_t cycle;
+    cycle_build(cfg, &cycle);
+    double angles[BENCH_MAX_CYCLE_EDGES];
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < cycle.count; i++) {
+        if (cycle.ev[i].gpio == CKP_GPIO) {
+            angles[n++] = cycle.ev[i].angle;
+        }
+    }
+    for (uint32_t i = 0; i < BENCH_EDGES; i++) {
+        uint32_t k = i % n;
+        double prev = (k == 0) ? angles[n - 1] - 720.0 : angles[k - 1];
+        double rpm = 1000.0 + (double)(rng_next() % 5000U);
+        periods[i] = (uint32_t)((angles[k] - prev) / (rpm * 6e-6));
+    }
+}
+
+static double time_decoder(trigger_wheel_preset_t preset, uint32_t *periods) {
+    sync_config_t cfg = {0};
+    trigger_wheel_preset(preset, &cfg);
+    const trigger_decoder_t *decoder = trigger_decoder_get(cfg.pattern);
+    static trigger_wheel_t wheel;
+    if (decoder == NULL || decoder->build(&cfg, &wheel) != ESP_OK) {
+        return -1.0;
+    }
+    fill_periods(&cfg, periods);
+
+    trigger_state_t state;
+    trigger_state_reset(&state);
+    volatile uint32_t sink = 0;
+    uint64_t t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_EDGES; i++) {
+        sink += decoder->decode(&state, &wheel, periods[i]);
+        sink += state.us_per_degree_q16;
+    }
+    uint64_t t1 = now_ns();
+    (void)sink;
+    return (double)(t1 - t0) / BENCH_EDGES;
+}
+
+static double time_legacy(uint32_t *periods) {
+    sync_config_t cfg = {0};
+    trigger_wheel_preset(TRIGGER_WHEEL_60_2, &cfg);
+    fill_periods(&cfg, periods);
+
+    uint32_t index = 0;
+    uint32_t period = 0;
+    uint32_t scale_q24 = (uint32_t)(((60ULL << 24) + 180U) / 360U);
+    volatile uint32_t sink = 0;
+    uint64_t t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_EDGES; i++) {
+        sink += legacy_decode(&index, &period, periods[i], 58U, scale_q24);
+        sink += index;
+    }
+    uint64_t t1 = now_ns();
+    (void)sink;
+    return (double)(t1 - t0) / BENCH_EDGES;
+}
+
+int main(int argc, char **argv) {
+    int only = -1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--wheel") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            for (int p = 0; p < TRIGGER_WHEEL_COUNT; p++) {
+                if (strcmp(name, trigger_wheel_preset_name((trigger_wheel_preset_t)p)) == 0) {
+                    only = p;
+                }
+            }
+            if (only < 0) {
+                fprintf(stderr, "unknown wheel %s\n", name);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "usage: %s [--wheel NAME]\n", argv[0]);
+            return 2;
+        }
+    }
+    esp_log_level_set("*", ESP_LOG_WARN);
+
+    if (sync_init() != ESP_OK || sync_start() != ESP_OK) {
+        fprintf(stderr, "sync init failed\n");
+        return 1;
+    }
+
+    bool ok = true;
+    for (int p = 0; p < TRIGGER_WHEEL_COUNT; p++) {
+        if (only < 0 || only == p) {
+            ok = check_wheel((trigger_wheel_preset_t)p) && ok;
+        }
+    }
+
+    uint32_t *periods = malloc(BENCH_EDGES * sizeof(uint32_t));
+    if (!periods) {
+        return 1;
+    }
+    printf("\ndecode cost per edge (host):\n");
+    for (int p = 0; p < TRIGGER_WHEEL_COUNT; p++) {
+        if (only < 0 || only == p) {
+            printf("  %-6s %6.2f ns\n", trigger_wheel_preset_name((trigger_wheel_preset_t)p),
+                   time_decoder((trigger_wheel_preset_t)p, periods));
+        }
+    }
+    printf("  60-2 legacy inline rule %6.2f ns\n", time_legacy(periods));
+
+    free(periods);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file host_sim.h
+ * @brief Control surface of the host (Linux) simulation of the S3 firmware
+ *
+ * The host build links the real engine_control sources against stubbed
+ * ESP-IDF / FreeRTOS APIs. Everything runs on a virtual microsecond clock:
+ *
+ * - Firmware tasks are real threads, but exactly one simulated context runs
+ *   at a time. A task runs until it blocks (notify take, delay, queue or
+ *   semaphore wait); preemption and the second core are not modelled.
+ * - "ISRs" (PCNT watch callbacks, GPIO handlers) run on the caller's thread
+ *   when an edge is injected with host_sim_gpio_edge().
+ * - Cores are bookkeeping only: esp_cpu_get_core_id() reports the running
+ *   task's core, or inside an ISR the core that registered it, as the S3
+ *   allocates an interrupt on the installing core. The core plan audit
+ *   (core_plan.h) reads those, and host wall-clock task time as run time.
+ * - The virtual clock only moves when the driver (the bench or replay tool)
+ *   advances it, so a run is fully deterministic; task execution takes zero
+ *   virtual time. Host wall-clock cost of every task slice is recorded
+ *   separately and exposed through host_sim_get_task_stats().
+ * - MCPWM generator outputs switch when the virtual clock passes their
+ *   compare values; advancing the clock runs those edges in time order.
+ * - MCPWM resources are limited per group as on the S3 (3 timers, 3
+ *   operators, 2 comparators and 2 generators per operator); the 16-bit
+ *   timer period is not enforced. GPIO ETM events are limited to 8.
+ */
+
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//=============================================================================
+// Virtual clock and scheduler
+//=============================================================================
+
+/** @brief Current virtual time in microseconds */
+uint64_t host_sim_now_us(void);
+
+/** @brief Runs every ready task until all of them block; time does not move */
+void host_sim_run_until_idle(void);
+
+/**
+ * @brief Advances the virtual clock to @p t_us, running every task timeout
+ *        and delay that expires on the way
+ * @note Must be called from the driver thread, never from a firmware task
+ */
+void host_sim_advance_to(uint64_t t_us);
+
+/** @brief Convenience wrapper: host_sim_advance_to(now + dt_us) */
+void host_sim_advance_by(uint64_t dt_us);
+
+/** @brief Per-task host wall-clock statistics */
+typedef struct {
+    const char *name;
+    uint32_t priority;
+    int core;
+    uint32_t slices;            ///< Times the task was dispatched
+    uint64_t runtime_ns;        ///< Total wall-clock time spent running
+    uint32_t p50_ns;            ///< Median slice duration
+    uint32_t p99_ns;            ///< 99th percentile slice duration
+    uint32_t max_ns;            ///< Longest slice
+} host_task_stats_t;
+
+size_t host_sim_get_task_count(void);
+bool host_sim_get_task_stats(size_t index, host_task_stats_t *out);
+void host_sim_reset_task_stats(void);
+
+//=============================================================================
+// Simulated peripherals
+//=============================================================================
+
+/**
+ * @brief Injects an edge on @p gpio at the current virtual time
+ *
+ * Routes the edge exactly like the hardware would: ETM-bound GPTimer
+ * captures first, then PCNT counting (and watch callbacks), then the GPIO
+ * ISR handler. Tasks woken by those callbacks run before this returns.
+ */
+void host_sim_gpio_edge(int gpio, bool rising);
+
+/** @brief Sets the 12-bit raw value returned for an ADC1 channel */
+void host_sim_adc_set_raw(unsigned channel, uint16_t raw);
+
+/** @brief Queues a CAN frame for twai_receive() and runs woken tasks */
+bool host_sim_twai_inject(uint32_t identifier, const uint8_t *data, uint8_t dlc);
+
+/** @brief Number of frames passed to twai_transmit() so far */
+uint32_t host_sim_twai_tx_count(void);
+
+/** @brief Total mcpwm_comparator_set_compare_value() calls */
+uint64_t host_sim_mcpwm_compare_writes(void);
+
+/**
+ * @brief Level changes driven by MCPWM generators so far
+ *
+ * Generators switch their pin when the timer reaches a compare value (or
+ * empty/full) with a matching action, or when a level is forced. Each change
+ * is routed like host_sim_gpio_edge(), so loop-back captures see it.
+ */
+uint64_t host_sim_mcpwm_output_edges(void);
+
+/** @brief Called for every MCPWM generator level change, at its virtual time */
+typedef void (*host_sim_output_hook_t)(int gpio, bool level, uint64_t t_us, void *ctx);
+
+/**
+ * @brief Installs @p hook (NULL removes it)
+ *
+ * The hook runs before the edge is routed to the GPIO handlers, in the
+ * context that advanced the clock. It must not advance the clock itself.
+ */
+void host_sim_set_output_hook(host_sim_output_hook_t hook, void *ctx);
+
+/** @brief Messages accepted by the host ESP-NOW link, by message type */
+uint32_t host_sim_espnow_sent(uint8_t msg_type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_SIM_H
@@ -0,0 +1,263 @@
+/**
+ * @file ecu_replay.c
+ * @brief Re-runs a recorded input capture through the real engine_control
+ *        stack on the virtual clock and traces every output edge
+ *
+ * Usage: ecu_replay CAPTURE [--trace OUT.csv] [--tail-ms N]
+ *
+ * CKP/CMP edges, ADC blocks and CAN frames are fed back at their recorded
+ * times (shifted to the host clock), so sync, sensor processing, the
+ * planner and the MCPWM drivers see the same inputs as the recorded run.
+ * Nothing waits on the wall clock: a capture replays as fast as the host
+ * can simulate it, and the same capture always gives the same trace.
+ *
+ * Trace columns: t_us (from the first record), output, edge (start = output
+ * on, end = output off, i.e. end of injection / spark), cycle_deg (crank
+ * angle in the 720 degree cycle at the edge, empty without sync) and rpm.
+ * The calibration is not part of the capture: the replay runs on the maps
+ * the host NVS holds, the defaults unless a tool wrote others.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config_manager.h"
+#include "engine_control.h"
+#include "engine_layout.h"
+#include "replay_capture.h"
+#include "s3_control_config.h"
+#include "sync.h"
+#include "esp_log.h"
+#include "host_sim.h"
+#include "replay_file.h"
+
+#define REPLAY_DEFAULT_TAIL_MS 100U
+
+static const int k_injector_gpios[ENGINE_MAX_CYLINDERS] = {
+    INJECTOR_GPIO_1, INJECTOR_GPIO_2, INJECTOR_GPIO_3, INJECTOR_GPIO_4,
+    INJECTOR_GPIO_5, INJECTOR_GPIO_6, INJECTOR_GPIO_7, INJECTOR_GPIO_8,
+};
+static const int k_ignition_gpios[ENGINE_MAX_CYLINDERS] = {
+    IGNITION_GPIO_1, IGNITION_GPIO_2, IGNITION_GPIO_3, IGNITION_GPIO_4,
+    IGNITION_GPIO_5, IGNITION_GPIO_6, IGNITION_GPIO_7, IGNITION_GPIO_8,
+};
+
+typedef struct {
+    FILE *trace;
+    uint64_t origin_us;            // Host time of the first record
+    uint32_t injector_edges;
+    uint32_t ignition_edges;
+    uint32_t other_edges;
+} replay_trace_t;
+
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool output_name(int gpio, char *buf, size_t len) {
+    for (uint8_t i = 0; i < ENGINE_MAX_CYLINDERS; i++) {
+        if (gpio == k_injector_gpios[i]) {
+            snprintf(buf, len, "inj%u", i + 1U);
+            return true;
+        }
+        if (gpio == k_ignition_gpios[i]) {
+            snprintf(buf, len, "ign%u", i + 1U);
+            return true;
+        }
+    }
+    snprintf(buf, len, "gpio%d", gpio);
+    return false;
+}
+
+static void trace_output(int gpio, bool level, uint64_t t_us, void *ctx) {
+    replay_trace_t *tr = ctx;
+    char name[16];
+    if (!output_name(gpio, name, sizeof(name))) {
+        tr->other_edges++;
+    } else if (name[1] == 'n') {
+        tr->injector_edges++;
+    } else {
+        tr->ignition_edges++;
+    }
+    if (tr->trace == NULL) {
+        return;
+    }
+
+    sync_snapshot_t sync = {0};
+    sync_get_snapshot(&sync);
+    uint64_t rel_us = (t_us >= tr->origin_us) ? t_us - tr->origin_us : 0U;
+    float us_per_deg = sync_us_per_degree(&sync);
+    if (sync_snapshot_acquired(&sync) && us_per_deg > 0.0f) {
+        // Extrapolated from the last tooth, like the scheduler does
+        float deg = sync_cycle_angle_deg(&sync) + (float)(int64_t)(t_us - sync.capture_time_us) / us_per_deg;
+        while (deg >= 720.0f) {
+            deg -= 720.0f;
+        }
+        while (deg < 0.0f) {
+            deg += 720.0f;
+        }
+        fprintf(tr->trace, "%" PRIu64 ",%s,%s,%.2f,%" PRIu32 "\n",
+                rel_us, name, level ? "start" : "end", deg, sync.rpm);
+    } else {
+        fprintf(tr->trace, "%" PRIu64 ",%s,%s,,%" PRIu32 "\n",
+                rel_us, name, level ? "start" : "end", sync.rpm);
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s CAPTURE [--trace OUT.csv] [--tail-ms N]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *capture_path = NULL;
+    const char *trace_path = NULL;
+    uint32_t tail_ms = REPLAY_DEFAULT_TAIL_MS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--tail-ms") == 0 && i + 1 < argc) {
+            tail_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && capture_path == NULL) {
+            capture_path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (capture_path == NULL) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    replay_file_t cap;
+    if (!replay_file_read(capture_path, &cap)) {
+        return 1;
+    }
+    const replay_capture_header_t *hdr = &cap.header;
+    if (hdr->records == 0U) {
+        fprintf(stderr, "%s: empty capture\n", capture_path);
+        replay_file_free(&cap);
+        return 1;
+    }
+
+    esp_log_level_set("*", ESP_LOG_WARN);
+    esp_err_t err = config_manager_init();
+    if (err == ESP_OK) {
+        err = engine_control_set_engine_layout(&hdr->layout);
+    }
+    if (err != ESP_OK) {
+        fprintf(stderr, "capture layout rejected: %s\n", esp_err_to_name(err));
+        replay_file_free(&cap);
+        return 1;
+    }
+
+    // The sensor task must start from the recorded readings, not from zeros
+    for (uint32_t i = 0; i < hdr->records; i++) {
+        const replay_record_t *r = &cap.records[i];
+        if (r->type == REPLAY_RECORD_ADC) {
+            for (uint8_t ch = 0; ch < r->count; ch++) {
+                host_sim_adc_set_raw(ch, r->u.adc_raw[ch]);
+            }
+            break;
+        }
+    }
+
+    err = engine_control_init();
+    if (err != ESP_OK) {
+        fprintf(stderr, "engine_control_init failed: %s\n", esp_err_to_name(err));
+        replay_file_free(&cap);
+        return 1;
+    }
+    engine_control_start();
+
+    replay_trace_t tr = {0};
+    if (trace_path != NULL) {
+        tr.trace = fopen(trace_path, "w");
+        if (tr.trace == NULL) {
+            perror(trace_path);
+            replay_file_free(&cap);
+            return 1;
+        }
+        fprintf(tr.trace, "t_us,output,edge,cycle_deg,rpm\n");
+    }
+
+    // Records keep their spacing; only the origin moves to the host clock
+    uint64_t first_us = cap.records[0].time_us;
+    tr.origin_us = host_sim_now_us();
+    host_sim_set_output_hook(trace_output, &tr);
+
+    uint32_t counts[REPLAY_RECORD_CAN + 1] = {0};
+    uint32_t seq_gaps = 0;
+    uint32_t out_of_order = 0;
+    uint64_t last_us = first_us;
+    double wall_start = wall_seconds();
+    for (uint32_t i = 0; i < hdr->records; i++) {
+        const replay_record_t *r = &cap.records[i];
+        if (i > 0U && r->seq != cap.records[i - 1U].seq + 1U) {
+            seq_gaps++;
+        }
+        if (r->time_us < last_us) {
+            // Sources stamp independently; never move the clock backwards
+            out_of_order++;
+        } else {
+            last_us = r->time_us;
+        }
+        host_sim_advance_to(tr.origin_us + (last_us - first_us));
+
+        switch ((replay_record_type_t)r->type) {
+        case REPLAY_RECORD_CKP:
+            host_sim_gpio_edge(hdr->ckp_gpio, true);
+            break;
+        case REPLAY_RECORD_CMP:
+            host_sim_gpio_edge(hdr->cmp_gpio, true);
+            break;
+        case REPLAY_RECORD_ADC:
+            for (uint8_t ch = 0; ch < r->count && ch < REPLAY_ADC_CHANNELS; ch++) {
+                host_sim_adc_set_raw(ch, r->u.adc_raw[ch]);
+            }
+            break;
+        case REPLAY_RECORD_CAN:
+            host_sim_twai_inject(r->u.can.identifier, r->u.can.data, r->count);
+            break;
+        default:
+            continue;
+        }
+        counts[r->type]++;
+    }
+    // Let the outputs armed by the last teeth complete
+    host_sim_advance_to(tr.origin_us + (last_us - first_us) + (uint64_t)tail_ms * 1000ULL);
+    double wall_s = wall_seconds() - wall_start;
+    host_sim_set_output_hook(NULL, NULL);
+    if (tr.trace != NULL) {
+        fclose(tr.trace);
+    }
+
+    sync_data_t sync = {0};
+    sync_get_data(&sync);
+    double virtual_s = (double)(last_us - first_us) / 1e6;
+    printf("ECU replay: %s, %" PRIu32 " records (%" PRIu32 " dropped at capture, %" PRIu32
+           " sequence gaps, %" PRIu32 " out of order)\n",
+           capture_path, hdr->records, hdr->dropped, seq_gaps, out_of_order);
+    printf("inputs: ckp=%" PRIu32 " cmp=%" PRIu32 " adc=%" PRIu32 " can=%" PRIu32 "\n",
+           counts[REPLAY_RECORD_CKP], counts[REPLAY_RECORD_CMP],
+           counts[REPLAY_RECORD_ADC], counts[REPLAY_RECORD_CAN]);
+    printf("layout: %u cylinders, %s\n", hdr->layout.cylinders,
+           hdr->layout.wasted_spark ? "wasted spark" : "coil on plug");
+    printf("outputs: injector edges=%" PRIu32 " ignition edges=%" PRIu32 " other=%" PRIu32 "\n",
+           tr.injector_edges, tr.ignition_edges, tr.other_edges);
+    printf("sync: acquired=%d rpm=%" PRIu32 " losses=%" PRIu32 "\n",
+           sync.sync_acquired, sync.rpm, sync.sync_loss_count);
+    printf("time: %.3f s virtual in %.3f s wall (%.1fx real time)\n",
+           virtual_s, wall_s, wall_s > 0.0 ? virtual_s / wall_s : 0.0);
+    if (trace_path != NULL) {
+        printf("trace: %s\n", trace_path);
+    }
+
+    replay_file_free(&cap);
+    return sync.sync_acquired ? 0 : 1;
+}
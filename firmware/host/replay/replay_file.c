@@ -0,0 +1,70 @@
+/**
+ * @file replay_file.c
+ * @brief Replay capture file I/O for the host tools
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "replay_file.h"
+
+bool replay_file_write(const char *path, const replay_capture_header_t *header,
+                       const replay_record_t *records) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    bool ok = fwrite(header, sizeof(*header), 1, f) == 1;
+    if (ok && header->records > 0U) {
+        ok = fwrite(records, sizeof(replay_record_t), header->records, f) == header->records;
+    }
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: write failed\n", path);
+    }
+    return ok;
+}
+
+bool replay_file_read(const char *path, replay_file_t *out) {
+    memset(out, 0, sizeof(*out));
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    replay_capture_header_t *h = &out->header;
+    if (fread(h, sizeof(*h), 1, f) != 1) {
+        fprintf(stderr, "%s: truncated header\n", path);
+        fclose(f);
+        return false;
+    }
+    if (h->magic != REPLAY_CAPTURE_MAGIC || h->version != REPLAY_CAPTURE_VERSION ||
+        h->record_size != sizeof(replay_record_t)) {
+        fprintf(stderr, "%s: not a version %u capture (magic 0x%08" PRIx32 " version %u record %u bytes)\n",
+                path, REPLAY_CAPTURE_VERSION, h->magic, h->version, h->record_size);
+        fclose(f);
+        return false;
+    }
+    if (h->records > 0U) {
+        out->records = malloc((size_t)h->records * sizeof(replay_record_t));
+        if (out->records == NULL ||
+            fread(out->records, sizeof(replay_record_t), h->records, f) != h->records) {
+            fprintf(stderr, "%s: truncated, %" PRIu32 " records expected\n", path, h->records);
+            fclose(f);
+            replay_file_free(out);
+            return false;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+void replay_file_free(replay_file_t *file) {
+    free(file->records);
+    file->records = NULL;
+}
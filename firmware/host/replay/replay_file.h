@@ -0,0 +1,42 @@
+/**
+ * @file replay_file.h
+ * @brief Reads and writes replay captures (replay_capture.h) as files
+ *
+ * A file is the replay_capture_header_t followed by header.records
+ * replay_record_t, exactly as replay_capture_copy() returns them.
+ */
+
+#ifndef REPLAY_FILE_H
+#define REPLAY_FILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "replay_capture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    replay_capture_header_t header;
+    replay_record_t *records;       ///< header.records entries, malloc'd
+} replay_file_t;
+
+/** @brief Writes a capture; false on I/O error */
+bool replay_file_write(const char *path, const replay_capture_header_t *header,
+                       const replay_record_t *records);
+
+/**
+ * @brief Loads a capture and checks magic, version and record size
+ * @return false with a message on stderr when the file is unusable
+ */
+bool replay_file_read(const char *path, replay_file_t *out);
+
+void replay_file_free(replay_file_t *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REPLAY_FILE_H
@@ -0,0 +1,95 @@
+/**
+ * @file wheel_sim.c
+ * @brief Synthetic crank/cam edge generator for the host simulation
+ */
+
+#include <string.h>
+
+#include "wheel_sim.h"
+
+void wheel_sim_default_config(wheel_sim_config_t *cfg, int ckp_gpio, int cmp_gpio) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->teeth_total = 60;
+    cfg->teeth_missing = 2;
+    cfg->ckp_gpio = ckp_gpio;
+    cfg->cmp_gpio = cmp_gpio;
+    cfg->cam_position = 30;
+}
+
+bool wheel_sim_init(wheel_sim_t *sim, const wheel_sim_config_t *cfg) {
+    if (sim == NULL || cfg == NULL || cfg->profile == NULL || cfg->profile_len == 0 ||
+        cfg->teeth_total < 3 || cfg->teeth_missing >= cfg->teeth_total ||
+        cfg->cam_position >= cfg->teeth_total) {
+        return false;
+    }
+    memset(sim, 0, sizeof(*sim));
+    sim->cfg = *cfg;
+    sim->time_us = (double)cfg->profile[0].at_us;
+    return true;
+}
+
+uint16_t wheel_sim_rpm_at(const wheel_sim_t *sim, uint64_t t_us) {
+    const wheel_rpm_point_t *p = sim->cfg.profile;
+    size_t n = sim->cfg.profile_len;
+    if (t_us <= p[0].at_us) {
+        return p[0].rpm;
+    }
+    for (size_t i = 1; i < n; i++) {
+        if (t_us <= p[i].at_us) {
+            uint64_t span = p[i].at_us - p[i - 1].at_us;
+            if (span == 0) {
+                return p[i].rpm;
+            }
+            double frac = (double)(t_us - p[i - 1].at_us) / (double)span;
+            double rpm = (double)p[i - 1].rpm + frac * ((double)p[i].rpm - (double)p[i - 1].rpm);
+            return (uint16_t)(rpm + 0.5);
+        }
+    }
+    return p[n - 1].rpm;
+}
+
+bool wheel_sim_next(wheel_sim_t *sim, wheel_edge_t *out) {
+    const wheel_sim_config_t *cfg = &sim->cfg;
+    uint8_t real_teeth = (uint8_t)(cfg->teeth_total - cfg->teeth_missing);
+
+    for (;;) {
+        uint16_t rpm = wheel_sim_rpm_at(sim, (uint64_t)sim->time_us);
+        if (rpm == 0) {
+            return false;
+        }
+        double slot_us = 60000000.0 / ((double)rpm * (double)cfg->teeth_total);
+        double next_time = sim->time_us + slot_us;
+
+        if (sim->cam_pending && (double)sim->cam_edge.time_us <= next_time) {
+            sim->cam_pending = false;
+            sim->cam_edges++;
+            *out = sim->cam_edge;
+            return true;
+        }
+
+        sim->time_us = next_time;
+        uint8_t position = sim->position;
+        uint8_t revolution = sim->revolution;
+        if (++sim->position >= cfg->teeth_total) {
+            sim->position = 0;
+            sim->revolution ^= 1U;
+        }
+
+        if (cfg->cmp_gpio >= 0 && revolution == 0 && position == cfg->cam_position) {
+            sim->cam_pending = true;
+            sim->cam_edge.time_us = (uint64_t)(next_time + slot_us * 0.5);
+            sim->cam_edge.gpio = cfg->cmp_gpio;
+            sim->cam_edge.position = position;
+            sim->cam_edge.revolution = revolution;
+        }
+
+        if (position < real_teeth) {
+            out->time_us = (uint64_t)next_time;
+            out->gpio = cfg->ckp_gpio;
+            out->position = position;
+            out->revolution = revolution;
+            sim->crank_edges++;
+            return true;
+        }
+    }
+}
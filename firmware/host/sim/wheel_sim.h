@@ -0,0 +1,73 @@
+/**
+ * @file wheel_sim.h
+ * @brief Synthetic crank (N-M missing tooth) and cam edge generator
+ *
+ * Produces the rising edges a 60-2 crank wheel plus a once-per-cycle cam
+ * pulse would deliver, following a piecewise-linear RPM profile. Edges are
+ * returned in time order and fed to host_sim_gpio_edge() by the caller.
+ */
+
+#ifndef WHEEL_SIM_H
+#define WHEEL_SIM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief One point of the RPM profile; RPM is interpolated linearly between points */
+typedef struct {
+    uint64_t at_us;
+    uint16_t rpm;
+} wheel_rpm_point_t;
+
+typedef struct {
+    uint8_t teeth_total;            ///< Tooth positions per revolution, including missing (60)
+    uint8_t teeth_missing;          ///< Missing teeth at the end of the revolution (2)
+    int ckp_gpio;
+    int cmp_gpio;                   ///< Negative to disable the cam signal
+    uint8_t cam_position;           ///< Crank position (first revolution of the cycle) of the cam edge
+    const wheel_rpm_point_t *profile;
+    size_t profile_len;
+} wheel_sim_config_t;
+
+typedef struct {
+    uint64_t time_us;
+    int gpio;
+    uint8_t position;               ///< Crank position 0..teeth_total-1
+    uint8_t revolution;             ///< 0 or 1 within the 720 degree cycle
+} wheel_edge_t;
+
+typedef struct {
+    wheel_sim_config_t cfg;
+    double time_us;
+    uint8_t position;
+    uint8_t revolution;
+    bool cam_pending;
+    wheel_edge_t cam_edge;
+    uint32_t crank_edges;
+    uint32_t cam_edges;
+} wheel_sim_t;
+
+/** @brief Default 60-2 wheel, cam edge at crank position 30 of the first revolution */
+void wheel_sim_default_config(wheel_sim_config_t *cfg, int ckp_gpio, int cmp_gpio);
+
+bool wheel_sim_init(wheel_sim_t *sim, const wheel_sim_config_t *cfg);
+
+/** @brief RPM of the profile at @p t_us (held constant after the last point) */
+uint16_t wheel_sim_rpm_at(const wheel_sim_t *sim, uint64_t t_us);
+
+/**
+ * @brief Produces the next edge in time order
+ * @return false when the profile RPM reaches zero (engine stopped)
+ */
+bool wheel_sim_next(wheel_sim_t *sim, wheel_edge_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WHEEL_SIM_H
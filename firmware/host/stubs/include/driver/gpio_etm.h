@@ -0,0 +1,32 @@
+/**
+ * @file gpio_etm.h
+ * @brief Host stub of the GPIO ETM event source
+ */
+
+#ifndef HOST_DRIVER_GPIO_ETM_H
+#define HOST_DRIVER_GPIO_ETM_H
+
+#include "esp_etm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    GPIO_ETM_EVENT_EDGE_POS = 0,
+    GPIO_ETM_EVENT_EDGE_NEG,
+    GPIO_ETM_EVENT_EDGE_ANY,
+} gpio_etm_event_edge_t;
+
+typedef struct {
+    gpio_etm_event_edge_t edge;
+} gpio_etm_event_config_t;
+
+esp_err_t gpio_new_etm_event(const gpio_etm_event_config_t *config, esp_etm_event_handle_t *ret_event);
+esp_err_t gpio_etm_event_bind_gpio(esp_etm_event_handle_t event, int gpio_num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_DRIVER_GPIO_ETM_H
@@ -0,0 +1,57 @@
+/**
+ * @file gptimer.h
+ * @brief Host stub of the general purpose timer driver (virtual clock based)
+ */
+
+#ifndef HOST_DRIVER_GPTIMER_H
+#define HOST_DRIVER_GPTIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct host_gptimer *gptimer_handle_t;
+
+typedef enum {
+    GPTIMER_CLK_SRC_DEFAULT = 0,
+    GPTIMER_CLK_SRC_APB,
+    GPTIMER_CLK_SRC_XTAL,
+} gptimer_clock_source_t;
+
+typedef enum {
+    GPTIMER_COUNT_DOWN = 0,
+    GPTIMER_COUNT_UP,
+} gptimer_count_direction_t;
+
+typedef struct {
+    gptimer_clock_source_t clk_src;
+    gptimer_count_direction_t direction;
+    uint32_t resolution_hz;
+    int intr_priority;
+    struct {
+        uint32_t intr_shared : 1;
+        uint32_t allow_pd : 1;
+        uint32_t backup_before_sleep : 1;
+    } flags;
+} gptimer_config_t;
+
+esp_err_t gptimer_new_timer(const gptimer_config_t *config, gptimer_handle_t *ret_timer);
+esp_err_t gptimer_del_timer(gptimer_handle_t timer);
+esp_err_t gptimer_enable(gptimer_handle_t timer);
+esp_err_t gptimer_disable(gptimer_handle_t timer);
+esp_err_t gptimer_start(gptimer_handle_t timer);
+esp_err_t gptimer_stop(gptimer_handle_t timer);
+esp_err_t gptimer_set_raw_count(gptimer_handle_t timer, uint64_t value);
+esp_err_t gptimer_get_raw_count(gptimer_handle_t timer, uint64_t *value);
+esp_err_t gptimer_get_captured_count(gptimer_handle_t timer, uint64_t *value);
+esp_err_t gptimer_get_resolution(gptimer_handle_t timer, uint32_t *out_resolution);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_DRIVER_GPTIMER_H
@@ -0,0 +1,35 @@
+/**
+ * @file gptimer_etm.h
+ * @brief Host stub of the GPTimer ETM tasks
+ */
+
+#ifndef HOST_DRIVER_GPTIMER_ETM_H
+#define HOST_DRIVER_GPTIMER_ETM_H
+
+#include "esp_etm.h"
+#include "driver/gptimer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    GPTIMER_ETM_TASK_START_COUNT = 0,
+    GPTIMER_ETM_TASK_STOP_COUNT,
+    GPTIMER_ETM_TASK_EN_ALARM,
+    GPTIMER_ETM_TASK_RELOAD,
+    GPTIMER_ETM_TASK_CAPTURE,
+} gptimer_etm_task_type_t;
+
+typedef struct {
+    gptimer_etm_task_type_t task_type;
+} gptimer_etm_task_config_t;
+
+esp_err_t gptimer_new_etm_task(gptimer_handle_t timer, const gptimer_etm_task_config_t *config,
+                               esp_etm_task_handle_t *out_task);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_DRIVER_GPTIMER_ETM_H
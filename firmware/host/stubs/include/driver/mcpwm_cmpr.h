@@ -0,0 +1,51 @@
+/**
+ * @file mcpwm_cmpr.h
+ * @brief Host stub of the MCPWM comparator driver (writes are counted,
+ *        on_reach runs when the counter reaches the compare value)
+ */
+
+#ifndef HOST_DRIVER_MCPWM_CMPR_H
+#define HOST_DRIVER_MCPWM_CMPR_H
+
+#include "driver/mcpwm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int intr_priority;
+    struct {
+        uint32_t update_cmp_on_tez : 1;
+        uint32_t update_cmp_on_tep : 1;
+        uint32_t update_cmp_on_sync : 1;
+    } flags;
+} mcpwm_comparator_config_t;
+
+esp_err_t mcpwm_new_comparator(mcpwm_oper_handle_t oper, const mcpwm_comparator_config_t *config,
+                               mcpwm_cmpr_handle_t *ret_cmpr);
+esp_err_t mcpwm_del_comparator(mcpwm_cmpr_handle_t cmpr);
+esp_err_t mcpwm_comparator_set_compare_value(mcpwm_cmpr_handle_t cmpr, uint32_t cmp_ticks);
+
+typedef struct {
+    uint32_t compare_ticks;
+    mcpwm_timer_direction_t direction;
+} mcpwm_compare_event_data_t;
+
+typedef bool (*mcpwm_compare_event_cb_t)(mcpwm_cmpr_handle_t comparator,
+                                         const mcpwm_compare_event_data_t *edata,
+                                         void *user_ctx);
+
+typedef struct {
+    mcpwm_compare_event_cb_t on_reach;
+} mcpwm_comparator_event_callbacks_t;
+
+esp_err_t mcpwm_comparator_register_event_callbacks(mcpwm_cmpr_handle_t cmpr,
+                                                    const mcpwm_comparator_event_callbacks_t *cbs,
+                                                    void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_DRIVER_MCPWM_CMPR_H
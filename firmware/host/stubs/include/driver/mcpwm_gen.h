@@ -0,0 +1,60 @@
+/**
+ * @file mcpwm_gen.h
+ * @brief Host stub of the MCPWM generator driver
+ */
+
+#ifndef HOST_DRIVER_MCPWM_GEN_H
+#define HOST_DRIVER_MCPWM_GEN_H
+
+#include "driver/mcpwm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int gen_gpio_num;
+    struct {
+        uint32_t invert_pwm : 1;
+        uint32_t io_loop_back : 1;
+        uint32_t io_od_mode : 1;
+        uint32_t pull_up : 1;
+        uint32_t pull_down : 1;
+    } flags;
+} mcpwm_generator_config_t;
+
+typedef struct {
+    mcpwm_timer_direction_t direction;
+    mcpwm_timer_event_t event;
+    mcpwm_generator_action_t action;
+} mcpwm_gen_timer_event_action_t;
+
+typedef struct {
+    mcpwm_timer_direction_t direction;
+    mcpwm_cmpr_handle_t comparator;
+    mcpwm_generator_action_t action;
+} mcpwm_gen_compare_event_action_t;
+
+#define MCPWM_GEN_TIMER_EVENT_ACTION(dir, ev, act) \
+    (mcpwm_gen_timer_event_action_t) { .direction = dir, .event = ev, .action = act }
+#define MCPWM_GEN_TIMER_EVENT_ACTION_END() \
+    (mcpwm_gen_timer_event_action_t) { .event = MCPWM_TIMER_EVENT_INVALID }
+#define MCPWM_GEN_COMPARE_EVENT_ACTION(dir, cmp, act) \
+    (mcpwm_gen_compare_event_action_t) { .direction = dir, .comparator = cmp, .action = act }
+#define MCPWM_GEN_COMPARE_EVENT_ACTION_END() \
+    (mcpwm_gen_compare_event_action_t) { .comparator = NULL }
+
+esp_err_t mcpwm_new_generator(mcpwm_oper_handle_t oper, const mcpwm_generator_config_t *config,
+                              mcpwm_gen_handle_t *ret_gen);
+esp_err_t mcpwm_del_generator(mcpwm_gen_handle_t gen);
+esp_err_t mcpwm_generator_set_force_level(mcpwm_gen_handle_t gen, int level, bool hold_on);
+esp_err_t mcpwm_generator_set_action_on_timer_event(mcpwm_gen_handle_t gen, mcpwm_gen_timer_event_action_t ev_act);
+esp_err_t mcpwm_generator_set_actions_on_timer_event(mcpwm_gen_handle_t gen, mcpwm_gen_timer_event_action_t ev_act, ...);
+esp_err_t mcpwm_generator_set_action_on_compare_event(mcpwm_gen_handle_t gen, mcpwm_gen_compare_event_action_t ev_act);
+esp_err_t mcpwm_generator_set_actions_on_compare_event(mcpwm_gen_handle_t gen, mcpwm_gen_compare_event_action_t ev_act, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_DRIVER_MCPWM_GEN_H
@@ -0,0 +1,36 @@
+/**
+ * @file mcpwm_oper.h
+ * @brief Host stub of the MCPWM operator driver
+ */
+
+#ifndef HOST_DRIVER_MCPWM_OPER_H
+#define HOST_DRIVER_MCPWM_OPER_H
+
+#include "driver/mcpwm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int group_id;
+    int intr_priority;
+    struct {
+        uint32_t update_gen_action_on_tez : 1;
+        uint32_t update_gen_action_on_tep : 1;
+        uint32_t update_gen_action_on_sync : 1;
+        uint32_t update_dead_time_on_tez : 1;
+        uint32_t update_dead_time_on_tep : 1;
+        uint32_t update_dead_time_on_sync : 1;
+    } flags;
+} mcpwm_operator_config_t;
+
+esp_err_t mcpwm_new_operator(const mcpwm_operator_config_t *config, mcpwm_oper_handle_t *ret_oper);
+esp_err_t mcpwm_del_operator(mcpwm_oper_handle_t oper);
+esp_err_t mcpwm_operator_connect_timer(mcpwm_oper_handle_t oper, mcpwm_timer_handle_t timer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_DRIVER_MCPWM_OPER_H
@@ -0,0 +1,42 @@
+/**
+ * @file mcpwm_timer.h
+ * @brief Host stub of the MCPWM timer driver (counts on the virtual clock)
+ */
+
+#ifndef HOST_DRIVER_MCPWM_TIMER_H
+#define HOST_DRIVER_MCPWM_TIMER_H
+
+#include "driver/mcpwm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int group_id;
+    mcpwm_timer_clock_source_t clk_src;
+    uint32_t resolution_hz;
+    mcpwm_timer_count_mode_t count_mode;
+    uint32_t period_ticks;
+    int intr_priority;
+    struct {
+        uint32_t update_period_on_empty : 1;
+        uint32_t update_period_on_sync : 1;
+        uint32_t allow_pd : 1;
+    } flags;
+} mcpwm_timer_config_t;
+
+esp_err_t mcpwm_new_timer(const mcpwm_timer_config_t *config, mcpwm_timer_handle_t *ret_timer);
+esp_err_t mcpwm_del_timer(mcpwm_timer_handle_t timer);
+esp_err_t mcpwm_timer_enable(mcpwm_timer_handle_t timer);
+esp_err_t mcpwm_timer_disable(mcpwm_timer_handle_t timer);
+esp_err_t mcpwm_timer_start_stop(mcpwm_timer_handle_t timer, mcpwm_timer_start_stop_cmd_t command);
+esp_err_t mcpwm_timer_set_period(mcpwm_timer_handle_t timer, uint32_t period_ticks);
+esp_err_t mcpwm_timer_get_phase(mcpwm_timer_handle_t timer, uint32_t *count_value,
+                                mcpwm_timer_direction_t *direction);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_DRIVER_MCPWM_TIMER_H
@@ -0,0 +1,64 @@
+/**
+ * @file mcpwm_types.h
+ * @brief Host stub of the MCPWM handle and event types
+ */
+
+#ifndef HOST_DRIVER_MCPWM_TYPES_H
+#define HOST_DRIVER_MCPWM_TYPES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct host_mcpwm_timer *mcpwm_timer_handle_t;
+typedef struct host_mcpwm_oper *mcpwm_oper_handle_t;
+typedef struct host_mcpwm_cmpr *mcpwm_cmpr_handle_t;
+typedef struct host_mcpwm_gen *mcpwm_gen_handle_t;
+
+typedef enum {
+    MCPWM_TIMER_CLK_SRC_DEFAULT = 0,
+    MCPWM_TIMER_CLK_SRC_PLL160M,
+} mcpwm_timer_clock_source_t;
+
+typedef enum {
+    MCPWM_TIMER_DIRECTION_UP = 0,
+    MCPWM_TIMER_DIRECTION_DOWN,
+} mcpwm_timer_direction_t;
+
+typedef enum {
+    MCPWM_TIMER_EVENT_EMPTY = 0,
+    MCPWM_TIMER_EVENT_FULL,
+    MCPWM_TIMER_EVENT_INVALID,
+} mcpwm_timer_event_t;
+
+typedef enum {
+    MCPWM_TIMER_COUNT_MODE_PAUSE = 0,
+    MCPWM_TIMER_COUNT_MODE_UP,
+    MCPWM_TIMER_COUNT_MODE_DOWN,
+    MCPWM_TIMER_COUNT_MODE_UP_DOWN,
+} mcpwm_timer_count_mode_t;
+
+typedef enum {
+    MCPWM_TIMER_STOP_EMPTY = 0,
+    MCPWM_TIMER_STOP_FULL,
+    MCPWM_TIMER_START_NO_STOP,
+    MCPWM_TIMER_START_STOP_EMPTY,
+    MCPWM_TIMER_START_STOP_FULL,
+} mcpwm_timer_start_stop_cmd_t;
+
+typedef enum {
+    MCPWM_GEN_ACTION_KEEP = 0,
+    MCPWM_GEN_ACTION_LOW,
+    MCPWM_GEN_ACTION_HIGH,
+    MCPWM_GEN_ACTION_TOGGLE,
+} mcpwm_generator_action_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_DRIVER_MCPWM_TYPES_H
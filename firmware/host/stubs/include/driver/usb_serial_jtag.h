@@ -0,0 +1,36 @@
+/**
+ * @file usb_serial_jtag.h
+ * @brief Host stub of the USB serial/JTAG driver: output to stdout, no input
+ */
+
+#ifndef HOST_DRIVER_USB_SERIAL_JTAG_H
+#define HOST_DRIVER_USB_SERIAL_JTAG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t tx_buffer_size;
+    uint32_t rx_buffer_size;
+} usb_serial_jtag_driver_config_t;
+
+#define USB_SERIAL_JTAG_DRIVER_CONFIG_DEFAULT() \
+    { .tx_buffer_size = 256, .rx_buffer_size = 256 }
+
+esp_err_t usb_serial_jtag_driver_install(usb_serial_jtag_driver_config_t *usb_serial_jtag_config);
+esp_err_t usb_serial_jtag_driver_uninstall(void);
+// Nothing is ever received: waits ticks_to_wait and returns 0
+int usb_serial_jtag_read_bytes(void *buf, uint32_t length, TickType_t ticks_to_wait);
+int usb_serial_jtag_write_bytes(const void *src, size_t size, TickType_t ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_DRIVER_USB_SERIAL_JTAG_H
@@ -0,0 +1,16 @@
+/**
+ * @file esp_attr.h
+ * @brief Host stub: memory placement attributes are no-ops on Linux
+ */
+
+#ifndef HOST_ESP_ATTR_H
+#define HOST_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define NOINIT_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+
+#endif // HOST_ESP_ATTR_H
@@ -0,0 +1,31 @@
+/**
+ * @file esp_cpu.h
+ * @brief Host stub: CPU cycle counter derived from the virtual clock
+ */
+
+#ifndef HOST_ESP_CPU_H
+#define HOST_ESP_CPU_H
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+static inline esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void) {
+    return (esp_cpu_cycle_count_t)((uint64_t)esp_timer_get_time() * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+}
+
+// Core of the running task, or of the running ISR's allocation; the driver
+// thread counts as core 0 (app_main). Implemented in host_rtos.c.
+int esp_cpu_get_core_id(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_CPU_H
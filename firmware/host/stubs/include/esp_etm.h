@@ -0,0 +1,38 @@
+/**
+ * @file esp_etm.h
+ * @brief Host stub of the Event Task Matrix (event -> task routing)
+ */
+
+#ifndef HOST_ESP_ETM_H
+#define HOST_ESP_ETM_H
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct host_etm_channel *esp_etm_channel_handle_t;
+typedef struct host_etm_event *esp_etm_event_handle_t;
+typedef struct host_etm_task *esp_etm_task_handle_t;
+
+typedef struct {
+    struct {
+        unsigned int allow_pd : 1;
+    } flags;
+} esp_etm_channel_config_t;
+
+esp_err_t esp_etm_new_channel(const esp_etm_channel_config_t *config, esp_etm_channel_handle_t *ret_chan);
+esp_err_t esp_etm_del_channel(esp_etm_channel_handle_t chan);
+esp_err_t esp_etm_channel_enable(esp_etm_channel_handle_t chan);
+esp_err_t esp_etm_channel_disable(esp_etm_channel_handle_t chan);
+esp_err_t esp_etm_channel_connect(esp_etm_channel_handle_t chan, esp_etm_event_handle_t event,
+                                  esp_etm_task_handle_t task);
+esp_err_t esp_etm_del_event(esp_etm_event_handle_t event);
+esp_err_t esp_etm_del_task(esp_etm_task_handle_t task);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_ETM_H
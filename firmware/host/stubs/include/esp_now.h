@@ -0,0 +1,21 @@
+/**
+ * @file esp_now.h
+ * @brief Host stub: only the types referenced by espnow_link.h
+ */
+
+#ifndef HOST_ESP_NOW_H
+#define HOST_ESP_NOW_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define ESP_NOW_ETH_ALEN 6
+#define ESP_NOW_KEY_LEN 16
+#define ESP_NOW_MAX_DATA_LEN 250
+
+typedef enum {
+    ESP_NOW_SEND_SUCCESS = 0,
+    ESP_NOW_SEND_FAIL,
+} esp_now_send_status_t;
+
+#endif // HOST_ESP_NOW_H
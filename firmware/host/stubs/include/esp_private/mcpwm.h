@@ -0,0 +1,11 @@
+/**
+ * @file mcpwm.h
+ * @brief Host stub of the private MCPWM helpers (nothing used on the host)
+ */
+
+#ifndef HOST_ESP_PRIVATE_MCPWM_H
+#define HOST_ESP_PRIVATE_MCPWM_H
+
+#include "driver/mcpwm_types.h"
+
+#endif // HOST_ESP_PRIVATE_MCPWM_H
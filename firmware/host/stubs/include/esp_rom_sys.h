@@ -0,0 +1,21 @@
+/**
+ * @file esp_rom_sys.h
+ * @brief Host stub of the ROM system helpers
+ */
+
+#ifndef HOST_ESP_ROM_SYS_H
+#define HOST_ESP_ROM_SYS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void esp_rom_delay_us(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_ROM_SYS_H
@@ -0,0 +1,26 @@
+/**
+ * @file esp_system.h
+ * @brief Host stub of the ESP-IDF system API
+ */
+
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+void esp_restart(void) __attribute__((noreturn));
+const char *esp_get_idf_version(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_SYSTEM_H
@@ -0,0 +1,33 @@
+/**
+ * @file esp_task_wdt.h
+ * @brief Host stub of the task watchdog (feeds are counted, never fires)
+ */
+
+#ifndef HOST_ESP_TASK_WDT_H
+#define HOST_ESP_TASK_WDT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t timeout_ms;
+    uint32_t idle_core_mask;
+    bool trigger_panic;
+} esp_task_wdt_config_t;
+
+typedef struct esp_task_wdt_user_handle_s *esp_task_wdt_user_handle_t;
+
+esp_err_t esp_task_wdt_init(const esp_task_wdt_config_t *config);
+esp_err_t esp_task_wdt_add_user(const char *user_name, esp_task_wdt_user_handle_t *user_handle_ret);
+esp_err_t esp_task_wdt_reset_user(esp_task_wdt_user_handle_t user_handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_TASK_WDT_H
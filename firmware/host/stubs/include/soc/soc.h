@@ -0,0 +1,9 @@
+/**
+ * @file soc.h
+ * @brief Host stub (no register map on Linux)
+ */
+
+#ifndef HOST_SOC_SOC_H
+#define HOST_SOC_SOC_H
+
+#endif // HOST_SOC_SOC_H
@@ -0,0 +1,20 @@
+/**
+ * @file soc_caps.h
+ * @brief Host stub mirroring the ESP32-S3 capabilities used by the firmware
+ */
+
+#ifndef HOST_SOC_SOC_CAPS_H
+#define HOST_SOC_SOC_CAPS_H
+
+#define SOC_MCPWM_GROUPS                2
+#define SOC_MCPWM_TIMERS_PER_GROUP      3
+#define SOC_MCPWM_OPERATORS_PER_GROUP   3
+#define SOC_MCPWM_COMPARATORS_PER_OPERATOR 2
+#define SOC_MCPWM_GENERATORS_PER_OPERATOR  2
+#define SOC_GPTIMER_SUPPORT_ETM         1
+#define SOC_ETM_SUPPORTED               1
+#define SOC_PCNT_UNITS_PER_GROUP        4
+#define SOC_ADC_DIGI_RESULT_BYTES       4
+#define SOC_CPU_CORES_NUM               2
+
+#endif // HOST_SOC_SOC_CAPS_H
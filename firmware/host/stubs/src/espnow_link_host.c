@@ -0,0 +1,135 @@
+/**
+ * @file espnow_link_host.c
+ * @brief Host replacement for espnow_link.c
+ *
+ * There is no radio on the host. The link always initializes and starts so
+ * the monitor task exercises its telemetry path; sent messages are counted
+ * per type and otherwise dropped.
+ */
+
+#include <string.h>
+
+#include "espnow_link.h"
+#include "host_sim.h"
+
+static bool g_initialized = false;
+static bool g_started = false;
+static uint32_t g_tx_count = 0;
+static uint32_t g_sent_by_type[256];
+static espnow_rx_callback_t g_rx_cb = NULL;
+static void *g_rx_ctx = NULL;
+
+static esp_err_t host_espnow_send(uint8_t msg_type, const void *payload) {
+    if (!g_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (payload == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    g_sent_by_type[msg_type]++;
+    g_tx_count++;
+    return ESP_OK;
+}
+
+esp_err_t espnow_link_init(void) {
+    if (g_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    memset(g_sent_by_type, 0, sizeof(g_sent_by_type));
+    g_tx_count = 0;
+    g_initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t espnow_link_deinit(void) {
+    if (!g_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_started = false;
+    g_initialized = false;
+    return ESP_OK;
+}
+
+esp_err_t espnow_link_start(void) {
+    if (!g_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_started = true;
+    return ESP_OK;
+}
+
+esp_err_t espnow_link_stop(void) {
+    if (!g_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_started = false;
+    return ESP_OK;
+}
+
+esp_err_t espnow_link_add_peer(const uint8_t *peer_mac, bool encrypt, const uint8_t *lmk) {
+    (void)encrypt;
+    (void)lmk;
+    return (peer_mac != NULL) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t espnow_link_remove_peer(const uint8_t *peer_mac) {
+    return (peer_mac != NULL) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t espnow_link_register_rx_callback(espnow_rx_callback_t callback, void *ctx) {
+    g_rx_cb = callback;
+    g_rx_ctx = ctx;
+    return ESP_OK;
+}
+
+esp_err_t espnow_link_send_engine_status(const espnow_engine_status_t *status) {
+    return host_espnow_send(ESPNOW_MSG_ENGINE_STATUS, status);
+}
+
+esp_err_t espnow_link_send_sensor_data(const espnow_sensor_data_t *data) {
+    return host_espnow_send(ESPNOW_MSG_SENSOR_DATA, data);
+}
+
+esp_err_t espnow_link_send_diagnostic(const espnow_diagnostic_t *diag) {
+    return host_espnow_send(ESPNOW_MSG_DIAGNOSTIC, diag);
+}
+
+esp_err_t espnow_link_send_perf_stats(const espnow_perf_stats_t *stats) {
+    return host_espnow_send(ESPNOW_MSG_PERF_STATS, stats);
+}
+
+esp_err_t espnow_link_send_task_profile(const espnow_task_profile_t *profile) {
+    return host_espnow_send(ESPNOW_MSG_TASK_PROFILE, profile);
+}
+
+esp_err_t espnow_link_send_config_response(const uint8_t *peer_mac,
+                                            const espnow_config_response_t *response) {
+    if (peer_mac == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return host_espnow_send(ESPNOW_MSG_CONFIG_RESPONSE, response);
+}
+
+void espnow_link_get_stats(uint32_t *tx_count, uint32_t *rx_count,
+                           uint32_t *tx_errors, uint32_t *rx_errors) {
+    if (tx_count) *tx_count = g_tx_count;
+    if (rx_count) *rx_count = 0;
+    if (tx_errors) *tx_errors = 0;
+    if (rx_errors) *rx_errors = 0;
+}
+
+bool espnow_link_is_initialized(void) {
+    return g_initialized;
+}
+
+bool espnow_link_is_started(void) {
+    return g_started;
+}
+
+uint8_t espnow_link_get_peer_count(void) {
+    return 0;
+}
+
+uint32_t host_sim_espnow_sent(uint8_t msg_type) {
+    return g_sent_by_type[msg_type];
+}
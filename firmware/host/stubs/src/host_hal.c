@@ -0,0 +1,1405 @@
+/**
+ * @file host_hal.c
+ * @brief Simulated peripherals for the host build
+ *
+ * GPTimer, MCPWM and PCNT state is derived from the virtual clock. Edges
+ * injected with host_sim_gpio_edge() follow the hardware routing used by
+ * sync.c: ETM capture into the bound GPTimer, PCNT count and watch
+ * callback, then the GPIO ISR handler. MCPWM generators drive their pins
+ * the same way when a compare or timer event changes their level; the
+ * per-group timer, operator, comparator and generator counts of the S3 are
+ * enforced.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "driver/gpio_etm.h"
+#include "driver/gptimer.h"
+#include "driver/gptimer_etm.h"
+#include "driver/pulse_cnt.h"
+#include "driver/mcpwm_timer.h"
+#include "driver/mcpwm_oper.h"
+#include "driver/mcpwm_cmpr.h"
+#include "driver/mcpwm_gen.h"
+#include "driver/twai.h"
+#include "driver/usb_serial_jtag.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_cpu.h"
+#include "esp_etm.h"
+#include "soc/soc_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "host_sim.h"
+#include "host_internal.h"
+
+#define HOST_MAX_ETM_CHANNELS   16
+#define HOST_MAX_GPIO_ETM_EVENTS 8     // GPIO ETM event channels on the S3
+#define HOST_MAX_MCPWM_GENS     (SOC_MCPWM_GROUPS * SOC_MCPWM_OPERATORS_PER_GROUP * SOC_MCPWM_GENERATORS_PER_OPERATOR)
+#define HOST_MAX_MCPWM_CMPRS    (SOC_MCPWM_GROUPS * SOC_MCPWM_OPERATORS_PER_GROUP * SOC_MCPWM_COMPARATORS_PER_OPERATOR)
+#define HOST_GEN_CMP_ACTIONS    4
+#define HOST_MAX_PCNT_UNITS     4
+#define HOST_MAX_PCNT_CHANNELS  8
+#define HOST_MAX_WATCH_POINTS   4
+#define HOST_ADC_CHANNELS       10
+#define HOST_TWAI_RX_LEN        32
+
+//=============================================================================
+// GPIO
+//=============================================================================
+
+typedef struct {
+    gpio_isr_t handler;
+    void *arg;
+    gpio_int_type_t intr_type;
+    uint32_t level;
+} host_gpio_t;
+
+static host_gpio_t g_gpio[GPIO_NUM_MAX];
+static bool g_gpio_isr_service = false;
+// Interrupts run on the core that allocated them (see host_rtos_isr_enter)
+static int g_gpio_isr_core = 0;
+
+esp_err_t gpio_config(const gpio_config_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < GPIO_NUM_MAX; i++) {
+        if (config->pin_bit_mask & (1ULL << i)) {
+            g_gpio[i].intr_type = config->intr_type;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags) {
+    (void)intr_alloc_flags;
+    if (g_gpio_isr_service) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_gpio_isr_service = true;
+    g_gpio_isr_core = esp_cpu_get_core_id();
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args) {
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!g_gpio_isr_service) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_gpio[gpio_num].handler = isr_handler;
+    g_gpio[gpio_num].arg = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num) {
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    g_gpio[gpio_num].handler = NULL;
+    g_gpio[gpio_num].arg = NULL;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    g_gpio[gpio_num].level = level ? 1U : 0U;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    g_gpio[gpio_num].intr_type = intr_type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_intr_enable(gpio_num_t gpio_num) {
+    return (gpio_num >= 0 && gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_intr_disable(gpio_num_t gpio_num) {
+    return (gpio_num >= 0 && gpio_num < GPIO_NUM_MAX) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return 0;
+    }
+    return (int)g_gpio[gpio_num].level;
+}
+
+//=============================================================================
+// GPTimer
+//=============================================================================
+
+struct host_gptimer {
+    uint32_t resolution_hz;
+    bool enabled;
+    bool running;
+    uint64_t base_count;
+    uint64_t start_us;
+    uint64_t captured;
+};
+
+static uint64_t gptimer_count_now(const struct host_gptimer *t) {
+    if (!t->running) {
+        return t->base_count;
+    }
+    uint64_t elapsed_us = host_rtos_now_us() - t->start_us;
+    return t->base_count + (elapsed_us * t->resolution_hz) / 1000000ULL;
+}
+
+esp_err_t gptimer_new_timer(const gptimer_config_t *config, gptimer_handle_t *ret_timer) {
+    if (config == NULL || ret_timer == NULL || config->resolution_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct host_gptimer *t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    t->resolution_hz = config->resolution_hz;
+    *ret_timer = t;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_del_timer(gptimer_handle_t timer) {
+    free(timer);
+    return ESP_OK;
+}
+
+esp_err_t gptimer_enable(gptimer_handle_t timer) {
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    timer->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_disable(gptimer_handle_t timer) {
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    timer->enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_start(gptimer_handle_t timer) {
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!timer->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!timer->running) {
+        timer->start_us = host_rtos_now_us();
+        timer->running = true;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gptimer_stop(gptimer_handle_t timer) {
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    timer->base_count = gptimer_count_now(timer);
+    timer->running = false;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_set_raw_count(gptimer_handle_t timer, uint64_t value) {
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    timer->base_count = value;
+    timer->start_us = host_rtos_now_us();
+    return ESP_OK;
+}
+
+esp_err_t gptimer_get_raw_count(gptimer_handle_t timer, uint64_t *value) {
+    if (timer == NULL || value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *value = gptimer_count_now(timer);
+    return ESP_OK;
+}
+
+esp_err_t gptimer_get_captured_count(gptimer_handle_t timer, uint64_t *value) {
+    if (timer == NULL || value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *value = timer->captured;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_get_resolution(gptimer_handle_t timer, uint32_t *out_resolution) {
+    if (timer == NULL || out_resolution == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_resolution = timer->resolution_hz;
+    return ESP_OK;
+}
+
+//=============================================================================
+// ETM (GPIO event -> GPTimer capture task)
+//=============================================================================
+
+struct host_etm_event {
+    int gpio;
+    gpio_etm_event_edge_t edge;
+};
+
+struct host_etm_task {
+    gptimer_handle_t timer;
+    gptimer_etm_task_type_t type;
+};
+
+struct host_etm_channel {
+    struct host_etm_event *event;
+    struct host_etm_task *task;
+    bool enabled;
+};
+
+static struct host_etm_channel *g_etm_channels[HOST_MAX_ETM_CHANNELS];
+static int g_gpio_etm_events = 0;
+
+esp_err_t gpio_new_etm_event(const gpio_etm_event_config_t *config, esp_etm_event_handle_t *ret_event) {
+    if (config == NULL || ret_event == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_gpio_etm_events >= HOST_MAX_GPIO_ETM_EVENTS) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    struct host_etm_event *e = calloc(1, sizeof(*e));
+    if (e == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    g_gpio_etm_events++;
+    e->gpio = -1;
+    e->edge = config->edge;
+    *ret_event = e;
+    return ESP_OK;
+}
+
+esp_err_t gpio_etm_event_bind_gpio(esp_etm_event_handle_t event, int gpio_num) {
+    if (event == NULL || gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    event->gpio = gpio_num;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_new_etm_task(gptimer_handle_t timer, const gptimer_etm_task_config_t *config,
+                               esp_etm_task_handle_t *out_task) {
+    if (timer == NULL || config == NULL || out_task == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct host_etm_task *t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    t->timer = timer;
+    t->type = config->task_type;
+    *out_task = t;
+    return ESP_OK;
+}
+
+esp_err_t esp_etm_new_channel(const esp_etm_channel_config_t *config, esp_etm_channel_handle_t *ret_chan) {
+    (void)config;
+    if (ret_chan == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < HOST_MAX_ETM_CHANNELS; i++) {
+        if (g_etm_channels[i] == NULL) {
+            struct host_etm_channel *c = calloc(1, sizeof(*c));
+            if (c == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
+            g_etm_channels[i] = c;
+            *ret_chan = c;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_etm_del_channel(esp_etm_channel_handle_t chan) {
+    for (int i = 0; i < HOST_MAX_ETM_CHANNELS; i++) {
+        if (g_etm_channels[i] == chan) {
+            g_etm_channels[i] = NULL;
+        }
+    }
+    free(chan);
+    return ESP_OK;
+}
+
+esp_err_t esp_etm_channel_enable(esp_etm_channel_handle_t chan) {
+    if (chan == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    chan->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_etm_channel_disable(esp_etm_channel_handle_t chan) {
+    if (chan == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    chan->enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_etm_channel_connect(esp_etm_channel_handle_t chan, esp_etm_event_handle_t event,
+                                  esp_etm_task_handle_t task) {
+    if (chan == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    chan->event = event;
+    chan->task = task;
+    return ESP_OK;
+}
+
+esp_err_t esp_etm_del_event(esp_etm_event_handle_t event) {
+    if (event != NULL) {
+        g_gpio_etm_events--;
+    }
+    free(event);
+    return ESP_OK;
+}
+
+esp_err_t esp_etm_del_task(esp_etm_task_handle_t task) {
+    free(task);
+    return ESP_OK;
+}
+
+//=============================================================================
+// PCNT
+//=============================================================================
+
+struct host_pcnt_unit {
+    int low_limit;
+    int high_limit;
+    int count;
+    bool enabled;
+    bool running;
+    int watch_points[HOST_MAX_WATCH_POINTS];
+    int watch_count;
+    pcnt_watch_cb_t on_reach;
+    void *user_ctx;
+    int isr_core;
+};
+
+struct host_pcnt_channel {
+    struct host_pcnt_unit *unit;
+    int edge_gpio;
+    pcnt_channel_edge_action_t pos_act;
+    pcnt_channel_edge_action_t neg_act;
+};
+
+static struct host_pcnt_unit *g_pcnt_units[HOST_MAX_PCNT_UNITS];
+static struct host_pcnt_channel *g_pcnt_channels[HOST_MAX_PCNT_CHANNELS];
+
+esp_err_t pcnt_new_unit(const pcnt_unit_config_t *config, pcnt_unit_handle_t *ret_unit) {
+    if (config == NULL || ret_unit == NULL || config->low_limit >= 0 || config->high_limit <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < HOST_MAX_PCNT_UNITS; i++) {
+        if (g_pcnt_units[i] == NULL) {
+            struct host_pcnt_unit *u = calloc(1, sizeof(*u));
+            if (u == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
+            u->low_limit = config->low_limit;
+            u->high_limit = config->high_limit;
+            g_pcnt_units[i] = u;
+            *ret_unit = u;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t pcnt_del_unit(pcnt_unit_handle_t unit) {
+    for (int i = 0; i < HOST_MAX_PCNT_UNITS; i++) {
+        if (g_pcnt_units[i] == unit) {
+            g_pcnt_units[i] = NULL;
+        }
+    }
+    free(unit);
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_set_glitch_filter(pcnt_unit_handle_t unit, const pcnt_glitch_filter_config_t *config) {
+    (void)config;
+    return (unit != NULL) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t pcnt_unit_enable(pcnt_unit_handle_t unit) {
+    if (unit == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    unit->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_disable(pcnt_unit_handle_t unit) {
+    if (unit == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    unit->enabled = false;
+    unit->running = false;
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_start(pcnt_unit_handle_t unit) {
+    if (unit == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!unit->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    unit->running = true;
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_stop(pcnt_unit_handle_t unit) {
+    if (unit == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!unit->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    unit->running = false;
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_clear_count(pcnt_unit_handle_t unit) {
+    if (unit == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    unit->count = 0;
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_get_count(pcnt_unit_handle_t unit, int *value) {
+    if (unit == NULL || value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *value = unit->count;
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_register_event_callbacks(pcnt_unit_handle_t unit, const pcnt_event_callbacks_t *cbs, void *user_data) {
+    if (unit == NULL || cbs == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (unit->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    unit->on_reach = cbs->on_reach;
+    unit->user_ctx = user_data;
+    unit->isr_core = esp_cpu_get_core_id();
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_add_watch_point(pcnt_unit_handle_t unit, int watch_point) {
+    if (unit == NULL || watch_point < unit->low_limit || watch_point > unit->high_limit) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (unit->watch_count >= HOST_MAX_WATCH_POINTS) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    unit->watch_points[unit->watch_count++] = watch_point;
+    return ESP_OK;
+}
+
+esp_err_t pcnt_unit_remove_watch_point(pcnt_unit_handle_t unit, int watch_point) {
+    if (unit == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < unit->watch_count; i++) {
+        if (unit->watch_points[i] == watch_point) {
+            unit->watch_points[i] = unit->watch_points[--unit->watch_count];
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t pcnt_new_channel(pcnt_unit_handle_t unit, const pcnt_chan_config_t *config, pcnt_channel_handle_t *ret_chan) {
+    if (unit == NULL || config == NULL || ret_chan == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < HOST_MAX_PCNT_CHANNELS; i++) {
+        if (g_pcnt_channels[i] == NULL) {
+            struct host_pcnt_channel *c = calloc(1, sizeof(*c));
+            if (c == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
+            c->unit = unit;
+            c->edge_gpio = config->edge_gpio_num;
+            g_pcnt_channels[i] = c;
+            *ret_chan = c;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t pcnt_del_channel(pcnt_channel_handle_t chan) {
+    for (int i = 0; i < HOST_MAX_PCNT_CHANNELS; i++) {
+        if (g_pcnt_channels[i] == chan) {
+            g_pcnt_channels[i] = NULL;
+        }
+    }
+    free(chan);
+    return ESP_OK;
+}
+
+esp_err_t pcnt_channel_set_edge_action(pcnt_channel_handle_t chan, pcnt_channel_edge_action_t pos_act,
+                                       pcnt_channel_edge_action_t neg_act) {
+    if (chan == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    chan->pos_act = pos_act;
+    chan->neg_act = neg_act;
+    return ESP_OK;
+}
+
+esp_err_t pcnt_channel_set_level_action(pcnt_channel_handle_t chan, pcnt_channel_level_action_t high_act,
+                                        pcnt_channel_level_action_t low_act) {
+    (void)high_act;
+    (void)low_act;
+    return (chan != NULL) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+static void pcnt_apply_edge(struct host_pcnt_channel *c, bool rising) {
+    struct host_pcnt_unit *u = c->unit;
+    if (!u->running) {
+        return;
+    }
+    pcnt_channel_edge_action_t act = rising ? c->pos_act : c->neg_act;
+    if (act == PCNT_CHANNEL_EDGE_ACTION_INCREASE) {
+        u->count++;
+    } else if (act == PCNT_CHANNEL_EDGE_ACTION_DECREASE) {
+        u->count--;
+    } else {
+        return;
+    }
+    int value = u->count;
+    if (u->count >= u->high_limit || u->count <= u->low_limit) {
+        u->count = 0;
+    }
+    for (int i = 0; i < u->watch_count; i++) {
+        if (u->watch_points[i] == value && u->on_reach != NULL) {
+            pcnt_watch_event_data_t edata = {
+                .watch_point_value = value,
+                .zero_cross_mode = PCNT_UNIT_ZERO_CROSS_POS_ZERO,
+            };
+            int prev = host_rtos_isr_enter(u->isr_core);
+            u->on_reach(u, &edata, u->user_ctx);
+            host_rtos_isr_exit(prev);
+        }
+    }
+}
+
+//=============================================================================
+// Edge injection
+//=============================================================================
+
+// Capture, count and interrupt for one edge; woken tasks run afterwards
+static void route_gpio_edge(int gpio, bool rising) {
+    if (gpio < 0 || gpio >= GPIO_NUM_MAX) {
+        return;
+    }
+    g_gpio[gpio].level = rising ? 1U : 0U;
+
+    for (int i = 0; i < HOST_MAX_ETM_CHANNELS; i++) {
+        struct host_etm_channel *c = g_etm_channels[i];
+        if (c == NULL || !c->enabled || c->event == NULL || c->task == NULL || c->event->gpio != gpio) {
+            continue;
+        }
+        bool match = (c->event->edge == GPIO_ETM_EVENT_EDGE_ANY) ||
+                     (c->event->edge == GPIO_ETM_EVENT_EDGE_POS && rising) ||
+                     (c->event->edge == GPIO_ETM_EVENT_EDGE_NEG && !rising);
+        if (match && c->task->type == GPTIMER_ETM_TASK_CAPTURE) {
+            c->task->timer->captured = gptimer_count_now(c->task->timer);
+        }
+    }
+
+    for (int i = 0; i < HOST_MAX_PCNT_CHANNELS; i++) {
+        struct host_pcnt_channel *c = g_pcnt_channels[i];
+        if (c != NULL && c->edge_gpio == gpio) {
+            pcnt_apply_edge(c, rising);
+        }
+    }
+
+    host_gpio_t *io = &g_gpio[gpio];
+    if (io->handler != NULL) {
+        bool match = (io->intr_type == GPIO_INTR_ANYEDGE) ||
+                     (io->intr_type == GPIO_INTR_POSEDGE && rising) ||
+                     (io->intr_type == GPIO_INTR_NEGEDGE && !rising);
+        if (match) {
+            int prev = host_rtos_isr_enter(g_gpio_isr_core);
+            io->handler(io->arg);
+            host_rtos_isr_exit(prev);
+        }
+    }
+}
+
+void host_sim_gpio_edge(int gpio, bool rising) {
+    route_gpio_edge(gpio, rising);
+    host_sim_run_until_idle();
+}
+
+//=============================================================================
+// MCPWM
+//=============================================================================
+
+struct host_mcpwm_timer {
+    int group_id;
+    uint32_t resolution_hz;
+    uint32_t period_ticks;
+    bool enabled;
+    bool running;
+    uint64_t start_us;
+};
+
+struct host_mcpwm_oper {
+    int group_id;
+    mcpwm_timer_handle_t timer;
+    int comparators;
+    int generators;
+};
+
+struct host_mcpwm_cmpr {
+    mcpwm_oper_handle_t oper;
+    uint32_t value;
+    mcpwm_compare_event_cb_t on_reach;
+    void *user_data;
+    int isr_core;
+};
+
+struct host_mcpwm_gen {
+    mcpwm_oper_handle_t oper;
+    int gpio;
+    int force_level;
+    uint32_t level;
+    mcpwm_generator_action_t on_empty;
+    mcpwm_generator_action_t on_full;
+    mcpwm_gen_compare_event_action_t on_compare[HOST_GEN_CMP_ACTIONS];
+    int compare_actions;
+};
+
+static uint64_t g_compare_writes = 0;
+static uint64_t g_output_edges = 0;
+static host_sim_output_hook_t g_output_hook = NULL;
+static void *g_output_hook_ctx = NULL;
+static struct host_mcpwm_gen *g_gens[HOST_MAX_MCPWM_GENS];
+// Comparators with an on_reach callback
+static struct host_mcpwm_cmpr *g_cmprs[HOST_MAX_MCPWM_CMPRS];
+static int g_group_timers[SOC_MCPWM_GROUPS];
+static int g_group_opers[SOC_MCPWM_GROUPS];
+// Generator events up to this time have been applied
+static uint64_t g_gen_checked_us = 0;
+
+esp_err_t mcpwm_new_timer(const mcpwm_timer_config_t *config, mcpwm_timer_handle_t *ret_timer) {
+    if (config == NULL || ret_timer == NULL || config->resolution_hz == 0 || config->period_ticks == 0 ||
+        config->group_id < 0 || config->group_id >= SOC_MCPWM_GROUPS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_group_timers[config->group_id] >= SOC_MCPWM_TIMERS_PER_GROUP) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    struct host_mcpwm_timer *t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    g_group_timers[config->group_id]++;
+    t->group_id = config->group_id;
+    t->resolution_hz = config->resolution_hz;
+    t->period_ticks = config->period_ticks;
+    *ret_timer = t;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_del_timer(mcpwm_timer_handle_t timer) {
+    if (timer != NULL) {
+        g_group_timers[timer->group_id]--;
+    }
+    free(timer);
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_timer_enable(mcpwm_timer_handle_t timer) {
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    timer->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_timer_disable(mcpwm_timer_handle_t timer) {
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    timer->enabled = false;
+    timer->running = false;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_timer_start_stop(mcpwm_timer_handle_t timer, mcpwm_timer_start_stop_cmd_t command) {
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!timer->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (command == MCPWM_TIMER_STOP_EMPTY || command == MCPWM_TIMER_STOP_FULL) {
+        timer->running = false;
+    } else {
+        timer->start_us = host_rtos_now_us();
+        timer->running = true;
+    }
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_timer_set_period(mcpwm_timer_handle_t timer, uint32_t period_ticks) {
+    if (timer == NULL || period_ticks == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    timer->period_ticks = period_ticks;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_timer_get_phase(mcpwm_timer_handle_t timer, uint32_t *count_value,
+                                mcpwm_timer_direction_t *direction) {
+    if (timer == NULL || count_value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint64_t ticks = 0;
+    if (timer->running) {
+        ticks = ((host_rtos_now_us() - timer->start_us) * timer->resolution_hz) / 1000000ULL;
+    }
+    *count_value = (uint32_t)(ticks % timer->period_ticks);
+    if (direction != NULL) {
+        *direction = MCPWM_TIMER_DIRECTION_UP;
+    }
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_new_operator(const mcpwm_operator_config_t *config, mcpwm_oper_handle_t *ret_oper) {
+    if (config == NULL || ret_oper == NULL || config->group_id < 0 || config->group_id >= SOC_MCPWM_GROUPS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_group_opers[config->group_id] >= SOC_MCPWM_OPERATORS_PER_GROUP) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    struct host_mcpwm_oper *o = calloc(1, sizeof(*o));
+    if (o == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    g_group_opers[config->group_id]++;
+    o->group_id = config->group_id;
+    *ret_oper = o;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_del_operator(mcpwm_oper_handle_t oper) {
+    if (oper != NULL) {
+        g_group_opers[oper->group_id]--;
+    }
+    free(oper);
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_operator_connect_timer(mcpwm_oper_handle_t oper, mcpwm_timer_handle_t timer) {
+    if (oper == NULL || timer == NULL || oper->group_id != timer->group_id) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    oper->timer = timer;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_new_comparator(mcpwm_oper_handle_t oper, const mcpwm_comparator_config_t *config,
+                               mcpwm_cmpr_handle_t *ret_cmpr) {
+    if (oper == NULL || config == NULL || ret_cmpr == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (oper->comparators >= SOC_MCPWM_COMPARATORS_PER_OPERATOR) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    struct host_mcpwm_cmpr *c = calloc(1, sizeof(*c));
+    if (c == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    oper->comparators++;
+    c->oper = oper;
+    *ret_cmpr = c;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_del_comparator(mcpwm_cmpr_handle_t cmpr) {
+    for (int i = 0; i < HOST_MAX_MCPWM_CMPRS; i++) {
+        if (g_cmprs[i] == cmpr) {
+            g_cmprs[i] = NULL;
+        }
+    }
+    if (cmpr != NULL && cmpr->oper != NULL) {
+        cmpr->oper->comparators--;
+    }
+    free(cmpr);
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_comparator_set_compare_value(mcpwm_cmpr_handle_t cmpr, uint32_t cmp_ticks) {
+    if (cmpr == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    mcpwm_timer_handle_t timer = cmpr->oper ? cmpr->oper->timer : NULL;
+    if (timer != NULL && cmp_ticks >= timer->period_ticks) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cmpr->value = cmp_ticks;
+    g_compare_writes++;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_comparator_register_event_callbacks(mcpwm_cmpr_handle_t cmpr,
+                                                    const mcpwm_comparator_event_callbacks_t *cbs,
+                                                    void *user_data) {
+    if (cmpr == NULL || cbs == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cmpr->on_reach = cbs->on_reach;
+    cmpr->user_data = user_data;
+    cmpr->isr_core = esp_cpu_get_core_id();
+    int free_slot = -1;
+    for (int i = 0; i < HOST_MAX_MCPWM_CMPRS; i++) {
+        if (g_cmprs[i] == cmpr) {
+            return ESP_OK;
+        }
+        if (g_cmprs[i] == NULL && free_slot < 0) {
+            free_slot = i;
+        }
+    }
+    if (free_slot < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    g_cmprs[free_slot] = cmpr;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_new_generator(mcpwm_oper_handle_t oper, const mcpwm_generator_config_t *config,
+                              mcpwm_gen_handle_t *ret_gen) {
+    if (oper == NULL || config == NULL || ret_gen == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (oper->generators >= SOC_MCPWM_GENERATORS_PER_OPERATOR) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    struct host_mcpwm_gen *g = calloc(1, sizeof(*g));
+    if (g == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    g->oper = oper;
+    g->gpio = config->gen_gpio_num;
+    g->force_level = -1;
+    for (int i = 0; i < HOST_MAX_MCPWM_GENS; i++) {
+        if (g_gens[i] == NULL) {
+            g_gens[i] = g;
+            oper->generators++;
+            *ret_gen = g;
+            return ESP_OK;
+        }
+    }
+    free(g);
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t mcpwm_del_generator(mcpwm_gen_handle_t gen) {
+    for (int i = 0; i < HOST_MAX_MCPWM_GENS; i++) {
+        if (g_gens[i] == gen) {
+            g_gens[i] = NULL;
+        }
+    }
+    if (gen != NULL && gen->oper != NULL) {
+        gen->oper->generators--;
+    }
+    free(gen);
+    return ESP_OK;
+}
+
+static void gen_drive(struct host_mcpwm_gen *gen, uint32_t level) {
+    if (gen->level == level) {
+        return;
+    }
+    gen->level = level;
+    g_output_edges++;
+    if (g_output_hook != NULL) {
+        g_output_hook(gen->gpio, level != 0, host_rtos_now_us(), g_output_hook_ctx);
+    }
+    route_gpio_edge(gen->gpio, level != 0);
+}
+
+static void gen_apply(struct host_mcpwm_gen *gen, mcpwm_generator_action_t action) {
+    switch (action) {
+        case MCPWM_GEN_ACTION_LOW:
+            gen_drive(gen, 0);
+            break;
+        case MCPWM_GEN_ACTION_HIGH:
+            gen_drive(gen, 1);
+            break;
+        case MCPWM_GEN_ACTION_TOGGLE:
+            gen_drive(gen, gen->level ^ 1U);
+            break;
+        default:
+            break;
+    }
+}
+
+esp_err_t mcpwm_generator_set_force_level(mcpwm_gen_handle_t gen, int level, bool hold_on) {
+    (void)hold_on;
+    if (gen == NULL || level < -1 || level > 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gen->force_level = level;
+    if (level >= 0) {
+        gen_drive(gen, (uint32_t)level);
+    }
+    return ESP_OK;
+}
+
+static void gen_set_timer_action(mcpwm_gen_handle_t gen, mcpwm_gen_timer_event_action_t ev_act) {
+    if (ev_act.direction != MCPWM_TIMER_DIRECTION_UP) {
+        return;
+    }
+    if (ev_act.event == MCPWM_TIMER_EVENT_EMPTY) {
+        gen->on_empty = ev_act.action;
+    } else if (ev_act.event == MCPWM_TIMER_EVENT_FULL) {
+        gen->on_full = ev_act.action;
+    }
+}
+
+static esp_err_t gen_add_compare_action(mcpwm_gen_handle_t gen, mcpwm_gen_compare_event_action_t ev_act) {
+    if (ev_act.direction != MCPWM_TIMER_DIRECTION_UP) {
+        return ESP_OK;
+    }
+    for (int i = 0; i < gen->compare_actions; i++) {
+        if (gen->on_compare[i].comparator == ev_act.comparator) {
+            gen->on_compare[i] = ev_act;
+            return ESP_OK;
+        }
+    }
+    if (gen->compare_actions >= HOST_GEN_CMP_ACTIONS) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    gen->on_compare[gen->compare_actions++] = ev_act;
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_generator_set_action_on_timer_event(mcpwm_gen_handle_t gen, mcpwm_gen_timer_event_action_t ev_act) {
+    if (gen == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gen_set_timer_action(gen, ev_act);
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_generator_set_actions_on_timer_event(mcpwm_gen_handle_t gen, mcpwm_gen_timer_event_action_t ev_act, ...) {
+    if (gen == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    va_list args;
+    va_start(args, ev_act);
+    while (ev_act.event != MCPWM_TIMER_EVENT_INVALID) {
+        gen_set_timer_action(gen, ev_act);
+        ev_act = va_arg(args, mcpwm_gen_timer_event_action_t);
+    }
+    va_end(args);
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_generator_set_action_on_compare_event(mcpwm_gen_handle_t gen, mcpwm_gen_compare_event_action_t ev_act) {
+    if (gen == NULL || ev_act.comparator == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return gen_add_compare_action(gen, ev_act);
+}
+
+esp_err_t mcpwm_generator_set_actions_on_compare_event(mcpwm_gen_handle_t gen, mcpwm_gen_compare_event_action_t ev_act, ...) {
+    if (gen == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = ESP_OK;
+    va_list args;
+    va_start(args, ev_act);
+    while (ev_act.comparator != NULL) {
+        if (err == ESP_OK) {
+            err = gen_add_compare_action(gen, ev_act);
+        }
+        ev_act = va_arg(args, mcpwm_gen_compare_event_action_t);
+    }
+    va_end(args);
+    return err;
+}
+
+/*
+ * Generator events. The counter value is derived from the virtual clock, so
+ * the first time after g_gen_checked_us at which the counter equals a
+ * compare value is computed directly. Compare values take effect as soon as
+ * they are written: the TEZ shadow update (update_cmp_on_tez) is not
+ * modelled. At one instant, generator actions run before comparator on_reach
+ * callbacks, like the hardware action precedes its interrupt.
+ */
+
+// Virtual time of the first tick after `after_us` where the counter reads `value`
+static uint64_t timer_next_match_us(const struct host_mcpwm_timer *t, uint64_t after_us, uint32_t value) {
+    if (after_us < t->start_us) {
+        after_us = t->start_us;
+    }
+    uint64_t ticks = ((after_us - t->start_us) * t->resolution_hz) / 1000000ULL;
+    uint64_t match = ticks - (ticks % t->period_ticks) + value;
+    while (match * 1000000ULL < (after_us - t->start_us) * t->resolution_hz + 1U) {
+        match += t->period_ticks;
+    }
+    return t->start_us + ((match * 1000000ULL) + t->resolution_hz - 1U) / t->resolution_hz;
+}
+
+static uint64_t gen_next_event_us(const struct host_mcpwm_gen *gen) {
+    const struct host_mcpwm_timer *t = (gen->oper != NULL) ? gen->oper->timer : NULL;
+    if (t == NULL || !t->running || gen->force_level >= 0) {
+        return UINT64_MAX;
+    }
+    uint64_t next = UINT64_MAX;
+    if (gen->on_empty != MCPWM_GEN_ACTION_KEEP) {
+        uint64_t at = timer_next_match_us(t, g_gen_checked_us, 0);
+        next = (at < next) ? at : next;
+    }
+    if (gen->on_full != MCPWM_GEN_ACTION_KEEP) {
+        uint64_t at = timer_next_match_us(t, g_gen_checked_us, t->period_ticks - 1U);
+        next = (at < next) ? at : next;
+    }
+    for (int i = 0; i < gen->compare_actions; i++) {
+        uint64_t at = timer_next_match_us(t, g_gen_checked_us, gen->on_compare[i].comparator->value);
+        next = (at < next) ? at : next;
+    }
+    return next;
+}
+
+static void gen_run_events_at(struct host_mcpwm_gen *gen, uint64_t at_us) {
+    const struct host_mcpwm_timer *t = gen->oper->timer;
+    if (gen->on_empty != MCPWM_GEN_ACTION_KEEP && timer_next_match_us(t, g_gen_checked_us, 0) == at_us) {
+        gen_apply(gen, gen->on_empty);
+    }
+    for (int i = 0; i < gen->compare_actions; i++) {
+        const mcpwm_gen_compare_event_action_t *a = &gen->on_compare[i];
+        if (timer_next_match_us(t, g_gen_checked_us, a->comparator->value) == at_us) {
+            gen_apply(gen, a->action);
+        }
+    }
+    if (gen->on_full != MCPWM_GEN_ACTION_KEEP &&
+        timer_next_match_us(t, g_gen_checked_us, t->period_ticks - 1U) == at_us) {
+        gen_apply(gen, gen->on_full);
+    }
+}
+
+static uint64_t cmpr_next_event_us(const struct host_mcpwm_cmpr *cmpr) {
+    const struct host_mcpwm_timer *t = (cmpr->oper != NULL) ? cmpr->oper->timer : NULL;
+    if (t == NULL || !t->running || cmpr->on_reach == NULL) {
+        return UINT64_MAX;
+    }
+    return timer_next_match_us(t, g_gen_checked_us, cmpr->value);
+}
+
+uint64_t host_hal_next_event_us(void) {
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < HOST_MAX_MCPWM_GENS; i++) {
+        if (g_gens[i] != NULL) {
+            uint64_t at = gen_next_event_us(g_gens[i]);
+            next = (at < next) ? at : next;
+        }
+    }
+    for (int i = 0; i < HOST_MAX_MCPWM_CMPRS; i++) {
+        if (g_cmprs[i] != NULL) {
+            uint64_t at = cmpr_next_event_us(g_cmprs[i]);
+            next = (at < next) ? at : next;
+        }
+    }
+    return next;
+}
+
+void host_hal_run_events(uint64_t now_us) {
+    for (;;) {
+        uint64_t at = host_hal_next_event_us();
+        if (at > now_us) {
+            break;
+        }
+        // Every generator switching at the same instant, then mark it done
+        struct host_mcpwm_gen *due[HOST_MAX_MCPWM_GENS];
+        int n = 0;
+        for (int i = 0; i < HOST_MAX_MCPWM_GENS; i++) {
+            if (g_gens[i] != NULL && gen_next_event_us(g_gens[i]) == at) {
+                due[n++] = g_gens[i];
+            }
+        }
+        struct host_mcpwm_cmpr *reached[HOST_MAX_MCPWM_CMPRS];
+        int m = 0;
+        for (int i = 0; i < HOST_MAX_MCPWM_CMPRS; i++) {
+            if (g_cmprs[i] != NULL && cmpr_next_event_us(g_cmprs[i]) == at) {
+                reached[m++] = g_cmprs[i];
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            gen_run_events_at(due[i], at);
+        }
+        for (int i = 0; i < m; i++) {
+            mcpwm_compare_event_data_t edata = {
+                .compare_ticks = reached[i]->value,
+                .direction = MCPWM_TIMER_DIRECTION_UP,
+            };
+            int prev = host_rtos_isr_enter(reached[i]->isr_core);
+            reached[i]->on_reach(reached[i], &edata, reached[i]->user_data);
+            host_rtos_isr_exit(prev);
+        }
+        g_gen_checked_us = at;
+    }
+    if (now_us > g_gen_checked_us) {
+        g_gen_checked_us = now_us;
+    }
+}
+
+uint64_t host_sim_mcpwm_compare_writes(void) {
+    return g_compare_writes;
+}
+
+uint64_t host_sim_mcpwm_output_edges(void) {
+    return g_output_edges;
+}
+
+void host_sim_set_output_hook(host_sim_output_hook_t hook, void *ctx) {
+    g_output_hook = hook;
+    g_output_hook_ctx = ctx;
+}
+
+//=============================================================================
+// ADC (continuous mode)
+//=============================================================================
+
+struct host_adc_continuous {
+    bool started;
+    uint32_t pattern_num;
+    uint8_t channels[HOST_ADC_CHANNELS];
+};
+
+// Defaults describe a warm idling engine: MAP 100 kPa, TPS 10 %, CLT 85 C,
+// IAT 30 C, O2 0.45 V, VBAT 13.5 V (see the sensor ranges in s3_control_config.h).
+static uint16_t g_adc_raw[HOST_ADC_CHANNELS] = {1638, 410, 3199, 1792, 369, 2662, 0, 0, 0, 0};
+
+void host_sim_adc_set_raw(unsigned channel, uint16_t raw) {
+    if (channel < HOST_ADC_CHANNELS) {
+        g_adc_raw[channel] = (uint16_t)(raw & 0x0FFFU);
+    }
+}
+
+esp_err_t adc_continuous_new_handle(const adc_continuous_handle_cfg_t *hdl_config, adc_continuous_handle_t *ret_handle) {
+    if (hdl_config == NULL || ret_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct host_adc_continuous *h = calloc(1, sizeof(*h));
+    if (h == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    *ret_handle = h;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_config(adc_continuous_handle_t handle, const adc_continuous_config_t *config) {
+    if (handle == NULL || config == NULL || config->pattern_num > HOST_ADC_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handle->pattern_num = config->pattern_num;
+    for (uint32_t i = 0; i < config->pattern_num; i++) {
+        handle->channels[i] = config->adc_pattern[i].channel;
+    }
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_start(adc_continuous_handle_t handle) {
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handle->started = true;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_stop(adc_continuous_handle_t handle) {
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handle->started = false;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_read(adc_continuous_handle_t handle, uint8_t *buf, uint32_t length_max,
+                              uint32_t *out_length, uint32_t timeout_ms) {
+    (void)timeout_ms;
+    if (handle == NULL || buf == NULL || out_length == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!handle->started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < handle->pattern_num && n + sizeof(adc_digi_output_data_t) <= length_max; i++) {
+        adc_digi_output_data_t sample = {0};
+        uint8_t chan = handle->channels[i];
+        sample.type2.channel = chan;
+        sample.type2.data = g_adc_raw[chan];
+        memcpy(&buf[n], &sample, sizeof(sample));
+        n += sizeof(sample);
+    }
+    *out_length = n;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_deinit(adc_continuous_handle_t handle) {
+    free(handle);
+    return ESP_OK;
+}
+
+//=============================================================================
+// TWAI
+//=============================================================================
+
+static QueueHandle_t g_twai_rx = NULL;
+static bool g_twai_started = false;
+static uint32_t g_twai_tx_count = 0;
+
+esp_err_t twai_driver_install(const twai_general_config_t *g_config, const twai_timing_config_t *t_config,
+                              const twai_filter_config_t *f_config) {
+    (void)t_config;
+    (void)f_config;
+    if (g_config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_twai_rx != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_twai_rx = xQueueCreate(HOST_TWAI_RX_LEN, sizeof(twai_message_t));
+    return (g_twai_rx != NULL) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t twai_driver_uninstall(void) {
+    if (g_twai_rx == NULL || g_twai_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    vQueueDelete(g_twai_rx);
+    g_twai_rx = NULL;
+    return ESP_OK;
+}
+
+esp_err_t twai_start(void) {
+    if (g_twai_rx == NULL || g_twai_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_twai_started = true;
+    return ESP_OK;
+}
+
+esp_err_t twai_stop(void) {
+    if (!g_twai_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_twai_started = false;
+    return ESP_OK;
+}
+
+esp_err_t twai_transmit(const twai_message_t *message, TickType_t ticks_to_wait) {
+    (void)ticks_to_wait;
+    if (message == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!g_twai_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_twai_tx_count++;
+    return ESP_OK;
+}
+
+esp_err_t twai_receive(twai_message_t *message, TickType_t ticks_to_wait) {
+    if (message == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_twai_rx == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return (xQueueReceive(g_twai_rx, message, ticks_to_wait) == pdTRUE) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+bool host_sim_twai_inject(uint32_t identifier, const uint8_t *data, uint8_t dlc) {
+    if (g_twai_rx == NULL || !g_twai_started || dlc > 8U) {
+        return false;
+    }
+    twai_message_t msg = {0};
+    msg.identifier = identifier;
+    msg.data_length_code = dlc;
+    if (data != NULL) {
+        memcpy(msg.data, data, dlc);
+    }
+    bool ok = (xQueueSend(g_twai_rx, &msg, 0) == pdTRUE);
+    host_sim_run_until_idle();
+    return ok;
+}
+
+uint32_t host_sim_twai_tx_count(void) {
+    return g_twai_tx_count;
+}
+
+//=============================================================================
+// USB serial/JTAG (CLI console)
+//=============================================================================
+
+static bool g_usb_installed = false;
+
+esp_err_t usb_serial_jtag_driver_install(usb_serial_jtag_driver_config_t *usb_serial_jtag_config) {
+    if (usb_serial_jtag_config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_usb_installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_usb_installed = true;
+    return ESP_OK;
+}
+
+esp_err_t usb_serial_jtag_driver_uninstall(void) {
+    g_usb_installed = false;
+    return ESP_OK;
+}
+
+int usb_serial_jtag_read_bytes(void *buf, uint32_t length, TickType_t ticks_to_wait) {
+    (void)buf;
+    (void)length;
+    if (ticks_to_wait > 0U) {
+        vTaskDelay(ticks_to_wait);
+    }
+    return 0;
+}
+
+int usb_serial_jtag_write_bytes(const void *src, size_t size, TickType_t ticks_to_wait) {
+    (void)ticks_to_wait;
+    if (!g_usb_installed || src == NULL) {
+        return -1;
+    }
+    return (int)fwrite(src, 1, size, stdout);
+}
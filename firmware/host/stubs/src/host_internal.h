@@ -0,0 +1,36 @@
+/**
+ * @file host_internal.h
+ * @brief Shared helpers between the host stub translation units
+ */
+
+#ifndef HOST_INTERNAL_H
+#define HOST_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Virtual clock read without taking the scheduler lock */
+uint64_t host_rtos_now_us(void);
+
+/** @brief Moves the virtual clock forward from inside a running context (busy waits) */
+void host_rtos_consume_us(uint32_t us);
+
+/** @brief True when called from a simulated firmware task */
+bool host_rtos_in_task(void);
+
+/**
+ * @brief Runs the caller as an ISR allocated on @p core until host_rtos_isr_exit()
+ *
+ * esp_cpu_get_core_id() then reports @p core, like the hardware does for an
+ * interrupt allocated there. Returns the value to hand to host_rtos_isr_exit().
+ */
+int host_rtos_isr_enter(int core);
+void host_rtos_isr_exit(int prev);
+
+/** @brief Earliest pending peripheral event (MCPWM generator switch), UINT64_MAX if none */
+uint64_t host_hal_next_event_us(void);
+
+/** @brief Applies every peripheral event due at or before @p now_us (driver thread, unlocked) */
+void host_hal_run_events(uint64_t now_us);
+
+#endif // HOST_INTERNAL_H
@@ -0,0 +1,341 @@
+/**
+ * @file host_platform.c
+ * @brief Host implementations of the ESP-IDF system services the firmware uses:
+ *        error names, logging, esp_timer, ROM CRC, NVS, task watchdog
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_rom_crc.h"
+#include "esp_rom_sys.h"
+#include "esp_task_wdt.h"
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "host_internal.h"
+
+//=============================================================================
+// Errors
+//=============================================================================
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_INVALID_VERSION: return "ESP_ERR_INVALID_VERSION";
+        case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_INVALID_LENGTH: return "ESP_ERR_NVS_INVALID_LENGTH";
+        default: return "ESP_ERR_UNKNOWN";
+    }
+}
+
+//=============================================================================
+// Logging
+//=============================================================================
+
+#define HOST_LOG_MAX_TAGS 16
+
+typedef struct {
+    char tag[24];
+    esp_log_level_t level;
+} host_log_tag_t;
+
+static esp_log_level_t g_log_default = ESP_LOG_INFO;
+static host_log_tag_t g_log_tags[HOST_LOG_MAX_TAGS];
+static int g_log_tag_count = 0;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    if (tag == NULL || strcmp(tag, "*") == 0) {
+        g_log_default = level;
+        g_log_tag_count = 0;
+        return;
+    }
+    for (int i = 0; i < g_log_tag_count; i++) {
+        if (strcmp(g_log_tags[i].tag, tag) == 0) {
+            g_log_tags[i].level = level;
+            return;
+        }
+    }
+    if (g_log_tag_count < HOST_LOG_MAX_TAGS) {
+        snprintf(g_log_tags[g_log_tag_count].tag, sizeof(g_log_tags[0].tag), "%s", tag);
+        g_log_tags[g_log_tag_count].level = level;
+        g_log_tag_count++;
+    }
+}
+
+static esp_log_level_t level_for_tag(const char *tag) {
+    for (int i = 0; tag != NULL && i < g_log_tag_count; i++) {
+        if (strcmp(g_log_tags[i].tag, tag) == 0) {
+            return g_log_tags[i].level;
+        }
+    }
+    return g_log_default;
+}
+
+void esp_log_writev(esp_log_level_t level, const char *tag, const char *format, va_list args) {
+    if (level == ESP_LOG_NONE || level > level_for_tag(tag)) {
+        return;
+    }
+    static const char letters[] = {'N', 'E', 'W', 'I', 'D', 'V'};
+    fprintf(stderr, "%c (%llu) %s: ", letters[level],
+            (unsigned long long)(host_rtos_now_us() / 1000ULL), tag ? tag : "");
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    esp_log_writev(level, tag, format, args);
+    va_end(args);
+}
+
+//=============================================================================
+// Time and system
+//=============================================================================
+
+int64_t esp_timer_get_time(void) {
+    return (int64_t)host_rtos_now_us();
+}
+
+void esp_rom_delay_us(uint32_t us) {
+    host_rtos_consume_us(us);
+}
+
+uint32_t esp_get_free_heap_size(void) {
+    return 256U * 1024U;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void) {
+    return 256U * 1024U;
+}
+
+void esp_restart(void) {
+    fprintf(stderr, "esp_restart() called\n");
+    exit(EXIT_FAILURE);
+}
+
+const char *esp_get_idf_version(void) {
+    return "host";
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+//=============================================================================
+// Task watchdog (feeds accepted, never fires)
+//=============================================================================
+
+struct esp_task_wdt_user_handle_s {
+    uint32_t feeds;
+};
+
+static struct esp_task_wdt_user_handle_s g_wdt_users[4];
+static int g_wdt_user_count = 0;
+static bool g_wdt_initialized = false;
+
+esp_err_t esp_task_wdt_init(const esp_task_wdt_config_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_wdt_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    g_wdt_initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_add_user(const char *user_name, esp_task_wdt_user_handle_t *user_handle_ret) {
+    (void)user_name;
+    if (user_handle_ret == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_wdt_user_count >= (int)(sizeof(g_wdt_users) / sizeof(g_wdt_users[0]))) {
+        return ESP_ERR_NO_MEM;
+    }
+    *user_handle_ret = &g_wdt_users[g_wdt_user_count++];
+    return ESP_OK;
+}
+
+esp_err_t esp_task_wdt_reset_user(esp_task_wdt_user_handle_t user_handle) {
+    if (user_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    user_handle->feeds++;
+    return ESP_OK;
+}
+
+//=============================================================================
+// NVS (in memory, lost at exit)
+//=============================================================================
+
+#define HOST_NVS_MAX_ENTRIES    32
+#define HOST_NVS_MAX_HANDLES    8
+#define HOST_NVS_KEY_LEN        16
+
+typedef struct {
+    char ns[HOST_NVS_KEY_LEN];
+    char key[HOST_NVS_KEY_LEN];
+    uint8_t *data;
+    size_t len;
+} host_nvs_entry_t;
+
+typedef struct {
+    bool open;
+    bool writable;
+    char ns[HOST_NVS_KEY_LEN];
+} host_nvs_handle_t;
+
+static host_nvs_entry_t g_nvs[HOST_NVS_MAX_ENTRIES];
+static host_nvs_handle_t g_nvs_handles[HOST_NVS_MAX_HANDLES];
+static bool g_nvs_initialized = false;
+
+esp_err_t nvs_flash_init(void) {
+    g_nvs_initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        free(g_nvs[i].data);
+        memset(&g_nvs[i], 0, sizeof(g_nvs[i]));
+    }
+    return ESP_OK;
+}
+
+static host_nvs_handle_t *nvs_lookup_handle(nvs_handle_t handle) {
+    if (handle == 0 || handle > HOST_NVS_MAX_HANDLES || !g_nvs_handles[handle - 1U].open) {
+        return NULL;
+    }
+    return &g_nvs_handles[handle - 1U];
+}
+
+static host_nvs_entry_t *nvs_find(const char *ns, const char *key) {
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        if (g_nvs[i].data != NULL && strcmp(g_nvs[i].ns, ns) == 0 && strcmp(g_nvs[i].key, key) == 0) {
+            return &g_nvs[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    if (!g_nvs_initialized) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (namespace_name == NULL || out_handle == NULL || strlen(namespace_name) >= HOST_NVS_KEY_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < HOST_NVS_MAX_HANDLES; i++) {
+        if (!g_nvs_handles[i].open) {
+            g_nvs_handles[i].open = true;
+            g_nvs_handles[i].writable = (open_mode == NVS_READWRITE);
+            snprintf(g_nvs_handles[i].ns, sizeof(g_nvs_handles[i].ns), "%s", namespace_name);
+            *out_handle = (nvs_handle_t)(i + 1);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    host_nvs_handle_t *h = nvs_lookup_handle(handle);
+    if (h != NULL) {
+        h->open = false;
+    }
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    return (nvs_lookup_handle(handle) != NULL) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    host_nvs_handle_t *h = nvs_lookup_handle(handle);
+    if (h == NULL || key == NULL || length == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host_nvs_entry_t *e = nvs_find(h->ns, key);
+    if (e == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (out_value == NULL) {
+        *length = e->len;
+        return ESP_OK;
+    }
+    if (*length < e->len) {
+        *length = e->len;
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, e->data, e->len);
+    *length = e->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    host_nvs_handle_t *h = nvs_lookup_handle(handle);
+    if (h == NULL || key == NULL || value == NULL || strlen(key) >= HOST_NVS_KEY_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!h->writable) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    host_nvs_entry_t *e = nvs_find(h->ns, key);
+    if (e == NULL) {
+        for (int i = 0; i < HOST_NVS_MAX_ENTRIES && e == NULL; i++) {
+            if (g_nvs[i].data == NULL) {
+                e = &g_nvs[i];
+            }
+        }
+        if (e == NULL) {
+            return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+        snprintf(e->ns, sizeof(e->ns), "%s", h->ns);
+        snprintf(e->key, sizeof(e->key), "%s", key);
+    }
+    uint8_t *copy = malloc(length > 0 ? length : 1U);
+    if (copy == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(copy, value, length);
+    free(e->data);
+    e->data = copy;
+    e->len = length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+    host_nvs_handle_t *h = nvs_lookup_handle(handle);
+    if (h == NULL || key == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host_nvs_entry_t *e = nvs_find(h->ns, key);
+    if (e == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    free(e->data);
+    memset(e, 0, sizeof(*e));
+    return ESP_OK;
+}
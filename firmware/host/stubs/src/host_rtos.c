@@ -0,0 +1,847 @@
+/**
+ * @file host_rtos.c
+ * @brief Deterministic FreeRTOS substitute for the host build
+ *
+ * Each firmware task is a pthread, but a single baton (g_current) decides
+ * which one may run: the driver thread hands it to the highest-priority
+ * ready task and waits until that task blocks again. Blocking calls record
+ * a virtual wake-up time; host_sim_advance_to() walks the clock from one
+ * wake-up to the next. A zero-tick delay sleeps until the next tick
+ * boundary so that polling loops cannot livelock the simulation.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "host_sim.h"
+#include "host_internal.h"
+
+#define HOST_RTOS_MAX_TASKS     32
+#define HOST_TASK_SAMPLES       8192
+#define HOST_TICK_US            (1000000ULL / configTICK_RATE_HZ)
+#define HOST_WAKE_NEVER         UINT64_MAX
+#define HOST_MAX_DISPATCHES     1000000U
+
+typedef enum {
+    HOST_TASK_READY = 0,
+    HOST_TASK_BLOCKED,
+    HOST_TASK_DELETED,
+} host_task_state_t;
+
+typedef enum {
+    HOST_WAIT_NONE = 0,
+    HOST_WAIT_DELAY,
+    HOST_WAIT_NOTIFY,
+    HOST_WAIT_QUEUE_RECV,
+    HOST_WAIT_QUEUE_SEND,
+} host_wait_t;
+
+struct host_task {
+    pthread_t thread;
+    pthread_cond_t cond;
+    char name[16];
+    TaskFunction_t fn;
+    void *arg;
+    UBaseType_t priority;
+    BaseType_t core;
+    uint32_t stack_depth;
+    host_task_state_t state;
+    host_wait_t wait;
+    const void *wait_obj;
+    uint64_t wake_us;
+    bool timed_out;
+    uint32_t notify_value;
+    uint64_t ready_seq;
+    // Wall-clock accounting
+    uint64_t slice_start_ns;
+    uint64_t runtime_ns;
+    uint32_t slices;
+    uint32_t max_ns;
+    uint32_t *samples;
+    uint32_t sample_count;
+};
+
+struct host_queue {
+    uint8_t *buf;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+};
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_driver_cond = PTHREAD_COND_INITIALIZER;
+static struct host_task *g_tasks[HOST_RTOS_MAX_TASKS];
+static size_t g_task_count = 0;
+static struct host_task *g_current = NULL;
+static uint64_t g_now_us = 0;
+static uint64_t g_ready_seq = 0;
+static __thread struct host_task *t_self = NULL;
+static __thread int t_isr_core = -1;
+
+static uint64_t wall_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t tick_deadline_us(TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        return HOST_WAKE_NEVER;
+    }
+    if (ticks == 0) {
+        ticks = 1;
+    }
+    return ((g_now_us / HOST_TICK_US) + ticks) * HOST_TICK_US;
+}
+
+static void slice_begin(struct host_task *t) {
+    t->slice_start_ns = wall_ns();
+}
+
+static void slice_end(struct host_task *t) {
+    uint64_t elapsed = wall_ns() - t->slice_start_ns;
+    uint32_t ns = (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed;
+    t->runtime_ns += elapsed;
+    t->slices++;
+    if (ns > t->max_ns) {
+        t->max_ns = ns;
+    }
+    t->samples[t->sample_count % HOST_TASK_SAMPLES] = ns;
+    t->sample_count++;
+}
+
+static void make_ready_locked(struct host_task *t) {
+    t->state = HOST_TASK_READY;
+    t->wake_us = HOST_WAKE_NEVER;
+    t->ready_seq = ++g_ready_seq;
+}
+
+// Hands the baton back to the driver and sleeps until re-dispatched.
+static void park_locked(struct host_task *t) {
+    slice_end(t);
+    g_current = NULL;
+    pthread_cond_signal(&g_driver_cond);
+    while (g_current != t) {
+        pthread_cond_wait(&t->cond, &g_lock);
+    }
+    slice_begin(t);
+}
+
+// Returns true when woken by an event, false on timeout.
+static bool block_until_locked(host_wait_t wait, const void *obj, uint64_t deadline_us) {
+    struct host_task *t = t_self;
+    t->state = HOST_TASK_BLOCKED;
+    t->wait = wait;
+    t->wait_obj = obj;
+    t->wake_us = deadline_us;
+    t->timed_out = false;
+    park_locked(t);
+    t->wait = HOST_WAIT_NONE;
+    t->wait_obj = NULL;
+    return !t->timed_out;
+}
+
+static void wake_waiter_locked(host_wait_t wait, const void *obj) {
+    struct host_task *best = NULL;
+    for (size_t i = 0; i < g_task_count; i++) {
+        struct host_task *t = g_tasks[i];
+        if (t->state != HOST_TASK_BLOCKED || t->wait != wait || t->wait_obj != obj) {
+            continue;
+        }
+        if (best == NULL || t->priority > best->priority) {
+            best = t;
+        }
+    }
+    if (best != NULL) {
+        make_ready_locked(best);
+    }
+}
+
+static void wake_expired_locked(void) {
+    for (size_t i = 0; i < g_task_count; i++) {
+        struct host_task *t = g_tasks[i];
+        if (t->state == HOST_TASK_BLOCKED && t->wake_us <= g_now_us) {
+            t->timed_out = (t->wait != HOST_WAIT_DELAY);
+            make_ready_locked(t);
+        }
+    }
+}
+
+static struct host_task *pick_ready_locked(void) {
+    struct host_task *best = NULL;
+    for (size_t i = 0; i < g_task_count; i++) {
+        struct host_task *t = g_tasks[i];
+        if (t->state != HOST_TASK_READY) {
+            continue;
+        }
+        if (best == NULL || t->priority > best->priority ||
+            (t->priority == best->priority && t->ready_seq < best->ready_seq)) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+static void run_until_idle_locked(void) {
+    uint32_t dispatches = 0;
+    for (;;) {
+        wake_expired_locked();
+        struct host_task *t = pick_ready_locked();
+        if (t == NULL) {
+            return;
+        }
+        if (++dispatches > HOST_MAX_DISPATCHES) {
+            fprintf(stderr, "host_rtos: task '%s' never blocks at t=%llu us\n",
+                    t->name, (unsigned long long)g_now_us);
+            abort();
+        }
+        g_current = t;
+        pthread_cond_signal(&t->cond);
+        while (g_current != NULL) {
+            pthread_cond_wait(&g_driver_cond, &g_lock);
+        }
+    }
+}
+
+static uint64_t next_wake_locked(void) {
+    uint64_t next = HOST_WAKE_NEVER;
+    for (size_t i = 0; i < g_task_count; i++) {
+        struct host_task *t = g_tasks[i];
+        if (t->state == HOST_TASK_BLOCKED && t->wake_us < next) {
+            next = t->wake_us;
+        }
+    }
+    return next;
+}
+
+// Peripheral events run their ISRs, which may take g_lock themselves
+static void run_hal_events_locked(void) {
+    uint64_t now = g_now_us;
+    pthread_mutex_unlock(&g_lock);
+    host_hal_run_events(now);
+    pthread_mutex_lock(&g_lock);
+}
+
+static void advance_to_locked(uint64_t t_us) {
+    for (;;) {
+        run_until_idle_locked();
+        uint64_t next = next_wake_locked();
+        uint64_t hal_next = host_hal_next_event_us();
+        if (hal_next < next) {
+            next = hal_next;
+        }
+        if (next > t_us) {
+            break;
+        }
+        if (next > g_now_us) {
+            g_now_us = next;
+        }
+        run_hal_events_locked();
+    }
+    if (t_us > g_now_us) {
+        g_now_us = t_us;
+    }
+    run_hal_events_locked();
+    run_until_idle_locked();
+}
+
+static void require_driver(const char *fn) {
+    if (t_self != NULL) {
+        fprintf(stderr, "host_rtos: %s called from task '%s'\n", fn, t_self->name);
+        abort();
+    }
+}
+
+static void *task_entry(void *p) {
+    struct host_task *t = (struct host_task *)p;
+    t_self = t;
+    pthread_mutex_lock(&g_lock);
+    while (g_current != t) {
+        pthread_cond_wait(&t->cond, &g_lock);
+    }
+    slice_begin(t);
+    pthread_mutex_unlock(&g_lock);
+
+    t->fn(t->arg);
+
+    pthread_mutex_lock(&g_lock);
+    t->state = HOST_TASK_DELETED;
+    slice_end(t);
+    g_current = NULL;
+    pthread_cond_signal(&g_driver_cond);
+    pthread_mutex_unlock(&g_lock);
+    return NULL;
+}
+
+//=============================================================================
+// Internal helpers shared with the other stubs
+//=============================================================================
+
+uint64_t host_rtos_now_us(void) {
+    return __atomic_load_n(&g_now_us, __ATOMIC_RELAXED);
+}
+
+void host_rtos_consume_us(uint32_t us) {
+    __atomic_fetch_add(&g_now_us, (uint64_t)us, __ATOMIC_RELAXED);
+}
+
+bool host_rtos_in_task(void) {
+    return t_self != NULL;
+}
+
+int host_rtos_isr_enter(int core) {
+    int prev = t_isr_core;
+    t_isr_core = core;
+    return prev;
+}
+
+void host_rtos_isr_exit(int prev) {
+    t_isr_core = prev;
+}
+
+int esp_cpu_get_core_id(void) {
+    if (t_isr_core >= 0) {
+        return t_isr_core;
+    }
+    if (t_self != NULL && t_self->core >= 0 && t_self->core < configNUMBER_OF_CORES) {
+        return (int)t_self->core;
+    }
+    return 0;
+}
+
+//=============================================================================
+// Simulation control
+//=============================================================================
+
+uint64_t host_sim_now_us(void) {
+    return host_rtos_now_us();
+}
+
+void host_sim_run_until_idle(void) {
+    require_driver(__func__);
+    pthread_mutex_lock(&g_lock);
+    run_until_idle_locked();
+    pthread_mutex_unlock(&g_lock);
+}
+
+void host_sim_advance_to(uint64_t t_us) {
+    require_driver(__func__);
+    pthread_mutex_lock(&g_lock);
+    advance_to_locked(t_us);
+    pthread_mutex_unlock(&g_lock);
+}
+
+void host_sim_advance_by(uint64_t dt_us) {
+    host_sim_advance_to(host_rtos_now_us() + dt_us);
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+size_t host_sim_get_task_count(void) {
+    return g_task_count;
+}
+
+bool host_sim_get_task_stats(size_t index, host_task_stats_t *out) {
+    if (out == NULL || index >= g_task_count) {
+        return false;
+    }
+    pthread_mutex_lock(&g_lock);
+    struct host_task *t = g_tasks[index];
+    memset(out, 0, sizeof(*out));
+    out->name = t->name;
+    out->priority = t->priority;
+    out->core = (int)t->core;
+    out->slices = t->slices;
+    out->runtime_ns = t->runtime_ns;
+    out->max_ns = t->max_ns;
+    uint32_t n = (t->sample_count < HOST_TASK_SAMPLES) ? t->sample_count : HOST_TASK_SAMPLES;
+    if (n > 0) {
+        uint32_t *sorted = malloc(n * sizeof(uint32_t));
+        if (sorted != NULL) {
+            memcpy(sorted, t->samples, n * sizeof(uint32_t));
+            qsort(sorted, n, sizeof(uint32_t), cmp_u32);
+            out->p50_ns = sorted[(n - 1U) / 2U];
+            out->p99_ns = sorted[((n - 1U) * 99U) / 100U];
+            free(sorted);
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return true;
+}
+
+void host_sim_reset_task_stats(void) {
+    pthread_mutex_lock(&g_lock);
+    for (size_t i = 0; i < g_task_count; i++) {
+        struct host_task *t = g_tasks[i];
+        t->runtime_ns = 0;
+        t->slices = 0;
+        t->max_ns = 0;
+        t->sample_count = 0;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+//=============================================================================
+// Tasks
+//=============================================================================
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t priority, TaskHandle_t *out_handle,
+                                   BaseType_t core_id) {
+    if (fn == NULL) {
+        return pdFAIL;
+    }
+    pthread_mutex_lock(&g_lock);
+    if (g_task_count >= HOST_RTOS_MAX_TASKS) {
+        pthread_mutex_unlock(&g_lock);
+        return pdFAIL;
+    }
+    struct host_task *t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        pthread_mutex_unlock(&g_lock);
+        return pdFAIL;
+    }
+    t->samples = calloc(HOST_TASK_SAMPLES, sizeof(uint32_t));
+    if (t->samples == NULL) {
+        free(t);
+        pthread_mutex_unlock(&g_lock);
+        return pdFAIL;
+    }
+    snprintf(t->name, sizeof(t->name), "%s", name ? name : "task");
+    t->fn = fn;
+    t->arg = arg;
+    t->priority = priority;
+    t->core = core_id;
+    t->stack_depth = stack_depth;
+    pthread_cond_init(&t->cond, NULL);
+    make_ready_locked(t);
+    g_tasks[g_task_count++] = t;
+    if (pthread_create(&t->thread, NULL, task_entry, t) != 0) {
+        g_task_count--;
+        free(t->samples);
+        free(t);
+        pthread_mutex_unlock(&g_lock);
+        return pdFAIL;
+    }
+    pthread_detach(t->thread);
+    if (out_handle != NULL) {
+        *out_handle = t;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t priority, TaskHandle_t *out_handle) {
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, out_handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    pthread_mutex_lock(&g_lock);
+    struct host_task *t = (task != NULL) ? task : t_self;
+    if (t == NULL) {
+        pthread_mutex_unlock(&g_lock);
+        return;
+    }
+    t->state = HOST_TASK_DELETED;
+    if (t == t_self) {
+        slice_end(t);
+        g_current = NULL;
+        pthread_cond_signal(&g_driver_cond);
+        pthread_mutex_unlock(&g_lock);
+        pthread_exit(NULL);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    pthread_mutex_lock(&g_lock);
+    uint64_t deadline = tick_deadline_us(ticks);
+    if (t_self == NULL) {
+        // Driver context (e.g. a bench main loop): delaying drives the clock.
+        advance_to_locked(deadline);
+    } else {
+        block_until_locked(HOST_WAIT_DELAY, NULL, deadline);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(host_rtos_now_us() / HOST_TICK_US);
+}
+
+TickType_t xTaskGetTickCountFromISR(void) {
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return t_self;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+    struct host_task *t = (task != NULL) ? task : t_self;
+    return (t != NULL) ? t->priority : 0;
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority) {
+    struct host_task *t = (task != NULL) ? task : t_self;
+    if (t != NULL) {
+        t->priority = priority;
+    }
+}
+
+void vTaskCoreAffinitySet(TaskHandle_t task, UBaseType_t core_mask) {
+    struct host_task *t = (task != NULL) ? task : t_self;
+    if (t != NULL) {
+        t->core = (core_mask == 0x2U) ? 1 : (core_mask == 0x1U) ? 0 : tskNO_AFFINITY;
+    }
+}
+
+BaseType_t xTaskGetCoreID(TaskHandle_t task) {
+    struct host_task *t = (task != NULL) ? task : t_self;
+    return (t != NULL) ? t->core : tskNO_AFFINITY;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    struct host_task *t = (task != NULL) ? task : t_self;
+    return (t != NULL) ? t->stack_depth : 0;
+}
+
+const char *pcTaskGetName(TaskHandle_t task) {
+    struct host_task *t = (task != NULL) ? task : t_self;
+    return (t != NULL) ? t->name : "driver";
+}
+
+eTaskState eTaskGetState(TaskHandle_t task) {
+    if (task == NULL) {
+        return eInvalid;
+    }
+    if (task == g_current) {
+        return eRunning;
+    }
+    switch (task->state) {
+        case HOST_TASK_READY:
+            return eReady;
+        case HOST_TASK_BLOCKED:
+            return eBlocked;
+        default:
+            return eDeleted;
+    }
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+    UBaseType_t n = 0;
+    pthread_mutex_lock(&g_lock);
+    for (size_t i = 0; i < g_task_count; i++) {
+        n += (g_tasks[i]->state != HOST_TASK_DELETED) ? 1U : 0U;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return n;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t array_size,
+                                 configRUN_TIME_COUNTER_TYPE *total_run_time) {
+    UBaseType_t n = uxTaskGetNumberOfTasks();
+    if (status == NULL || array_size < n) {
+        return 0;
+    }
+    pthread_mutex_lock(&g_lock);
+    n = 0;
+    for (size_t i = 0; i < g_task_count; i++) {
+        struct host_task *t = g_tasks[i];
+        if (t->state == HOST_TASK_DELETED) {
+            continue;
+        }
+        TaskStatus_t *st = &status[n++];
+        memset(st, 0, sizeof(*st));
+        st->xHandle = t;
+        st->pcTaskName = t->name;
+        st->xTaskNumber = (UBaseType_t)i;
+        st->eCurrentState = (t == g_current) ? eRunning : (t->state == HOST_TASK_READY) ? eReady : eBlocked;
+        st->uxCurrentPriority = t->priority;
+        st->uxBasePriority = t->priority;
+        st->ulRunTimeCounter = (configRUN_TIME_COUNTER_TYPE)(t->runtime_ns / 1000U);
+        st->usStackHighWaterMark = t->stack_depth;
+        st->xCoreID = t->core;
+    }
+    pthread_mutex_unlock(&g_lock);
+    if (total_run_time != NULL) {
+        *total_run_time = (configRUN_TIME_COUNTER_TYPE)host_rtos_now_us();
+    }
+    return n;
+}
+
+TaskHandle_t xTaskGetIdleTaskHandleForCore(BaseType_t core_id) {
+    (void)core_id;
+    return NULL;
+}
+
+void vTaskSuspendAll(void) {
+}
+
+BaseType_t xTaskResumeAll(void) {
+    return pdFALSE;
+}
+
+//=============================================================================
+// Direct-to-task notifications
+//=============================================================================
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    pthread_mutex_lock(&g_lock);
+    struct host_task *t = t_self;
+    if (t == NULL) {
+        pthread_mutex_unlock(&g_lock);
+        return 0;
+    }
+    if (t->notify_value == 0 && ticks != 0) {
+        block_until_locked(HOST_WAIT_NOTIFY, NULL, tick_deadline_us(ticks));
+    }
+    uint32_t value = t->notify_value;
+    if (value != 0) {
+        t->notify_value = clear_on_exit ? 0 : value - 1U;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return value;
+}
+
+static bool notify_give_locked(struct host_task *t) {
+    if (t == NULL || t->state == HOST_TASK_DELETED) {
+        return false;
+    }
+    t->notify_value++;
+    if (t->state == HOST_TASK_BLOCKED && t->wait == HOST_WAIT_NOTIFY) {
+        make_ready_locked(t);
+        return true;
+    }
+    return false;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&g_lock);
+    notify_give_locked(task);
+    pthread_mutex_unlock(&g_lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken) {
+    pthread_mutex_lock(&g_lock);
+    bool woken = notify_give_locked(task);
+    if (woken && higher_priority_task_woken != NULL &&
+        (t_self == NULL || task->priority > t_self->priority)) {
+        *higher_priority_task_woken = pdTRUE;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+//=============================================================================
+// Queues and semaphores
+//=============================================================================
+
+static struct host_queue *queue_create(UBaseType_t length, UBaseType_t item_size, UBaseType_t initial) {
+    struct host_queue *q = calloc(1, sizeof(*q));
+    if (q == NULL) {
+        return NULL;
+    }
+    if (item_size > 0) {
+        q->buf = calloc(length, item_size);
+        if (q->buf == NULL) {
+            free(q);
+            return NULL;
+        }
+    }
+    q->length = length;
+    q->item_size = item_size;
+    q->count = initial;
+    return q;
+}
+
+static BaseType_t queue_send(QueueHandle_t q, const void *item, TickType_t ticks, bool front, bool overwrite) {
+    if (q == NULL) {
+        return pdFAIL;
+    }
+    pthread_mutex_lock(&g_lock);
+    uint64_t deadline = tick_deadline_us(ticks);
+    for (;;) {
+        if (q->count < q->length || overwrite) {
+            if (q->count >= q->length) {
+                q->count = 0;
+                q->head = 0;
+            }
+            UBaseType_t slot;
+            if (front) {
+                q->head = (q->head + q->length - 1U) % q->length;
+                slot = q->head;
+            } else {
+                slot = (q->head + q->count) % q->length;
+            }
+            if (q->item_size > 0 && item != NULL) {
+                memcpy(q->buf + (size_t)slot * q->item_size, item, q->item_size);
+            }
+            q->count++;
+            wake_waiter_locked(HOST_WAIT_QUEUE_RECV, q);
+            pthread_mutex_unlock(&g_lock);
+            return pdPASS;
+        }
+        if (ticks == 0) {
+            break;
+        }
+        if (t_self == NULL) {
+            run_until_idle_locked();
+            if (q->count < q->length) {
+                continue;
+            }
+            break;
+        }
+        if (!block_until_locked(HOST_WAIT_QUEUE_SEND, q, deadline) && q->count >= q->length) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return errQUEUE_FULL;
+}
+
+static BaseType_t queue_receive(QueueHandle_t q, void *item, TickType_t ticks, bool peek) {
+    if (q == NULL) {
+        return pdFAIL;
+    }
+    pthread_mutex_lock(&g_lock);
+    uint64_t deadline = tick_deadline_us(ticks);
+    for (;;) {
+        if (q->count > 0) {
+            if (q->item_size > 0 && item != NULL) {
+                memcpy(item, q->buf + (size_t)q->head * q->item_size, q->item_size);
+            }
+            if (!peek) {
+                q->head = (q->head + 1U) % q->length;
+                q->count--;
+                wake_waiter_locked(HOST_WAIT_QUEUE_SEND, q);
+            }
+            pthread_mutex_unlock(&g_lock);
+            return pdPASS;
+        }
+        if (ticks == 0) {
+            break;
+        }
+        if (t_self == NULL) {
+            run_until_idle_locked();
+            if (q->count > 0) {
+                continue;
+            }
+            break;
+        }
+        if (!block_until_locked(HOST_WAIT_QUEUE_RECV, q, deadline) && q->count == 0) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return errQUEUE_EMPTY;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    if (length == 0) {
+        return NULL;
+    }
+    return queue_create(length, item_size, 0);
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    if (queue == NULL) {
+        return;
+    }
+    free(queue->buf);
+    free(queue);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queue_send(queue, item, ticks, false, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    return queue_send(queue, item, ticks, true, false);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *higher_priority_task_woken) {
+    (void)higher_priority_task_woken;
+    return queue_send(queue, item, 0, false, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item) {
+    return queue_send(queue, item, 0, false, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    return queue_receive(queue, item, ticks, false);
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void *item, BaseType_t *higher_priority_task_woken) {
+    (void)higher_priority_task_woken;
+    return queue_receive(queue, item, 0, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void *item, TickType_t ticks) {
+    return queue_receive(queue, item, ticks, true);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    return (queue != NULL) ? queue->count : 0;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    return (queue != NULL) ? queue->length - queue->count : 0;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    if (queue == NULL) {
+        return pdFAIL;
+    }
+    pthread_mutex_lock(&g_lock);
+    queue->count = 0;
+    queue->head = 0;
+    pthread_mutex_unlock(&g_lock);
+    return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return queue_create(1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return queue_create(1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    if (max_count == 0 || initial_count > max_count) {
+        return NULL;
+    }
+    return queue_create(max_count, 0, initial_count);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    return queue_receive(sem, NULL, ticks, false);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    return queue_send(sem, NULL, 0, false, false);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *higher_priority_task_woken) {
+    (void)higher_priority_task_woken;
+    return queue_send(sem, NULL, 0, false, false);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    vQueueDelete(sem);
+}
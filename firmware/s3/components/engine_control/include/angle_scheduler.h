@@ -0,0 +1,131 @@
+#ifndef ANGLE_SCHEDULER_H
+#define ANGLE_SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_attr.h"
+#include "latency_hist.h"
+#include "sync.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Angle-domain event scheduling.
+ *
+ * The executor runs on every tooth, but an injection or spark only needs its
+ * comparators written once per engine cycle. Each event (kind, cylinder) is
+ * armed once it comes within ANGLE_SCHED_ARM_DEG of the current tooth, then
+ * only rewritten on the last ANGLE_SCHED_REFINE_TEETH teeth before it, and
+ * only when the target time moved by at least ANGLE_SCHED_REFINE_MIN_US.
+ * An event is re-armed for the next cycle once the engine has passed it.
+ *
+ * Callers compute the event angle and target, ask angle_scheduler_plan()
+ * whether to write it, and report the driver result with
+ * angle_scheduler_commit().
+ *
+ * ISR refine (optional): the executor only arms events and hands over what
+ * the last writes need (event angle, fixed lead time, pulses). The refine
+ * on the last teeth then runs in the tooth ISR, angle_scheduler_on_tooth(),
+ * from the capture that just happened and in fixed point, through the
+ * writer registered for the event kind. The angle-critical write no longer
+ * waits for the planner and executor tasks to be scheduled. The time from
+ * the tooth capture to each compare write is recorded per path. The ISR
+ * takes the scheduler lock only to claim one event at a time; the recompute
+ * and the write run with interrupts enabled, and the executor holds a
+ * claimed event until the next tooth.
+ */
+
+#define ANGLE_SCHED_MAX_PULSES 2U  // SPLIT_INJ_MAX_PULSES
+
+typedef enum {
+    ANGLE_EVENT_INJECTION = 0,
+    ANGLE_EVENT_SPARK,
+    ANGLE_EVENT_KIND_COUNT,
+} angle_event_kind_t;
+
+typedef enum {
+    ANGLE_EVENT_HOLD = 0,  // nothing to write on this tooth
+    ANGLE_EVENT_ARM,       // first write of the event in this cycle
+    ANGLE_EVENT_REFINE,    // rewrite on one of the last teeth before the event
+} angle_event_action_t;
+
+// What an ISR refine needs to rewrite an armed event without the planner
+typedef struct {
+    uint32_t event_angle;        // Cycle angle of the target, 1/64 deg (sync.h)
+    int32_t lead_us;             // Added to the angle-derived time (latency compensation)
+    uint8_t channel;             // Driver channel
+    uint8_t count;               // Pulses
+    uint32_t offset_us[ANGLE_SCHED_MAX_PULSES];  // Pulse start after the target
+    uint32_t width_us[ANGLE_SCHED_MAX_PULSES];   // Pulse width (spark: dwell before the target)
+} angle_event_detail_t;
+
+// Writes an event from the tooth ISR; must be IRAM safe
+typedef bool (*angle_event_writer_t)(uint64_t target_us, const angle_event_detail_t *detail);
+
+typedef struct {
+    uint32_t updates;            // plan calls (one per event per tooth)
+    uint32_t arms;
+    uint32_t refines;
+    uint32_t refines_skipped;    // refine teeth where the target barely moved
+    uint32_t deferred;           // event still outside the arm window
+    uint32_t rejected;           // driver refused the target (already passed)
+    uint32_t comparator_writes;  // compare values written (2 per accepted event)
+    uint32_t isr_refines;        // refines written from the tooth ISR
+    uint32_t isr_refines_skipped;
+    uint32_t isr_rejected;
+} angle_scheduler_stats_t;
+
+// Forget all armed events (sync lost or fallback scheduling took over)
+void angle_scheduler_reset(void);
+
+/**
+ * @brief Decide whether an event must be written on this tooth
+ *
+ * @param kind Injection or spark
+ * @param cylinder Cylinder 1..engine_layout_cylinders()
+ * @param dist_deg Crank angle from the current tooth to the event, 0..720
+ * @param deg_per_tooth Crank angle between two teeth
+ * @param target_us Event time on the shared timebase (low 32 bits, see timebase.h)
+ */
+angle_event_action_t angle_scheduler_plan(angle_event_kind_t kind,
+                                          uint8_t cylinder,
+                                          float dist_deg,
+                                          float deg_per_tooth,
+                                          uint32_t target_us);
+
+/**
+ * @brief Record the driver result for an ARM or REFINE returned by angle_scheduler_plan()
+ *
+ * @param edge_us Capture time of the tooth the target was computed from
+ * @param detail Hand-over for ISR refines, NULL if the event kind has none
+ */
+void angle_scheduler_commit(angle_event_kind_t kind,
+                            uint8_t cylinder,
+                            angle_event_action_t action,
+                            uint32_t target_us,
+                            uint64_t edge_us,
+                            bool written,
+                            const angle_event_detail_t *detail);
+
+// ISR refine on or off; events of a kind without a writer stay task refined
+void angle_scheduler_set_isr_refine(bool enabled);
+bool angle_scheduler_get_isr_refine(void);
+void angle_scheduler_set_writer(angle_event_kind_t kind, angle_event_writer_t writer);
+
+// Tooth ISR hook: refines the armed events on their last teeth
+IRAM_ATTR void angle_scheduler_on_tooth(void);
+
+// Tooth capture to compare write, in us, for task (executor) or ISR writes
+void angle_scheduler_get_write_latency(bool isr, latency_summary_t *out);
+
+void angle_scheduler_get_stats(angle_scheduler_stats_t *out);
+// Clears the counters and the write latency histograms
+void angle_scheduler_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ANGLE_SCHEDULER_H
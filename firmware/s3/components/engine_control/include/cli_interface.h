@@ -49,12 +49,6 @@ extern "C" {
 /** @brief Maximum registered commands */
 #define CLI_MAX_COMMANDS            32
 
-/** @brief CLI task stack size */
-#define CLI_TASK_STACK_SIZE         4096
-
-/** @brief CLI task priority */
-#define CLI_TASK_PRIORITY           3
-
 /** @brief Default stream interval (ms) */
 #define CLI_DEFAULT_STREAM_INTERVAL 100
 
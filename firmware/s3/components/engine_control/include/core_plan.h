@@ -0,0 +1,177 @@
+#ifndef CORE_PLAN_H
+#define CORE_PLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "s3_control_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Core partitioning.
+ *
+ * CORE_PLAN_CONTROL_CORE runs crank capture and event scheduling only: the
+ * planner and executor tasks plus the CKP/CMP, MCPWM compare and output
+ * capture interrupts. Everything else (sensor task, CAN, ESP-NOW and the
+ * Wi-Fi stack, monitor, CLI, logger) lives on CORE_PLAN_COMM_CORE.
+ *
+ * Tasks are created from one table (name, stack, priority and core per
+ * task). An interrupt is allocated on the core that installs its
+ * driver, so each driver is brought up from a task pinned to the core its
+ * interrupts belong on (core_plan_run_on_core).
+ *
+ * The audit reads the FreeRTOS run time counters: per-core load over the
+ * window since the previous audit, and which tasks may run on the control
+ * core. ISRs are not in those counters (their time is charged to the task
+ * they interrupted); each planned ISR instead counts its runs per core.
+ */
+
+#define CORE_PLAN_CONTROL_CORE CONTROL_TASK_CORE
+#define CORE_PLAN_COMM_CORE COMM_TASK_CORE
+#define CORE_PLAN_CORES 2U
+#define CORE_PLAN_INIT_STACK 4096U
+#define CORE_PLAN_AUDIT_TASKS 32U
+
+typedef enum {
+    CORE_TASK_ENGINE_EXEC = 0,
+    CORE_TASK_ENGINE_PLAN,
+    CORE_TASK_ENGINE_MON,
+    CORE_TASK_SENSOR,
+    CORE_TASK_TWAI_RX,
+    CORE_TASK_ESPNOW_TX,
+    CORE_TASK_CLI,
+    CORE_TASK_LOGGER,
+    CORE_TASK_COUNT
+} core_task_id_t;
+
+typedef enum {
+    CORE_ISR_CKP = 0,            // PCNT watch point or CKP GPIO
+    CORE_ISR_CMP,
+    CORE_ISR_MCPWM,              // Output comparators
+    CORE_ISR_OUTPUT_CAPTURE,     // Output GPIO readback
+    CORE_ISR_COUNT
+} core_isr_id_t;
+
+typedef struct {
+    const char *name;
+    uint32_t stack;
+    UBaseType_t priority;
+    BaseType_t core;
+} core_task_plan_t;
+
+typedef struct {
+    char name[16];
+    int8_t core;                 // Affinity, -1 unpinned
+    uint8_t priority;
+    uint16_t load_permille;      // Of one core, over the audit window
+    bool planned;                // Created from the plan table
+    bool misplaced;              // Planned, but not on its planned core
+} core_plan_task_audit_t;
+
+typedef struct {
+    uint32_t window_us;
+    uint16_t core_load_permille[CORE_PLAN_CORES];
+    uint32_t isr_runs[CORE_ISR_COUNT][CORE_PLAN_CORES];  // Since boot
+    uint32_t task_count;
+    core_plan_task_audit_t tasks[CORE_PLAN_AUDIT_TASKS];
+    uint32_t control_core_tasks; // Pinned to the control core or unpinned
+    uint32_t foreign_tasks;      // Of those: not planned there, idle excluded
+    uint32_t violations;         // Misplaced tasks + ISRs run on the wrong core
+} core_plan_audit_t;
+
+// Run time counters of the previous sample, matched by handle. One per
+// caller, so that the audit and the task profiler windows do not cut each
+// other short.
+typedef struct {
+    struct {
+        TaskHandle_t handle;
+        configRUN_TIME_COUNTER_TYPE runtime;
+    } prev[CORE_PLAN_AUDIT_TASKS];
+    uint32_t prev_count;
+    configRUN_TIME_COUNTER_TYPE prev_total;
+} core_plan_window_t;
+
+typedef struct {
+    const TaskStatus_t *status;
+    configRUN_TIME_COUNTER_TYPE runtime;  // Over the window; all of it after a restart
+    BaseType_t core;             // Affinity, -1 unpinned
+    uint16_t load_permille;      // Of one core, over the window
+    bool idle;                   // Idle task of its core
+} core_plan_task_sample_t;
+
+typedef struct {
+    uint32_t window_us;
+    uint16_t core_load_permille[CORE_PLAN_CORES];
+} core_plan_load_t;
+
+typedef void (*core_plan_task_cb_t)(const core_plan_task_sample_t *task, void *ctx);
+
+extern uint32_t g_core_plan_isr_runs[CORE_ISR_COUNT][CORE_PLAN_CORES];
+
+// One relaxed increment; called first thing in each planned ISR
+IRAM_ATTR static inline void core_plan_isr_mark(core_isr_id_t isr) {
+    uint32_t core = (uint32_t)esp_cpu_get_core_id();
+    __atomic_fetch_add(&g_core_plan_isr_runs[isr][core < CORE_PLAN_CORES ? core : 0U], 1U, __ATOMIC_RELAXED);
+}
+
+const core_task_plan_t *core_plan_get_task(core_task_id_t id);
+
+// Handle from core_plan_create_task, NULL before. Kept after the task is
+// deleted: compare it against live handles, never pass it to FreeRTOS.
+TaskHandle_t core_plan_get_handle(core_task_id_t id);
+
+// Core an ISR must run on
+BaseType_t core_plan_get_isr_core(core_isr_id_t isr);
+const char *core_plan_get_isr_name(core_isr_id_t isr);
+
+/**
+ * @brief Create a task with the name, stack, priority and core of its plan entry
+ *
+ * @return ESP_ERR_NO_MEM when FreeRTOS cannot create the task
+ */
+esp_err_t core_plan_create_task(core_task_id_t id, TaskFunction_t fn, void *arg, TaskHandle_t *out_handle);
+
+/**
+ * @brief Run @p fn on @p core and return its result
+ *
+ * Runs in place when already on that core; otherwise from a temporary task
+ * pinned there, at the caller's priority, while the caller waits. Driver
+ * installs done this way allocate their interrupts on @p core.
+ */
+esp_err_t core_plan_run_on_core(BaseType_t core, esp_err_t (*fn)(void));
+
+/**
+ * @brief Task and core loads since the previous sample of @p window
+ *
+ * Calls @p cb (may be NULL) once per task with its share of the window;
+ * the TaskStatus_t is valid during the call only. A counter lower than at
+ * the previous sample (task deleted and its handle reused, counters reset)
+ * counts as a task started within the window. A sample with a NULL @p cb
+ * and @p load only restarts the window.
+ *
+ * @return ESP_ERR_NOT_SUPPORTED without FreeRTOS trace facility and run time stats
+ * @return ESP_ERR_NO_MEM when more tasks run than CORE_PLAN_AUDIT_TASKS
+ */
+esp_err_t core_plan_sample_tasks(core_plan_window_t *window, core_plan_task_cb_t cb, void *ctx,
+                                 core_plan_load_t *load);
+
+/**
+ * @brief Per-core load and control core occupancy since the previous call
+ *
+ * @return ESP_ERR_NOT_SUPPORTED without FreeRTOS trace facility and run time
+ *         stats; the ISR counters are filled in anyway
+ */
+esp_err_t core_plan_audit(core_plan_audit_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CORE_PLAN_H
@@ -0,0 +1,80 @@
+#ifndef CYL_TRIM_H
+#define CYL_TRIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "s3_control_config.h"
+#include "engine_layout.h"
+#include "table_interp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per-cylinder fuel and ignition trims.
+ *
+ * Each trim is a 16x16 rpm/load map per cylinder, stored as one 3D table
+ * whose z axis is the cylinder number (z_bins = 1..ENGINE_MAX_CYLINDERS), so
+ * the cylinders share the rpm/load axes, the checksum and the persisted
+ * layout. A lookup locates rpm/load once and evaluates the layers of the
+ * engine's cylinders in one loop; the z axis is never interpolated.
+ *
+ * Raw cells:
+ * - fuel: pulse width multiplier in 1/1000 (1000 = no trim)
+ * - ignition: advance offset in 0.1 deg plus CYL_TRIM_IGN_ZERO
+ */
+
+#define CYL_TRIM_CYLINDERS ENGINE_MAX_CYLINDERS
+#define CYL_TRIM_BINS 16U
+
+#define CYL_TRIM_FUEL_UNITY 1000U
+#define CYL_TRIM_IGN_ZERO 1000U
+
+#define CYL_TRIM_FUEL_MIN_PCT -25.0f
+#define CYL_TRIM_FUEL_MAX_PCT 25.0f
+#define CYL_TRIM_IGN_MIN_DEG -10.0f
+#define CYL_TRIM_IGN_MAX_DEG 10.0f
+
+// x = rpm, y = load (MAP kPa * 10), z = cylinder 1..ENGINE_MAX_CYLINDERS
+TABLE_3D_DEFINE(cyl_trim_map, CYL_TRIM_BINS, CYL_TRIM_BINS, CYL_TRIM_CYLINDERS)
+
+typedef struct {
+    cyl_trim_map_t fuel;
+    cyl_trim_map_t ignition;
+} cyl_trim_maps_t;
+
+// Trims of every cylinder at one rpm/load point, index = cylinder - 1
+typedef struct {
+    uint16_t fuel_x1000[CYL_TRIM_CYLINDERS];
+    int16_t ign_deg10[CYL_TRIM_CYLINDERS];
+} cyl_trim_t;
+
+// Zero trims on the default rpm/load bins
+void cyl_trim_init_defaults(cyl_trim_maps_t *maps);
+
+// Checksums match, axes are strictly increasing and shared by both maps
+bool cyl_trim_validate(const cyl_trim_maps_t *maps);
+
+// Fills the first @p cylinders entries of @p out
+void cyl_trim_lookup(const cyl_trim_maps_t *maps, uint16_t rpm, uint16_t load,
+                     uint8_t cylinders, cyl_trim_t *out);
+
+// Applies the trims to a base pulse width and advance, one entry per cylinder
+void cyl_trim_apply(const cyl_trim_t *trim,
+                    uint8_t cylinders,
+                    uint32_t base_pw_us,
+                    uint16_t base_advance_deg10,
+                    uint32_t pw_us[CYL_TRIM_CYLINDERS],
+                    uint16_t advance_deg10[CYL_TRIM_CYLINDERS]);
+
+uint16_t cyl_trim_fuel_to_raw(float pct);
+float cyl_trim_fuel_from_raw(uint16_t raw);
+uint16_t cyl_trim_ign_to_raw(float deg);
+float cyl_trim_ign_from_raw(uint16_t raw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CYL_TRIM_H
@@ -0,0 +1,110 @@
+#ifndef DWELL_CONTROL_H
+#define DWELL_CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "table_interp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Coil dwell: how long each coil charges before its spark.
+ *
+ * - Dwell map over rpm and battery voltage, in microseconds. The defaults
+ *   come from the coil model: the primary current of an L/R circuit,
+ *   i(t) = V/R * (1 - exp(-t R / L)), must reach the peak current that
+ *   stores the spark energy (E = L i^2 / 2), which takes longer on a low
+ *   battery.
+ * - Duty limit: at high rpm the dwell is cut to max_duty of the coil's
+ *   spark period and leaves at least min_off_us for the spark to burn, so
+ *   the coil neither overheats nor starts charging before the last spark
+ *   ended.
+ *
+ * The map is expanded into one rpm row per 0.1 V bucket when it changes.
+ * The planner fills a dwell_plan_t per plan from the live battery voltage
+ * and the drivers only read its dwell_us.
+ */
+
+#define DWELL_RPM_BINS 8U
+#define DWELL_VBAT_BINS 8U
+
+#define DWELL_VBAT_MIN_DV 60U
+#define DWELL_VBAT_MAX_DV 180U
+#define DWELL_VBAT_NOMINAL_DV 135U  // Used while the battery reads 0
+#define DWELL_VBAT_BUCKETS (DWELL_VBAT_MAX_DV - DWELL_VBAT_MIN_DV + 1U)
+
+#define DWELL_MIN_US 500U
+#define DWELL_MAX_US 8000U
+
+// Duty limit, max_duty in 1/10 percent of the spark period
+#define DWELL_MIN_DUTY_X10 100U
+#define DWELL_MAX_DUTY_X10 900U
+#define DWELL_DEFAULT_DUTY_X10 700U
+#define DWELL_MAX_OFF_US 5000U
+#define DWELL_DEFAULT_OFF_US 1000U
+
+// Typical pencil coil
+#define DWELL_COIL_DEFAULT_INDUCTANCE_UH 4000U
+#define DWELL_COIL_DEFAULT_RESISTANCE_MOHM 600U
+#define DWELL_COIL_DEFAULT_PEAK_MA 7000U
+
+// x = rpm, y = battery voltage (dV), value = dwell (us)
+TABLE_2D_DEFINE(dwell_map, DWELL_RPM_BINS, DWELL_VBAT_BINS)
+
+typedef struct {
+    uint16_t inductance_uh;    // primary inductance
+    uint16_t resistance_mohm;  // primary resistance, wiring and driver included
+    uint16_t peak_ma;          // primary current at the spark
+} dwell_coil_t;
+
+typedef struct {
+    dwell_map_t map;
+    dwell_coil_t coil;         // what the map was last generated from
+    uint16_t max_duty_x10;
+    uint16_t min_off_us;
+} dwell_config_t;
+
+// Dwell of one plan
+typedef struct {
+    uint16_t vbat_dv;
+    uint16_t dwell_us;
+    bool duty_limited;         // cut by max_duty or min_off_us
+} dwell_plan_t;
+
+// Map from the default coil, default duty limit
+void dwell_control_init_defaults(dwell_config_t *cfg);
+
+// Checksum matches, axes strictly increasing, cells, coil and limits in range
+bool dwell_control_validate(const dwell_config_t *cfg);
+
+bool dwell_control_coil_valid(const dwell_coil_t *coil);
+
+// Charge time of the coil model at a battery voltage, clamped to
+// DWELL_MIN_US..DWELL_MAX_US (the maximum when the peak is out of reach)
+uint16_t dwell_control_coil_dwell_us(const dwell_coil_t *coil, uint16_t vbat_dv);
+
+// Rewrites every cell from the coil model on the map's own axes
+void dwell_control_fill_from_coil(dwell_config_t *cfg, const dwell_coil_t *coil);
+
+/**
+ * @brief Dwell of one plan
+ *
+ * The map row comes from the 0.1 V bucket cache, rebuilt when the map
+ * changes. Planner context only (the cache is not locked).
+ *
+ * @param cfg Dwell configuration, NULL for the defaults
+ * @param vbat_dv Battery voltage, 0 when unknown
+ * @param clt_c Coolant temperature (hot coils charge shorter, cold longer)
+ * @param rpm Engine speed
+ * @param coil_period_us Time between two sparks of one coil, 0 for no duty limit
+ */
+void dwell_control_prepare(const dwell_config_t *cfg, uint16_t vbat_dv, int16_t clt_c,
+                           uint16_t rpm, uint32_t coil_period_us, dwell_plan_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DWELL_CONTROL_H
@@ -3,6 +3,9 @@
 
 #include "esp_err.h"
 #include "sensor_processing.h"
+#include "engine_layout.h"
+#include "dwell_control.h"
+#include "latency_hist.h"
 
 // Engine parameters
 typedef struct {
@@ -24,11 +27,29 @@ typedef struct {
     uint32_t executor_p99_us;
     uint32_t planner_deadline_miss;
     uint32_t executor_deadline_miss;
-    uint32_t queue_overruns;
+    uint32_t queue_overruns;     // plans refused by a full queue (PLAN_RING_MAILBOX 0)
     uint32_t queue_depth_peak;
-    uint32_t sample_count;
+    uint32_t plans_superseded;   // plans replaced by a newer one before the executor ran
+    uint32_t sample_count;       // planner passes recorded since start/reset
 } engine_perf_stats_t;
 
+// Latency histograms kept by the planner and executor (latency_hist.h)
+typedef enum {
+    ENGINE_PERF_PLANNER = 0,     // whole planner pass
+    ENGINE_PERF_EXECUTOR,        // whole executor pass
+    ENGINE_PERF_SYNC_READ,       // planner: sync snapshot
+    ENGINE_PERF_SENSOR_READ,     // planner: sensor snapshot
+    ENGINE_PERF_TABLE_LOOKUP,    // planner: map set lookups and per-plan models
+    ENGINE_PERF_LAMBDA_PID,      // planner: closed loop, only while enabled
+    ENGINE_PERF_SCHEDULING,      // executor: arming injection and ignition
+    ENGINE_PERF_EDGE_TO_WRITE_TASK,  // tooth capture to compare write, executor path
+    ENGINE_PERF_EDGE_TO_WRITE_ISR,   // tooth capture to compare write, tooth ISR refine
+    ENGINE_PERF_PLANNER_WAKE,    // tooth notify to planner running
+    ENGINE_PERF_EXECUTOR_WAKE,   // planner notify to executor running
+    ENGINE_PERF_CKP_ISR,         // CKP interrupt, entry to exit (sync.h)
+    ENGINE_PERF_STAGE_COUNT,
+} engine_perf_stage_t;
+
 typedef struct {
     uint16_t rpm;
     uint16_t load;
@@ -37,8 +58,16 @@ typedef struct {
     float eoit_target_deg;
     float eoit_fallback_target_deg;
     uint32_t pulsewidth_us;
-    float soi_deg[4];
-    uint32_t delay_us[4];
+    // Per cylinder, index = cylinder - 1 (entries past the layout's count are 0)
+    uint32_t pulsewidth_cyl_us[ENGINE_MAX_CYLINDERS];  // after per-cylinder trims
+    float soi_deg[ENGINE_MAX_CYLINDERS];
+    uint32_t delay_us[ENGINE_MAX_CYLINDERS];
+    uint8_t pulses[ENGINE_MAX_CYLINDERS];  // 2 when split
+    float split_first_pct;                 // 100 = single pulse
+    uint16_t vbat_dv;                      // battery voltage of the plan
+    uint16_t dead_time_us;                 // injector dead time at vbat_dv
+    uint16_t dwell_us;                     // coil dwell of the plan
+    bool dwell_limited;                    // dwell cut by the duty limit
     bool sync_acquired;
     bool map_mode_enabled;
     uint32_t updated_at_us;
@@ -58,10 +87,52 @@ esp_err_t engine_control_set_eoit_map_enabled(bool enabled);
 bool engine_control_get_eoit_map_enabled(void);
 esp_err_t engine_control_set_eoit_map_cell(uint8_t rpm_idx, uint8_t load_idx, float normal);
 esp_err_t engine_control_get_eoit_map_cell(uint8_t rpm_idx, uint8_t load_idx, float *normal);
+// Cylinder count, firing order and coil wiring, persisted. Applied right away
+// before engine_control_init(), otherwise on the next init.
+// ESP_ERR_NOT_SUPPORTED: more injector + coil outputs than MCPWM channels.
+esp_err_t engine_control_set_engine_layout(const engine_layout_t *layout);
+void engine_control_get_engine_layout(engine_layout_t *layout);
+// Per-cylinder trims (cylinder 1..layout count): fuel in % of pulse width, ignition in degrees
+esp_err_t engine_control_set_cyl_trim_cell(uint8_t cylinder, uint8_t rpm_idx, uint8_t load_idx,
+                                           float fuel_pct, float ign_deg);
+esp_err_t engine_control_get_cyl_trim_cell(uint8_t cylinder, uint8_t rpm_idx, uint8_t load_idx,
+                                           float *fuel_pct, float *ign_deg);
+// Split injection: share of the cycle's fuel in the first pulse (100 = no
+// split) and the gap / minimum fuel per pulse, in microseconds
+esp_err_t engine_control_set_split_ratio_cell(uint8_t rpm_idx, uint8_t load_idx, float first_pct);
+esp_err_t engine_control_get_split_ratio_cell(uint8_t rpm_idx, uint8_t load_idx, float *first_pct);
+esp_err_t engine_control_set_split_timing(uint16_t gap_us, uint16_t min_pulse_us);
+esp_err_t engine_control_get_split_timing(uint16_t *gap_us, uint16_t *min_pulse_us);
+// Injector characterization breakpoints (see injector_model.h): dead time at
+// a battery voltage, and short pulse correction (us, may be negative) at a
+// fuel pulse. Breakpoints must stay strictly increasing.
+esp_err_t engine_control_set_injector_dead_time(uint8_t idx, float vbat_v, uint16_t dead_time_us);
+esp_err_t engine_control_get_injector_dead_time(uint8_t idx, float *vbat_v, uint16_t *dead_time_us);
+esp_err_t engine_control_set_injector_short_pulse(uint8_t idx, uint16_t fuel_us, float correction_us);
+esp_err_t engine_control_get_injector_short_pulse(uint8_t idx, uint16_t *fuel_us, float *correction_us);
+// Coil dwell (see dwell_control.h): map cells in us, the coil model that
+// rewrites the whole map, and the duty limit (percent of the spark period,
+// minimum time between dwell end and the next dwell start)
+esp_err_t engine_control_set_dwell_cell(uint8_t rpm_idx, uint8_t vbat_idx, uint16_t dwell_us);
+esp_err_t engine_control_get_dwell_cell(uint8_t rpm_idx, uint8_t vbat_idx, uint16_t *dwell_us);
+esp_err_t engine_control_set_dwell_coil(const dwell_coil_t *coil);
+esp_err_t engine_control_get_dwell_coil(dwell_coil_t *coil);
+esp_err_t engine_control_set_dwell_limits(float max_duty_pct, uint16_t min_off_us);
+esp_err_t engine_control_get_dwell_limits(float *max_duty_pct, uint16_t *min_off_us);
 esp_err_t engine_control_get_injection_diag(engine_injection_diag_t *diag);
 bool engine_control_is_limp_mode(void);
 void engine_control_set_closed_loop_enabled(bool enabled);
 bool engine_control_get_closed_loop_enabled(void);
+// Last-teeth refine of armed events from the tooth ISR instead of the
+// executor (angle_scheduler.h); the executor still arms every event
+void engine_control_set_isr_refine(bool enabled);
+bool engine_control_get_isr_refine(void);
 esp_err_t engine_control_get_perf_stats(engine_perf_stats_t *stats);
+// p50/p95/p99/p99.9/max of one stage in ns, over every pass since start/reset
+esp_err_t engine_control_get_perf_latency(engine_perf_stage_t stage, latency_summary_t *out);
+const char *engine_control_perf_stage_name(engine_perf_stage_t stage);
+// Clears the histograms, maxima, deadline misses, queue peak and the
+// angle scheduler counters
+void engine_control_reset_perf_stats(void);
 
 #endif // ENGINE_CONTROL_H
@@ -0,0 +1,60 @@
+#ifndef ENGINE_LAYOUT_H
+#define ENGINE_LAYOUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cylinder count, firing order and coil wiring.
+ *
+ * Cylinders fire evenly spaced: the cylinder at position p of the firing
+ * order reaches TDC at p * 720 / cylinders degrees of the engine cycle. One
+ * injector output per cylinder; one coil output per cylinder, or with
+ * wasted spark one coil per pair of cylinders 360 degrees apart (even
+ * cylinder counts only). The layout is set once at init, before the output
+ * drivers allocate their channels, and is read-only while the engine runs.
+ */
+
+#define ENGINE_MAX_CYLINDERS 8U
+
+typedef struct {
+    uint8_t cylinders;                           // 1..ENGINE_MAX_CYLINDERS
+    uint8_t firing_order[ENGINE_MAX_CYLINDERS];  // cylinder numbers (1-based), unused tail = 0
+    uint8_t wasted_spark;                        // 1: one coil per cylinder pair
+} engine_layout_t;
+
+// Inline 4, firing order 1-3-4-2, one coil per cylinder
+void engine_layout_default(engine_layout_t *layout);
+
+// Firing order is a permutation of 1..cylinders, wasted spark needs an even count
+bool engine_layout_validate(const engine_layout_t *layout);
+
+// Takes effect for drivers initialized afterwards
+esp_err_t engine_layout_apply(const engine_layout_t *layout);
+
+const engine_layout_t *engine_layout_get(void);
+uint8_t engine_layout_cylinders(void);
+uint8_t engine_layout_coils(void);
+
+// Injector plus coil outputs a layout needs (see mcpwm_output.h for the limit)
+uint8_t engine_layout_output_count(const engine_layout_t *layout);
+
+// TDC of a cylinder (1-based) in the 720 degree cycle, 0 for an unknown cylinder
+float engine_layout_tdc_deg(uint8_t cylinder);
+
+// Coil output (1-based) that fires a cylinder, 0 for an unknown cylinder
+uint8_t engine_layout_coil(uint8_t cylinder);
+
+// Cylinder whose compression stroke a coil fires first in the cycle
+uint8_t engine_layout_coil_cylinder(uint8_t coil);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ENGINE_LAYOUT_H
@@ -66,6 +66,8 @@ typedef enum {
     ESPNOW_MSG_ENGINE_STATUS   = 0x01,  /**< ECU -> Peer: Engine status */
     ESPNOW_MSG_SENSOR_DATA     = 0x02,  /**< ECU -> Peer: Sensor data */
     ESPNOW_MSG_DIAGNOSTIC      = 0x03,  /**< ECU -> Peer: Diagnostic info */
+    ESPNOW_MSG_PERF_STATS      = 0x04,  /**< ECU -> Peer: Latency percentiles */
+    ESPNOW_MSG_TASK_PROFILE    = 0x05,  /**< ECU -> Peer: CPU load, stacks, wake/ISR time */
     ESPNOW_MSG_CONFIG_REQUEST  = 0x10,  /**< Peer -> ECU: Request config */
     ESPNOW_MSG_CONFIG_RESPONSE = 0x11,  /**< ECU -> Peer: Config response */
     ESPNOW_MSG_TABLE_UPDATE    = 0x12,  /**< Peer -> ECU: Table update */
@@ -175,6 +177,80 @@ typedef struct __attribute__((packed)) {
     uint32_t    tooth_count;      /**< Total tooth count */
 } espnow_diagnostic_t;
 
+/**
+ * @brief Stages in a perf stats message: the first ones of engine_perf_stage_t
+ *
+ * The wake and CKP ISR stages after them go in the task profile instead.
+ */
+#define ESPNOW_PERF_STAGES        9
+
+/**
+ * @brief Latency percentiles of one planner/executor stage, in ns
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t    count;            /**< Passes recorded since start/reset */
+    uint32_t    p50_ns;
+    uint32_t    p95_ns;
+    uint32_t    p99_ns;
+    uint32_t    p999_ns;          /**< 99.9th percentile */
+    uint32_t    max_ns;
+} espnow_perf_stage_t;
+
+/**
+ * @brief Perf stats message payload
+ *
+ * Percentiles over every pass since start, from the engine latency
+ * histograms; stages in engine_perf_stage_t order.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t    timestamp_ms;     /**< Message timestamp */
+    uint32_t    planner_deadline_miss;
+    uint32_t    executor_deadline_miss;
+    espnow_perf_stage_t stages[ESPNOW_PERF_STAGES];
+} espnow_perf_stats_t;
+
+/** @brief Task slots in a task profile (core_task_id_t) */
+#define ESPNOW_PROFILE_TASKS      8
+
+/** @brief Latencies in a task profile: planner wake, executor wake, CKP ISR */
+#define ESPNOW_PROFILE_LATENCIES  3
+
+/**
+ * @brief Load and stack of one planned task
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t     task;             /**< core_task_id_t */
+    uint8_t     core;             /**< Core the task ran on */
+    uint16_t    load_permille;    /**< Of one core, over the profile window */
+    uint16_t    stack_free;       /**< Bytes never used (high-water mark) */
+    uint16_t    stack_size;       /**< Bytes */
+} espnow_task_entry_t;
+
+/**
+ * @brief Tail latency of a wake or ISR stage, in ns, since start/reset
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t    p99_ns;
+    uint32_t    max_ns;
+} espnow_latency_tail_t;
+
+/**
+ * @brief Task profile message payload
+ *
+ * Per-core load and per-task load and stack headroom over the window since
+ * the previous profile, from the FreeRTOS run time counters. Only the
+ * planned tasks that exist are listed, task_count of them.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t    timestamp_ms;     /**< Message timestamp */
+    uint32_t    window_ms;        /**< Time the loads are averaged over */
+    uint16_t    core_load_permille[2];
+    uint8_t     task_count;
+    uint8_t     reserved[3];
+    espnow_task_entry_t tasks[ESPNOW_PROFILE_TASKS];
+    espnow_latency_tail_t latency[ESPNOW_PROFILE_LATENCIES];
+} espnow_task_profile_t;
+
 /**
  * @brief Configuration request message payload
  */
@@ -352,6 +428,33 @@ esp_err_t espnow_link_send_sensor_data(const espnow_sensor_data_t *data);
  */
 esp_err_t espnow_link_send_diagnostic(const espnow_diagnostic_t *diag);
 
+/**
+ * @brief Send perf stats message
+ * 
+ * Queues a latency percentile message for transmission to all peers.
+ * 
+ * @param stats Perf stats
+ * @return ESP_OK on success
+ * @return ESP_ERR_INVALID_STATE if not initialized or not started
+ * @return ESP_ERR_INVALID_ARG if stats is NULL
+ * @return ESP_ERR_TIMEOUT if queue is full
+ */
+esp_err_t espnow_link_send_perf_stats(const espnow_perf_stats_t *stats);
+
+/**
+ * @brief Send task profile message
+ * 
+ * Queues a CPU load / stack / wake latency profile for transmission to all
+ * peers.
+ * 
+ * @param profile Task profile
+ * @return ESP_OK on success
+ * @return ESP_ERR_INVALID_STATE if not initialized or not started
+ * @return ESP_ERR_INVALID_ARG if profile is NULL
+ * @return ESP_ERR_TIMEOUT if queue is full
+ */
+esp_err_t espnow_link_send_task_profile(const espnow_task_profile_t *profile);
+
 /**
  * @brief Send configuration response
  * 
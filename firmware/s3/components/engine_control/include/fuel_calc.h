@@ -5,17 +5,31 @@
 #include <stdbool.h>
 #include "s3_control_config.h"
 #include "sensor_processing.h"
+#include "table_interp.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// x = rpm, y = load (MAP kPa * 10)
+TABLE_2D_DEFINE(fuel_ve_map, VE_TABLE_RPM_BINS, VE_TABLE_LOAD_BINS)
+TABLE_2D_DEFINE(fuel_ign_map, IGN_TABLE_RPM_BINS, IGN_TABLE_LOAD_BINS)
+TABLE_2D_DEFINE(fuel_lambda_map, LAMBDA_TABLE_RPM_BINS, LAMBDA_TABLE_LOAD_BINS)
+
 typedef struct {
-    table_16x16_t fuel_table;
-    table_16x16_t ignition_table;
-    table_16x16_t lambda_table;
+    fuel_ve_map_t fuel_table;
+    fuel_ign_map_t ignition_table;
+    fuel_lambda_map_t lambda_table;
 } fuel_calc_maps_t;
 
+// Results of one planner lookup pass over all maps sharing rpm/load axes
+typedef struct {
+    uint16_t ve_x10;
+    uint16_t advance_deg10;
+    uint16_t lambda_target;
+    uint16_t eoit_normal_raw;   // only valid when an EOIT map was given
+} fuel_calc_lookup_t;
+
 void fuel_calc_init_defaults(fuel_calc_maps_t *maps);
 void fuel_calc_reset_interpolation_cache(void);
 
@@ -23,6 +37,27 @@ uint16_t fuel_calc_lookup_ve(const fuel_calc_maps_t *maps, uint16_t rpm, uint16_
 uint16_t fuel_calc_lookup_ignition(const fuel_calc_maps_t *maps, uint16_t rpm, uint16_t load);
 uint16_t fuel_calc_lookup_lambda(const fuel_calc_maps_t *maps, uint16_t rpm, uint16_t load);
 
+// Checksums match and all axes are strictly increasing.
+bool fuel_calc_validate_maps(const fuel_calc_maps_t *maps);
+
+/**
+ * @brief Look up VE, ignition, lambda and (optionally) EOIT in one pass
+ *
+ * The axis search is done once and reused by every table with the same
+ * bins; tables with different bins fall back to their own lookup.
+ *
+ * @param maps Fuel/ignition/lambda maps
+ * @param eoit_map View of the EOIT normal map, or NULL to skip it
+ * @param rpm Engine speed
+ * @param load Load (MAP kPa * 10)
+ * @param out Lookup results
+ */
+void fuel_calc_lookup_all(const fuel_calc_maps_t *maps,
+                          const table_view_t *eoit_map,
+                          uint16_t rpm,
+                          uint16_t load,
+                          fuel_calc_lookup_t *out);
+
 uint32_t fuel_calc_pulsewidth_us(const sensor_data_t *sensors,
                                  uint16_t rpm,
                                  uint16_t ve_x10,
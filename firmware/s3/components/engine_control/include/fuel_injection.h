@@ -4,40 +4,79 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "sync.h"
+#include "engine_layout.h"
+#include "split_injection.h"
+#include "injector_model.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-typedef struct {
-    float cyl_tdc_deg[4];      // TDC angle for each cylinder (0-720)
-} fuel_injection_config_t;
-
 typedef struct {
     float eoi_deg;
     float soi_deg;
     uint32_t delay_us;
+    uint8_t pulses;     // 2 when the cycle's fuel is split
 } fuel_injection_schedule_info_t;
 
-// Initialize fuel injection scheduling
-void fuel_injection_init(const fuel_injection_config_t *config);
+// Initialize fuel injection scheduling; cylinder TDC angles come from engine_layout
+void fuel_injection_init(void);
 
-// Schedule injection using EOI (End of Injection) logic
+// Schedule injection using EOI (End of Injection) logic; the pulse is
+// compensated with the injector model at nominal battery voltage
 bool fuel_injection_schedule_eoi(uint8_t cylinder_id,
                                  float target_eoi_deg,
                                  uint32_t pulsewidth_us,
-                                 const sync_data_t *sync);
+                                 const sync_snapshot_t *sync);
 
 bool fuel_injection_schedule_eoi_ex(uint8_t cylinder_id,
                                      float target_eoi_deg,
                                      uint32_t pulsewidth_us,
-                                     const sync_data_t *sync,
+                                     const sync_snapshot_t *sync,
                                      fuel_injection_schedule_info_t *info);
 
-// Schedule sequential injection for all cylinders
-bool fuel_injection_schedule_sequential(uint32_t pulsewidth_us[4],
-                                         float target_eoi_deg[4],
-                                         const sync_data_t *sync);
+/**
+ * @brief Per-tooth injection update through the angle scheduler
+ *
+ * Same event as fuel_injection_schedule_eoi_ex(), but the comparators are
+ * only written when the event is armed for its cycle or refined on the last
+ * teeth before SOI (see angle_scheduler.h). info is filled on every call.
+ *
+ * With a split the fuel goes out as two pulses gap_us apart, the second
+ * ending at the EOI target; SOI is the start of the first one (see
+ * split_injection.h). Every pulse gets the injector dead time and short
+ * pulse correction on its own.
+ *
+ * @param split Split at the current rpm/load, NULL for a single pulse
+ * @param injector Compensation of the plan (injector_model_prepare()), NULL
+ *        for nominal battery voltage
+ * @return false only if the event cannot be computed (no sync or config); a
+ *         target the driver rejects is retried on the next tooth
+ */
+bool fuel_injection_schedule_eoi_angle(uint8_t cylinder_id,
+                                       float target_eoi_deg,
+                                       uint32_t pulsewidth_us,
+                                       const split_injection_t *split,
+                                       const injector_comp_t *injector,
+                                       const sync_snapshot_t *sync,
+                                       fuel_injection_schedule_info_t *info);
+
+/**
+ * @brief Per-tooth update of every injector from a per-cylinder plan
+ *
+ * Runs fuel_injection_schedule_eoi_angle() for cylinders 1..N with their own
+ * pulse width and EOI target, a shared split and a shared injector
+ * compensation. Every cylinder is attempted.
+ *
+ * @param info Per-cylinder schedule info (index = cylinder - 1), may be NULL
+ * @return false if any cylinder could not be computed
+ */
+bool fuel_injection_schedule_sequential(const uint32_t pulsewidth_us[ENGINE_MAX_CYLINDERS],
+                                        const float target_eoi_deg[ENGINE_MAX_CYLINDERS],
+                                        const split_injection_t *split,
+                                        const injector_comp_t *injector,
+                                        const sync_snapshot_t *sync,
+                                        fuel_injection_schedule_info_t info[ENGINE_MAX_CYLINDERS]);
 
 #ifdef __cplusplus
 }
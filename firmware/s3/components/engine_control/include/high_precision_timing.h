@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_attr.h"
+#include "esp_cpu.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "sdkconfig.h"
@@ -48,9 +49,13 @@ extern "C" {
  * @return Contagem de ciclos do CCOUNT register
  */
 IRAM_ATTR static inline uint32_t hp_get_cycle_count(void) {
+#if defined(__XTENSA__)
     uint32_t ccount;
     __asm__ volatile ("rsr %0, ccount" : "=r"(ccount));
     return ccount;
+#else
+    return (uint32_t)esp_cpu_get_cycle_count();
+#endif
 }
 
 /**
@@ -59,7 +64,11 @@ IRAM_ATTR static inline uint32_t hp_get_cycle_count(void) {
  * @note Usa CCOMPARE register para timing preciso
  */
 IRAM_ATTR static inline void hp_set_cycle_alarm(uint32_t target_cycles) {
+#if defined(__XTENSA__)
     __asm__ volatile ("wsr %0, ccompare0" :: "r"(target_cycles));
+#else
+    (void)target_cycles;
+#endif
 }
 
 /**
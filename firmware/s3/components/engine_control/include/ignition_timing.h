@@ -3,9 +3,24 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "engine_layout.h"
+#include "sync.h"
 
 bool ignition_init(void);
-void ignition_apply_timing(uint16_t advance_deg10, uint16_t rpm);
+
+// dwell_us is the coil charge time of the plan (dwell_control_prepare())
+void ignition_apply_timing(uint16_t advance_deg10, uint16_t dwell_us);
+
+// Per-tooth spark update through the angle scheduler: each coil is written
+// once per cycle and refined on the last teeth before the spark
+void ignition_schedule_angle(uint16_t advance_deg10, uint16_t dwell_us);
+
+// Same, with one advance per cylinder (index = cylinder - 1), e.g. after
+// per-cylinder trims. With wasted spark a coil follows whichever of its
+// cylinders sparks next. sync is the snapshot the caller's pass runs on
+// (NULL to take a fresh one), so injection and spark share one tooth.
+void ignition_schedule_angle_cyl(const uint16_t advance_deg10[ENGINE_MAX_CYLINDERS], uint16_t dwell_us,
+                                 const sync_snapshot_t *sync);
 
 // Get jitter statistics from high-precision timing system
 void ignition_get_jitter_stats(float *avg_us, float *max_us, float *min_us);
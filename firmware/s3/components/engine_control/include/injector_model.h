@@ -0,0 +1,90 @@
+#ifndef INJECTOR_MODEL_H
+#define INJECTOR_MODEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "table_interp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Injector characterization: electrical pulse for a requested fuel pulse.
+ *
+ * pulse = fuel + dead_time(battery) + short_pulse(fuel)
+ *
+ * - Dead time: opening minus closing delay, from a curve over battery
+ *   voltage. The curve is expanded into one entry per 0.1 V bucket when it
+ *   changes, so the planner gets the dead time of a plan with one index.
+ * - Short pulse: correction for the non-linear flow of pulses too short to
+ *   fully open the pintle, from a curve over the fuel pulse. Beyond the last
+ *   bin the last value applies (normally 0).
+ *
+ * The planner fills an injector_comp_t per plan from the live battery
+ * voltage; fuel_injection applies it to every pulse, split pulses included.
+ *
+ * Raw cells:
+ * - dead time: microseconds
+ * - short pulse: correction in microseconds plus INJECTOR_SHORT_PULSE_ZERO
+ */
+
+#define INJECTOR_DEAD_TIME_BINS 8U
+#define INJECTOR_SHORT_PULSE_BINS 8U
+
+#define INJECTOR_VBAT_MIN_DV 60U
+#define INJECTOR_VBAT_MAX_DV 180U
+#define INJECTOR_VBAT_NOMINAL_DV 135U  // Used while the battery reads 0
+#define INJECTOR_VBAT_BUCKETS (INJECTOR_VBAT_MAX_DV - INJECTOR_VBAT_MIN_DV + 1U)
+
+#define INJECTOR_DEAD_TIME_MAX_US 5000U
+#define INJECTOR_SHORT_PULSE_ZERO 1000U
+#define INJECTOR_SHORT_PULSE_MIN_US -1000.0f
+#define INJECTOR_SHORT_PULSE_MAX_US 1000.0f
+
+// x = battery voltage (dV), value = dead time (us)
+TABLE_1D_DEFINE(injector_dead_time_curve, INJECTOR_DEAD_TIME_BINS)
+// x = fuel pulse (us), value = correction (us) + INJECTOR_SHORT_PULSE_ZERO
+TABLE_1D_DEFINE(injector_short_pulse_curve, INJECTOR_SHORT_PULSE_BINS)
+
+typedef struct {
+    injector_dead_time_curve_t dead_time;
+    injector_short_pulse_curve_t short_pulse;
+} injector_model_config_t;
+
+// Compensation for one plan, self-contained so the executor needs no tables
+typedef struct {
+    uint16_t vbat_dv;
+    uint16_t dead_time_us;
+    uint16_t short_bins_us[INJECTOR_SHORT_PULSE_BINS];
+    int16_t short_corr_us[INJECTOR_SHORT_PULSE_BINS];
+} injector_comp_t;
+
+// Typical high impedance injector dead time, no short pulse correction
+void injector_model_init_defaults(injector_model_config_t *cfg);
+
+// Checksums match, axes strictly increasing, cells in range
+bool injector_model_validate(const injector_model_config_t *cfg);
+
+/**
+ * @brief Compensation at the current battery voltage
+ *
+ * The dead time comes from the 0.1 V bucket cache, rebuilt when the dead
+ * time curve changes. Planner context only (the cache is not locked).
+ *
+ * @param cfg Characterization, NULL for the defaults
+ * @param vbat_dv Battery voltage, 0 when unknown
+ */
+void injector_model_prepare(const injector_model_config_t *cfg, uint16_t vbat_dv, injector_comp_t *out);
+
+// Electrical pulse for a fuel pulse; comp NULL leaves the pulse unchanged
+uint32_t injector_model_pulse_us(const injector_comp_t *comp, uint32_t fuel_us);
+
+uint16_t injector_model_short_to_raw(float correction_us);
+float injector_model_short_from_raw(uint16_t raw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INJECTOR_MODEL_H
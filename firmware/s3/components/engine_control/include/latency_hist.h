@@ -0,0 +1,85 @@
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_attr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Log-linear latency histogram (HDR style).
+ *
+ * Values below LATENCY_HIST_SUB_COUNT get one bucket each. Above that, every
+ * power of two is split into LATENCY_HIST_SUB_COUNT equal buckets, so a
+ * bucket is at most 1/16 (6.25 %) of its value wide at any magnitude.
+ * Values of 2^LATENCY_HIST_RANGE_BITS and more only count as overflow; the
+ * max is kept exactly.
+ *
+ * Recording is a few instructions and one relaxed atomic increment per
+ * counter, with no lock, so any task or ISR can record. Readers walk the
+ * fixed bucket array: the cost of a percentile query does not depend on the
+ * number of samples, and the tail is never lost to a sample window.
+ * A query that races with recorders may be off by the samples in flight.
+ */
+
+#define LATENCY_HIST_SUB_BITS 4U
+#define LATENCY_HIST_SUB_COUNT (1U << LATENCY_HIST_SUB_BITS)
+#define LATENCY_HIST_RANGE_BITS 22U  // 4194303 cycles, 17 ms at 240 MHz
+#define LATENCY_HIST_BUCKETS ((LATENCY_HIST_RANGE_BITS - LATENCY_HIST_SUB_BITS + 1U) * LATENCY_HIST_SUB_COUNT)
+
+typedef struct {
+    uint32_t counts[LATENCY_HIST_BUCKETS];
+    uint32_t overflow;           // values >= 2^LATENCY_HIST_RANGE_BITS
+    uint32_t total;
+    uint32_t max;
+} latency_hist_t;
+
+// Percentiles are the highest value of the bucket they fall in, capped at max
+typedef struct {
+    uint32_t count;
+    uint32_t p50;
+    uint32_t p95;
+    uint32_t p99;
+    uint32_t p999;
+    uint32_t max;
+    uint32_t overflow;
+} latency_summary_t;
+
+IRAM_ATTR static inline uint32_t latency_hist_bucket(uint32_t value) {
+    if (value < LATENCY_HIST_SUB_COUNT) {
+        return value;
+    }
+    uint32_t msb = 31U - (uint32_t)__builtin_clz(value);
+    uint32_t shift = msb - LATENCY_HIST_SUB_BITS;
+    return shift * LATENCY_HIST_SUB_COUNT + (value >> shift);
+}
+
+IRAM_ATTR static inline void latency_hist_record(latency_hist_t *h, uint32_t value) {
+    if (value < (1UL << LATENCY_HIST_RANGE_BITS)) {
+        __atomic_fetch_add(&h->counts[latency_hist_bucket(value)], 1U, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(&h->overflow, 1U, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&h->total, 1U, __ATOMIC_RELAXED);
+    uint32_t max = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+    while (value > max &&
+           !__atomic_compare_exchange_n(&h->max, &max, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void latency_hist_reset(latency_hist_t *h);
+
+// Highest value that falls in @p bucket
+uint32_t latency_hist_bucket_max(uint32_t bucket);
+
+// One pass over the buckets for p50, p95, p99 and p99.9
+void latency_hist_summary(const latency_hist_t *h, latency_summary_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LATENCY_HIST_H
@@ -3,6 +3,10 @@
 
 #include "esp_err.h"
 #include "fuel_calc.h"
+#include "cyl_trim.h"
+#include "split_injection.h"
+#include "injector_model.h"
+#include "dwell_control.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -11,6 +15,24 @@ extern "C" {
 esp_err_t map_storage_load(fuel_calc_maps_t *maps);
 esp_err_t map_storage_save(const fuel_calc_maps_t *maps);
 
+// Per-cylinder fuel/ignition trims, stored under their own key. Both share
+// one static buffer: call at init or with the map mutex held. A failed load
+// may leave @p trims partly written.
+esp_err_t map_storage_load_trims(cyl_trim_maps_t *trims);
+esp_err_t map_storage_save_trims(const cyl_trim_maps_t *trims);
+
+// Split injection ratio map, gap and minimum pulse, under their own key
+esp_err_t map_storage_load_split(split_injection_config_t *split);
+esp_err_t map_storage_save_split(const split_injection_config_t *split);
+
+// Injector dead time and short pulse curves, under their own key
+esp_err_t map_storage_load_injector(injector_model_config_t *injector);
+esp_err_t map_storage_save_injector(const injector_model_config_t *injector);
+
+// Dwell map, coil model and duty limit, under their own key
+esp_err_t map_storage_load_dwell(dwell_config_t *dwell);
+esp_err_t map_storage_save_dwell(const dwell_config_t *dwell);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,6 +16,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "mcpwm_ignition.h"
+#include "timebase.h"
 #include "esp_attr.h"
 
 #ifdef __cplusplus
@@ -24,6 +25,9 @@ extern "C" {
 
 /**
  * @brief Inicializa o driver de ignição de alta precisão
+ *
+ * Aloca um canal do pool mcpwm_output por bobina do engine_layout.
+ *
  * @return true se bem-sucedido
  */
 bool mcpwm_ignition_hp_init(void);
@@ -33,52 +37,91 @@ bool mcpwm_ignition_hp_init(void);
  * 
  * Esta função usa compare absoluto em vez de recalcular delays.
  * O timer roda continuamente sem reinício por evento.
+ * Valores são módulo o período de 30 s: a faísca está à frente se cair no
+ * próximo meio período, e o dwell pode começar antes do wrap.
  * 
  * @note IRAM_ATTR - função crítica de timing, pode ser chamada em ISR context
  * 
- * @param cylinder_id ID do cilindro (1-4)
- * @param target_us Tempo absoluto desde o início da janela (em microssegundos)
- * @param rpm RPM atual para cálculo de dwell
- * @param battery_voltage Tensão da bateria para cálculo de dwell
+ * O dwell chega pronto (dwell_control_prepare() no planejador): o driver
+ * não faz conta em ponto flutuante por faísca.
+ *
+ * @param cylinder_id ID da bobina (1 a engine_layout_coils())
+ * @param target_us Valor do contador na faísca (0..período-1)
+ * @param dwell_us Tempo de carga da bobina antes da faísca
  * @param current_counter Valor atual do contador do timer
- * @return true se bem-sucedido
+ * @return true se bem-sucedido (false conta como descarte em get_sched_stats)
  */
 IRAM_ATTR bool mcpwm_ignition_hp_schedule_one_shot_absolute(
     uint8_t cylinder_id,
     uint32_t target_us,
-    uint16_t rpm,
-    float battery_voltage,
+    uint32_t dwell_us,
     uint32_t current_counter);
 
+/**
+ * @brief Agenda ignição num instante da base de tempo compartilhada (timebase.h)
+ *
+ * O instante da faísca é convertido para o contador do próprio canal, sem
+ * usar o contador de outro timer.
+ *
+ * @note IRAM_ATTR - função crítica de timing
+ *
+ * @param cylinder_id ID da bobina (1 a engine_layout_coils())
+ * @param spark_us Instante da faísca na base de tempo compartilhada
+ * @param dwell_us Tempo de carga da bobina antes da faísca
+ * @return true se bem-sucedido (false se o instante já passou)
+ */
+IRAM_ATTR bool mcpwm_ignition_hp_schedule_at(uint8_t cylinder_id, uint64_t spark_us, uint32_t dwell_us);
+
 /**
  * @brief Agenda múltiplos cilindros sequencialmente
- * @param rpm RPM atual
- * @param battery_voltage Tensão da bateria
+ * @param dwell_us Tempo de carga das bobinas
  * @param base_target_us Tempo base em microssegundos
  * @param cylinder_offsets Array de offsets por cilindro
  * @return true se todos agendados com sucesso
  */
 bool mcpwm_ignition_hp_schedule_sequential_absolute(
-    uint16_t rpm,
-    float battery_voltage,
+    uint32_t dwell_us,
     uint32_t base_target_us,
-    uint32_t cylinder_offsets[4]);
+    uint32_t cylinder_offsets[ENGINE_MAX_CYLINDERS]);
 
 /**
  * @brief Para cilindro específico
- * @param cylinder_id ID do cilindro (1-4)
+ * @param cylinder_id ID da bobina (1 a engine_layout_coils())
  * @return true se bem-sucedido
  */
 bool mcpwm_ignition_hp_stop_cylinder(uint8_t cylinder_id);
 
+/**
+ * @brief Para todas as bobinas (saídas forçadas em baixo até o próximo agendamento)
+ * @return true se bem-sucedido
+ */
+bool mcpwm_ignition_hp_stop_all(void);
+
 /**
  * @brief Obtém status do canal de ignição
- * @param cylinder_id ID do cilindro (1-4)
+ * @param cylinder_id ID da bobina (1 a engine_layout_coils())
  * @param status Ponteiro para estrutura de status
  * @return true se bem-sucedido
  */
 bool mcpwm_ignition_hp_get_status(uint8_t cylinder_id, mcpwm_ignition_status_t *status);
 
+/**
+ * @brief Obtém contadores de agendamento do canal
+ *
+ * Eventos escritos, janelas que cruzam o wrap do período e eventos
+ * descartados (faísca já passada ou fora do período).
+ *
+ * @param cylinder_id ID da bobina (1 a engine_layout_coils())
+ * @param[out] out Contadores do canal
+ * @return true se bem-sucedido
+ */
+bool mcpwm_ignition_hp_get_sched_stats(uint8_t cylinder_id, timebase_compare_stats_t *out);
+
+/**
+ * @brief Zera os contadores de agendamento de todos os canais
+ */
+void mcpwm_ignition_hp_reset_sched_stats(void);
+
 /**
  * @brief Atualiza preditor de fase com medição
  * @note IRAM_ATTR - função crítica de timing
@@ -109,7 +152,7 @@ void mcpwm_ignition_hp_apply_latency_compensation(float *timing_us, float batter
  * @note IRAM_ATTR - função crítica de timing, pode ser chamada em ISR context
  * @note Esta função deve ser usada para obter o tempo atual real para cálculos de timing
  * 
- * @param cylinder_id ID do cilindro (0-3)
+ * @param cylinder_id ID da bobina (0 a engine_layout_coils()-1)
  * @return Valor atual do contador em microssegundos, ou 0 se inválido
  */
 IRAM_ATTR uint32_t mcpwm_ignition_hp_get_counter(uint8_t cylinder_id);
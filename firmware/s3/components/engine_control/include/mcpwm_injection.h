@@ -8,6 +8,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include "engine_layout.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,7 +22,7 @@ typedef struct {
     uint32_t timer_resolution_bits;  // Timer resolution in bits
     uint32_t min_pulsewidth_us;      // Minimum pulsewidth in microseconds
     uint32_t max_pulsewidth_us;      // Maximum pulsewidth in microseconds
-    int gpio_nums[4];                // GPIO numbers for each injector
+    int gpio_nums[ENGINE_MAX_CYLINDERS];                // GPIO numbers for each injector
 } mcpwm_injection_config_t;
 
 /**
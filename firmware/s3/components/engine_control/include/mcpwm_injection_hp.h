@@ -7,6 +7,8 @@
  * - Compare absoluto em ticks (sem recalculação de delay)
  * - Leitura direta de contador do timer
  * - Funções críticas marcadas com IRAM_ATTR para execução em ISR
+ * - Até MCPWM_INJECTION_MAX_PULSES pulsos por ciclo (injeção dividida),
+ *   armados um a um pela ISR de fim do pulso anterior
  */
 
 #ifndef MCPWM_INJECTION_HP_H
@@ -15,14 +17,33 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "mcpwm_injection.h"
+#include "timebase.h"
 #include "esp_attr.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define MCPWM_INJECTION_MAX_PULSES 3U
+
+// Um pulso na base de tempo compartilhada (timebase.h)
+typedef struct {
+    uint64_t start_us;
+    uint32_t pulsewidth_us;
+} mcpwm_injection_pulse_t;
+
+typedef struct {
+    uint32_t lists;      // Listas aceitas (primeiro pulso armado)
+    uint32_t rearmed;    // Pulsos armados pela ISR de fim do anterior
+    uint32_t dropped;    // Pulsos da fila perdidos: início já passado na ISR
+    uint32_t deferred;   // Listas recusadas com a lista atual em andamento
+} mcpwm_injection_pulse_stats_t;
+
 /**
  * @brief Inicializa o driver de injeção de alta precisão
+ *
+ * Aloca um canal do pool mcpwm_output por cilindro do engine_layout.
+ *
  * @return true se bem-sucedido
  */
 bool mcpwm_injection_hp_init(void);
@@ -39,14 +60,16 @@ bool mcpwm_injection_hp_configure(const mcpwm_injection_config_t *config);
  * 
  * Esta função usa compare absoluto em vez de recalcular delays.
  * O timer roda continuamente sem reinício por evento.
+ * Valores são módulo o período de 30 s: o início está à frente se cair no
+ * próximo meio período, e o fim do pulso pode cair depois do wrap.
  * 
  * @note IRAM_ATTR - função crítica de timing, pode ser chamada em ISR context
  * 
- * @param cylinder_id ID do injetor (0-3)
- * @param delay_us Delay absoluto desde o início da janela (em microssegundos)
+ * @param cylinder_id ID do injetor (0 a cilindros-1)
+ * @param delay_us Valor do contador no início da injeção (0..período-1)
  * @param pulsewidth_us Largura de pulso desejada
  * @param current_counter Valor atual do contador do timer
- * @return true se bem-sucedido
+ * @return true se bem-sucedido (false conta como descarte em get_sched_stats)
  */
 IRAM_ATTR bool mcpwm_injection_hp_schedule_one_shot_absolute(
     uint8_t cylinder_id,
@@ -54,6 +77,43 @@ IRAM_ATTR bool mcpwm_injection_hp_schedule_one_shot_absolute(
     uint32_t pulsewidth_us,
     uint32_t current_counter);
 
+/**
+ * @brief Agenda injeção num instante da base de tempo compartilhada (timebase.h)
+ *
+ * O instante (ex.: captura do dente + atraso angular) é convertido para o
+ * contador do próprio canal, sem usar o contador de outro timer.
+ *
+ * @note IRAM_ATTR - função crítica de timing
+ *
+ * @param cylinder_id ID do injetor (0 a cilindros-1)
+ * @param start_us Início da injeção na base de tempo compartilhada
+ * @param pulsewidth_us Largura de pulso desejada
+ * @return true se bem-sucedido (false se o instante já passou)
+ */
+IRAM_ATTR bool mcpwm_injection_hp_schedule_at(uint8_t cylinder_id, uint64_t start_us, uint32_t pulsewidth_us);
+
+/**
+ * @brief Agenda os pulsos de um ciclo (injeção dividida)
+ *
+ * O primeiro pulso é armado agora; os demais ficam na fila do canal e cada
+ * um é armado pela ISR de fim do pulso anterior, então o intervalo entre
+ * pulsos precisa cobrir a latência dessa ISR. Uma nova lista substitui a
+ * fila (refinamento do mesmo ciclo) enquanto o primeiro pulso não começou.
+ * Com a lista atual em andamento a chamada falha: uma lista que começa
+ * depois dela é o próximo ciclo e é repetida no próximo dente.
+ * mcpwm_injection_hp_schedule_at() é o caso de um pulso só.
+ *
+ * @note IRAM_ATTR - função crítica de timing
+ *
+ * @param cylinder_id ID do injetor (0 a cilindros-1)
+ * @param pulses Pulsos em ordem, instantes na base de tempo compartilhada
+ * @param count 1..MCPWM_INJECTION_MAX_PULSES
+ * @return true se o primeiro pulso foi armado
+ */
+IRAM_ATTR bool mcpwm_injection_hp_schedule_pulses_at(uint8_t cylinder_id,
+                                                      const mcpwm_injection_pulse_t *pulses,
+                                                      uint8_t count);
+
 /**
  * @brief Agenda múltiplos injetores sequencialmente
  * @note IRAM_ATTR - função crítica de timing
@@ -67,12 +127,12 @@ IRAM_ATTR bool mcpwm_injection_hp_schedule_one_shot_absolute(
 IRAM_ATTR bool mcpwm_injection_hp_schedule_sequential_absolute(
     uint32_t base_delay_us,
     uint32_t pulsewidth_us,
-    uint32_t cylinder_offsets[4],
+    uint32_t cylinder_offsets[ENGINE_MAX_CYLINDERS],
     uint32_t current_counter);
 
 /**
  * @brief Para injetor específico
- * @param cylinder_id ID do injetor (0-3)
+ * @param cylinder_id ID do injetor (0 a cilindros-1)
  * @return true se bem-sucedido
  */
 bool mcpwm_injection_hp_stop(uint8_t cylinder_id);
@@ -85,12 +145,37 @@ bool mcpwm_injection_hp_stop_all(void);
 
 /**
  * @brief Obtém status do canal de injeção
- * @param cylinder_id ID do injetor (0-3)
+ * @param cylinder_id ID do injetor (0 a cilindros-1)
  * @param status Ponteiro para estrutura de status
  * @return true se bem-sucedido
  */
 bool mcpwm_injection_hp_get_status(uint8_t cylinder_id, mcpwm_injector_channel_t *status);
 
+/**
+ * @brief Obtém contadores de agendamento do canal
+ *
+ * Eventos escritos, pulsos que cruzam o wrap do período e eventos
+ * descartados (início já passado ou fora do período).
+ *
+ * @param cylinder_id ID do injetor (0 a cilindros-1)
+ * @param[out] out Contadores do canal
+ * @return true se bem-sucedido
+ */
+bool mcpwm_injection_hp_get_sched_stats(uint8_t cylinder_id, timebase_compare_stats_t *out);
+
+/**
+ * @brief Obtém contadores da fila de pulsos do canal
+ * @param cylinder_id ID do injetor (0 a cilindros-1)
+ * @param[out] out Contadores do canal
+ * @return true se bem-sucedido
+ */
+bool mcpwm_injection_hp_get_pulse_stats(uint8_t cylinder_id, mcpwm_injection_pulse_stats_t *out);
+
+/**
+ * @brief Zera os contadores de agendamento e da fila de pulsos de todos os canais
+ */
+void mcpwm_injection_hp_reset_sched_stats(void);
+
 /**
  * @brief Obtém estatísticas de jitter
  * @param[out] avg_us Jitter médio em microssegundos
@@ -100,7 +185,9 @@ bool mcpwm_injection_hp_get_status(uint8_t cylinder_id, mcpwm_injector_channel_t
 void mcpwm_injection_hp_get_jitter_stats(float *avg_us, float *max_us, float *min_us);
 
 /**
- * @brief Aplica compensação de latência física
+ * @brief Aplica compensação de latência física (modelo linear legado)
+ * @note O agendamento de injeção usa injector_model.h (curva de tempo morto
+ *       por tensão e correção de pulso curto); mantida para chamadas antigas
  * @param[in,out] pulsewidth_us Ponteiro para largura de pulso (será modificado)
  * @param battery_voltage Tensão da bateria em volts
  * @param temperature Temperatura em Celsius
@@ -113,7 +200,7 @@ void mcpwm_injection_hp_apply_latency_compensation(float *pulsewidth_us, float b
  * @note IRAM_ATTR - função crítica de timing, pode ser chamada em ISR context
  * @note Esta função deve ser usada para obter o tempo atual real para cálculos de timing
  * 
- * @param cylinder_id ID do injetor (0-3)
+ * @param cylinder_id ID do injetor (0 a cilindros-1)
  * @return Valor atual do contador em microssegundos, ou 0 se inválido
  */
 IRAM_ATTR uint32_t mcpwm_injection_hp_get_counter(uint8_t cylinder_id);
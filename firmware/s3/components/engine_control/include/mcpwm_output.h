@@ -0,0 +1,118 @@
+/**
+ * @file mcpwm_output.h
+ * @brief Pool de canais de saída MCPWM compartilhado por injeção e ignição
+ *
+ * O S3 tem 2 grupos MCPWM, cada um com 3 timers e 3 operadores de 2
+ * comparadores e 2 geradores. Um timer por canal esgota o hardware com
+ * 6 saídas, então o pool usa:
+ * - Um timer contínuo por grupo, ligado a todos os operadores do grupo e
+ *   amarrado à base de tempo compartilhada (timebase.h)
+ * - Canal dedicado: um gerador com 2 comparadores (início e fim)
+ * - Canal compartilhado: os 2 geradores de um operador com 1 comparador
+ *   cada; o gerador alterna (TOGGLE) no compare e a ISR do comparador o
+ *   reescreve com o fim do pulso logo após a borda de início. As duas
+ *   bordas continuam saindo pelo hardware.
+ *
+ * Operadores só são divididos quando os canais pedidos não cabem em canais
+ * dedicados: até 6 canais nenhum é compartilhado, 12 é o máximo.
+ *
+ * Como o timer não para, um compare esquecido casa de novo a cada período.
+ * A ISR de fim de pulso de todo canal força a saída em baixo até o próximo
+ * arm, então um canal sem evento novo fica quieto (sem pulso fantasma 30 s
+ * depois).
+ */
+
+#ifndef MCPWM_OUTPUT_H
+#define MCPWM_OUTPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driver/gpio.h"
+#include "driver/mcpwm_timer.h"
+#include "driver/mcpwm_cmpr.h"
+#include "driver/mcpwm_gen.h"
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "soc/soc_caps.h"
+#include "timebase.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MCPWM_OUTPUT_PERIOD_TICKS 30000000UL  // 30 segundos em ticks de 1us
+#define MCPWM_OUTPUT_OPERATORS (SOC_MCPWM_GROUPS * SOC_MCPWM_OPERATORS_PER_GROUP)
+#define MCPWM_OUTPUT_MAX_CHANNELS (MCPWM_OUTPUT_OPERATORS * SOC_MCPWM_GENERATORS_PER_OPERATOR)
+
+typedef struct {
+    mcpwm_timer_handle_t timer;      // Timer do grupo (compartilhado)
+    const timebase_mcpwm_t *tb;      // Offset desse timer na base de tempo
+    mcpwm_cmpr_handle_t cmp_start;   // Único comparador se shared
+    mcpwm_cmpr_handle_t cmp_end;     // NULL se shared
+    mcpwm_gen_handle_t gen;
+    gpio_num_t gpio;
+    uint8_t group_id;
+    bool shared;
+    volatile uint8_t phase;          // shared: aguardando início / fim
+    volatile uint32_t end_ticks;     // Fim do último arm (shared: escrito pela ISR)
+    void (*end_cb)(void *ctx);       // Chamada na ISR ao fim de cada pulso
+    void *end_ctx;
+} mcpwm_output_t;
+
+typedef struct {
+    uint8_t channels;          // Canais reservados em mcpwm_output_init()
+    uint8_t allocated;
+    uint8_t timers;            // Um por grupo em uso
+    uint8_t operators;
+    uint8_t shared_operators;  // Operadores com 2 canais de 1 comparador
+    uint32_t isr_rearms;       // Fins escritos pela ISR do comparador
+    uint32_t late_ends;        // Fim já passado na ISR: pulso fechado na hora
+} mcpwm_output_info_t;
+
+/**
+ * @brief Reserva timers e operadores para @p channels canais
+ * @return ESP_ERR_NOT_SUPPORTED se não couberem no hardware
+ */
+esp_err_t mcpwm_output_init(uint8_t channels);
+
+/**
+ * @brief Cria o próximo canal reservado no pino @p gpio
+ *
+ * Os primeiros canais alocados ficam com os operadores dedicados.
+ */
+esp_err_t mcpwm_output_alloc(gpio_num_t gpio, mcpwm_output_t **out);
+
+/**
+ * @brief Escreve um pulso de start_ticks a end_ticks no contador do canal
+ *
+ * Com o pulso em andamento só o fim muda. Num canal compartilhado, um
+ * início que já passou começa o pulso imediatamente.
+ *
+ * @note IRAM_ATTR - chamada no caminho crítico dos drivers
+ */
+IRAM_ATTR void mcpwm_output_arm(mcpwm_output_t *ch, uint32_t start_ticks, uint32_t end_ticks,
+                                uint32_t counter);
+
+/**
+ * @brief Chama @p cb na ISR do comparador a cada fim de pulso do canal
+ *
+ * A saída já desceu e está forçada em baixo quando @p cb roda, que pode
+ * armar o próximo pulso com mcpwm_output_arm().
+ *
+ * @note @p cb deve ser IRAM_ATTR
+ */
+esp_err_t mcpwm_output_set_end_callback(mcpwm_output_t *ch, void (*cb)(void *ctx), void *ctx);
+
+// Força a saída em nível baixo até o próximo arm
+esp_err_t mcpwm_output_stop(mcpwm_output_t *ch);
+
+void mcpwm_output_get_info(mcpwm_output_info_t *out);
+
+// Libera todos os canais, operadores e timers
+void mcpwm_output_deinit(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MCPWM_OUTPUT_H
@@ -0,0 +1,100 @@
+#ifndef OUTPUT_CAPTURE_H
+#define OUTPUT_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "driver/mcpwm_timer.h"
+#include "engine_layout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Measured output timing.
+ *
+ * Injector and coil pins are read back (MCPWM generator io_loop_back) and
+ * every transition is timestamped like sync.c timestamps CKP: a GPIO ETM
+ * event triggers a GPTimer capture, one GPTimer per output kind. The GPIO
+ * ISR converts the capture to the channel's MCPWM counter and matches it to
+ * the compare value the driver armed for that transition (rising = start of
+ * injection / dwell, falling = end of injection / spark).
+ *
+ * The S3 has 8 GPIO ETM event channels and sync uses two, so not every pin
+ * gets a hardware timestamp: coils are registered first; pins left without
+ * an ETM event are timestamped at GPIO ISR entry instead (error includes
+ * interrupt latency, flagged by hw_timestamp = false). Two pins of one kind
+ * switching within one ISR latency share the later capture.
+ *
+ * A transition whose target was just reached when the channel is armed
+ * again (split injection arms the next pulse from the end-of-pulse ISR)
+ * stays matchable until its edge is recorded.
+ */
+
+#define OUTPUT_CAPTURE_CHANNELS ENGINE_MAX_CYLINDERS
+#define OUTPUT_CAPTURE_WINDOW 128U       // Error samples kept per channel
+
+typedef enum {
+    OUTPUT_CAPTURE_INJECTION = 0,
+    OUTPUT_CAPTURE_IGNITION,
+    OUTPUT_CAPTURE_KIND_COUNT,
+} output_capture_kind_t;
+
+typedef struct {
+    uint32_t armed;          // Transitions expected, a refined target counted once
+    uint32_t matched;        // Edges matched to a target
+    uint32_t missed;         // Target passed without its edge
+    uint32_t pending;        // Still expected: armed = matched + missed + pending
+    uint32_t stray;          // Edges with no pending target
+    uint32_t samples;        // Samples behind the percentiles (up to OUTPUT_CAPTURE_WINDOW)
+    uint32_t p50_us;         // |edge - target|, microseconds
+    uint32_t p99_us;
+    uint32_t max_us;         // Since start/reset, not only the window
+    uint32_t p50_cdeg;       // Same error in crank angle, 1/100 degree
+    uint32_t p99_cdeg;
+    uint32_t max_cdeg;
+    bool hw_timestamp;       // ETM capture (false: timestamped in the ISR)
+} output_capture_stats_t;
+
+// Creates the capture timers; call before the output drivers register their pins
+esp_err_t output_capture_init(void);
+void output_capture_deinit(void);
+
+/**
+ * @brief Start timestamping one output pin
+ *
+ * @param kind Injection or ignition
+ * @param channel Driver channel 0..OUTPUT_CAPTURE_CHANNELS-1
+ * @param gpio Output pin, with its generator created with io_loop_back
+ * @param timer MCPWM timer the channel compares against
+ * @param period_ticks Period of that timer
+ */
+esp_err_t output_capture_register(output_capture_kind_t kind,
+                                  uint8_t channel,
+                                  gpio_num_t gpio,
+                                  mcpwm_timer_handle_t timer,
+                                  uint32_t period_ticks);
+
+/**
+ * @brief Record the compare values just written for a channel
+ *
+ * Transitions whose target is already behind @p counter are not expected
+ * (e.g. dwell start when only the spark is refined).
+ */
+void output_capture_arm(output_capture_kind_t kind,
+                        uint8_t channel,
+                        uint32_t start_ticks,
+                        uint32_t end_ticks,
+                        uint32_t counter);
+
+// Per-channel statistics, 1-based (injector = cylinder, coil number for ignition)
+esp_err_t output_capture_get_stats(output_capture_kind_t kind, uint8_t cylinder, output_capture_stats_t *out);
+void output_capture_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OUTPUT_CAPTURE_H
@@ -0,0 +1,105 @@
+#ifndef REPLAY_CAPTURE_H
+#define REPLAY_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_attr.h"
+#include "engine_layout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Input capture for offline replay.
+ *
+ * While running, the recorder stores every input the planner depends on as
+ * fixed-size records stamped on the shared timebase (timebase.h):
+ *
+ * - CKP and CMP edges, at their capture time (sync.c)
+ * - ADC blocks: the raw value of every sensor channel after a block of
+ *   conversions, stored only when one of them changed
+ * - CAN frames as received by the lambda task, before any filtering
+ *
+ * A capture is a replay_capture_header_t followed by header.records records,
+ * little endian, exactly as they sit in memory. The host replay tool
+ * (firmware/host/replay) feeds them back through the real sync, sensor,
+ * planner and driver code on the virtual clock.
+ *
+ * Records go to a caller-provided buffer under a spinlock, from the sync
+ * ISRs and the sensor / CAN tasks. When the buffer is full the recorder
+ * either drops new records or overwrites the oldest ones (flight recorder),
+ * and counts what it lost. The buffer is read back after replay_capture_stop().
+ */
+
+#define REPLAY_CAPTURE_MAGIC 0x52534D45U  // "EMSR" on disk
+#define REPLAY_CAPTURE_VERSION 1U
+#define REPLAY_ADC_CHANNELS 8U
+
+typedef enum {
+    REPLAY_RECORD_CKP = 1,
+    REPLAY_RECORD_CMP = 2,
+    REPLAY_RECORD_ADC = 3,
+    REPLAY_RECORD_CAN = 4,
+} replay_record_type_t;
+
+typedef struct {
+    uint64_t time_us;            // Shared timebase
+    uint8_t type;                // replay_record_type_t
+    uint8_t count;               // ADC: channels, CAN: data length
+    uint16_t reserved;
+    uint32_t seq;                // Record number since start; gaps show overwritten records
+    union {
+        uint16_t adc_raw[REPLAY_ADC_CHANNELS];  // Indexed by ADC channel
+        struct {
+            uint32_t identifier;
+            uint8_t data[8];
+        } can;
+    } u;
+} replay_record_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;        // sizeof(replay_record_t)
+    uint32_t records;            // Records following the header
+    uint32_t dropped;            // Lost to a full buffer (not stored or overwritten)
+    uint64_t start_us;           // Shared timebase at replay_capture_start()
+    int32_t ckp_gpio;
+    int32_t cmp_gpio;
+    engine_layout_t layout;      // Layout the capture ran with
+} replay_capture_header_t;
+
+/**
+ * @brief Starts recording into @p buffer
+ *
+ * @param buffer Storage for @p capacity records, owned by the caller until stop
+ * @param overwrite true: keep the latest records when full, false: keep the first ones
+ * @return ESP_ERR_INVALID_STATE if a capture is running
+ */
+esp_err_t replay_capture_start(replay_record_t *buffer, uint32_t capacity, bool overwrite);
+
+// Stops recording; the buffer can then be read with replay_capture_copy()
+void replay_capture_stop(void);
+
+bool replay_capture_is_running(void);
+
+/**
+ * @brief Copies the stopped capture, oldest record first
+ *
+ * @param[out] header Filled for the copied records, may be NULL
+ * @return Records copied (at most @p max)
+ */
+uint32_t replay_capture_copy(replay_capture_header_t *header, replay_record_t *out, uint32_t max);
+
+// Hooks; they return at once while no capture is running
+IRAM_ATTR void replay_capture_edge(replay_record_type_t type, uint64_t time_us, bool from_isr);
+void replay_capture_adc(const uint16_t *raw, uint8_t channels);
+void replay_capture_can(uint32_t identifier, const uint8_t *data, uint8_t dlc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // REPLAY_CAPTURE_H
@@ -48,23 +48,82 @@
 #define SENSOR_TASK_PRIORITY 9
 #define COMM_TASK_PRIORITY 8
 #define MONITOR_TASK_PRIORITY 7
+#define ESPNOW_TASK_PRIORITY 5
+#define CLI_TASK_PRIORITY 3
+#define LOGGER_TASK_PRIORITY 2
 
 // Task stack sizes
 #define CONTROL_TASK_STACK 4096
 #define SENSOR_TASK_STACK 4096
 #define COMM_TASK_STACK 4096
 #define MONITOR_TASK_STACK 3072
-
-// Core affinity (-1 means no pinning)
+#define ESPNOW_TASK_STACK 4096
+#define CLI_TASK_STACK 4096
+#define LOGGER_TASK_STACK 4096
+
+// Core affinity (-1 means no pinning). Core 1 only runs crank capture and
+// event scheduling: its tasks and the sync/MCPWM/output capture interrupts.
+// Sensors, CAN, ESP-NOW, Wi-Fi, CLI and logging stay on core 0. The table
+// that applies this at init is in core_plan.c.
 #define CONTROL_TASK_CORE 1
 #define SENSOR_TASK_CORE 0
 #define COMM_TASK_CORE 0
 #define MONITOR_TASK_CORE 0
 
+// Angle-domain scheduling (angle_scheduler.h): an event is armed once it is
+// within ANGLE_SCHED_ARM_DEG (one revolution covers the longest dwell at
+// MAX_RPM), then rewritten only on the last ANGLE_SCHED_REFINE_TEETH teeth
+// before it when the target moved by at least ANGLE_SCHED_REFINE_MIN_US
+#define ANGLE_SCHED_ARM_DEG 360.0f
+#define ANGLE_SCHED_REFINE_TEETH 3
+#define ANGLE_SCHED_REFINE_MIN_US 2U
+// 1: the last-teeth refine runs in the tooth ISR instead of the executor
+// (angle_scheduler_on_tooth); engine_control_set_isr_refine() switches at runtime
+#define ANGLE_SCHED_ISR_REFINE 0
+
 // Interpolation cache tuning (steady-state reuse window)
 #define INTERP_CACHE_RPM_DEADBAND 50
 #define INTERP_CACHE_LOAD_DEADBAND 20
 
+// Table interpolation engine: 1 = integer Q16 path with cached axis
+// reciprocals (no FPU state touched, usable from ISRs), 0 = float reference
+// path. On the host the float path is the faster one (table_interp_bench);
+// no ESP32-S3 timing backs either choice yet.
+#ifndef TABLE_FIXED_POINT
+#define TABLE_FIXED_POINT 1
+#endif
+
+// Table axis search: linear scan, branchless binary search, or direct index
+// through a coarse bucket table built with the axis reciprocals (falls back
+// to binary search when no cache is available)
+#define TABLE_AXIS_SEARCH_LINEAR 0
+#define TABLE_AXIS_SEARCH_BINARY 1
+#define TABLE_AXIS_SEARCH_DIRECT 2
+#ifndef TABLE_AXIS_SEARCH
+#define TABLE_AXIS_SEARCH TABLE_AXIS_SEARCH_DIRECT
+#endif
+
+// Fuel/ignition/lambda map dimensions (2..32 bins per axis). All 16 x 16
+// keeps the original NVS layout; other sizes start from resampled defaults.
+#ifndef VE_TABLE_RPM_BINS
+#define VE_TABLE_RPM_BINS 16
+#endif
+#ifndef VE_TABLE_LOAD_BINS
+#define VE_TABLE_LOAD_BINS 16
+#endif
+#ifndef IGN_TABLE_RPM_BINS
+#define IGN_TABLE_RPM_BINS 16
+#endif
+#ifndef IGN_TABLE_LOAD_BINS
+#define IGN_TABLE_LOAD_BINS 16
+#endif
+#ifndef LAMBDA_TABLE_RPM_BINS
+#define LAMBDA_TABLE_RPM_BINS 16
+#endif
+#ifndef LAMBDA_TABLE_LOAD_BINS
+#define LAMBDA_TABLE_LOAD_BINS 16
+#endif
+
 // 16x16 map structure
 #pragma pack(push, 1)
 typedef struct {
@@ -123,12 +182,22 @@ static const uint16_t DEFAULT_LOAD_BINS[16] = {
 #define INJECTOR_GPIO_2 GPIO_NUM_13
 #define INJECTOR_GPIO_3 GPIO_NUM_15
 #define INJECTOR_GPIO_4 GPIO_NUM_2
+// Used only when engine_layout has more than 4 cylinders
+#define INJECTOR_GPIO_5 GPIO_NUM_38
+#define INJECTOR_GPIO_6 GPIO_NUM_39
+#define INJECTOR_GPIO_7 GPIO_NUM_40
+#define INJECTOR_GPIO_8 GPIO_NUM_41
 
 // Ignition GPIOs
 #define IGNITION_GPIO_1 GPIO_NUM_16
 #define IGNITION_GPIO_2 GPIO_NUM_17
 #define IGNITION_GPIO_3 GPIO_NUM_18
 #define IGNITION_GPIO_4 GPIO_NUM_21
+// Used only when engine_layout has more than 4 coils
+#define IGNITION_GPIO_5 GPIO_NUM_42
+#define IGNITION_GPIO_6 GPIO_NUM_47
+#define IGNITION_GPIO_7 GPIO_NUM_48
+#define IGNITION_GPIO_8 GPIO_NUM_14
 
 // System configuration
 #define DEBUG_MODE true
@@ -0,0 +1,81 @@
+#ifndef SPLIT_INJECTION_H
+#define SPLIT_INJECTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "s3_control_config.h"
+#include "table_interp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Split injection: the fuel of one cycle delivered as two pulses.
+ *
+ * A 16x16 rpm/load map gives the first pulse's share of the cycle's fuel in
+ * 1/1000; SPLIT_INJ_SINGLE (the default in every cell) keeps one pulse. The
+ * second pulse follows the first after gap_us and ends on the EOI target,
+ * so the whole window moves earlier. Each pulse pays the injector opening
+ * latency on its own, so a split whose smaller pulse would carry less than
+ * min_pulse_us of fuel falls back to one pulse.
+ */
+
+#define SPLIT_INJ_MAX_PULSES 2U
+#define SPLIT_INJ_BINS 16U
+
+#define SPLIT_INJ_SINGLE 1000U
+#define SPLIT_INJ_MIN_FIRST_PCT 10.0f
+#define SPLIT_INJ_MAX_FIRST_PCT 100.0f
+
+// The gap covers the end-of-pulse ISR that arms the next pulse
+#define SPLIT_INJ_MIN_GAP_US 100U
+#define SPLIT_INJ_MAX_GAP_US 5000U
+#define SPLIT_INJ_DEFAULT_GAP_US 500U
+#define SPLIT_INJ_MIN_PULSE_US 500U
+#define SPLIT_INJ_DEFAULT_MIN_PULSE_US 800U
+
+// x = rpm, y = load (MAP kPa * 10), value = first pulse share in 1/1000
+TABLE_2D_DEFINE(split_ratio_map, SPLIT_INJ_BINS, SPLIT_INJ_BINS)
+
+typedef struct {
+    split_ratio_map_t ratio;
+    uint16_t gap_us;
+    uint16_t min_pulse_us;
+} split_injection_config_t;
+
+// Split at one rpm/load point
+typedef struct {
+    uint16_t first_x1000;
+    uint16_t gap_us;
+    uint16_t min_pulse_us;
+} split_injection_t;
+
+// Single pulse everywhere on the default rpm/load bins
+void split_injection_init_defaults(split_injection_config_t *cfg);
+
+// Checksum matches, axes are strictly increasing, cells and gap in range
+bool split_injection_validate(const split_injection_config_t *cfg);
+
+void split_injection_lookup(const split_injection_config_t *cfg, uint16_t rpm, uint16_t load,
+                            split_injection_t *out);
+
+/**
+ * @brief Fuel of each pulse, before injector latency
+ *
+ * @param split Split to apply, NULL for a single pulse
+ * @param pw_us Fuel of the whole cycle
+ * @param[out] pulse_us Fuel per pulse, in injection order
+ * @return Number of pulses (1 when the split is off or a pulse would be too short)
+ */
+uint8_t split_injection_pulses(const split_injection_t *split, uint32_t pw_us,
+                               uint32_t pulse_us[SPLIT_INJ_MAX_PULSES]);
+
+uint16_t split_injection_ratio_to_raw(float first_pct);
+float split_injection_ratio_from_raw(uint16_t raw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPLIT_INJECTION_H
@@ -0,0 +1,98 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Single-producer / single-consumer ring on atomics.
+ *
+ * Exactly one task pushes and one task pops; neither side takes a lock or
+ * masks interrupts, so a push or pop never delays an ISR on either core.
+ * Items are fixed-size records copied in and out of caller storage.
+ *
+ * SPSC_RING_QUEUE: power-of-two FIFO. The producer owns head, the consumer
+ * owns tail; a full ring refuses the new item (the consumer's slots are
+ * never overwritten) and counts it as dropped.
+ *
+ * SPSC_RING_MAILBOX: latest value only, as a triple buffer. The producer
+ * fills its private slot and swaps it with the shared middle slot; the
+ * consumer swaps the middle slot for its own when a fresh item is there.
+ * A push never fails; an item the consumer did not take in time is
+ * replaced and counted as superseded.
+ *
+ * Producer and consumer fields sit on separate cache lines so the two
+ * cores do not invalidate each other's index on every access.
+ */
+
+#define SPSC_RING_CACHE_LINE 32U   // ESP32-S3 data cache line (default config)
+#define SPSC_RING_MAILBOX_SLOTS 3U
+
+typedef enum {
+    SPSC_RING_QUEUE = 0,
+    SPSC_RING_MAILBOX,
+} spsc_ring_mode_t;
+
+typedef struct {
+    uint32_t pushed;
+    uint32_t popped;
+    uint32_t dropped;            // queue full, newest item refused
+    uint32_t superseded;         // mailbox item replaced before it was popped
+} spsc_ring_stats_t;
+
+typedef struct {
+    // Read-only after init
+    uint8_t *slots;
+    uint32_t item_size;
+    uint32_t mask;               // capacity - 1 (queue)
+    spsc_ring_mode_t mode;
+
+    // Producer side
+    uint32_t head __attribute__((aligned(SPSC_RING_CACHE_LINE)));
+    uint32_t back;               // mailbox: slot being filled
+    uint32_t pushed;
+    uint32_t dropped;
+    uint32_t superseded;
+
+    // Consumer side
+    uint32_t tail __attribute__((aligned(SPSC_RING_CACHE_LINE)));
+    uint32_t front;              // mailbox: slot being read
+    uint32_t popped;
+
+    // Mailbox: middle slot index and the fresh flag, exchanged by both sides
+    uint32_t middle __attribute__((aligned(SPSC_RING_CACHE_LINE)));
+} spsc_ring_t;
+
+/**
+ * @brief Set up a ring over caller storage
+ *
+ * @param storage item_size * capacity bytes, aligned for the item type
+ * @param capacity Queue: power of two >= 2. Mailbox: SPSC_RING_MAILBOX_SLOTS.
+ */
+esp_err_t spsc_ring_init(spsc_ring_t *ring, spsc_ring_mode_t mode,
+                         void *storage, uint32_t item_size, uint32_t capacity);
+
+// Producer only. False if a full queue refused the item.
+bool spsc_ring_push(spsc_ring_t *ring, const void *item);
+
+// Consumer only. Oldest item (queue) or the fresh one (mailbox).
+bool spsc_ring_pop(spsc_ring_t *ring, void *out);
+
+// Consumer only. Newest item, discarding the older ones still queued.
+bool spsc_ring_pop_latest(spsc_ring_t *ring, void *out);
+
+// Items waiting; exact on the consumer side, a lower bound elsewhere
+uint32_t spsc_ring_depth(const spsc_ring_t *ring);
+
+void spsc_ring_get_stats(const spsc_ring_t *ring, spsc_ring_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPSC_RING_H
@@ -4,20 +4,40 @@
 #include "esp_err.h"
 #include "esp_timer.h"
 #include <stdbool.h>
+#include "latency_hist.h"
 #include "s3_control_config.h"
 
+// Crank angles published by sync are fixed-point, 1/64 degree
+#define SYNC_ANGLE_FRAC_BITS 6
+#define SYNC_ANGLE_SCALE (1U << SYNC_ANGLE_FRAC_BITS)
+#define SYNC_ANGLE_CYCLE (720U * SYNC_ANGLE_SCALE)
+
+// Most edges per wheel revolution accepted by sync_set_config() (size of the tooth angle table)
+#define SYNC_MAX_TEETH 128U
+
+// Trigger wheel pattern, decoded by trigger_decoder.c
+typedef enum {
+    TRIGGER_PATTERN_MISSING_TOOTH = 0, // N-M wheel (60-2, 36-1, 24-1), reference after the gap
+    TRIGGER_PATTERN_N_PLUS_1,          // N even teeth plus one sync tooth (4+1, 12+1)
+    TRIGGER_PATTERN_COUNT,
+} trigger_pattern_t;
+
 // Sync configuration
 typedef struct {
-    uint32_t tooth_count;        // Number of teeth (excluding gap)
+    uint32_t tooth_count;        // Number of teeth (excluding gap / sync tooth)
     uint32_t gap_tooth;          // Tooth number where gap occurs
     uint32_t max_rpm;            // Maximum RPM for calculation
     uint32_t min_rpm;            // Minimum RPM for calculation
     bool enable_phase_detection; // Enable phase detection
+    trigger_pattern_t pattern;   // Wheel decoder
+    uint32_t missing_teeth;      // Missing-tooth wheels: teeth missing in the gap
+    uint32_t sync_tooth_deg;     // N+1 wheels: crank degrees from the previous tooth to the sync tooth
+    bool cam_speed;              // Wheel turns once per cycle (cam/distributor): phase from the wheel
 } sync_config_t;
 
 // Sync data
 typedef struct {
-    uint32_t tooth_index;        // Current tooth index (0 to tooth_count-1)
+    uint32_t tooth_index;        // Current edge index within the wheel revolution
     uint32_t time_per_degree;    // Time per degree in microseconds
     bool phase_detected;         // Phase detection status
     uint32_t rpm;                // Calculated RPM
@@ -36,8 +56,64 @@ typedef struct {
     bool sync_acquired;          // Full sync acquired (gap + phase)
     bool sync_valid;             // Sync validity based on freshness and RPM limits
     uint32_t latency_us;         // Estimated latency between capture and update
+    uint32_t cycle_angle;        // Angle of the last tooth in the 720-degree cycle, 1/64 deg
+    uint16_t tooth_angle;        // Angle of the last tooth within the revolution, 1/64 deg
+    uint16_t tooth_pitch;        // Nominal angle between two teeth, 1/64 deg
+    uint32_t us_per_degree_q16;  // Microseconds per degree, Q16 (0 until a period is known)
+    uint32_t sync_loss_count;    // Reference tooth early or missing since start/reset
+    uint64_t capture_time_us;    // Last CKP capture, full width, on the shared timebase (timebase.h)
 } sync_data_t;
 
+// What the schedulers need from the last tooth. Published by the capture
+// path under a sequence counter: readers copy it without masking interrupts
+// and retry if a tooth landed during the copy. One snapshot is meant to be
+// taken per pass and passed down, so every event of the pass uses the same
+// tooth.
+#define SYNC_SNAP_ACQUIRED 0x01U     // Full sync (gap + phase)
+#define SYNC_SNAP_VALID 0x02U        // Speed in range and last tooth fresh
+#define SYNC_SNAP_PHASE 0x04U        // Phase known
+#define SYNC_SNAP_GAP 0x08U          // Last tooth was the reference
+
+typedef struct {
+    uint64_t capture_time_us;    // Last CKP capture on the shared timebase
+    uint32_t tooth_index;
+    uint32_t cycle_angle;        // 1/64 deg in the 720-degree cycle
+    uint32_t us_per_degree_q16;  // 0 until a period is known
+    uint32_t tooth_period;       // us
+    uint32_t rpm;
+    uint16_t tooth_angle;        // 1/64 deg within the revolution
+    uint16_t tooth_pitch;        // 1/64 deg
+    uint8_t revolution_index;
+    uint8_t flags;               // SYNC_SNAP_*
+} sync_snapshot_t;
+
+static inline bool sync_snapshot_valid(const sync_snapshot_t *sync) {
+    return (sync->flags & SYNC_SNAP_VALID) != 0U;
+}
+
+// Implies valid
+static inline bool sync_snapshot_acquired(const sync_snapshot_t *sync) {
+    return (sync->flags & SYNC_SNAP_ACQUIRED) != 0U;
+}
+
+// Float views of the fixed-point angle fields: multiplies only, no divides
+
+static inline float sync_cycle_angle_deg(const sync_snapshot_t *sync) {
+    return (float)sync->cycle_angle * (1.0f / (float)SYNC_ANGLE_SCALE);
+}
+
+static inline float sync_tooth_angle_deg(const sync_snapshot_t *sync) {
+    return (float)sync->tooth_angle * (1.0f / (float)SYNC_ANGLE_SCALE);
+}
+
+static inline float sync_tooth_pitch_deg(const sync_snapshot_t *sync) {
+    return (float)sync->tooth_pitch * (1.0f / (float)SYNC_ANGLE_SCALE);
+}
+
+static inline float sync_us_per_degree(const sync_snapshot_t *sync) {
+    return (float)sync->us_per_degree_q16 * (1.0f / 65536.0f);
+}
+
 typedef void (*sync_tooth_callback_t)(void *ctx);
 
 // Function prototypes
@@ -46,9 +122,17 @@ esp_err_t sync_deinit(void);
 esp_err_t sync_start(void);
 esp_err_t sync_stop(void);
 esp_err_t sync_reset(void);
+// Full state for diagnostics; copied under the capture spinlock
 esp_err_t sync_get_data(sync_data_t *data);
+// Compact snapshot of the last tooth, lock-free; safe from ISRs (no FPU)
+esp_err_t sync_get_snapshot(sync_snapshot_t *out);
+// Last us/degree (Q16) without copying sync_data_t, safe from ISRs
+uint32_t sync_get_us_per_degree_q16(void);
 esp_err_t sync_set_config(const sync_config_t *config);
 esp_err_t sync_get_config(sync_config_t *config);
+// CKP interrupt time, entry to exit, in CPU cycles (tooth callback included)
+void sync_get_isr_latency(latency_summary_t *out);
+void sync_reset_isr_latency(void);
 esp_err_t sync_register_tooth_callback(sync_tooth_callback_t cb, void *ctx);
 void sync_unregister_tooth_callback(void);
 
@@ -4,20 +4,40 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "s3_control_config.h"
+#include "table_interp.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Axis reciprocals and search buckets of a table_16x16_t (axis[0] = rpm,
+// axis[1] = load)
+typedef table_cache_t table_16x16_recip_t;
+
 void table_16x16_init(table_16x16_t *table,
                       const uint16_t *rpm_bins,
                       const uint16_t *load_bins,
                       uint16_t default_value);
 
-uint16_t table_16x16_interpolate(const table_16x16_t *table, uint16_t rpm, uint16_t load);
+// Lookups on live maps go through table_interp.h (table_view_interpolate,
+// table_multi_interpolate), whose caches follow the map generations. The two
+// paths below are the reference pair table_interp_bench compares.
+uint16_t table_16x16_interpolate_float(const table_16x16_t *table, uint16_t rpm, uint16_t load);
+
+// Integer-only bilinear interpolation, within 1 LSB of the float path.
+// recip may be NULL, in which case the spans are divided per call.
+uint16_t table_16x16_interpolate_fixed(const table_16x16_t *table,
+                                       const table_16x16_recip_t *recip,
+                                       uint16_t rpm,
+                                       uint16_t load);
+
+void table_16x16_recip_build(const table_16x16_t *table, table_16x16_recip_t *recip);
+
+table_view_t table_16x16_view(const table_16x16_t *table);
 
 uint16_t table_16x16_checksum(const table_16x16_t *table);
 
+// Checksum matches and both axes are strictly increasing.
 bool table_16x16_validate(const table_16x16_t *table);
 
 #ifdef __cplusplus
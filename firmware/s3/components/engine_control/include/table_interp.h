@@ -0,0 +1,555 @@
+#ifndef TABLE_INTERP_H
+#define TABLE_INTERP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "s3_control_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Generic lookup tables: 1D curves, 2D maps and 3D (trilinear) tables with
+ * 2..TABLE_AXIS_MAX_BINS bins per axis and uint16_t cells.
+ *
+ * TABLE_1D_DEFINE / TABLE_2D_DEFINE / TABLE_3D_DEFINE declare a fixed-size
+ * table type plus inline accessors. The axis search and interpolation kernels
+ * below are static inline, so each fixed-size wrapper compiles to a kernel
+ * specialized for its dimensions (unrolled search, constant row stride).
+ *
+ * Every table carries a generation number, unique across all tables, that
+ * changes on each edit. Caches are keyed on it, so an edit invalidates only
+ * the caches of the table that changed. The checksum is a 16-bit sum of bins
+ * and values, updated by delta on single-cell writes. Only the fields before
+ * the generation are persisted (TABLE_PERSIST_SIZE).
+ */
+
+#define TABLE_AXIS_MIN_BINS 2
+#define TABLE_AXIS_MAX_BINS 32
+#define TABLE_MAX_DIMS 3
+#define TABLE_FRAC_BITS 16
+
+#define TABLE_AXIS_COARSE_SIZE 64
+
+// Direct-index bucket table for one axis: bucket k covers values from
+// bins[0] + (k << shift) and holds the bin index at its start, so a lookup
+// is one shift plus at most a short forward step.
+typedef struct {
+    uint8_t start[TABLE_AXIS_COARSE_SIZE];
+    uint8_t shift;
+} table_axis_coarse_t;
+
+// Per-bin reciprocals (Q32, 2^32 / span) and direct-index buckets of one axis
+typedef struct {
+    uint32_t recip[TABLE_AXIS_MAX_BINS - 1];
+    table_axis_coarse_t coarse;
+} table_axis_cache_t;
+
+// Derived per-table data, rebuilt when the table generation changes (or its
+// checksum, for tables without one). Kept next to the table rather than
+// inside it so persisted layouts do not change.
+typedef struct {
+    table_axis_cache_t axis[TABLE_MAX_DIMS];
+    uint32_t generation;  // table generation the cache was built from
+    uint16_t checksum;
+    bool valid;
+} table_cache_t;
+
+// Position of one input value on an axis. Computed once and reusable on every
+// table with the same bins.
+typedef struct {
+    uint8_t index;          // lower bin, 0..count-2
+    uint16_t lo;
+    uint16_t hi;
+    int32_t offset;         // value - lo; negative or > span when extrapolating
+    const uint32_t *recip;  // NULL: divide by the span
+} table_axis_pos_t;
+
+// Runtime description of any table, for code that handles mixed sizes.
+// Unused axes have count 1 and NULL bins. values are row-major [z][y][x].
+typedef struct {
+    const uint16_t *x_bins;
+    const uint16_t *y_bins;
+    const uint16_t *z_bins;
+    const uint16_t *values;
+    const uint16_t *checksum;
+    const uint32_t *generation;  // NULL for tables without one (table_16x16_t)
+    uint8_t nx;
+    uint8_t ny;
+    uint8_t nz;
+} table_view_t;
+
+//=============================================================================
+// Axis search
+//=============================================================================
+
+static inline uint8_t table_axis_index_linear(const uint16_t *bins, uint8_t count, uint16_t value) {
+    for (uint8_t i = 0; i + 2U < count; i++) {
+        if (value < bins[i + 1]) {
+            return i;
+        }
+    }
+    return (uint8_t)(count - 2U);
+}
+
+// Counts bins[1..count-1] <= value with halving steps. With a constant count
+// the loop unrolls into log2(count) conditional moves.
+static inline uint8_t table_axis_index_binary(const uint16_t *bins, uint8_t count, uint16_t value) {
+    uint8_t m = (uint8_t)(count - 1U);
+    uint8_t step = 1;
+    while ((uint8_t)(step << 1) <= m && step < 128U) {
+        step = (uint8_t)(step << 1);
+    }
+    uint8_t i = 0;
+    for (; step != 0U; step >>= 1) {
+        uint8_t next = (uint8_t)(i + step);
+        i = (next <= m && value >= bins[next]) ? next : i;
+    }
+    return (i > (uint8_t)(count - 2U)) ? (uint8_t)(count - 2U) : i;
+}
+
+static inline uint8_t table_axis_index_direct(const uint16_t *bins,
+                                              uint8_t count,
+                                              const table_axis_coarse_t *coarse,
+                                              uint16_t value) {
+    if (value < bins[0]) {
+        return 0;
+    }
+    uint32_t bucket = (uint32_t)(value - bins[0]) >> coarse->shift;
+    if (bucket >= TABLE_AXIS_COARSE_SIZE) {
+        return table_axis_index_binary(bins, count, value);
+    }
+    uint8_t i = coarse->start[bucket];
+    while (i + 2U < count && value >= bins[i + 1]) {
+        i++;
+    }
+    return i;
+}
+
+// Bin index i (0..count-2) with bins[i] <= value < bins[i + 1], clamped at
+// the ends. Uses the TABLE_AXIS_SEARCH strategy; coarse may be NULL.
+static inline uint8_t table_axis_index(const uint16_t *bins,
+                                       uint8_t count,
+                                       const table_axis_coarse_t *coarse,
+                                       uint16_t value) {
+#if TABLE_AXIS_SEARCH == TABLE_AXIS_SEARCH_DIRECT
+    if (coarse) {
+        return table_axis_index_direct(bins, count, coarse, value);
+    }
+    return table_axis_index_binary(bins, count, value);
+#elif TABLE_AXIS_SEARCH == TABLE_AXIS_SEARCH_BINARY
+    (void)coarse;
+    return table_axis_index_binary(bins, count, value);
+#else
+    (void)coarse;
+    return table_axis_index_linear(bins, count, value);
+#endif
+}
+
+static inline void table_axis_locate(const uint16_t *bins,
+                                     uint8_t count,
+                                     const table_axis_cache_t *cache,
+                                     uint16_t value,
+                                     table_axis_pos_t *pos) {
+    uint8_t i = table_axis_index(bins, count, cache ? &cache->coarse : NULL, value);
+    pos->index = i;
+    pos->lo = bins[i];
+    pos->hi = bins[i + 1];
+    pos->offset = (int32_t)value - (int32_t)pos->lo;
+    pos->recip = cache ? &cache->recip[i] : NULL;
+}
+
+//=============================================================================
+// Interpolation kernel
+//=============================================================================
+
+// (p * recip) >> 32 without a 64x32 product overflowing int64.
+static inline int64_t table_mul_recip_q32(int64_t p, uint32_t recip) {
+    uint64_t u = (p < 0) ? (uint64_t)(-p) : (uint64_t)p;
+    uint64_t r = ((u >> 32) * recip) + (((u & 0xFFFFFFFFULL) * recip) >> 32);
+    return (p < 0) ? -(int64_t)r : (int64_t)r;
+}
+
+// a + (b - a) * offset / span in Q16. The offset is scaled by the span only
+// after the multiply, so the fraction itself is never quantized.
+static inline int64_t table_lerp_q16(int64_t a, int64_t b, const table_axis_pos_t *pos) {
+    if (pos->hi <= pos->lo) {
+        return a;
+    }
+    int64_t p = (b - a) * pos->offset;
+    if (pos->recip) {
+        return a + table_mul_recip_q32(p, *pos->recip);
+    }
+    return a + p / (int64_t)(pos->hi - pos->lo);
+}
+
+static inline uint16_t table_q16_to_u16(int64_t v) {
+    if (v < 0) {
+        return 0;
+    }
+    v = (v + (1LL << (TABLE_FRAC_BITS - 1))) >> TABLE_FRAC_BITS;
+    return (v > 65535) ? 65535U : (uint16_t)v;
+}
+
+static inline int64_t table_cell_q16(uint16_t v) {
+    return (int64_t)v << TABLE_FRAC_BITS;
+}
+
+static inline int64_t table_eval_2d_q16(const uint16_t *values,
+                                        uint8_t nx,
+                                        const table_axis_pos_t *x,
+                                        const table_axis_pos_t *y) {
+    const uint16_t *row = values + (size_t)y->index * nx + x->index;
+    int64_t v0 = table_lerp_q16(table_cell_q16(row[0]), table_cell_q16(row[1]), x);
+    int64_t v1 = table_lerp_q16(table_cell_q16(row[nx]), table_cell_q16(row[nx + 1]), x);
+    return table_lerp_q16(v0, v1, y);
+}
+
+static inline float table_frac_f(const table_axis_pos_t *pos) {
+    if (pos->hi <= pos->lo) {
+        return 0.0f;
+    }
+    return (float)pos->offset / (float)(pos->hi - pos->lo);
+}
+
+static inline uint16_t table_round_f(float v) {
+    if (v < 0.0f) {
+        v = 0.0f;
+    }
+    if (v > 65535.0f) {
+        v = 65535.0f;
+    }
+    return (uint16_t)(v + 0.5f);
+}
+
+static inline float table_eval_2d_f(const uint16_t *values,
+                                    uint8_t nx,
+                                    const table_axis_pos_t *x,
+                                    const table_axis_pos_t *y) {
+    const uint16_t *row = values + (size_t)y->index * nx + x->index;
+    float dx = table_frac_f(x);
+    float dy = table_frac_f(y);
+    float v00 = (float)row[0];
+    float v10 = (float)row[1];
+    float v01 = (float)row[nx];
+    float v11 = (float)row[nx + 1];
+    float v0 = v00 + dx * (v10 - v00);
+    float v1 = v01 + dx * (v11 - v01);
+    return v0 + dy * (v1 - v0);
+}
+
+static inline uint16_t table_eval_2d_fixed(const uint16_t *values,
+                                           uint8_t nx,
+                                           const table_axis_pos_t *x,
+                                           const table_axis_pos_t *y) {
+    return table_q16_to_u16(table_eval_2d_q16(values, nx, x, y));
+}
+
+static inline uint16_t table_eval_2d_float(const uint16_t *values,
+                                           uint8_t nx,
+                                           const table_axis_pos_t *x,
+                                           const table_axis_pos_t *y) {
+    return table_round_f(table_eval_2d_f(values, nx, x, y));
+}
+
+// Fixed-point or float path, selected with TABLE_FIXED_POINT.
+static inline uint16_t table_eval_1d(const uint16_t *values, const table_axis_pos_t *x) {
+    const uint16_t *v = values + x->index;
+#if TABLE_FIXED_POINT
+    return table_q16_to_u16(table_lerp_q16(table_cell_q16(v[0]), table_cell_q16(v[1]), x));
+#else
+    return table_round_f((float)v[0] + table_frac_f(x) * ((float)v[1] - (float)v[0]));
+#endif
+}
+
+static inline uint16_t table_eval_2d(const uint16_t *values,
+                                     uint8_t nx,
+                                     const table_axis_pos_t *x,
+                                     const table_axis_pos_t *y) {
+#if TABLE_FIXED_POINT
+    return table_eval_2d_fixed(values, nx, x, y);
+#else
+    return table_eval_2d_float(values, nx, x, y);
+#endif
+}
+
+static inline uint16_t table_eval_3d(const uint16_t *values,
+                                     uint8_t nx,
+                                     uint8_t ny,
+                                     const table_axis_pos_t *x,
+                                     const table_axis_pos_t *y,
+                                     const table_axis_pos_t *z) {
+    const uint16_t *layer = values + (size_t)z->index * nx * ny;
+    const uint16_t *next = layer + (size_t)nx * ny;
+#if TABLE_FIXED_POINT
+    int64_t w0 = table_eval_2d_q16(layer, nx, x, y);
+    int64_t w1 = table_eval_2d_q16(next, nx, x, y);
+    return table_q16_to_u16(table_lerp_q16(w0, w1, z));
+#else
+    float w0 = table_eval_2d_f(layer, nx, x, y);
+    float w1 = table_eval_2d_f(next, nx, x, y);
+    return table_round_f(w0 + table_frac_f(z) * (w1 - w0));
+#endif
+}
+
+//=============================================================================
+// Table maintenance (table_interp.c)
+//=============================================================================
+
+// Next table generation: unique across all tables, never 0.
+uint32_t table_next_generation(void);
+
+// Checksum after one cell changes from old_value to new_value.
+static inline uint16_t table_checksum_delta(uint16_t checksum, uint16_t old_value, uint16_t new_value) {
+    return (uint16_t)(checksum + new_value - old_value);
+}
+
+void table_axis_cache_build(const uint16_t *bins, uint8_t count, table_axis_cache_t *cache);
+
+bool table_axis_is_monotonic(const uint16_t *bins, uint8_t count);
+
+// Fills dst with count bins spread over the same range and shape as src
+// (piecewise-linear resampling); a plain copy when the counts match.
+void table_axis_resample(uint16_t *dst, uint8_t count, const uint16_t *src, uint8_t src_count);
+
+uint16_t table_checksum_words(const uint16_t *words, size_t count);
+
+void table_cache_build(const table_view_t *view, table_cache_t *cache);
+
+// True when cache was built from the current version of the table.
+static inline bool table_cache_matches(const table_cache_t *cache, const table_view_t *view) {
+    if (!cache->valid) {
+        return false;
+    }
+    if (view->generation) {
+        return cache->generation == *view->generation;
+    }
+    return view->checksum && cache->checksum == *view->checksum;
+}
+
+// Checksum matches and every axis is strictly increasing.
+bool table_view_validate(const table_view_t *view);
+
+bool table_view_same_axes(const table_view_t *a, const table_view_t *b);
+
+// Interpolates any table through its view (no per-size specialization).
+// cache may be NULL; otherwise it is rebuilt when it does not match.
+uint16_t table_view_interpolate(const table_view_t *view,
+                                table_cache_t *cache,
+                                uint16_t x,
+                                uint16_t y,
+                                uint16_t z);
+
+#define TABLE_MULTI_MAX 4
+
+// State for table_multi_interpolate(): which 2D tables share the axes of the
+// first one and their caches, rebuilt when a table generation changes.
+typedef struct {
+    const uint16_t *values[TABLE_MULTI_MAX];
+    table_cache_t cache[TABLE_MULTI_MAX];
+    bool shared[TABLE_MULTI_MAX];
+    uint8_t count;
+    bool bound;
+} table_multi_t;
+
+void table_multi_reset(table_multi_t *multi);
+
+// True when multi was bound to these tables at their current generations.
+bool table_multi_is_bound(const table_multi_t *multi, const table_view_t *views, uint8_t count);
+
+// Interpolates count 2D tables at one x/y point. The axis search runs once
+// on views[0]; tables with different axes or sizes fall back to their own
+// lookup. Returns how many tables used the shared position (0 on error).
+uint8_t table_multi_interpolate(table_multi_t *multi,
+                                const table_view_t *views,
+                                uint8_t count,
+                                uint16_t x,
+                                uint16_t y,
+                                uint16_t *out);
+
+//=============================================================================
+// Fixed-size table types
+//=============================================================================
+
+// Bytes of a fixed-size table that are persisted: bins, values and checksum,
+// without the generation or its padding
+#define TABLE_PERSIST_SIZE(type) (offsetof(type, checksum) + sizeof(uint16_t))
+
+// cache must not be NULL: callers with an optional cache test it first
+#define TABLE_CACHE_SYNC(t, cache, view_fn)                                     \
+    do {                                                                        \
+        if (!(cache)->valid || (cache)->generation != (t)->generation) {        \
+            table_view_t cache_view_ = view_fn(t);                              \
+            table_cache_build(&cache_view_, (cache));                           \
+        }                                                                       \
+    } while (0)
+
+// Accessors shared by every fixed-size table type. Bulk edits write the
+// values and call NAME_commit(); NAME_touch() only moves to a new generation
+// (e.g. after loading a table whose checksum must still be checked).
+#define TABLE_COMMON_DEFINE(NAME)                                               \
+    static inline uint16_t NAME##_checksum(const NAME##_t *t) {                 \
+        return table_checksum_words(&t->x_bins[0],                              \
+                                    offsetof(NAME##_t, checksum) / sizeof(uint16_t)); \
+    }                                                                           \
+    static inline void NAME##_touch(NAME##_t *t) {                              \
+        t->generation = table_next_generation();                                \
+    }                                                                           \
+    static inline void NAME##_commit(NAME##_t *t) {                             \
+        t->checksum = NAME##_checksum(t);                                       \
+        NAME##_touch(t);                                                        \
+    }                                                                           \
+    static inline bool NAME##_validate(const NAME##_t *t) {                     \
+        table_view_t v = NAME##_view(t);                                        \
+        return table_view_validate(&v);                                         \
+    }                                                                           \
+    static inline void NAME##_write_cell(NAME##_t *t, uint16_t *cell, uint16_t value) { \
+        t->checksum = table_checksum_delta(t->checksum, *cell, value);          \
+        *cell = value;                                                          \
+        NAME##_touch(t);                                                        \
+    }
+
+// 1D curve NAME_t: N bins and N values
+#define TABLE_1D_DEFINE(NAME, N)                                                \
+    typedef struct {                                                            \
+        uint16_t x_bins[N];                                                     \
+        uint16_t values[N];                                                     \
+        uint16_t checksum;                                                      \
+        uint32_t generation;                                                    \
+    } NAME##_t;                                                                 \
+    static inline table_view_t NAME##_view(const NAME##_t *t) {                 \
+        table_view_t v = { t->x_bins, NULL, NULL, t->values, &t->checksum,      \
+                           &t->generation, (N), 1, 1 };                         \
+        return v;                                                               \
+    }                                                                           \
+    TABLE_COMMON_DEFINE(NAME)                                                   \
+    static inline void NAME##_init(NAME##_t *t, const uint16_t *x_bins,         \
+                                   uint8_t x_count, uint16_t value) {           \
+        table_axis_resample(t->x_bins, (N), x_bins, x_count);                   \
+        for (size_t i_ = 0; i_ < (N); i_++) {                                   \
+            t->values[i_] = value;                                              \
+        }                                                                       \
+        NAME##_commit(t);                                                       \
+    }                                                                           \
+    static inline void NAME##_set_cell(NAME##_t *t, uint8_t x, uint16_t value) { \
+        if (x < (N)) {                                                          \
+            NAME##_write_cell(t, &t->values[x], value);                         \
+        }                                                                       \
+    }                                                                           \
+    static inline uint16_t NAME##_interpolate(const NAME##_t *t,                \
+                                              table_cache_t *cache,             \
+                                              uint16_t x) {                     \
+        if (cache) {                                                            \
+            TABLE_CACHE_SYNC(t, cache, NAME##_view);                            \
+        }                                                                       \
+        table_axis_pos_t px;                                                    \
+        table_axis_locate(t->x_bins, (N), cache ? &cache->axis[0] : NULL, x, &px); \
+        return table_eval_1d(t->values, &px);                                   \
+    }
+
+// 2D map NAME_t: NX x-bins (columns), NY y-bins (rows), values[NY][NX]
+#define TABLE_2D_DEFINE(NAME, NX, NY)                                           \
+    typedef struct {                                                            \
+        uint16_t x_bins[NX];                                                    \
+        uint16_t y_bins[NY];                                                    \
+        uint16_t values[NY][NX];                                                \
+        uint16_t checksum;                                                      \
+        uint32_t generation;                                                    \
+    } NAME##_t;                                                                 \
+    static inline table_view_t NAME##_view(const NAME##_t *t) {                 \
+        table_view_t v = { t->x_bins, t->y_bins, NULL, &t->values[0][0],        \
+                           &t->checksum, &t->generation, (NX), (NY), 1 };       \
+        return v;                                                               \
+    }                                                                           \
+    TABLE_COMMON_DEFINE(NAME)                                                   \
+    static inline void NAME##_init(NAME##_t *t,                                 \
+                                   const uint16_t *x_bins, uint8_t x_count,     \
+                                   const uint16_t *y_bins, uint8_t y_count,     \
+                                   uint16_t value) {                            \
+        table_axis_resample(t->x_bins, (NX), x_bins, x_count);                  \
+        table_axis_resample(t->y_bins, (NY), y_bins, y_count);                  \
+        for (size_t i_ = 0; i_ < (size_t)(NX) * (NY); i_++) {                   \
+            (&t->values[0][0])[i_] = value;                                     \
+        }                                                                       \
+        NAME##_commit(t);                                                       \
+    }                                                                           \
+    static inline void NAME##_set_cell(NAME##_t *t, uint8_t x, uint8_t y,       \
+                                       uint16_t value) {                        \
+        if (x < (NX) && y < (NY)) {                                             \
+            NAME##_write_cell(t, &t->values[y][x], value);                      \
+        }                                                                       \
+    }                                                                           \
+    static inline uint16_t NAME##_interpolate(const NAME##_t *t,                \
+                                              table_cache_t *cache,             \
+                                              uint16_t x,                       \
+                                              uint16_t y) {                     \
+        if (cache) {                                                            \
+            TABLE_CACHE_SYNC(t, cache, NAME##_view);                            \
+        }                                                                       \
+        table_axis_pos_t px;                                                    \
+        table_axis_pos_t py;                                                    \
+        table_axis_locate(t->x_bins, (NX), cache ? &cache->axis[0] : NULL, x, &px); \
+        table_axis_locate(t->y_bins, (NY), cache ? &cache->axis[1] : NULL, y, &py); \
+        return table_eval_2d(&t->values[0][0], (NX), &px, &py);                 \
+    }
+
+// 3D table NAME_t (e.g. RPM x load x gear/CLT): values[NZ][NY][NX],
+// trilinear interpolation
+#define TABLE_3D_DEFINE(NAME, NX, NY, NZ)                                       \
+    typedef struct {                                                            \
+        uint16_t x_bins[NX];                                                    \
+        uint16_t y_bins[NY];                                                    \
+        uint16_t z_bins[NZ];                                                    \
+        uint16_t values[NZ][NY][NX];                                            \
+        uint16_t checksum;                                                      \
+        uint32_t generation;                                                    \
+    } NAME##_t;                                                                 \
+    static inline table_view_t NAME##_view(const NAME##_t *t) {                 \
+        table_view_t v = { t->x_bins, t->y_bins, t->z_bins, &t->values[0][0][0], \
+                           &t->checksum, &t->generation, (NX), (NY), (NZ) };    \
+        return v;                                                               \
+    }                                                                           \
+    TABLE_COMMON_DEFINE(NAME)                                                   \
+    static inline void NAME##_init(NAME##_t *t,                                 \
+                                   const uint16_t *x_bins, uint8_t x_count,     \
+                                   const uint16_t *y_bins, uint8_t y_count,     \
+                                   const uint16_t *z_bins, uint8_t z_count,     \
+                                   uint16_t value) {                            \
+        table_axis_resample(t->x_bins, (NX), x_bins, x_count);                  \
+        table_axis_resample(t->y_bins, (NY), y_bins, y_count);                  \
+        table_axis_resample(t->z_bins, (NZ), z_bins, z_count);                  \
+        for (size_t i_ = 0; i_ < (size_t)(NX) * (NY) * (NZ); i_++) {            \
+            (&t->values[0][0][0])[i_] = value;                                  \
+        }                                                                       \
+        NAME##_commit(t);                                                       \
+    }                                                                           \
+    static inline void NAME##_set_cell(NAME##_t *t, uint8_t x, uint8_t y,       \
+                                       uint8_t z, uint16_t value) {             \
+        if (x < (NX) && y < (NY) && z < (NZ)) {                                 \
+            NAME##_write_cell(t, &t->values[z][y][x], value);                   \
+        }                                                                       \
+    }                                                                           \
+    static inline uint16_t NAME##_interpolate(const NAME##_t *t,                \
+                                              table_cache_t *cache,             \
+                                              uint16_t x,                       \
+                                              uint16_t y,                       \
+                                              uint16_t z) {                     \
+        if (cache) {                                                            \
+            TABLE_CACHE_SYNC(t, cache, NAME##_view);                            \
+        }                                                                       \
+        table_axis_pos_t px;                                                    \
+        table_axis_pos_t py;                                                    \
+        table_axis_pos_t pz;                                                    \
+        table_axis_locate(t->x_bins, (NX), cache ? &cache->axis[0] : NULL, x, &px); \
+        table_axis_locate(t->y_bins, (NY), cache ? &cache->axis[1] : NULL, y, &py); \
+        table_axis_locate(t->z_bins, (NZ), cache ? &cache->axis[2] : NULL, z, &pz); \
+        return table_eval_3d(&t->values[0][0][0], (NX), (NY), &px, &py, &pz);  \
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TABLE_INTERP_H
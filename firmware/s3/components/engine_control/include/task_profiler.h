@@ -0,0 +1,57 @@
+#ifndef TASK_PROFILER_H
+#define TASK_PROFILER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "espnow_link.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Task profiler.
+ *
+ * Headroom of every planned task (core_plan.h): its share of a core over
+ * the window since the previous sample, from the FreeRTOS run time
+ * counters, and the bytes of its stack never touched. Alongside, the tail
+ * latencies of the control core: tooth notify to planner running, planner
+ * notify to executor running, and the CKP interrupt itself.
+ *
+ * A sample is the ESP-NOW task profile record. The monitor task takes one
+ * every TASK_PROFILER_INTERVAL_MS and sends it with the diagnostics; the
+ * CLI reads the last one.
+ */
+
+#define TASK_PROFILER_INTERVAL_MS 1000U
+
+/**
+ * @brief Take a sample: loads since the previous one, stacks and latencies now
+ *
+ * @param out Optional copy of the record
+ * @return ESP_ERR_NOT_SUPPORTED without FreeRTOS trace facility and run time
+ *         stats; the latencies are filled in anyway
+ * @return ESP_ERR_NO_MEM when more tasks run than the profiler holds
+ */
+esp_err_t task_profiler_sample(uint32_t now_ms, espnow_task_profile_t *out);
+
+/**
+ * @brief Start the next load window now, e.g. after the run time counters
+ *        were reset
+ *
+ * @return As task_profiler_sample(), without touching the last record
+ */
+esp_err_t task_profiler_restart(void);
+
+/**
+ * @brief Last record taken by task_profiler_sample()
+ *
+ * @return ESP_ERR_INVALID_STATE before the first sample
+ */
+esp_err_t task_profiler_get_last(espnow_task_profile_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TASK_PROFILER_H
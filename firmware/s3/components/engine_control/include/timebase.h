@@ -0,0 +1,117 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "driver/gptimer.h"
+#include "driver/mcpwm_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Shared timebase.
+ *
+ * One free-running 1 MHz GPTimer is the time reference of the engine control
+ * path: sync captures CKP edges into it over ETM, and event targets are
+ * computed on it (tooth capture + angle * us/degree). It is never reset or
+ * stopped while the engine runs.
+ *
+ * The S3 MCPWM timers cannot be started or synced from ETM, so each output
+ * timer is tied to the reference by an offset: the reference time at which
+ * its counter read 0, measured by reading both back to back. Both count the
+ * same crystal, so the offset holds until the timer is restarted;
+ * timebase_check() re-measures every attached timer and re-anchors any that
+ * moved by more than one tick.
+ */
+
+#define TIMEBASE_RESOLUTION_HZ 1000000U
+#define TIMEBASE_MAX_MCPWM_TIMERS 8U
+
+typedef struct {
+    mcpwm_timer_handle_t timer;
+    uint32_t period_ticks;
+    uint64_t origin_us;      // Reference time of a counter zero
+} timebase_mcpwm_t;
+
+typedef struct {
+    uint32_t attached;       // MCPWM timers tied to the reference
+    uint32_t checks;         // timebase_check() passes
+    int32_t max_skew_ticks;  // Largest |measured - model| seen
+    uint32_t reanchors;      // Offsets re-measured after moving
+} timebase_stats_t;
+
+// Creates and starts the reference timer; safe to call more than once
+esp_err_t timebase_init(void);
+void timebase_deinit(void);
+
+// Reference timer for ETM capture tasks (NULL before init)
+gptimer_handle_t timebase_get_timer(void);
+
+// Reference time in microseconds (esp_timer when the GPTimer is unavailable)
+uint64_t timebase_now_us(void);
+
+/**
+ * @brief Tie a running MCPWM timer to the reference
+ *
+ * The timer must already count (mcpwm_timer_start_stop); @p tb stays owned
+ * by the caller and is re-checked by timebase_check().
+ */
+esp_err_t timebase_attach_mcpwm(timebase_mcpwm_t *tb, mcpwm_timer_handle_t timer, uint32_t period_ticks);
+void timebase_detach_mcpwm(timebase_mcpwm_t *tb);
+
+// Counter value of the timer at reference time @p time_us, modulo its period
+static inline uint32_t timebase_mcpwm_counter_at(const timebase_mcpwm_t *tb, uint64_t time_us) {
+    return (uint32_t)((time_us - tb->origin_us) % tb->period_ticks);
+}
+
+/*
+ * Absolute compares on a wrapping counter. An MCPWM timer counts 0..period-1
+ * and wraps, so a compare value only means something relative to the
+ * current counter: it is ahead when it lies within the next half period and
+ * behind otherwise. A window may straddle the wrap (end < start); the
+ * generators act on compare events only, so such a window simply continues
+ * from 0 after the wrap.
+ */
+
+// Ticks from @p a forward to @p b within one period
+static inline uint32_t timebase_ticks_between(uint32_t a, uint32_t b, uint32_t period) {
+    return (b >= a) ? (b - a) : (b + period - a);
+}
+
+// Signed b - a, taking the shorter way around the period
+static inline int32_t timebase_ticks_delta(uint32_t a, uint32_t b, uint32_t period) {
+    uint32_t d = timebase_ticks_between(a, b, period);
+    return (d > period / 2U) ? -(int32_t)(period - d) : (int32_t)d;
+}
+
+// @p ticks moved by @p delta (|delta| < period), folded back into the period
+static inline uint32_t timebase_ticks_add(uint32_t ticks, int32_t delta, uint32_t period) {
+    int64_t v = (int64_t)ticks + delta;
+    if (v < 0) {
+        v += period;
+    } else if (v >= (int64_t)period) {
+        v -= period;
+    }
+    return (uint32_t)v;
+}
+
+// Per-channel accounting of absolute compare writes
+typedef struct {
+    uint32_t scheduled;      // Compare pairs written
+    uint32_t wrapped;        // Of those, windows straddling the counter wrap
+    uint32_t dropped_late;   // Target not ahead of the counter
+    uint32_t dropped_range;  // Target outside the timer period
+} timebase_compare_stats_t;
+
+// Re-measure every attached timer (task context)
+void timebase_check(void);
+void timebase_get_stats(timebase_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIMEBASE_H
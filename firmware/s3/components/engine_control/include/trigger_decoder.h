@@ -0,0 +1,88 @@
+#ifndef TRIGGER_DECODER_H
+#define TRIGGER_DECODER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sync.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Trigger wheel decoders.
+ *
+ * A decoder turns the period between two crank (or cam) wheel edges into the
+ * index of the edge within one wheel revolution. Each pattern provides:
+ *
+ * - build(): the wheel table for a sync_config_t (edge angles and the span
+ *   since the previous edge). Built outside the ISR. Edge 0 is the reference
+ *   tooth (first tooth after the gap, or the sync tooth) at angle 0.
+ * - decode(): the per-edge step. It only compares the period against the last
+ *   one to spot the reference tooth (gap or extra tooth); the tooth count
+ *   between two references is checked by a state machine shared by all
+ *   patterns.
+ *
+ * Sync loss is reported when a reference shows up where a regular tooth was
+ * expected, or the other way round. The next reference re-acquires sync.
+ */
+
+typedef struct {
+    uint16_t angle[SYNC_MAX_TEETH];        // Edge angle within the wheel revolution, 1/64 deg
+    uint32_t inv_span_q24[SYNC_MAX_TEETH]; // 1 / degrees since the previous edge, Q24
+    uint16_t edges;                        // Edges per wheel revolution
+    uint32_t inv_pitch_q24;                // 1 / nominal pitch in degrees, Q24 (edges before sync)
+    uint16_t pitch;                        // Nominal tooth pitch, 1/64 deg
+    bool cam_speed;                        // Wheel turns once per 720-degree cycle
+} trigger_wheel_t;
+
+typedef struct {
+    uint32_t tooth_index;        // Index of the last edge (0 to edges-1)
+    uint32_t pitch_period;       // Last period scaled to one nominal pitch (0 = none yet)
+    uint32_t us_per_degree_q16;  // Last period over the angle it spanned, Q16
+    bool synced;                 // A reference was seen and the tooth count held since
+} trigger_state_t;
+
+typedef enum {
+    TRIGGER_EDGE_NO_SYNC = 0,    // Position not known yet
+    TRIGGER_EDGE_TOOTH,          // Regular tooth where one was expected
+    TRIGGER_EDGE_REFERENCE,      // Reference tooth, the wheel revolution starts over
+    TRIGGER_EDGE_SYNC_LOST,      // Reference early or missing: sync dropped
+} trigger_edge_t;
+
+typedef struct {
+    const char *name;
+    esp_err_t (*build)(const sync_config_t *config, trigger_wheel_t *wheel);
+    trigger_edge_t (*decode)(trigger_state_t *state, const trigger_wheel_t *wheel, uint32_t period_us);
+} trigger_decoder_t;
+
+// Wheels in the fleet, as sync_config_t pattern fields
+typedef enum {
+    TRIGGER_WHEEL_60_2 = 0,
+    TRIGGER_WHEEL_36_1,
+    TRIGGER_WHEEL_24_1,
+    TRIGGER_WHEEL_4_PLUS_1,      // Distributor / cam wheel, 4 teeth plus a sync tooth
+    TRIGGER_WHEEL_12_PLUS_1,     // Honda-style crank wheel, 12 teeth plus a sync tooth
+    TRIGGER_WHEEL_COUNT,
+} trigger_wheel_preset_t;
+
+// Decoder for a pattern, NULL if the pattern is unknown
+const trigger_decoder_t *trigger_decoder_get(trigger_pattern_t pattern);
+
+void trigger_state_reset(trigger_state_t *state);
+
+/**
+ * @brief Fill the wheel fields of a sync configuration from a preset
+ *
+ * Only pattern, tooth_count, gap_tooth, missing_teeth, sync_tooth_deg and
+ * cam_speed are written; RPM limits and phase detection are left as they are.
+ */
+esp_err_t trigger_wheel_preset(trigger_wheel_preset_t preset, sync_config_t *config);
+const char *trigger_wheel_preset_name(trigger_wheel_preset_t preset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TRIGGER_DECODER_H
@@ -7,6 +7,8 @@
  */
 
 #include "cli_interface.h"
+#include "core_plan.h"
+#include "task_profiler.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_system.h"
@@ -28,6 +30,7 @@
 #include "config_manager.h"
 #include "fuel_calc.h"
 #include "table_16x16.h"
+#include "twai_lambda.h"
 
 /*============================================================================
  * Constants
@@ -76,6 +79,8 @@ static int cli_cmd_tables(int argc, char **argv);
 static int cli_cmd_config(int argc, char **argv);
 static int cli_cmd_limits(int argc, char **argv);
 static int cli_cmd_diag(int argc, char **argv);
+static int cli_cmd_perf(int argc, char **argv);
+static int cli_cmd_prof(int argc, char **argv);
 static int cli_cmd_stream(int argc, char **argv);
 static int cli_cmd_reset(int argc, char **argv);
 static int cli_cmd_version(int argc, char **argv);
@@ -127,6 +132,8 @@ static const cli_command_t default_commands[] = {
     {"config",  "Configuration operations", "<subcommand>", cli_cmd_config, config_subcommands, CLI_FLAG_ADMIN},
     {"limits",  "Safety limits", "[set <name> <value>]", cli_cmd_limits, NULL, CLI_FLAG_ADMIN},
     {"diag",    "Diagnostics", "[errors|reset]", cli_cmd_diag, NULL, CLI_FLAG_NONE},
+    {"perf",    "Planner/executor latency", "[reset]", cli_cmd_perf, NULL, CLI_FLAG_NONE},
+    {"prof",    "CPU load, stacks, wake/ISR time", "[raw]", cli_cmd_prof, NULL, CLI_FLAG_NONE},
     {"stream",  "Data streaming", "<subcommand>", cli_cmd_stream, stream_subcommands, CLI_FLAG_STREAMING},
     {"reset",   "Reset operations", "<subcommand>", cli_cmd_reset, reset_subcommands, CLI_FLAG_CONFIRM | CLI_FLAG_ADMIN},
     {"version", "Show version", NULL, cli_cmd_version, NULL, CLI_FLAG_NONE},
@@ -269,34 +276,39 @@ static int cli_cmd_status(int argc, char **argv)
     (void)argc;
     (void)argv;
     
-    engine_runtime_state_t state;
-    uint32_t seq;
-    engine_control_get_runtime_state(&state, &seq);
+    engine_params_t params = {0};
+    engine_control_get_engine_parameters(&params);
+    engine_injection_diag_t inj = {0};
+    bool have_inj = (engine_control_get_injection_diag(&inj) == ESP_OK);
+    float lambda = 0.0f;
+    uint32_t lambda_age_ms = 0;
+    bool have_lambda = twai_lambda_get_latest(&lambda, &lambda_age_ms);
     
     cli_print_table_header("ECU STATUS", 50);
     
     // Format status
-    const char *sync_str = state.sync_status ? "ACQUIRED" : "LOST";
-    const char *limp_str = state.limp_mode ? "ACTIVE" : "OFF";
+    const char *sync_str = (have_inj && inj.sync_acquired) ? "ACQUIRED" : "LOST";
+    const char *limp_str = engine_control_is_limp_mode() ? "ACTIVE" : "OFF";
     
     char buffer[64];
     
-    snprintf(buffer, sizeof(buffer), "%u rpm", state.rpm);
+    snprintf(buffer, sizeof(buffer), "%lu rpm", (unsigned long)params.rpm);
     cli_print_table_row("RPM", buffer);
     
-    snprintf(buffer, sizeof(buffer), "%.1f kPa", state.load / 10.0f);
+    snprintf(buffer, sizeof(buffer), "%.1f kPa", params.load / 10.0f);
     cli_print_table_row("MAP", buffer);
     
-    snprintf(buffer, sizeof(buffer), "%.1f deg", state.advance_deg10 / 10.0f);
+    snprintf(buffer, sizeof(buffer), "%.1f deg", params.advance_deg10 / 10.0f);
     cli_print_table_row("Advance", buffer);
     
-    snprintf(buffer, sizeof(buffer), "%u us", state.pw_us);
+    snprintf(buffer, sizeof(buffer), "%lu us", (unsigned long)inj.pulsewidth_us);
     cli_print_table_row("Pulse Width", buffer);
     
-    snprintf(buffer, sizeof(buffer), "%.3f", state.lambda_target);
-    cli_print_table_row("Lambda Target", buffer);
-    
-    snprintf(buffer, sizeof(buffer), "%.3f", state.lambda_measured);
+    if (have_lambda) {
+        snprintf(buffer, sizeof(buffer), "%.3f (%lu ms ago)", lambda, (unsigned long)lambda_age_ms);
+    } else {
+        snprintf(buffer, sizeof(buffer), "no data");
+    }
     cli_print_table_row("Lambda Actual", buffer);
     
     cli_print_table_separator();
@@ -306,13 +318,13 @@ static int cli_cmd_status(int argc, char **argv)
     // Get sensor data
     sensor_data_t sensors;
     if (sensor_get_data(&sensors) == ESP_OK) {
-        snprintf(buffer, sizeof(buffer), "%.1f C", sensors.clt_c);
+        snprintf(buffer, sizeof(buffer), "%d C", sensors.clt_c);
         cli_print_table_row("CLT", buffer);
-        snprintf(buffer, sizeof(buffer), "%.1f C", sensors.iat_c);
+        snprintf(buffer, sizeof(buffer), "%d C", sensors.iat_c);
         cli_print_table_row("IAT", buffer);
-        snprintf(buffer, sizeof(buffer), "%.1f %%", sensors.tps_pct);
+        snprintf(buffer, sizeof(buffer), "%u %%", (unsigned)sensors.tps_percent);
         cli_print_table_row("TPS", buffer);
-        snprintf(buffer, sizeof(buffer), "%.2f V", sensors.vbat);
+        snprintf(buffer, sizeof(buffer), "%.1f V", sensors.vbat_dv / 10.0f);
         cli_print_table_row("Battery", buffer);
     }
     
@@ -331,12 +343,12 @@ static int cli_cmd_sensors(int argc, char **argv)
         while (g_cli.streaming) {
             sensor_data_t sensors;
             if (sensor_get_data(&sensors) == ESP_OK) {
-                engine_runtime_state_t state;
-                uint32_t seq;
-                engine_control_get_runtime_state(&state, &seq);
+                engine_params_t params = {0};
+                engine_control_get_engine_parameters(&params);
                 
-                cli_println("MAP: %.1f kPa | TPS: %.1f%% | CLT: %.1fC | RPM: %u",
-                           sensors.map_kpa, sensors.tps_pct, sensors.clt_c, state.rpm);
+                cli_println("MAP: %.1f kPa | TPS: %u%% | CLT: %dC | RPM: %lu",
+                           sensors.map_kpa10 / 10.0f, (unsigned)sensors.tps_percent, sensors.clt_c,
+                           (unsigned long)params.rpm);
             }
             vTaskDelay(pdMS_TO_TICKS(200));
         }
@@ -354,28 +366,31 @@ static int cli_cmd_sensors(int argc, char **argv)
     
     char buffer[64];
     
-    snprintf(buffer, sizeof(buffer), "%.1f kPa (raw: %u)", sensors.map_kpa, sensors.map_raw);
+    snprintf(buffer, sizeof(buffer), "%.1f kPa (raw: %u)", sensors.map_kpa10 / 10.0f,
+             (unsigned)sensors.raw_adc[SENSOR_MAP]);
     cli_print_table_row("MAP", buffer);
     
-    snprintf(buffer, sizeof(buffer), "%.1f %% (raw: %u)", sensors.tps_pct, sensors.tps_raw);
+    snprintf(buffer, sizeof(buffer), "%u %% (raw: %u)", (unsigned)sensors.tps_percent,
+             (unsigned)sensors.raw_adc[SENSOR_TPS]);
     cli_print_table_row("TPS", buffer);
     
-    snprintf(buffer, sizeof(buffer), "%.1f C (raw: %u)", sensors.clt_c, sensors.clt_raw);
+    snprintf(buffer, sizeof(buffer), "%d C (raw: %u)", sensors.clt_c, (unsigned)sensors.raw_adc[SENSOR_CLT]);
     cli_print_table_row("CLT", buffer);
     
-    snprintf(buffer, sizeof(buffer), "%.1f C (raw: %u)", sensors.iat_c, sensors.iat_raw);
+    snprintf(buffer, sizeof(buffer), "%d C (raw: %u)", sensors.iat_c, (unsigned)sensors.raw_adc[SENSOR_IAT]);
     cli_print_table_row("IAT", buffer);
     
-    snprintf(buffer, sizeof(buffer), "%.3f V (raw: %u)", sensors.o2_voltage, sensors.o2_raw);
+    snprintf(buffer, sizeof(buffer), "%u mV (raw: %u)", (unsigned)sensors.o2_mv, (unsigned)sensors.raw_adc[SENSOR_O2]);
     cli_print_table_row("O2", buffer);
     
-    snprintf(buffer, sizeof(buffer), "%.2f V (raw: %u)", sensors.vbat, sensors.vbat_raw);
+    snprintf(buffer, sizeof(buffer), "%.1f V (raw: %u)", sensors.vbat_dv / 10.0f,
+             (unsigned)sensors.raw_adc[SENSOR_VBAT]);
     cli_print_table_row("Battery", buffer);
     
     cli_print_table_separator();
     
-    const char *fault_str = sensors.sensor_faults ? "DETECTED" : "NONE";
-    cli_print_table_row("Faults", fault_str);
+    snprintf(buffer, sizeof(buffer), "%lu", (unsigned long)sensors.error_count);
+    cli_print_table_row("Errors", buffer);
     
     cli_print_table_footer();
     return 0;
@@ -531,19 +546,20 @@ static int cli_cmd_diag(int argc, char **argv)
     
     char buffer[64];
     
-    snprintf(buffer, sizeof(buffer), "%lu:%02lu:%02lu", hours, minutes, seconds);
+    snprintf(buffer, sizeof(buffer), "%lu:%02lu:%02lu", (unsigned long)hours, (unsigned long)minutes,
+             (unsigned long)seconds);
     cli_print_table_row("Uptime", buffer);
     
-    snprintf(buffer, sizeof(buffer), "%lu KB", esp_get_free_heap_size() / 1024);
+    snprintf(buffer, sizeof(buffer), "%lu KB", (unsigned long)(esp_get_free_heap_size() / 1024));
     cli_print_table_row("Free Heap", buffer);
     
     // Get sync statistics
-    const sync_data_t *sync = sync_get_data();
-    if (sync) {
-        snprintf(buffer, sizeof(buffer), "%lu", sync->sync_lost_count);
+    sync_data_t sync;
+    if (sync_get_data(&sync) == ESP_OK) {
+        snprintf(buffer, sizeof(buffer), "%lu", (unsigned long)sync.sync_loss_count);
         cli_print_table_row("Sync Losses", buffer);
-        snprintf(buffer, sizeof(buffer), "%lu", sync->tooth_count);
-        cli_print_table_row("Tooth Count", buffer);
+        snprintf(buffer, sizeof(buffer), "%lu", (unsigned long)sync.tooth_index);
+        cli_print_table_row("Tooth Index", buffer);
     }
     
     // Safety status
@@ -555,6 +571,81 @@ static int cli_cmd_diag(int argc, char **argv)
     return 0;
 }
 
+static int cli_cmd_perf(int argc, char **argv)
+{
+    if (argc > 1 && strcasecmp(argv[1], "reset") == 0) {
+        engine_control_reset_perf_stats();
+        cli_println("Latency histograms reset");
+        return 0;
+    }
+    if (argc > 1) {
+        cli_println("Usage: perf [reset]");
+        return -1;
+    }
+    
+    engine_perf_stats_t perf = {0};
+    engine_control_get_perf_stats(&perf);
+    
+    cli_println("");
+    cli_println("%-18s %10s %8s %8s %8s %8s %8s", "stage (us)", "count", "p50", "p95", "p99", "p99.9", "max");
+    for (int i = 0; i < ENGINE_PERF_STAGE_COUNT; i++) {
+        latency_summary_t sum;
+        if (engine_control_get_perf_latency((engine_perf_stage_t)i, &sum) != ESP_OK) {
+            continue;
+        }
+        cli_println("%-18s %10lu %8.1f %8.1f %8.1f %8.1f %8.1f",
+                    engine_control_perf_stage_name((engine_perf_stage_t)i), (unsigned long)sum.count,
+                    sum.p50 / 1000.0f, sum.p95 / 1000.0f, sum.p99 / 1000.0f,
+                    sum.p999 / 1000.0f, sum.max / 1000.0f);
+    }
+    cli_println("Deadline misses: planner %lu, executor %lu | queue overruns %lu, peak %lu",
+                (unsigned long)perf.planner_deadline_miss, (unsigned long)perf.executor_deadline_miss,
+                (unsigned long)perf.queue_overruns, (unsigned long)perf.queue_depth_peak);
+    return 0;
+}
+
+static int cli_cmd_prof(int argc, char **argv)
+{
+    espnow_task_profile_t prof;
+    if (task_profiler_get_last(&prof) != ESP_OK) {
+        cli_println("No profile yet");
+        return -1;
+    }
+    
+    if (argc > 1 && strcasecmp(argv[1], "raw") == 0) {
+        // Same bytes as the ESP-NOW task profile payload
+        const uint8_t *bytes = (const uint8_t *)&prof;
+        for (size_t i = 0; i < sizeof(prof); i++) {
+            cli_print("%02x%s", bytes[i], ((i + 1U) % 32U == 0U) ? "\r\n" : "");
+        }
+        cli_println("");
+        return 0;
+    }
+    if (argc > 1) {
+        cli_println("Usage: prof [raw]");
+        return -1;
+    }
+    
+    cli_println("");
+    cli_println("Load over %lu ms: core0 %.1f%%, core1 %.1f%%", (unsigned long)prof.window_ms,
+                prof.core_load_permille[0] / 10.0f, prof.core_load_permille[1] / 10.0f);
+    cli_println("%-12s %4s %7s %10s %10s", "task", "core", "load%", "stack free", "stack");
+    for (uint8_t i = 0; i < prof.task_count && i < ESPNOW_PROFILE_TASKS; i++) {
+        const espnow_task_entry_t *t = &prof.tasks[i];
+        const core_task_plan_t *plan = core_plan_get_task((core_task_id_t)t->task);
+        cli_println("%-12s %4d %7.1f %10u %10u", plan ? plan->name : "?",
+                    (t->core == 0xFFU) ? -1 : (int)t->core, t->load_permille / 10.0f,
+                    (unsigned)t->stack_free, (unsigned)t->stack_size);
+    }
+    cli_println("%-13s %8s %8s", "latency (us)", "p99", "max");
+    for (int i = 0; i < ESPNOW_PROFILE_LATENCIES; i++) {
+        // Profile latencies follow engine_perf_stage_t from the planner wake on
+        cli_println("%-13s %8.1f %8.1f", engine_control_perf_stage_name((engine_perf_stage_t)(ENGINE_PERF_PLANNER_WAKE + i)),
+                    prof.latency[i].p99_ns / 1000.0f, prof.latency[i].max_ns / 1000.0f);
+    }
+    return 0;
+}
+
 static int cli_cmd_stream(int argc, char **argv)
 {
     if (argc < 2) {
@@ -576,7 +667,7 @@ static int cli_cmd_stream(int argc, char **argv)
         g_cli.streaming = true;
         g_cli.stream_format = CLI_STREAM_CSV;
         
-        cli_println("Streaming at %lu ms interval (Ctrl+C to stop)", interval);
+        cli_println("Streaming at %lu ms interval (Ctrl+C to stop)", (unsigned long)interval);
         cli_println("time,rpm,map,tps,clt,iat,advance,pw,lambda");
         
         uint32_t start_ms = (uint32_t)(esp_timer_get_time() / 1000);
@@ -584,23 +675,27 @@ static int cli_cmd_stream(int argc, char **argv)
         while (g_cli.streaming) {
             uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
             
-            engine_runtime_state_t state;
-            uint32_t seq;
-            engine_control_get_runtime_state(&state, &seq);
+            engine_params_t params = {0};
+            engine_control_get_engine_parameters(&params);
+            engine_injection_diag_t inj = {0};
+            engine_control_get_injection_diag(&inj);
+            float lambda = 0.0f;
+            uint32_t lambda_age_ms = 0;
+            twai_lambda_get_latest(&lambda, &lambda_age_ms);
             
-            sensor_data_t sensors;
+            sensor_data_t sensors = {0};
             sensor_get_data(&sensors);
             
-            cli_println("%lu,%u,%.1f,%.1f,%.1f,%.1f,%.1f,%u,%.3f",
-                       now_ms - start_ms,
-                       state.rpm,
-                       sensors.map_kpa,
-                       sensors.tps_pct,
+            cli_println("%lu,%lu,%.1f,%u,%d,%d,%.1f,%lu,%.3f",
+                       (unsigned long)(now_ms - start_ms),
+                       (unsigned long)params.rpm,
+                       sensors.map_kpa10 / 10.0f,
+                       (unsigned)sensors.tps_percent,
                        sensors.clt_c,
                        sensors.iat_c,
-                       state.advance_deg10 / 10.0f,
-                       state.pw_us,
-                       state.lambda_measured);
+                       params.advance_deg10 / 10.0f,
+                       (unsigned long)inj.pulsewidth_us,
+                       lambda);
             
             vTaskDelay(pdMS_TO_TICKS(g_cli.stream_interval_ms));
         }
@@ -781,12 +876,12 @@ void cli_process_char(char c)
         if (g_cli.input_pos > 0) {
             // Add to history
             if (g_cli.history_count < CLI_HISTORY_SIZE) {
-                strncpy(g_cli.history[g_cli.history_count], g_cli.input_buffer, CLI_MAX_INPUT_LEN - 1);
+                memcpy(g_cli.history[g_cli.history_count], g_cli.input_buffer, g_cli.input_pos + 1);
                 g_cli.history_count++;
             } else {
                 // Shift history
                 memmove(g_cli.history[0], g_cli.history[1], sizeof(g_cli.history[0]) * (CLI_HISTORY_SIZE - 1));
-                strncpy(g_cli.history[CLI_HISTORY_SIZE - 1], g_cli.input_buffer, CLI_MAX_INPUT_LEN - 1);
+                memcpy(g_cli.history[CLI_HISTORY_SIZE - 1], g_cli.input_buffer, g_cli.input_pos + 1);
             }
             g_cli.history_pos = g_cli.history_count;
             
@@ -966,16 +1061,7 @@ esp_err_t cli_start(void)
     }
     
     // Create CLI task
-    BaseType_t ret = xTaskCreate(
-        cli_task,
-        "cli",
-        CLI_TASK_STACK_SIZE,
-        NULL,
-        CLI_TASK_PRIORITY,
-        &g_cli.cli_task
-    );
-    
-    if (ret != pdPASS) {
+    if (core_plan_create_task(CORE_TASK_CLI, cli_task, NULL, &g_cli.cli_task) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to create CLI task");
         return ESP_ERR_NO_MEM;
     }
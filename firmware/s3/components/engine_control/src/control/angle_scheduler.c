@@ -0,0 +1,245 @@
+#include "../include/angle_scheduler.h"
+#include "../include/engine_layout.h"
+#include "../include/s3_control_config.h"
+#include "../include/timebase.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+#define ANGLE_SCHED_CYLINDERS ENGINE_MAX_CYLINDERS
+
+typedef struct {
+    float last_dist_deg;
+    uint32_t target_us;
+    bool armed;
+    bool busy;                   // between plan and commit: the ISR keeps off
+    bool isr_busy;               // claimed by the tooth ISR: the executor holds
+    bool has_detail;
+    angle_event_detail_t detail;
+} angle_event_t;
+
+static angle_event_t g_events[ANGLE_EVENT_KIND_COUNT][ANGLE_SCHED_CYLINDERS];
+static angle_scheduler_stats_t g_stats;
+static angle_event_writer_t g_writers[ANGLE_EVENT_KIND_COUNT];
+static volatile bool g_isr_refine = (ANGLE_SCHED_ISR_REFINE != 0);
+static latency_hist_t g_write_latency[2];  // [0] executor, [1] tooth ISR
+// Events are shared by the executor task and the tooth ISR
+static portMUX_TYPE g_sched_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+static angle_event_t *event_get(angle_event_kind_t kind, uint8_t cylinder) {
+    if ((unsigned)kind >= ANGLE_EVENT_KIND_COUNT || cylinder < 1U || cylinder > ANGLE_SCHED_CYLINDERS) {
+        return NULL;
+    }
+    return &g_events[kind][cylinder - 1U];
+}
+
+IRAM_ATTR static void record_write_latency(bool isr, uint64_t edge_us) {
+    uint64_t now_us = timebase_now_us();
+    latency_hist_record(&g_write_latency[isr ? 1 : 0], (now_us > edge_us) ? (uint32_t)(now_us - edge_us) : 0U);
+}
+
+static bool isr_refines(angle_event_kind_t kind) {
+    return g_isr_refine && g_writers[kind] != NULL;
+}
+
+void angle_scheduler_reset(void) {
+    portENTER_CRITICAL_SAFE(&g_sched_spinlock);
+    memset(g_events, 0, sizeof(g_events));
+    portEXIT_CRITICAL_SAFE(&g_sched_spinlock);
+}
+
+angle_event_action_t angle_scheduler_plan(angle_event_kind_t kind,
+                                          uint8_t cylinder,
+                                          float dist_deg,
+                                          float deg_per_tooth,
+                                          uint32_t target_us) {
+    angle_event_t *ev = event_get(kind, cylinder);
+    if (!ev) {
+        return ANGLE_EVENT_HOLD;
+    }
+    angle_event_action_t action = ANGLE_EVENT_HOLD;
+    portENTER_CRITICAL_SAFE(&g_sched_spinlock);
+    g_stats.updates++;
+    if (ev->isr_busy) {
+        // The tooth ISR is rewriting this event; look again on the next tooth
+        portEXIT_CRITICAL_SAFE(&g_sched_spinlock);
+        return ANGLE_EVENT_HOLD;
+    }
+
+    // The distance shrinks tooth by tooth and jumps up by almost a full cycle
+    // once the event angle has been passed: the event fired, arm the next one.
+    if (ev->armed && dist_deg > ev->last_dist_deg + 360.0f) {
+        ev->armed = false;
+    }
+    ev->last_dist_deg = dist_deg;
+
+    if (!ev->armed) {
+        if (dist_deg > ANGLE_SCHED_ARM_DEG) {
+            g_stats.deferred++;
+        } else {
+            action = ANGLE_EVENT_ARM;
+        }
+    } else if (dist_deg <= (float)ANGLE_SCHED_REFINE_TEETH * deg_per_tooth && !isr_refines(kind)) {
+        // Targets are low 32 bits of the timebase; the signed difference survives the wrap
+        int32_t diff = (int32_t)(target_us - ev->target_us);
+        uint32_t moved = (diff < 0) ? (uint32_t)(-(int64_t)diff) : (uint32_t)diff;
+        if (moved < ANGLE_SCHED_REFINE_MIN_US) {
+            g_stats.refines_skipped++;
+        } else {
+            action = ANGLE_EVENT_REFINE;
+        }
+    }
+    ev->busy = (action != ANGLE_EVENT_HOLD);
+    portEXIT_CRITICAL_SAFE(&g_sched_spinlock);
+    return action;
+}
+
+void angle_scheduler_commit(angle_event_kind_t kind,
+                            uint8_t cylinder,
+                            angle_event_action_t action,
+                            uint32_t target_us,
+                            uint64_t edge_us,
+                            bool written,
+                            const angle_event_detail_t *detail) {
+    angle_event_t *ev = event_get(kind, cylinder);
+    if (!ev || action == ANGLE_EVENT_HOLD) {
+        return;
+    }
+    if (written) {
+        record_write_latency(false, edge_us);
+    }
+    portENTER_CRITICAL_SAFE(&g_sched_spinlock);
+    ev->busy = false;
+    if (!written) {
+        // An unarmed event is retried on the next tooth
+        g_stats.rejected++;
+    } else {
+        ev->armed = true;
+        ev->target_us = target_us;
+        ev->has_detail = (detail != NULL);
+        if (detail) {
+            ev->detail = *detail;
+        }
+        __atomic_fetch_add(&g_stats.comparator_writes, 2U, __ATOMIC_RELAXED);
+        if (action == ANGLE_EVENT_ARM) {
+            g_stats.arms++;
+        } else {
+            g_stats.refines++;
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&g_sched_spinlock);
+}
+
+void angle_scheduler_set_isr_refine(bool enabled) {
+    g_isr_refine = enabled;
+}
+
+bool angle_scheduler_get_isr_refine(void) {
+    return g_isr_refine;
+}
+
+void angle_scheduler_set_writer(angle_event_kind_t kind, angle_event_writer_t writer) {
+    if ((unsigned)kind < ANGLE_EVENT_KIND_COUNT) {
+        g_writers[kind] = writer;
+    }
+}
+
+// The event to refine on this tooth, claimed under the lock: the ISR then
+// works on its copy with interrupts enabled
+typedef struct {
+    angle_event_t *ev;
+    uint32_t dist;
+    uint32_t target_us;
+    angle_event_detail_t detail;
+} isr_claim_t;
+
+IRAM_ATTR static bool isr_claim(angle_event_t *ev, const sync_snapshot_t *tooth, uint32_t window,
+                                isr_claim_t *claim) {
+    bool claimed = false;
+    portENTER_CRITICAL_SAFE(&g_sched_spinlock);
+    if (ev->armed && !ev->busy && !ev->isr_busy && ev->has_detail) {
+        uint32_t dist = (ev->detail.event_angle + SYNC_ANGLE_CYCLE - tooth->cycle_angle) % SYNC_ANGLE_CYCLE;
+        if (dist <= window) {
+            ev->isr_busy = true;
+            claim->ev = ev;
+            claim->dist = dist;
+            claim->target_us = ev->target_us;
+            claim->detail = ev->detail;
+            claimed = true;
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&g_sched_spinlock);
+    return claimed;
+}
+
+IRAM_ATTR static void isr_release(const isr_claim_t *claim, bool written, uint32_t target_us) {
+    portENTER_CRITICAL_SAFE(&g_sched_spinlock);
+    if (written) {
+        claim->ev->target_us = target_us;
+    }
+    claim->ev->isr_busy = false;
+    portEXIT_CRITICAL_SAFE(&g_sched_spinlock);
+}
+
+// Fixed point only: no FPU in ISRs
+IRAM_ATTR void angle_scheduler_on_tooth(void) {
+    if (!g_isr_refine) {
+        return;
+    }
+    sync_snapshot_t tooth;
+    if (sync_get_snapshot(&tooth) != ESP_OK || !sync_snapshot_acquired(&tooth) ||
+        tooth.us_per_degree_q16 == 0U) {
+        return;
+    }
+    uint32_t window = (uint32_t)ANGLE_SCHED_REFINE_TEETH * tooth.tooth_pitch;
+
+    for (uint32_t kind = 0; kind < ANGLE_EVENT_KIND_COUNT; kind++) {
+        angle_event_writer_t writer = g_writers[kind];
+        if (writer == NULL) {
+            continue;
+        }
+        for (uint32_t i = 0; i < ANGLE_SCHED_CYLINDERS; i++) {
+            isr_claim_t claim;
+            if (!isr_claim(&g_events[kind][i], &tooth, window, &claim)) {
+                continue;
+            }
+            // us = angle / 64 * us_per_degree_q16 / 65536, rounded
+            uint64_t delay_us = ((uint64_t)claim.dist * tooth.us_per_degree_q16 +
+                                 (1ULL << (SYNC_ANGLE_FRAC_BITS + 15U))) >> (SYNC_ANGLE_FRAC_BITS + 16U);
+            uint64_t target_us = tooth.capture_time_us + delay_us + (int64_t)claim.detail.lead_us;
+            int32_t diff = (int32_t)((uint32_t)target_us - claim.target_us);
+            uint32_t moved = (diff < 0) ? (uint32_t)(-(int64_t)diff) : (uint32_t)diff;
+            bool written = false;
+            if (moved < ANGLE_SCHED_REFINE_MIN_US) {
+                __atomic_fetch_add(&g_stats.isr_refines_skipped, 1U, __ATOMIC_RELAXED);
+            } else if (writer(target_us, &claim.detail)) {
+                record_write_latency(true, tooth.capture_time_us);
+                written = true;
+                __atomic_fetch_add(&g_stats.isr_refines, 1U, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&g_stats.comparator_writes, 2U, __ATOMIC_RELAXED);
+            } else {
+                __atomic_fetch_add(&g_stats.isr_rejected, 1U, __ATOMIC_RELAXED);
+            }
+            isr_release(&claim, written, (uint32_t)target_us);
+        }
+    }
+}
+
+void angle_scheduler_get_write_latency(bool isr, latency_summary_t *out) {
+    latency_hist_summary(&g_write_latency[isr ? 1 : 0], out);
+}
+
+void angle_scheduler_get_stats(angle_scheduler_stats_t *out) {
+    if (out) {
+        portENTER_CRITICAL_SAFE(&g_sched_spinlock);
+        *out = g_stats;
+        portEXIT_CRITICAL_SAFE(&g_sched_spinlock);
+    }
+}
+
+void angle_scheduler_reset_stats(void) {
+    portENTER_CRITICAL_SAFE(&g_sched_spinlock);
+    memset(&g_stats, 0, sizeof(g_stats));
+    portEXIT_CRITICAL_SAFE(&g_sched_spinlock);
+    latency_hist_reset(&g_write_latency[0]);
+    latency_hist_reset(&g_write_latency[1]);
+}
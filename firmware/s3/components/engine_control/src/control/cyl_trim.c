@@ -0,0 +1,95 @@
+#include "../include/cyl_trim.h"
+#include "../include/math_utils.h"
+#include <math.h>
+
+static const uint16_t CYL_TRIM_Z_BINS[CYL_TRIM_CYLINDERS] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+// Axis reciprocals and buckets of the fuel map; the ignition map shares its
+// axes (cyl_trim_validate), so one cache serves both
+static table_cache_t g_trim_axes = {0};
+
+void cyl_trim_init_defaults(cyl_trim_maps_t *maps) {
+    if (!maps) {
+        return;
+    }
+    cyl_trim_map_init(&maps->fuel, DEFAULT_RPM_BINS, 16, DEFAULT_LOAD_BINS, 16,
+                      CYL_TRIM_Z_BINS, CYL_TRIM_CYLINDERS, CYL_TRIM_FUEL_UNITY);
+    cyl_trim_map_init(&maps->ignition, DEFAULT_RPM_BINS, 16, DEFAULT_LOAD_BINS, 16,
+                      CYL_TRIM_Z_BINS, CYL_TRIM_CYLINDERS, CYL_TRIM_IGN_ZERO);
+}
+
+bool cyl_trim_validate(const cyl_trim_maps_t *maps) {
+    if (!maps || !cyl_trim_map_validate(&maps->fuel) || !cyl_trim_map_validate(&maps->ignition)) {
+        return false;
+    }
+    table_view_t fuel = cyl_trim_map_view(&maps->fuel);
+    table_view_t ign = cyl_trim_map_view(&maps->ignition);
+    return table_view_same_axes(&fuel, &ign);
+}
+
+void cyl_trim_lookup(const cyl_trim_maps_t *maps, uint16_t rpm, uint16_t load,
+                     uint8_t cylinders, cyl_trim_t *out) {
+    if (!out) {
+        return;
+    }
+    if (cylinders > CYL_TRIM_CYLINDERS) {
+        cylinders = CYL_TRIM_CYLINDERS;
+    }
+    if (!maps) {
+        for (uint8_t c = 0; c < cylinders; c++) {
+            out->fuel_x1000[c] = CYL_TRIM_FUEL_UNITY;
+            out->ign_deg10[c] = 0;
+        }
+        return;
+    }
+
+    TABLE_CACHE_SYNC(&maps->fuel, &g_trim_axes, cyl_trim_map_view);
+    table_axis_pos_t px;
+    table_axis_pos_t py;
+    table_axis_locate(maps->fuel.x_bins, CYL_TRIM_BINS, &g_trim_axes.axis[0], rpm, &px);
+    table_axis_locate(maps->fuel.y_bins, CYL_TRIM_BINS, &g_trim_axes.axis[1], load, &py);
+
+    // One position, one layer per cylinder, no z interpolation
+    for (uint8_t c = 0; c < cylinders; c++) {
+        out->fuel_x1000[c] = table_eval_2d(&maps->fuel.values[c][0][0], CYL_TRIM_BINS, &px, &py);
+        uint16_t ign_raw = table_eval_2d(&maps->ignition.values[c][0][0], CYL_TRIM_BINS, &px, &py);
+        out->ign_deg10[c] = (int16_t)((int32_t)ign_raw - (int32_t)CYL_TRIM_IGN_ZERO);
+    }
+}
+
+void cyl_trim_apply(const cyl_trim_t *trim,
+                    uint8_t cylinders,
+                    uint32_t base_pw_us,
+                    uint16_t base_advance_deg10,
+                    uint32_t pw_us[CYL_TRIM_CYLINDERS],
+                    uint16_t advance_deg10[CYL_TRIM_CYLINDERS]) {
+    if (cylinders > CYL_TRIM_CYLINDERS) {
+        cylinders = CYL_TRIM_CYLINDERS;
+    }
+    for (uint8_t c = 0; c < cylinders; c++) {
+        uint32_t fuel = trim ? trim->fuel_x1000[c] : CYL_TRIM_FUEL_UNITY;
+        int32_t ign = trim ? trim->ign_deg10[c] : 0;
+        uint64_t pw = ((uint64_t)base_pw_us * fuel + (CYL_TRIM_FUEL_UNITY / 2U)) / CYL_TRIM_FUEL_UNITY;
+        pw_us[c] = (pw > UINT32_MAX) ? UINT32_MAX : (uint32_t)pw;
+        int32_t adv = (int32_t)base_advance_deg10 + ign;
+        advance_deg10[c] = (adv < 0) ? 0U : ((adv > 65535) ? 65535U : (uint16_t)adv);
+    }
+}
+
+uint16_t cyl_trim_fuel_to_raw(float pct) {
+    float v = clamp_float(pct, CYL_TRIM_FUEL_MIN_PCT, CYL_TRIM_FUEL_MAX_PCT);
+    return (uint16_t)lroundf((float)CYL_TRIM_FUEL_UNITY + (v * 10.0f));
+}
+
+float cyl_trim_fuel_from_raw(uint16_t raw) {
+    return ((float)raw - (float)CYL_TRIM_FUEL_UNITY) / 10.0f;
+}
+
+uint16_t cyl_trim_ign_to_raw(float deg) {
+    float v = clamp_float(deg, CYL_TRIM_IGN_MIN_DEG, CYL_TRIM_IGN_MAX_DEG);
+    return (uint16_t)lroundf((float)CYL_TRIM_IGN_ZERO + (v * 10.0f));
+}
+
+float cyl_trim_ign_from_raw(uint16_t raw) {
+    return ((float)raw - (float)CYL_TRIM_IGN_ZERO) / 10.0f;
+}
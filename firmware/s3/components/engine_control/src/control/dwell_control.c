@@ -0,0 +1,182 @@
+#include "../include/dwell_control.h"
+#include <math.h>
+#include <string.h>
+
+static const uint16_t DEFAULT_DWELL_RPM_BINS[DWELL_RPM_BINS] = {500, 1000, 2000, 3000, 4000, 5500, 7000, 8000};
+static const uint16_t DEFAULT_DWELL_VBAT_BINS_DV[DWELL_VBAT_BINS] = {80, 100, 110, 120, 130, 140, 150, 160};
+
+// Dwell per 0.1 V from DWELL_VBAT_MIN_DV at each rpm bin, built from one map generation
+static uint16_t g_dwell_lut[DWELL_VBAT_BUCKETS][DWELL_RPM_BINS];
+static uint32_t g_lut_generation = 0;
+static bool g_lut_valid = false;
+
+static dwell_config_t g_default_cfg;
+static bool g_default_ready = false;
+
+bool dwell_control_coil_valid(const dwell_coil_t *coil) {
+    return coil && coil->inductance_uh > 0U && coil->resistance_mohm > 0U && coil->peak_ma > 0U;
+}
+
+uint16_t dwell_control_coil_dwell_us(const dwell_coil_t *coil, uint16_t vbat_dv) {
+    if (!dwell_control_coil_valid(coil) || vbat_dv == 0U) {
+        return DWELL_MAX_US;
+    }
+    // t = -(L / R) * ln(1 - I R / V)
+    float v = (float)vbat_dv / 10.0f;
+    float r = (float)coil->resistance_mohm / 1000.0f;
+    float l = (float)coil->inductance_uh / 1000000.0f;
+    float i = (float)coil->peak_ma / 1000.0f;
+    float x = 1.0f - (i * r) / v;
+    if (x <= 0.0f) {
+        return DWELL_MAX_US;
+    }
+    float t_us = -(l / r) * logf(x) * 1000000.0f;
+    if (t_us < (float)DWELL_MIN_US) {
+        return DWELL_MIN_US;
+    }
+    if (t_us > (float)DWELL_MAX_US) {
+        return DWELL_MAX_US;
+    }
+    return (uint16_t)lroundf(t_us);
+}
+
+void dwell_control_fill_from_coil(dwell_config_t *cfg, const dwell_coil_t *coil) {
+    if (!cfg || !coil) {
+        return;
+    }
+    for (uint8_t y = 0; y < DWELL_VBAT_BINS; y++) {
+        uint16_t dwell_us = dwell_control_coil_dwell_us(coil, cfg->map.y_bins[y]);
+        for (uint8_t x = 0; x < DWELL_RPM_BINS; x++) {
+            cfg->map.values[y][x] = dwell_us;
+        }
+    }
+    dwell_map_commit(&cfg->map);
+    cfg->coil = *coil;
+}
+
+void dwell_control_init_defaults(dwell_config_t *cfg) {
+    if (!cfg) {
+        return;
+    }
+    dwell_map_init(&cfg->map, DEFAULT_DWELL_RPM_BINS, DWELL_RPM_BINS,
+                   DEFAULT_DWELL_VBAT_BINS_DV, DWELL_VBAT_BINS, DWELL_MIN_US);
+    dwell_coil_t coil = {
+        .inductance_uh = DWELL_COIL_DEFAULT_INDUCTANCE_UH,
+        .resistance_mohm = DWELL_COIL_DEFAULT_RESISTANCE_MOHM,
+        .peak_ma = DWELL_COIL_DEFAULT_PEAK_MA,
+    };
+    dwell_control_fill_from_coil(cfg, &coil);
+    cfg->max_duty_x10 = DWELL_DEFAULT_DUTY_X10;
+    cfg->min_off_us = DWELL_DEFAULT_OFF_US;
+}
+
+bool dwell_control_validate(const dwell_config_t *cfg) {
+    if (!cfg || !dwell_map_validate(&cfg->map) || !dwell_control_coil_valid(&cfg->coil)) {
+        return false;
+    }
+    if (cfg->max_duty_x10 < DWELL_MIN_DUTY_X10 || cfg->max_duty_x10 > DWELL_MAX_DUTY_X10 ||
+        cfg->min_off_us > DWELL_MAX_OFF_US) {
+        return false;
+    }
+    for (uint8_t y = 0; y < DWELL_VBAT_BINS; y++) {
+        for (uint8_t x = 0; x < DWELL_RPM_BINS; x++) {
+            if (cfg->map.values[y][x] < DWELL_MIN_US || cfg->map.values[y][x] > DWELL_MAX_US) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void dwell_lut_build(const dwell_map_t *map) {
+    for (uint32_t b = 0; b < DWELL_VBAT_BUCKETS; b++) {
+        uint16_t v = (uint16_t)(DWELL_VBAT_MIN_DV + b);
+        for (uint8_t x = 0; x < DWELL_RPM_BINS; x++) {
+            g_dwell_lut[b][x] = dwell_map_interpolate(map, NULL, map->x_bins[x], v);
+        }
+    }
+    g_lut_generation = map->generation;
+    g_lut_valid = true;
+}
+
+// Hot coils have more resistance and heat up faster: look them up as if the
+// battery were higher (shorter dwell), cold ones as if it were lower
+static int32_t dwell_temp_bias_dv(int16_t clt_c) {
+    if (clt_c >= 105) {
+        return 10;
+    }
+    if (clt_c >= 95) {
+        return 5;
+    }
+    if (clt_c <= 0) {
+        return -7;
+    }
+    if (clt_c <= 20) {
+        return -4;
+    }
+    return 0;
+}
+
+static uint16_t dwell_row_interpolate(const uint16_t *x_bins, const uint16_t *row, uint16_t rpm) {
+    const uint8_t last = DWELL_RPM_BINS - 1U;
+    if (rpm <= x_bins[0]) {
+        return row[0];
+    }
+    if (rpm >= x_bins[last]) {
+        return row[last];
+    }
+    uint8_t i = 1;
+    while (rpm > x_bins[i]) {
+        i++;
+    }
+    int32_t x0 = x_bins[i - 1U];
+    int32_t span = (int32_t)x_bins[i] - x0;
+    int32_t dy = (int32_t)row[i] - (int32_t)row[i - 1U];
+    int32_t num = dy * ((int32_t)rpm - x0);
+    return (uint16_t)((int32_t)row[i - 1U] + ((num >= 0) ? (num + span / 2) : (num - span / 2)) / span);
+}
+
+void dwell_control_prepare(const dwell_config_t *cfg, uint16_t vbat_dv, int16_t clt_c,
+                           uint16_t rpm, uint32_t coil_period_us, dwell_plan_t *out) {
+    if (!out) {
+        return;
+    }
+    if (!cfg) {
+        if (!g_default_ready) {
+            dwell_control_init_defaults(&g_default_cfg);
+            g_default_ready = true;
+        }
+        cfg = &g_default_cfg;
+    }
+    if (!g_lut_valid || g_lut_generation != cfg->map.generation) {
+        dwell_lut_build(&cfg->map);
+    }
+
+    if (vbat_dv == 0U) {
+        vbat_dv = DWELL_VBAT_NOMINAL_DV;
+    }
+    int32_t v = (int32_t)vbat_dv + dwell_temp_bias_dv(clt_c);
+    if (v < (int32_t)DWELL_VBAT_MIN_DV) {
+        v = DWELL_VBAT_MIN_DV;
+    } else if (v > (int32_t)DWELL_VBAT_MAX_DV) {
+        v = DWELL_VBAT_MAX_DV;
+    }
+    uint32_t dwell_us = dwell_row_interpolate(cfg->map.x_bins, g_dwell_lut[v - DWELL_VBAT_MIN_DV], rpm);
+
+    bool limited = false;
+    if (coil_period_us > 0U) {
+        uint32_t max_us = (uint32_t)(((uint64_t)coil_period_us * cfg->max_duty_x10) / 1000U);
+        if (coil_period_us > cfg->min_off_us && coil_period_us - cfg->min_off_us < max_us) {
+            max_us = coil_period_us - cfg->min_off_us;
+        } else if (coil_period_us <= cfg->min_off_us) {
+            max_us = 0U;
+        }
+        if (dwell_us > max_us) {
+            dwell_us = max_us;
+            limited = true;
+        }
+    }
+    out->vbat_dv = vbat_dv;
+    out->dwell_us = (uint16_t)dwell_us;
+    out->duty_limited = limited;
+}
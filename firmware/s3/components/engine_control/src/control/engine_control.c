@@ -8,6 +8,7 @@
 #include "../include/s3_control_config.h"
 #include "../include/fuel_injection.h"
 #include "../include/ignition_timing.h"
+#include "../include/angle_scheduler.h"
 #include "../include/config_manager.h"
 #include "../include/map_storage.h"
 #include "../include/safety_monitor.h"
@@ -16,6 +17,19 @@
 #include "../include/espnow_link.h"
 #include "../include/mcpwm_injection_hp.h"
 #include "../include/mcpwm_ignition_hp.h"
+#include "../include/output_capture.h"
+#include "../include/timebase.h"
+#include "../include/cyl_trim.h"
+#include "../include/split_injection.h"
+#include "../include/injector_model.h"
+#include "../include/dwell_control.h"
+#include "../include/engine_layout.h"
+#include "../include/mcpwm_output.h"
+#include "../include/latency_hist.h"
+#include "../include/spsc_ring.h"
+#include "../include/high_precision_timing.h"
+#include "../include/core_plan.h"
+#include "../include/task_profiler.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
@@ -25,8 +39,27 @@
 #include <stdint.h>
 #include <string.h>
 
+// Runtime copy of the persisted EOIT normal map (table_16x16_t), with a
+// generation so edits only invalidate its own lookup cache.
+TABLE_2D_DEFINE(eoit_normal_map, 16, 16)
+
+// Everything the planner reads from the calibration maps. Two copies: the
+// planner reads the published one without locking, writers (holding
+// g_map_mutex) edit a copy in the spare one and publish it (see map_set_*).
+typedef struct {
+    fuel_calc_maps_t maps;
+    eoit_normal_map_t eoit_map;
+    bool eoit_enabled;
+    cyl_trim_maps_t trims;
+    split_injection_config_t split;
+    injector_model_config_t injector;
+    dwell_config_t dwell;
+} map_set_t;
+
 // Static variables
-static fuel_calc_maps_t g_maps = {0};
+static map_set_t g_map_sets[2] = {0};
+static volatile uint32_t g_map_active = 0;         // index of the published set
+static volatile uint32_t g_map_readers[2] = {0};   // readers pinned on each set
 static lambda_pid_t g_lambda_pid = {0};
 static bool g_engine_math_ready = false;
 static float g_target_eoi_deg = 360.0f;
@@ -34,12 +67,11 @@ static float g_target_eoi_deg_fallback = 360.0f;
 static float g_eoit_boundary = 6.5f;
 static float g_eoit_normal = 5.55f;
 static float g_eoit_fallback_normal = 5.55f;
-static table_16x16_t g_eoit_normal_map = {0};
-static bool g_eoit_map_enabled = false;
 static TaskHandle_t g_planner_task_handle = NULL;
 static TaskHandle_t g_executor_task_handle = NULL;
 static TaskHandle_t g_monitor_task_handle = NULL;
-static SemaphoreHandle_t g_map_mutex = NULL;
+static bool g_outputs_parked = true;  // executor task only
+static SemaphoreHandle_t g_map_mutex = NULL;  // serializes map writers only
 static float g_stft = 0.0f;
 static float g_ltft = 0.0f;
 static uint16_t g_last_rpm = 0;
@@ -48,6 +80,10 @@ static uint32_t g_stable_start_ms = 0;
 static uint32_t g_last_map_save_ms = 0;
 static uint32_t g_map_version = 0;
 static bool g_map_dirty = false;
+static uint32_t g_trims_version = 0;
+static bool g_trims_dirty = false;
+// Monitor task only: the trim maps are too large for its stack
+static cyl_trim_maps_t g_trims_snapshot;
 static bool g_closed_loop_enabled = true;
 static sensor_data_t g_last_sensor_snapshot = {0};
 static bool g_last_sensor_valid = false;
@@ -56,6 +92,8 @@ static volatile uint32_t g_runtime_seq = 0;
 
 #define CLOSED_LOOP_CONFIG_KEY "closed_loop_cfg"
 #define CLOSED_LOOP_CONFIG_VERSION 1U
+#define ENGINE_LAYOUT_CONFIG_KEY "engine_layout"
+#define ENGINE_LAYOUT_CONFIG_VERSION 1U
 
 /**
  * @brief Short-Term Fuel Trim limits and configuration
@@ -81,6 +119,7 @@ static volatile uint32_t g_runtime_seq = 0;
 #define LTFT_RPM_DELTA_MAX 50U        // ±50 RPM stability window
 #define LTFT_LOAD_DELTA_MAX 50U       // ±50 load units stability window
 #define LTFT_APPLY_THRESHOLD 0.03f    // 3% minimum LTFT to apply
+#define LTFT_RING_SIZE 8U             // LTFT cell updates waiting for the monitor task (power of two)
 
 /**
  * @brief Timing and performance configuration
@@ -96,8 +135,10 @@ static volatile uint32_t g_runtime_seq = 0;
 /**
  * @brief Ring buffer and performance monitoring configuration
  */
-#define PLAN_RING_SIZE 16U            // Command ring buffer size
-#define PERF_WINDOW 128U              // Performance samples window
+#define PLAN_RING_SIZE 16U            // Command ring size in queue mode (power of two)
+// 1: the executor gets the newest plan through a latest-value mailbox,
+// 0: through a PLAN_RING_SIZE queue it drains to the newest entry
+#define PLAN_RING_MAILBOX 1
 #define SENSOR_FALLBACK_TIMEOUT_MS 100U // Sensor data timeout before fallback
 
 #define EOI_CONFIG_KEY "eoi_config"
@@ -144,39 +185,44 @@ typedef struct {
     uint32_t crc32;
 } closed_loop_config_blob_t;
 
+typedef struct {
+    uint32_t version;
+    engine_layout_t layout;
+    uint32_t crc32;
+} engine_layout_config_blob_t;
+
 typedef struct {
     uint16_t rpm;
     uint16_t load;
     uint16_t advance_deg10;
     uint32_t pw_us;
+    // Per-cylinder plan after trims, index = cylinder - 1
+    uint16_t advance_deg10_cyl[ENGINE_MAX_CYLINDERS];
+    uint32_t pw_us_cyl[ENGINE_MAX_CYLINDERS];
+    split_injection_t split;
+    injector_comp_t injector;  // at the battery voltage of the plan
+    dwell_plan_t dwell;        // coil charge time, duty limited
     float eoit_normal_used;
     float eoi_target_deg;
     float eoi_fallback_deg;
-    sync_data_t sync_data;
+    // No sync snapshot: the executor always schedules from the live one
     uint32_t planned_at_us;
 } engine_plan_cmd_t;
 
+// Updated with relaxed atomics by the planner and executor; the latency
+// distributions live in g_perf_hist
 typedef struct {
-    engine_plan_cmd_t items[PLAN_RING_SIZE];
-    volatile uint8_t head;
-    volatile uint8_t tail;
-    volatile uint32_t overruns;
-    portMUX_TYPE mux;
-} plan_ring_t;
-
-typedef struct {
-    uint32_t planner_samples[PERF_WINDOW];
-    uint32_t executor_samples[PERF_WINDOW];
-    uint16_t sample_idx;
-    uint16_t sample_count;
     uint32_t planner_last_us;
     uint32_t planner_max_us;
     uint32_t executor_last_us;
     uint32_t executor_max_us;
     uint32_t planner_deadline_miss;
     uint32_t executor_deadline_miss;
-    uint32_t queue_overruns;
     uint32_t queue_depth_peak;
+    // Cycle count at the last notify of each task. Notifier and task both run
+    // on the control core, so the core-local cycle counters compare.
+    uint32_t planner_notified_at;
+    uint32_t executor_notified_at;
 } perf_stats_t;
 
 typedef struct {
@@ -187,21 +233,30 @@ typedef struct {
     bool valid;
 } runtime_engine_state_t;
 
-static plan_ring_t g_plan_ring = {
-    .head = 0,
-    .tail = 0,
-    .overruns = 0,
-    .mux = portMUX_INITIALIZER_UNLOCKED,
-};
+// Planner -> executor, one producer and one consumer task
+static spsc_ring_t g_plan_ring;
+#if PLAN_RING_MAILBOX
+static engine_plan_cmd_t g_plan_slots[SPSC_RING_MAILBOX_SLOTS];
+#else
+static engine_plan_cmd_t g_plan_slots[PLAN_RING_SIZE];
+#endif
+
+// LTFT cell corrections, planner -> monitor task: the planner only reads the
+// maps, the monitor task applies the corrections as a map writer
+typedef struct {
+    uint16_t rpm;
+    uint16_t load;
+    float ltft;
+} ltft_update_t;
+static spsc_ring_t g_ltft_ring;
+static ltft_update_t g_ltft_slots[LTFT_RING_SIZE];
 static perf_stats_t g_perf_stats = {0};
+static latency_hist_t g_perf_hist[ENGINE_PERF_STAGE_COUNT];
 static runtime_engine_state_t g_runtime_state = {0};
-static portMUX_TYPE g_perf_spinlock = portMUX_INITIALIZER_UNLOCKED;
 static engine_injection_diag_t g_injection_diag = {0};
 static volatile uint32_t g_injection_diag_seq = 0;
 static bool g_engine_initialized = false;
 
-static float compute_current_angle_360(const sync_data_t *sync, uint32_t tooth_count);
-static float sync_us_per_degree(const sync_data_t *sync, const sync_config_t *cfg);
 
 static uint32_t eoi_config_crc(const eoi_config_blob_t *cfg) {
     return esp_rom_crc32_le(0, (const uint8_t *)&cfg->boundary, (uint32_t)(sizeof(float) * 3));
@@ -285,26 +340,72 @@ static void eoit_map_config_defaults(eoit_map_config_blob_t *cfg) {
     cfg->crc32 = eoit_map_config_crc(cfg);
 }
 
-static void eoit_map_config_apply(const eoit_map_config_blob_t *cfg) {
-    if (!cfg) {
-        return;
+/**
+ * @brief Pin the published map set for reading
+ *
+ * Never blocks: retries only if a writer published between loading the index
+ * and pinning it. Pair with map_set_release().
+ */
+static const map_set_t *map_set_acquire(uint32_t *idx) {
+    for (;;) {
+        uint32_t i = __atomic_load_n(&g_map_active, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&g_map_readers[i], 1U, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&g_map_active, __ATOMIC_SEQ_CST) == i) {
+            *idx = i;
+            return &g_map_sets[i];
+        }
+        __atomic_fetch_sub(&g_map_readers[i], 1U, __ATOMIC_SEQ_CST);
     }
-    g_eoit_map_enabled = (cfg->enabled != 0U);
-    g_eoit_normal_map = cfg->normal_map;
 }
 
-static float compute_current_angle_360(const sync_data_t *sync, uint32_t tooth_count) {
-    float degrees_per_tooth = 360.0f / (float)(tooth_count + 2);
-    float current_angle = sync->tooth_index * degrees_per_tooth;
-    return wrap_angle_360(current_angle);
+static void map_set_release(uint32_t idx) {
+    __atomic_fetch_sub(&g_map_readers[idx], 1U, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Start a map update: returns the spare set holding a copy of the
+ * published one
+ *
+ * Caller holds g_map_mutex. Waits (blocking, never spinning) until readers
+ * still pinned on the spare set from before the last publish are done; only
+ * writers wait. The planner is never a writer: its LTFT corrections go
+ * through g_ltft_ring to the monitor task.
+ */
+static map_set_t *map_set_begin_update(void) {
+    uint32_t active = __atomic_load_n(&g_map_active, __ATOMIC_SEQ_CST);
+    uint32_t spare = active ^ 1U;
+    while (__atomic_load_n(&g_map_readers[spare], __ATOMIC_SEQ_CST) != 0U) {
+        vTaskDelay(1);
+    }
+    g_map_sets[spare] = g_map_sets[active];
+    return &g_map_sets[spare];
+}
+
+static void map_set_publish(const map_set_t *set) {
+    __atomic_store_n(&g_map_active, (uint32_t)(set - g_map_sets), __ATOMIC_SEQ_CST);
 }
 
-static float sync_us_per_degree(const sync_data_t *sync, const sync_config_t *cfg) {
-    if (!sync || !cfg || sync->tooth_period == 0U || cfg->tooth_count == 0U) {
-        return 0.0f;
+static void eoit_map_to_blob(const eoit_normal_map_t *map, table_16x16_t *dst) {
+    memcpy(dst->rpm_bins, map->x_bins, sizeof(dst->rpm_bins));
+    memcpy(dst->load_bins, map->y_bins, sizeof(dst->load_bins));
+    memcpy(dst->values, map->values, sizeof(dst->values));
+    dst->checksum = map->checksum;
+}
+
+// Caller holds g_map_mutex, or runs before the engine tasks are started
+static void eoit_map_config_apply(const eoit_map_config_blob_t *cfg) {
+    if (!cfg) {
+        return;
     }
-    uint32_t total_positions = cfg->tooth_count + 2U;
-    return ((float)sync->tooth_period * (float)total_positions) / 360.0f;
+    map_set_t *set = map_set_begin_update();
+    eoit_normal_map_t *map = &set->eoit_map;
+    set->eoit_enabled = (cfg->enabled != 0U);
+    memcpy(map->x_bins, cfg->normal_map.rpm_bins, sizeof(map->x_bins));
+    memcpy(map->y_bins, cfg->normal_map.load_bins, sizeof(map->y_bins));
+    memcpy(map->values, cfg->normal_map.values, sizeof(map->values));
+    map->checksum = cfg->normal_map.checksum;
+    eoit_normal_map_touch(map);
+    map_set_publish(set);
 }
 
 static uint32_t angle_delta_to_delay_us(float delta_deg, float cycle_deg, float us_per_deg) {
@@ -331,6 +432,18 @@ static uint32_t closed_loop_config_crc(const closed_loop_config_blob_t *cfg) {
     return esp_rom_crc32_le(0, (const uint8_t *)&cfg->enabled, (uint32_t)sizeof(cfg->enabled) + sizeof(cfg->reserved));
 }
 
+static uint32_t engine_layout_config_crc(const engine_layout_config_blob_t *cfg) {
+    return esp_rom_crc32_le(0, (const uint8_t *)&cfg->layout, (uint32_t)sizeof(cfg->layout));
+}
+
+static esp_err_t engine_layout_config_save(const engine_layout_t *layout) {
+    engine_layout_config_blob_t cfg = {0};
+    cfg.version = ENGINE_LAYOUT_CONFIG_VERSION;
+    cfg.layout = *layout;
+    cfg.crc32 = engine_layout_config_crc(&cfg);
+    return config_manager_save(ENGINE_LAYOUT_CONFIG_KEY, &cfg, sizeof(cfg));
+}
+
 static void closed_loop_config_defaults(closed_loop_config_blob_t *cfg) {
     if (!cfg) {
         return;
@@ -343,34 +456,39 @@ static void closed_loop_config_defaults(closed_loop_config_blob_t *cfg) {
     cfg->crc32 = closed_loop_config_crc(cfg);
 }
 
-static uint8_t find_bin_index(const uint16_t *bins, uint16_t value) {
-    for (uint8_t i = 0; i < 15; i++) {
-        if (value < bins[i + 1]) {
-            return i;
-        }
-    }
-    return 14;
+// Planner side only. False if the monitor task has not caught up yet.
+static bool ltft_post_update(uint16_t rpm, uint16_t load, float ltft) {
+    ltft_update_t update = {.rpm = rpm, .load = load, .ltft = ltft};
+    return spsc_ring_push(&g_ltft_ring, &update);
 }
 
-static void apply_ltft_to_fuel_table(uint16_t rpm, uint16_t load) {
-    if (g_map_mutex == NULL) {
+static void apply_ltft_to_fuel_table(map_set_t *set, const ltft_update_t *update) {
+    fuel_ve_map_t *table = &set->maps.fuel_table;
+    uint8_t x = table_axis_index(table->x_bins, VE_TABLE_RPM_BINS, NULL, update->rpm);
+    uint8_t y = table_axis_index(table->y_bins, VE_TABLE_LOAD_BINS, NULL, update->load);
+
+    float current = (float)table->values[y][x];
+    float updated = current * (1.0f + update->ltft);
+    if (updated < 0.0f) updated = 0.0f;
+    if (updated > 65535.0f) updated = 65535.0f;
+    // Delta checksum and a new VE generation; the other maps' caches stay warm
+    fuel_ve_map_set_cell(table, x, y, (uint16_t)(updated + 0.5f));
+}
+
+// Monitor task: applies every pending LTFT correction in one map update
+static void apply_pending_ltft(void) {
+    if (g_map_mutex == NULL || spsc_ring_depth(&g_ltft_ring) == 0U) {
         return;
     }
     if (xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
         return;
     }
-
-    table_16x16_t *table = &g_maps.fuel_table;
-    uint8_t x = find_bin_index(table->rpm_bins, rpm);
-    uint8_t y = find_bin_index(table->load_bins, load);
-
-    float current = (float)table->values[y][x];
-    float updated = current * (1.0f + g_ltft);
-    if (updated < 0.0f) updated = 0.0f;
-    if (updated > 65535.0f) updated = 65535.0f;
-    table->values[y][x] = (uint16_t)(updated + 0.5f);
-    table->checksum = table_16x16_checksum(table);
-    fuel_calc_reset_interpolation_cache();
+    map_set_t *set = map_set_begin_update();
+    ltft_update_t update;
+    while (spsc_ring_pop(&g_ltft_ring, &update)) {
+        apply_ltft_to_fuel_table(set, &update);
+    }
+    map_set_publish(set);
     g_map_dirty = true;
     g_map_version++;
     xSemaphoreGive(g_map_mutex);
@@ -383,29 +501,44 @@ static void maybe_persist_maps(uint32_t now_ms) {
 
     fuel_calc_maps_t maps_snapshot = {0};
     uint32_t version_snapshot = 0;
-    bool should_save = false;
+    uint32_t trims_version_snapshot = 0;
+    bool save_maps = false;
+    bool save_trims = false;
 
+    // Writers hold the mutex, so the published set is stable while it is held.
+    // The planner is not involved: the NVS writes below never delay it.
     if (xSemaphoreTake(g_map_mutex, portMAX_DELAY) == pdTRUE) {
-        if (g_map_dirty && (now_ms - g_last_map_save_ms) >= MAP_SAVE_INTERVAL_MS) {
-            maps_snapshot = g_maps;
-            version_snapshot = g_map_version;
-            should_save = true;
+        if ((now_ms - g_last_map_save_ms) >= MAP_SAVE_INTERVAL_MS) {
+            const map_set_t *set = &g_map_sets[__atomic_load_n(&g_map_active, __ATOMIC_ACQUIRE)];
+            if (g_map_dirty) {
+                maps_snapshot = set->maps;
+                version_snapshot = g_map_version;
+                save_maps = true;
+            }
+            if (g_trims_dirty) {
+                g_trims_snapshot = set->trims;
+                trims_version_snapshot = g_trims_version;
+                save_trims = true;
+            }
         }
         xSemaphoreGive(g_map_mutex);
     }
 
-    if (!should_save) {
+    if (!save_maps && !save_trims) {
         return;
     }
 
-    if (map_storage_save(&maps_snapshot) == ESP_OK) {
-        if (xSemaphoreTake(g_map_mutex, portMAX_DELAY) == pdTRUE) {
-            if (g_map_version == version_snapshot) {
-                g_map_dirty = false;
-            }
-            g_last_map_save_ms = now_ms;
-            xSemaphoreGive(g_map_mutex);
+    bool maps_saved = save_maps && map_storage_save(&maps_snapshot) == ESP_OK;
+    bool trims_saved = save_trims && map_storage_save_trims(&g_trims_snapshot) == ESP_OK;
+    if (xSemaphoreTake(g_map_mutex, portMAX_DELAY) == pdTRUE) {
+        if (maps_saved && g_map_version == version_snapshot) {
+            g_map_dirty = false;
         }
+        if (trims_saved && g_trims_version == trims_version_snapshot) {
+            g_trims_dirty = false;
+        }
+        g_last_map_save_ms = now_ms;
+        xSemaphoreGive(g_map_mutex);
     }
 }
 
@@ -427,118 +560,66 @@ static bool ltft_can_update(uint16_t rpm, uint16_t load, uint32_t now_ms) {
     return false;
 }
 
-static uint32_t perf_percentile(const uint32_t *arr, uint16_t n, uint8_t pct) {
-    if (!arr || n == 0) {
-        return 0;
+static void perf_update_max(uint32_t *max, uint32_t value) {
+    uint32_t cur = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (value > cur &&
+           !__atomic_compare_exchange_n(max, &cur, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
     }
-
-    uint32_t copy[PERF_WINDOW] = {0};
-    if (n > PERF_WINDOW) {
-        n = PERF_WINDOW;
-    }
-    memcpy(copy, arr, sizeof(uint32_t) * n);
-
-    for (uint16_t i = 0; i < n; i++) {
-        for (uint16_t j = i + 1; j < n; j++) {
-            if (copy[j] < copy[i]) {
-                uint32_t t = copy[i];
-                copy[i] = copy[j];
-                copy[j] = t;
-            }
-        }
-    }
-
-    uint16_t idx = (uint16_t)(((uint32_t)(n - 1) * pct) / 100U);
-    return copy[idx];
 }
 
-static uint8_t plan_ring_depth(void) {
-    uint8_t head = g_plan_ring.head;
-    uint8_t tail = g_plan_ring.tail;
-    if (head >= tail) {
-        return (uint8_t)(head - tail);
-    }
-    return (uint8_t)(PLAN_RING_SIZE - tail + head);
+static void plan_ring_init(void) {
+    spsc_ring_init(&g_plan_ring, PLAN_RING_MAILBOX ? SPSC_RING_MAILBOX : SPSC_RING_QUEUE,
+                   g_plan_slots, sizeof(g_plan_slots[0]),
+                   (uint32_t)(sizeof(g_plan_slots) / sizeof(g_plan_slots[0])));
+    spsc_ring_init(&g_ltft_ring, SPSC_RING_QUEUE, g_ltft_slots, sizeof(g_ltft_slots[0]), LTFT_RING_SIZE);
 }
 
+// Planner side only
 static void plan_ring_push(const engine_plan_cmd_t *cmd) {
     if (!cmd) {
         return;
     }
-
-    portENTER_CRITICAL(&g_plan_ring.mux);
-    uint8_t head = g_plan_ring.head;
-    uint8_t next = (uint8_t)((head + 1U) % PLAN_RING_SIZE);
-    bool overrun = false;
-    if (next == g_plan_ring.tail) {
-        g_plan_ring.tail = (uint8_t)((g_plan_ring.tail + 1U) % PLAN_RING_SIZE);
-        g_plan_ring.overruns++;
-        overrun = true;
-    }
-    g_plan_ring.items[head] = *cmd;
-    g_plan_ring.head = next;
-    uint8_t depth = plan_ring_depth();
-    portEXIT_CRITICAL(&g_plan_ring.mux);
-
-    portENTER_CRITICAL(&g_perf_spinlock);
-    if (overrun) {
-        g_perf_stats.queue_overruns = g_plan_ring.overruns;
-    }
-    if (depth > g_perf_stats.queue_depth_peak) {
-        g_perf_stats.queue_depth_peak = depth;
-    }
-    portEXIT_CRITICAL(&g_perf_spinlock);
+    spsc_ring_push(&g_plan_ring, cmd);
+    perf_update_max(&g_perf_stats.queue_depth_peak, spsc_ring_depth(&g_plan_ring));
 }
 
+// Executor side only
 static bool plan_ring_pop_latest(engine_plan_cmd_t *cmd) {
     if (!cmd) {
         return false;
     }
-
-    bool ok = false;
-    portENTER_CRITICAL(&g_plan_ring.mux);
-    if (g_plan_ring.tail != g_plan_ring.head) {
-        uint8_t latest_idx = (g_plan_ring.head == 0U) ? (PLAN_RING_SIZE - 1U) : (uint8_t)(g_plan_ring.head - 1U);
-        *cmd = g_plan_ring.items[latest_idx];
-        g_plan_ring.tail = g_plan_ring.head;
-        ok = true;
-    }
-    portEXIT_CRITICAL(&g_plan_ring.mux);
-    return ok;
+    return spsc_ring_pop_latest(&g_plan_ring, cmd);
 }
 
-static void perf_record_planner(uint32_t elapsed_us) {
-    portENTER_CRITICAL(&g_perf_spinlock);
-    g_perf_stats.planner_last_us = elapsed_us;
-    if (elapsed_us > g_perf_stats.planner_max_us) {
-        g_perf_stats.planner_max_us = elapsed_us;
-    }
+static void perf_record_planner(uint32_t elapsed_cycles) {
+    uint32_t elapsed_us = hp_cycles_to_us_u32(elapsed_cycles);
+    latency_hist_record(&g_perf_hist[ENGINE_PERF_PLANNER], elapsed_cycles);
+    __atomic_store_n(&g_perf_stats.planner_last_us, elapsed_us, __ATOMIC_RELAXED);
+    perf_update_max(&g_perf_stats.planner_max_us, elapsed_us);
     if (elapsed_us > PLANNER_DEADLINE_US) {
-        g_perf_stats.planner_deadline_miss++;
+        __atomic_fetch_add(&g_perf_stats.planner_deadline_miss, 1U, __ATOMIC_RELAXED);
     }
-
-    uint16_t idx = g_perf_stats.sample_idx % PERF_WINDOW;
-    g_perf_stats.planner_samples[idx] = elapsed_us;
-    portEXIT_CRITICAL(&g_perf_spinlock);
 }
 
-static void perf_record_executor(uint32_t elapsed_us, uint32_t queue_age_us) {
-    portENTER_CRITICAL(&g_perf_spinlock);
-    g_perf_stats.executor_last_us = elapsed_us;
-    if (elapsed_us > g_perf_stats.executor_max_us) {
-        g_perf_stats.executor_max_us = elapsed_us;
-    }
+// Stale plans are dropped without running: they count as misses only
+static void perf_record_executor(uint32_t elapsed_cycles, uint32_t queue_age_us, bool executed) {
     if (queue_age_us > PLANNER_DEADLINE_US) {
-        g_perf_stats.executor_deadline_miss++;
+        __atomic_fetch_add(&g_perf_stats.executor_deadline_miss, 1U, __ATOMIC_RELAXED);
     }
-
-    uint16_t idx = g_perf_stats.sample_idx % PERF_WINDOW;
-    g_perf_stats.executor_samples[idx] = elapsed_us;
-    g_perf_stats.sample_idx = (uint16_t)((g_perf_stats.sample_idx + 1U) % PERF_WINDOW);
-    if (g_perf_stats.sample_count < PERF_WINDOW) {
-        g_perf_stats.sample_count++;
+    if (!executed) {
+        return;
     }
-    portEXIT_CRITICAL(&g_perf_spinlock);
+    uint32_t elapsed_us = hp_cycles_to_us_u32(elapsed_cycles);
+    latency_hist_record(&g_perf_hist[ENGINE_PERF_EXECUTOR], elapsed_cycles);
+    __atomic_store_n(&g_perf_stats.executor_last_us, elapsed_us, __ATOMIC_RELAXED);
+    perf_update_max(&g_perf_stats.executor_max_us, elapsed_us);
+}
+
+// Records the cycles since @p since for @p stage and returns the new mark
+static inline uint32_t perf_stage_mark(engine_perf_stage_t stage, uint32_t since) {
+    uint32_t now = hp_get_cycle_count();
+    latency_hist_record(&g_perf_hist[stage], now - since);
+    return now;
 }
 
 static void runtime_state_publish(const engine_plan_cmd_t *cmd) {
@@ -604,75 +685,60 @@ IRAM_ATTR static void engine_sync_tooth_callback(void *ctx) {
     if (g_planner_task_handle == NULL) {
         return;
     }
+    // Armed events on their last teeth are rewritten here, before any task runs
+    angle_scheduler_on_tooth();
     BaseType_t hp_woken = pdFALSE;
+    __atomic_store_n(&g_perf_stats.planner_notified_at, hp_get_cycle_count(), __ATOMIC_RELAXED);
     vTaskNotifyGiveFromISR(g_planner_task_handle, &hp_woken);
     if (hp_woken == pdTRUE) {
         portYIELD_FROM_ISR();
     }
 }
 
-static void schedule_semi_seq_injection(uint16_t rpm,
-                                        uint16_t load,
-                                        uint32_t pw_us,
-                                        const sync_data_t *sync,
-                                        float eoi_base_deg) {
-    (void)rpm;
-    (void)load;
-    sync_config_t sync_cfg = {0};
-    if (sync_get_config(&sync_cfg) != ESP_OK || sync_cfg.tooth_count == 0) {
-        return;
-    }
-
-    float current_angle = compute_current_angle_360(sync, sync_cfg.tooth_count);
-    float us_per_deg = sync_us_per_degree(sync, &sync_cfg);
+// Without cam sync the 720 degree position is unknown: every event is placed
+// at its cylinder's TDC modulo one revolution, so cylinders 360 degrees
+// apart share a slot (1 & 4 at 0 deg, 2 & 3 at 180 deg on an inline 4)
+static void schedule_semi_seq_injection(const uint32_t pw_us[ENGINE_MAX_CYLINDERS],
+                                        const injector_comp_t *injector,
+                                        const sync_snapshot_t *sync,
+                                        float eoi_base_deg,
+                                        engine_injection_diag_t *diag) {
+    float current_angle = sync_tooth_angle_deg(sync);
+    float us_per_deg = sync_us_per_degree(sync);
     if (us_per_deg <= 0.0f) {
         return;
     }
 
-    float pw_deg = pw_us / us_per_deg;
-    // Pair 1: cylinders 1 & 4 at 0°
-    float eoi0 = wrap_angle_360(eoi_base_deg);
-    float soi0 = wrap_angle_360(eoi0 - pw_deg);
-    float delta0 = soi0 - current_angle;
-    uint32_t delay0 = angle_delta_to_delay_us(delta0, 360.0f, us_per_deg);
-    uint32_t counter = mcpwm_injection_hp_get_counter(0);
-    mcpwm_injection_hp_schedule_one_shot_absolute(0, delay0, pw_us, counter);
-    mcpwm_injection_hp_schedule_one_shot_absolute(3, delay0, pw_us, counter);
-
-    // Pair 2: cylinders 2 & 3 at 180°
-    float eoi180 = wrap_angle_360(eoi_base_deg + 180.0f);
-    float soi180 = wrap_angle_360(eoi180 - pw_deg);
-    float delta180 = soi180 - current_angle;
-    uint32_t delay180 = angle_delta_to_delay_us(delta180, 360.0f, us_per_deg);
-    mcpwm_injection_hp_schedule_one_shot_absolute(1, delay180, pw_us, counter);
-    mcpwm_injection_hp_schedule_one_shot_absolute(2, delay180, pw_us, counter);
-}
-
-static void schedule_wasted_spark(uint16_t advance_deg10, uint16_t rpm, const sync_data_t *sync) {
-    sync_config_t sync_cfg = {0};
-    if (sync_get_config(&sync_cfg) != ESP_OK || sync_cfg.tooth_count == 0) {
-        return;
+    uint8_t cylinders = engine_layout_cylinders();
+    for (uint8_t i = 0; i < cylinders; i++) {
+        uint32_t pw = injector_model_pulse_us(injector, pw_us[i]);
+        float eoi = wrap_angle_360(eoi_base_deg + engine_layout_tdc_deg((uint8_t)(i + 1U)));
+        float soi = wrap_angle_360(eoi - (pw / us_per_deg));
+        uint32_t delay = angle_delta_to_delay_us(soi - current_angle, 360.0f, us_per_deg);
+        mcpwm_injection_hp_schedule_at(i, sync->capture_time_us + delay, pw);
+        if (diag) {
+            diag->soi_deg[i] = soi;
+            diag->delay_us[i] = delay;
+        }
     }
+}
 
-    float current_angle = compute_current_angle_360(sync, sync_cfg.tooth_count);
-    float us_per_deg = sync_us_per_degree(sync, &sync_cfg);
+// One spark per coil per revolution, timed on the coil's first cylinder
+static void schedule_wasted_spark(const uint16_t advance_deg10[ENGINE_MAX_CYLINDERS], uint16_t dwell_us,
+                                  const sync_snapshot_t *sync) {
+    float current_angle = sync_tooth_angle_deg(sync);
+    float us_per_deg = sync_us_per_degree(sync);
     if (us_per_deg <= 0.0f) {
         return;
     }
 
-    float advance_deg = advance_deg10 / 10.0f;
-    float spark0 = wrap_angle_360(0.0f - advance_deg);
-    float delta0 = spark0 - current_angle;
-    uint32_t delay0 = angle_delta_to_delay_us(delta0, 360.0f, us_per_deg);
-    uint32_t counter = mcpwm_ignition_hp_get_counter(0);
-    mcpwm_ignition_hp_schedule_one_shot_absolute(1, delay0, rpm, 13.5f, counter);
-    mcpwm_ignition_hp_schedule_one_shot_absolute(4, delay0, rpm, 13.5f, counter);
-
-    float spark180 = wrap_angle_360(180.0f - advance_deg);
-    float delta180 = spark180 - current_angle;
-    uint32_t delay180 = angle_delta_to_delay_us(delta180, 360.0f, us_per_deg);
-    mcpwm_ignition_hp_schedule_one_shot_absolute(2, delay180, rpm, 13.5f, counter);
-    mcpwm_ignition_hp_schedule_one_shot_absolute(3, delay180, rpm, 13.5f, counter);
+    uint8_t coils = engine_layout_coils();
+    for (uint8_t coil = 1; coil <= coils; coil++) {
+        uint8_t cyl = engine_layout_coil_cylinder(coil);
+        float spark = wrap_angle_360(engine_layout_tdc_deg(cyl) - (advance_deg10[cyl - 1U] / 10.0f));
+        uint32_t delay = angle_delta_to_delay_us(spark - current_angle, 360.0f, us_per_deg);
+        mcpwm_ignition_hp_schedule_at(coil, sync->capture_time_us + delay, dwell_us);
+    }
 }
 
 static esp_err_t engine_control_build_plan(engine_plan_cmd_t *cmd) {
@@ -680,10 +746,12 @@ static esp_err_t engine_control_build_plan(engine_plan_cmd_t *cmd) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    sync_data_t sync_data = {0};
-    if (sync_get_data(&sync_data) != ESP_OK || !sync_data.sync_valid) {
+    uint32_t mark = hp_get_cycle_count();
+    sync_snapshot_t sync = {0};
+    if (sync_get_snapshot(&sync) != ESP_OK || !sync_snapshot_valid(&sync)) {
         return ESP_FAIL;
     }
+    mark = perf_stage_mark(ENGINE_PERF_SYNC_READ, mark);
 
     sensor_data_t sensor_data = {0};
     uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
@@ -703,8 +771,9 @@ static esp_err_t engine_control_build_plan(engine_plan_cmd_t *cmd) {
         g_last_sensor_valid = true;
         g_last_sensor_timestamp_ms = now_ms;
     }
+    perf_stage_mark(ENGINE_PERF_SENSOR_READ, mark);
 
-    uint16_t rpm = (uint16_t)sync_data.rpm;
+    uint16_t rpm = (uint16_t)sync.rpm;
     uint16_t load = sensor_data.map_kpa10;
     if (safety_check_over_rev(rpm) ||
         safety_check_overheat(sensor_data.clt_c) ||
@@ -712,21 +781,36 @@ static esp_err_t engine_control_build_plan(engine_plan_cmd_t *cmd) {
         return ESP_FAIL;
     }
 
-    if (g_map_mutex == NULL || xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
-        return ESP_FAIL;
-    }
-    uint16_t ve_x10 = fuel_calc_lookup_ve(&g_maps, rpm, load);
-    uint16_t advance_deg10 = fuel_calc_lookup_ignition(&g_maps, rpm, load);
-    uint16_t lambda_target_raw = fuel_calc_lookup_lambda(&g_maps, rpm, load);
+    mark = hp_get_cycle_count();
+    uint32_t map_idx;
+    const map_set_t *set = map_set_acquire(&map_idx);
+    fuel_calc_lookup_t lookup;
+    table_view_t eoit_view = eoit_normal_map_view(&set->eoit_map);
+    fuel_calc_lookup_all(&set->maps, set->eoit_enabled ? &eoit_view : NULL, rpm, load, &lookup);
+    uint8_t cylinders = engine_layout_cylinders();
+    cyl_trim_t trim;
+    cyl_trim_lookup(&set->trims, rpm, load, cylinders, &trim);
+    split_injection_lookup(&set->split, rpm, load, &cmd->split);
+    injector_model_prepare(&set->injector, sensor_data.vbat_dv, &cmd->injector);
+    // Coils fire every revolution with wasted spark and on the partial sync fallback
+    uint32_t rev_us = (rpm > 0U) ? (60000000U / rpm) : 0U;
+    bool spark_per_rev = engine_layout_get()->wasted_spark || !sync_snapshot_acquired(&sync);
+    dwell_control_prepare(&set->dwell, sensor_data.vbat_dv, sensor_data.clt_c, rpm,
+                          spark_per_rev ? rev_us : 2U * rev_us, &cmd->dwell);
+    bool eoit_enabled = set->eoit_enabled;
+    map_set_release(map_idx);
+    perf_stage_mark(ENGINE_PERF_TABLE_LOOKUP, mark);
+    uint16_t ve_x10 = lookup.ve_x10;
+    uint16_t advance_deg10 = lookup.advance_deg10;
+    uint16_t lambda_target_raw = lookup.lambda_target;
     float eoit_normal_used = g_eoit_normal;
-    if (g_eoit_map_enabled) {
-        uint16_t normal_raw = table_16x16_interpolate(&g_eoit_normal_map, rpm, load);
-        eoit_normal_used = clamp_eoit_normal(eoit_normal_from_table(normal_raw));
+    if (eoit_enabled) {
+        eoit_normal_used = clamp_eoit_normal(eoit_normal_from_table(lookup.eoit_normal_raw));
     }
-    xSemaphoreGive(g_map_mutex);
 
     float lambda_corr = 0.0f;
     if (g_engine_math_ready && g_closed_loop_enabled) {
+        mark = hp_get_cycle_count();
         float lambda_target = lambda_target_raw / 1000.0f;
         float lambda_measured = 1.0f;
         bool lambda_valid = false;
@@ -746,37 +830,54 @@ static esp_err_t engine_control_build_plan(engine_plan_cmd_t *cmd) {
             if (ltft_can_update(rpm, load, now_ms)) {
                 g_ltft += LTFT_ALPHA * (g_stft - g_ltft);
                 g_ltft = clamp_float(g_ltft, -LTFT_LIMIT, LTFT_LIMIT);
-                if (fabsf(g_ltft) >= LTFT_APPLY_THRESHOLD) {
-                    apply_ltft_to_fuel_table(rpm, load);
+                // A full ring keeps the trim and retries on a later pass
+                if (fabsf(g_ltft) >= LTFT_APPLY_THRESHOLD && ltft_post_update(rpm, load, g_ltft)) {
                     g_ltft = 0.0f;
                 }
             }
             lambda_corr = clamp_float(g_stft + g_ltft, -STFT_LIMIT, STFT_LIMIT);
         }
+        perf_stage_mark(ENGINE_PERF_LAMBDA_PID, mark);
     }
 
     cmd->rpm = rpm;
     cmd->load = load;
     cmd->advance_deg10 = advance_deg10;
     cmd->pw_us = fuel_calc_pulsewidth_us(&sensor_data, rpm, ve_x10, lambda_corr);
+    cyl_trim_apply(&trim, cylinders, cmd->pw_us, advance_deg10, cmd->pw_us_cyl, cmd->advance_deg10_cyl);
     cmd->eoit_normal_used = eoit_normal_used;
     cmd->eoi_target_deg = eoit_target_from_calibration(g_eoit_boundary, eoit_normal_used);
     cmd->eoi_fallback_deg = eoit_target_from_calibration(g_eoit_boundary, g_eoit_fallback_normal);
-    cmd->sync_data = sync_data;
     cmd->planned_at_us = (uint32_t)esp_timer_get_time();
     return ESP_OK;
 }
 
-static void engine_control_execute_plan(const engine_plan_cmd_t *cmd) {
-    if (!cmd) {
+// The MCPWM timers never stop: whatever was armed last stays in the
+// comparators. Without a valid sync (lost, or no tooth since the stall
+// timeout) every output is forced low and the pending events dropped.
+static void park_outputs(void) {
+    if (g_outputs_parked) {
         return;
     }
+    angle_scheduler_reset();
+    mcpwm_injection_hp_stop_all();
+    mcpwm_ignition_hp_stop_all();
+    g_outputs_parked = true;
+    LOG_SAFETY_W("Sync lost or engine stopped: outputs parked");
+}
+
+static bool engine_control_execute_plan(const engine_plan_cmd_t *cmd) {
+    if (!cmd) {
+        return false;
+    }
 
-    sync_data_t exec_sync = cmd->sync_data;
-    sync_data_t live_sync = {0};
-    if (sync_get_data(&live_sync) == ESP_OK && live_sync.sync_valid) {
-        exec_sync = live_sync;
+    // Sync lost since the plan was built: nothing to schedule from
+    sync_snapshot_t exec_sync = {0};
+    if (sync_get_snapshot(&exec_sync) != ESP_OK || !sync_snapshot_valid(&exec_sync)) {
+        park_outputs();
+        return false;
     }
+    g_outputs_parked = false;
     engine_injection_diag_t diag = {0};
     diag.rpm = cmd->rpm;
     diag.load = cmd->load;
@@ -785,59 +886,47 @@ static void engine_control_execute_plan(const engine_plan_cmd_t *cmd) {
     diag.eoit_target_deg = cmd->eoi_target_deg;
     diag.eoit_fallback_target_deg = cmd->eoi_fallback_deg;
     diag.pulsewidth_us = cmd->pw_us;
-    diag.sync_acquired = exec_sync.sync_acquired;
-    diag.map_mode_enabled = g_eoit_map_enabled;
-
-    if (exec_sync.sync_acquired) {
-        bool scheduling_ok = true;
-        for (uint8_t cyl = 1; cyl <= 4; cyl++) {
-            fuel_injection_schedule_info_t info = {0};
-            bool inj_ok = fuel_injection_schedule_eoi_ex(cyl, cmd->eoi_target_deg, cmd->pw_us, &exec_sync, &info);
-            scheduling_ok = scheduling_ok && inj_ok;
-            diag.soi_deg[cyl - 1] = info.soi_deg;
-            diag.delay_us[cyl - 1] = info.delay_us;
+    diag.split_first_pct = split_injection_ratio_from_raw(cmd->split.first_x1000);
+    diag.vbat_dv = cmd->injector.vbat_dv;
+    diag.dead_time_us = cmd->injector.dead_time_us;
+    diag.dwell_us = cmd->dwell.dwell_us;
+    diag.dwell_limited = cmd->dwell.duty_limited;
+    memcpy(diag.pulsewidth_cyl_us, cmd->pw_us_cyl, sizeof(diag.pulsewidth_cyl_us));
+    diag.sync_acquired = sync_snapshot_acquired(&exec_sync);
+    diag.map_mode_enabled = engine_control_get_eoit_map_enabled();
+
+    uint32_t mark = hp_get_cycle_count();
+    if (sync_snapshot_acquired(&exec_sync)) {
+        uint8_t cylinders = engine_layout_cylinders();
+        float eoi[ENGINE_MAX_CYLINDERS];
+        fuel_injection_schedule_info_t info[ENGINE_MAX_CYLINDERS] = {0};
+        for (uint8_t i = 0; i < cylinders; i++) {
+            eoi[i] = cmd->eoi_target_deg;
+        }
+        bool scheduling_ok = fuel_injection_schedule_sequential(cmd->pw_us_cyl, eoi, &cmd->split, &cmd->injector,
+                                                                &exec_sync, info);
+        for (uint8_t i = 0; i < cylinders; i++) {
+            diag.soi_deg[i] = info[i].soi_deg;
+            diag.delay_us[i] = info[i].delay_us;
+            diag.pulses[i] = info[i].pulses;
         }
-        ignition_apply_timing(cmd->advance_deg10, cmd->rpm);
+        ignition_schedule_angle_cyl(cmd->advance_deg10_cyl, cmd->dwell.dwell_us, &exec_sync);
         if (!scheduling_ok) {
             LOG_SAFETY_E("Injection scheduling failure on synced path");
             safety_activate_limp_mode();
         }
     } else {
         LOG_SAFETY_W("Sync partial: fallback to semi-sequential + wasted spark");
-        schedule_semi_seq_injection(cmd->rpm, cmd->load, cmd->pw_us, &exec_sync, cmd->eoi_fallback_deg);
-        schedule_wasted_spark(cmd->advance_deg10, cmd->rpm, &exec_sync);
-
-        sync_config_t sync_cfg = {0};
-        if (sync_get_config(&sync_cfg) == ESP_OK && sync_cfg.tooth_count > 0) {
-            float current_angle = compute_current_angle_360(&exec_sync, sync_cfg.tooth_count);
-            float us_per_deg = sync_us_per_degree(&exec_sync, &sync_cfg);
-            if (us_per_deg > 0.0f) {
-                float pw_deg = cmd->pw_us / us_per_deg;
-
-                float eoi0 = wrap_angle_360(cmd->eoi_fallback_deg);
-                float soi0 = wrap_angle_360(eoi0 - pw_deg);
-                float d0 = soi0 - current_angle;
-                uint32_t delay0 = angle_delta_to_delay_us(d0, 360.0f, us_per_deg);
-                diag.soi_deg[0] = soi0;
-                diag.soi_deg[3] = soi0;
-                diag.delay_us[0] = delay0;
-                diag.delay_us[3] = delay0;
-
-                float eoi180 = wrap_angle_360(cmd->eoi_fallback_deg + 180.0f);
-                float soi180 = wrap_angle_360(eoi180 - pw_deg);
-                float d180 = soi180 - current_angle;
-                uint32_t delay180 = angle_delta_to_delay_us(d180, 360.0f, us_per_deg);
-                diag.soi_deg[1] = soi180;
-                diag.soi_deg[2] = soi180;
-                diag.delay_us[1] = delay180;
-                diag.delay_us[2] = delay180;
-            }
-        }
+        angle_scheduler_reset();
+        schedule_semi_seq_injection(cmd->pw_us_cyl, &cmd->injector, &exec_sync, cmd->eoi_fallback_deg, &diag);
+        schedule_wasted_spark(cmd->advance_deg10_cyl, cmd->dwell.dwell_us, &exec_sync);
     }
+    perf_stage_mark(ENGINE_PERF_SCHEDULING, mark);
     diag.updated_at_us = (uint32_t)esp_timer_get_time();
     injection_diag_publish(&diag);
     runtime_state_publish(cmd);
     safety_watchdog_feed();
+    return true;
 }
 
 static void engine_planner_task(void *arg) {
@@ -847,18 +936,20 @@ static void engine_planner_task(void *arg) {
         if (notified == 0) {
             continue;
         }
-        uint32_t t0 = (uint32_t)esp_timer_get_time();
+        // Notifications coalesce: the wake is timed from the latest tooth
+        uint32_t t0 = perf_stage_mark(ENGINE_PERF_PLANNER_WAKE,
+                                      __atomic_load_n(&g_perf_stats.planner_notified_at, __ATOMIC_RELAXED));
 
         engine_plan_cmd_t cmd = {0};
         if (engine_control_build_plan(&cmd) == ESP_OK) {
             plan_ring_push(&cmd);
             if (g_executor_task_handle != NULL) {
+                __atomic_store_n(&g_perf_stats.executor_notified_at, hp_get_cycle_count(), __ATOMIC_RELAXED);
                 xTaskNotifyGive(g_executor_task_handle);
             }
         }
 
-        uint32_t elapsed = (uint32_t)esp_timer_get_time() - t0;
-        perf_record_planner(elapsed);
+        perf_record_planner(hp_get_cycle_count() - t0);
     }
 }
 
@@ -867,32 +958,71 @@ static void engine_executor_task(void *arg) {
     while (1) {
         uint32_t notified = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
         if (notified == 0) {
+            // No plan since the last tooth: park once the engine has stopped
+            sync_snapshot_t sync = {0};
+            if (!g_outputs_parked &&
+                (sync_get_snapshot(&sync) != ESP_OK || !sync_snapshot_valid(&sync))) {
+                park_outputs();
+            }
             continue;
         }
+        perf_stage_mark(ENGINE_PERF_EXECUTOR_WAKE,
+                        __atomic_load_n(&g_perf_stats.executor_notified_at, __ATOMIC_RELAXED));
         engine_plan_cmd_t cmd = {0};
         while (plan_ring_pop_latest(&cmd)) {
-            uint32_t t0 = (uint32_t)esp_timer_get_time();
-            uint32_t queue_age = t0 - cmd.planned_at_us;
+            uint32_t queue_age = (uint32_t)esp_timer_get_time() - cmd.planned_at_us;
             if (queue_age > EXECUTOR_MAX_PLAN_AGE_US) {
-                perf_record_executor(0U, queue_age);
+                perf_record_executor(0U, queue_age, false);
                 continue;
             }
-            engine_control_execute_plan(&cmd);
-            uint32_t elapsed = (uint32_t)esp_timer_get_time() - t0;
-            perf_record_executor(elapsed, queue_age);
+            uint32_t t0 = hp_get_cycle_count();
+            bool executed = engine_control_execute_plan(&cmd);
+            perf_record_executor(hp_get_cycle_count() - t0, queue_age, executed);
         }
     }
 }
 
+static void send_perf_stats(uint32_t now_ms) {
+    espnow_perf_stats_t msg = {0};
+    msg.timestamp_ms = now_ms;
+    msg.planner_deadline_miss = __atomic_load_n(&g_perf_stats.planner_deadline_miss, __ATOMIC_RELAXED);
+    msg.executor_deadline_miss = __atomic_load_n(&g_perf_stats.executor_deadline_miss, __ATOMIC_RELAXED);
+    for (uint32_t i = 0; i < ENGINE_PERF_STAGE_COUNT && i < ESPNOW_PERF_STAGES; i++) {
+        latency_summary_t sum;
+        engine_control_get_perf_latency((engine_perf_stage_t)i, &sum);
+        msg.stages[i].count = sum.count;
+        msg.stages[i].p50_ns = sum.p50;
+        msg.stages[i].p95_ns = sum.p95;
+        msg.stages[i].p99_ns = sum.p99;
+        msg.stages[i].p999_ns = sum.p999;
+        msg.stages[i].max_ns = sum.max;
+    }
+    espnow_link_send_perf_stats(&msg);
+}
+
 static void engine_monitor_task(void *arg) {
     (void)arg;
     uint32_t last_espnow_status_ms = 0;
     uint32_t last_espnow_sensor_ms = 0;
     uint32_t last_espnow_diag_ms = 0;
+    uint32_t last_timebase_check_ms = 0;
+    uint32_t last_profile_ms = 0;
     
     while (1) {
         uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        apply_pending_ltft();
         maybe_persist_maps(now_ms);
+
+        // Confirm the MCPWM timers still sit where the timebase model puts them
+        if (now_ms - last_timebase_check_ms >= 1000U) {
+            last_timebase_check_ms = now_ms;
+            timebase_check();
+        }
+
+        if (now_ms - last_profile_ms >= TASK_PROFILER_INTERVAL_MS) {
+            last_profile_ms = now_ms;
+            (void)task_profiler_sample(now_ms, NULL);
+        }
         
         // Publish ESP-NOW messages if initialized
         if (espnow_link_is_started()) {
@@ -959,7 +1089,22 @@ static void engine_monitor_task(void *arg) {
                     diag.error_bitmap |= ESPNOW_ERR_LIMP_MODE;
                 }
                 
+                // Busier core, from the last task profile
+                espnow_task_profile_t profile;
+                bool profiled = (task_profiler_get_last(&profile) == ESP_OK);
+                if (profiled) {
+                    uint16_t load = profile.core_load_permille[0];
+                    if (profile.core_load_permille[1] > load) {
+                        load = profile.core_load_permille[1];
+                    }
+                    diag.cpu_usage_pct = (uint16_t)(load / 10U);
+                }
+                
                 espnow_link_send_diagnostic(&diag);
+                send_perf_stats(now_ms);
+                if (profiled) {
+                    espnow_link_send_task_profile(&profile);
+                }
             }
         }
         
@@ -1018,6 +1163,12 @@ static void engine_control_init_rollback(bool callback_registered,
     g_engine_initialized = false;
 }
 
+// MCPWM outputs and their readback, installed on the control core
+static esp_err_t output_drivers_init(void) {
+    fuel_injection_init();
+    return ignition_init() ? ESP_OK : ESP_FAIL;
+}
+
 // Initialize engine control system
 esp_err_t engine_control_init(void) {
     ESP_LOGI("ENGINE_CONTROL", "Initializing engine control system");
@@ -1056,19 +1207,42 @@ esp_err_t engine_control_init(void) {
         map_mutex_created_here = true;
     }
 
-    if (map_storage_load(&g_maps) != ESP_OK) {
-        fuel_calc_init_defaults(&g_maps);
-        map_storage_save(&g_maps);
+    // Tasks are not running yet, so the published set is written in place
+    map_set_t *set = &g_map_sets[__atomic_load_n(&g_map_active, __ATOMIC_ACQUIRE)];
+    if (map_storage_load(&set->maps) != ESP_OK) {
+        fuel_calc_init_defaults(&set->maps);
+        map_storage_save(&set->maps);
     } else {
         fuel_calc_reset_interpolation_cache();
     }
+    if (map_storage_load_trims(&set->trims) != ESP_OK) {
+        cyl_trim_init_defaults(&set->trims);
+        map_storage_save_trims(&set->trims);
+    }
+    if (map_storage_load_split(&set->split) != ESP_OK) {
+        split_injection_init_defaults(&set->split);
+        map_storage_save_split(&set->split);
+    }
+    if (map_storage_load_injector(&set->injector) != ESP_OK) {
+        injector_model_init_defaults(&set->injector);
+        map_storage_save_injector(&set->injector);
+    }
+    if (map_storage_load_dwell(&set->dwell) != ESP_OK) {
+        dwell_control_init_defaults(&set->dwell);
+        map_storage_save_dwell(&set->dwell);
+    }
     g_map_version = 0;
     g_map_dirty = false;
+    g_trims_version = 0;
+    g_trims_dirty = false;
     g_last_map_save_ms = 0;
     g_last_sensor_valid = false;
     memset(&g_runtime_state, 0, sizeof(g_runtime_state));
     __atomic_store_n(&g_runtime_seq, 0U, __ATOMIC_RELEASE);
     lambda_pid_init(&g_lambda_pid, 0.6f, 0.08f, 0.01f, -0.25f, 0.25f);
+    angle_scheduler_reset();
+    angle_scheduler_reset_stats();
+    g_outputs_parked = true;
     g_engine_math_ready = true;
 
     closed_loop_config_blob_t cl_cfg = {0};
@@ -1080,6 +1254,17 @@ esp_err_t engine_control_init(void) {
     }
     g_closed_loop_enabled = (cl_cfg.enabled != 0);
 
+    // Layout before the output drivers size their channels (ignition_init)
+    engine_layout_config_blob_t layout_cfg = {0};
+    if (config_manager_load(ENGINE_LAYOUT_CONFIG_KEY, &layout_cfg, sizeof(layout_cfg)) != ESP_OK ||
+        layout_cfg.version != ENGINE_LAYOUT_CONFIG_VERSION ||
+        layout_cfg.crc32 != engine_layout_config_crc(&layout_cfg) ||
+        engine_layout_apply(&layout_cfg.layout) != ESP_OK) {
+        engine_layout_config_save(engine_layout_get());
+    }
+    ESP_LOGI("ENGINE_CONTROL", "Engine layout: %u cylinders, %u coils",
+             engine_layout_cylinders(), engine_layout_coils());
+
     // Initialize sensor, sync, TWAI lambda, injection, and ignition subsystems
     err = sensor_init();
     if (err == ESP_OK) {
@@ -1099,7 +1284,8 @@ esp_err_t engine_control_init(void) {
                                      config_initialized_here);
         return err;
     }
-    err = sensor_start();
+    // Each driver is installed from the core its interrupt belongs on
+    err = core_plan_run_on_core(SENSOR_TASK_CORE, sensor_start);
     if (err == ESP_OK) {
         sensor_started_here = true;
     } else if (err != ESP_ERR_INVALID_STATE) {
@@ -1118,7 +1304,7 @@ esp_err_t engine_control_init(void) {
         return err;
     }
 
-    err = sync_init();
+    err = core_plan_run_on_core(CORE_PLAN_CONTROL_CORE, sync_init);
     if (err == ESP_OK) {
         sync_initialized_here = true;
     } else if (err != ESP_ERR_INVALID_STATE) {
@@ -1155,7 +1341,7 @@ esp_err_t engine_control_init(void) {
         return err;
     }
 
-    err = twai_lambda_init();
+    err = core_plan_run_on_core(CORE_PLAN_COMM_CORE, twai_lambda_init);
     if (err == ESP_OK) {
         twai_started_here = true;
     } else if (err != ESP_ERR_INVALID_STATE) {
@@ -1174,8 +1360,7 @@ esp_err_t engine_control_init(void) {
         return err;
     }
 
-    fuel_injection_init(NULL);
-    if (!ignition_init()) {
+    if (core_plan_run_on_core(CORE_PLAN_CONTROL_CORE, output_drivers_init) != ESP_OK) {
         ESP_LOGE("ENGINE_CONTROL", "Failed to initialize MCPWM ignition/injection");
         engine_control_init_rollback(callback_registered,
                                      monitor_task_created,
@@ -1193,8 +1378,9 @@ esp_err_t engine_control_init(void) {
     safety_monitor_init();
     safety_watchdog_init(1000);
 
-    // Initialize ESP-NOW link (optional - continues on failure)
-    err = espnow_link_init();
+    // Initialize ESP-NOW link (optional - continues on failure); the Wi-Fi
+    // interrupt stays off the control core
+    err = core_plan_run_on_core(CORE_PLAN_COMM_CORE, espnow_link_init);
     if (err == ESP_OK) {
         ESP_LOGI("ENGINE_CONTROL", "ESP-NOW link initialized");
         err = espnow_link_start();
@@ -1236,11 +1422,13 @@ esp_err_t engine_control_init(void) {
     }
     eoit_map_config_apply(&eoit_map_cfg);
 
+    // Both ends of the plan ring are the tasks created below (the LTFT ring
+    // runs from the planner to the monitor task)
+    if (g_executor_task_handle == NULL && g_planner_task_handle == NULL) {
+        plan_ring_init();
+    }
     if (g_executor_task_handle == NULL) {
-        BaseType_t task_ok = xTaskCreatePinnedToCore(engine_executor_task, "engine_exec",
-                                                     CONTROL_TASK_STACK, NULL, CONTROL_TASK_PRIORITY, &g_executor_task_handle,
-                                                     CONTROL_TASK_CORE);
-        if (task_ok != pdPASS) {
+        if (core_plan_create_task(CORE_TASK_ENGINE_EXEC, engine_executor_task, NULL, &g_executor_task_handle) != ESP_OK) {
             ESP_LOGE("ENGINE_CONTROL", "Failed to create executor task");
             engine_control_init_rollback(callback_registered,
                                          monitor_task_created,
@@ -1259,10 +1447,7 @@ esp_err_t engine_control_init(void) {
     }
 
     if (g_planner_task_handle == NULL) {
-        BaseType_t task_ok = xTaskCreatePinnedToCore(engine_planner_task, "engine_plan",
-                                                     CONTROL_TASK_STACK, NULL, CONTROL_TASK_PRIORITY, &g_planner_task_handle,
-                                                     CONTROL_TASK_CORE);
-        if (task_ok != pdPASS) {
+        if (core_plan_create_task(CORE_TASK_ENGINE_PLAN, engine_planner_task, NULL, &g_planner_task_handle) != ESP_OK) {
             ESP_LOGE("ENGINE_CONTROL", "Failed to create planner task");
             engine_control_init_rollback(callback_registered,
                                          monitor_task_created,
@@ -1280,10 +1465,7 @@ esp_err_t engine_control_init(void) {
         planner_task_created = true;
     }
     if (g_monitor_task_handle == NULL) {
-        BaseType_t task_ok = xTaskCreatePinnedToCore(engine_monitor_task, "engine_mon",
-                                                     MONITOR_TASK_STACK, NULL, MONITOR_TASK_PRIORITY, &g_monitor_task_handle,
-                                                     MONITOR_TASK_CORE);
-        if (task_ok != pdPASS) {
+        if (core_plan_create_task(CORE_TASK_ENGINE_MON, engine_monitor_task, NULL, &g_monitor_task_handle) != ESP_OK) {
             ESP_LOGE("ENGINE_CONTROL", "Failed to create monitor task");
             engine_control_init_rollback(callback_registered,
                                          monitor_task_created,
@@ -1353,8 +1535,11 @@ esp_err_t engine_control_deinit(void) {
     sync_stop();
     sync_deinit();
     twai_lambda_deinit();
+    output_capture_deinit();
     mcpwm_injection_hp_deinit();
     mcpwm_ignition_hp_deinit();
+    mcpwm_output_deinit();
+    timebase_deinit();
 
     config_manager_deinit();
     if (g_map_mutex != NULL) {
@@ -1460,7 +1645,7 @@ esp_err_t engine_control_set_eoit_map_enabled(bool enabled) {
     if (g_map_mutex == NULL || xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
         return ESP_FAIL;
     }
-    cfg.normal_map = g_eoit_normal_map;
+    eoit_map_to_blob(&g_map_sets[__atomic_load_n(&g_map_active, __ATOMIC_ACQUIRE)].eoit_map, &cfg.normal_map);
     xSemaphoreGive(g_map_mutex);
 
     cfg.crc32 = eoit_map_config_crc(&cfg);
@@ -1468,12 +1653,22 @@ esp_err_t engine_control_set_eoit_map_enabled(bool enabled) {
     if (err != ESP_OK) {
         return err;
     }
-    eoit_map_config_apply(&cfg);
+
+    if (xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    map_set_t *set = map_set_begin_update();
+    set->eoit_enabled = enabled;
+    map_set_publish(set);
+    xSemaphoreGive(g_map_mutex);
     return ESP_OK;
 }
 
 bool engine_control_get_eoit_map_enabled(void) {
-    return g_eoit_map_enabled;
+    uint32_t map_idx;
+    bool enabled = map_set_acquire(&map_idx)->eoit_enabled;
+    map_set_release(map_idx);
+    return enabled;
 }
 
 esp_err_t engine_control_set_eoit_map_cell(uint8_t rpm_idx, uint8_t load_idx, float normal) {
@@ -1483,7 +1678,6 @@ esp_err_t engine_control_set_eoit_map_cell(uint8_t rpm_idx, uint8_t load_idx, fl
 
     eoit_map_config_blob_t cfg = {0};
     cfg.version = EOIT_MAP_CONFIG_VERSION;
-    cfg.enabled = g_eoit_map_enabled ? 1U : 0U;
     cfg.reserved[0] = 0U;
     cfg.reserved[1] = 0U;
     cfg.reserved[2] = 0U;
@@ -1491,18 +1685,15 @@ esp_err_t engine_control_set_eoit_map_cell(uint8_t rpm_idx, uint8_t load_idx, fl
     if (g_map_mutex == NULL || xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
         return ESP_FAIL;
     }
-    g_eoit_normal_map.values[load_idx][rpm_idx] = eoit_normal_to_table(normal);
-    g_eoit_normal_map.checksum = table_16x16_checksum(&g_eoit_normal_map);
-    cfg.normal_map = g_eoit_normal_map;
+    map_set_t *set = map_set_begin_update();
+    eoit_normal_map_set_cell(&set->eoit_map, rpm_idx, load_idx, eoit_normal_to_table(normal));
+    map_set_publish(set);
+    cfg.enabled = set->eoit_enabled ? 1U : 0U;
+    eoit_map_to_blob(&set->eoit_map, &cfg.normal_map);
     xSemaphoreGive(g_map_mutex);
 
     cfg.crc32 = eoit_map_config_crc(&cfg);
-    esp_err_t err = config_manager_save(EOIT_MAP_CONFIG_KEY, &cfg, sizeof(cfg));
-    if (err != ESP_OK) {
-        return err;
-    }
-    eoit_map_config_apply(&cfg);
-    return ESP_OK;
+    return config_manager_save(EOIT_MAP_CONFIG_KEY, &cfg, sizeof(cfg));
 }
 
 esp_err_t engine_control_get_eoit_map_cell(uint8_t rpm_idx, uint8_t load_idx, float *normal) {
@@ -1510,12 +1701,315 @@ esp_err_t engine_control_get_eoit_map_cell(uint8_t rpm_idx, uint8_t load_idx, fl
         return ESP_ERR_INVALID_ARG;
     }
 
+    if (g_map_mutex == NULL) {
+        return ESP_FAIL;
+    }
+    uint32_t map_idx;
+    uint16_t raw = map_set_acquire(&map_idx)->eoit_map.values[load_idx][rpm_idx];
+    map_set_release(map_idx);
+    *normal = eoit_normal_from_table(raw);
+    return ESP_OK;
+}
+
+esp_err_t engine_control_set_cyl_trim_cell(uint8_t cylinder,
+                                           uint8_t rpm_idx,
+                                           uint8_t load_idx,
+                                           float fuel_pct,
+                                           float ign_deg) {
+    if (cylinder < 1U || cylinder > engine_layout_cylinders() ||
+        rpm_idx >= CYL_TRIM_BINS || load_idx >= CYL_TRIM_BINS ||
+        !isfinite(fuel_pct) || !isfinite(ign_deg)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
     if (g_map_mutex == NULL || xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
         return ESP_FAIL;
     }
-    uint16_t raw = g_eoit_normal_map.values[load_idx][rpm_idx];
+    map_set_t *set = map_set_begin_update();
+    uint8_t z = (uint8_t)(cylinder - 1U);
+    cyl_trim_map_set_cell(&set->trims.fuel, rpm_idx, load_idx, z, cyl_trim_fuel_to_raw(fuel_pct));
+    cyl_trim_map_set_cell(&set->trims.ignition, rpm_idx, load_idx, z, cyl_trim_ign_to_raw(ign_deg));
+    map_set_publish(set);
+    // Persisted by the monitor task (maybe_persist_maps), off the mutex
+    g_trims_dirty = true;
+    g_trims_version++;
     xSemaphoreGive(g_map_mutex);
-    *normal = eoit_normal_from_table(raw);
+    return ESP_OK;
+}
+
+esp_err_t engine_control_get_cyl_trim_cell(uint8_t cylinder,
+                                           uint8_t rpm_idx,
+                                           uint8_t load_idx,
+                                           float *fuel_pct,
+                                           float *ign_deg) {
+    if (cylinder < 1U || cylinder > engine_layout_cylinders() ||
+        rpm_idx >= CYL_TRIM_BINS || load_idx >= CYL_TRIM_BINS ||
+        !fuel_pct || !ign_deg) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL) {
+        return ESP_FAIL;
+    }
+    uint32_t map_idx;
+    const map_set_t *set = map_set_acquire(&map_idx);
+    uint8_t z = (uint8_t)(cylinder - 1U);
+    uint16_t fuel_raw = set->trims.fuel.values[z][load_idx][rpm_idx];
+    uint16_t ign_raw = set->trims.ignition.values[z][load_idx][rpm_idx];
+    map_set_release(map_idx);
+    *fuel_pct = cyl_trim_fuel_from_raw(fuel_raw);
+    *ign_deg = cyl_trim_ign_from_raw(ign_raw);
+    return ESP_OK;
+}
+
+esp_err_t engine_control_set_split_ratio_cell(uint8_t rpm_idx, uint8_t load_idx, float first_pct) {
+    if (rpm_idx >= SPLIT_INJ_BINS || load_idx >= SPLIT_INJ_BINS || !isfinite(first_pct)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL || xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    map_set_t *set = map_set_begin_update();
+    split_ratio_map_set_cell(&set->split.ratio, rpm_idx, load_idx, split_injection_ratio_to_raw(first_pct));
+    map_set_publish(set);
+    split_injection_config_t snapshot = set->split;
+    xSemaphoreGive(g_map_mutex);
+    return map_storage_save_split(&snapshot);
+}
+
+esp_err_t engine_control_get_split_ratio_cell(uint8_t rpm_idx, uint8_t load_idx, float *first_pct) {
+    if (rpm_idx >= SPLIT_INJ_BINS || load_idx >= SPLIT_INJ_BINS || !first_pct) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL) {
+        return ESP_FAIL;
+    }
+    uint32_t map_idx;
+    uint16_t raw = map_set_acquire(&map_idx)->split.ratio.values[load_idx][rpm_idx];
+    map_set_release(map_idx);
+    *first_pct = split_injection_ratio_from_raw(raw);
+    return ESP_OK;
+}
+
+esp_err_t engine_control_set_split_timing(uint16_t gap_us, uint16_t min_pulse_us) {
+    if (gap_us < SPLIT_INJ_MIN_GAP_US || gap_us > SPLIT_INJ_MAX_GAP_US ||
+        min_pulse_us < SPLIT_INJ_MIN_PULSE_US) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL || xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    map_set_t *set = map_set_begin_update();
+    set->split.gap_us = gap_us;
+    set->split.min_pulse_us = min_pulse_us;
+    map_set_publish(set);
+    split_injection_config_t snapshot = set->split;
+    xSemaphoreGive(g_map_mutex);
+    return map_storage_save_split(&snapshot);
+}
+
+esp_err_t engine_control_get_split_timing(uint16_t *gap_us, uint16_t *min_pulse_us) {
+    if (!gap_us || !min_pulse_us) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL) {
+        return ESP_FAIL;
+    }
+    uint32_t map_idx;
+    const map_set_t *set = map_set_acquire(&map_idx);
+    *gap_us = set->split.gap_us;
+    *min_pulse_us = set->split.min_pulse_us;
+    map_set_release(map_idx);
+    return ESP_OK;
+}
+
+esp_err_t engine_control_set_injector_dead_time(uint8_t idx, float vbat_v, uint16_t dead_time_us) {
+    if (idx >= INJECTOR_DEAD_TIME_BINS || !isfinite(vbat_v) || dead_time_us > INJECTOR_DEAD_TIME_MAX_US) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    long vbat_dv = lroundf(vbat_v * 10.0f);
+    if (vbat_dv < 0 || vbat_dv > UINT16_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL || xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    map_set_t *set = map_set_begin_update();
+    injector_dead_time_curve_t curve = set->injector.dead_time;
+    curve.x_bins[idx] = (uint16_t)vbat_dv;
+    curve.values[idx] = dead_time_us;
+    injector_dead_time_curve_commit(&curve);
+    if (!injector_dead_time_curve_validate(&curve)) {
+        // Breakpoints must stay strictly increasing; drop the copy
+        xSemaphoreGive(g_map_mutex);
+        return ESP_ERR_INVALID_ARG;
+    }
+    set->injector.dead_time = curve;
+    map_set_publish(set);
+    injector_model_config_t snapshot = set->injector;
+    xSemaphoreGive(g_map_mutex);
+    return map_storage_save_injector(&snapshot);
+}
+
+esp_err_t engine_control_get_injector_dead_time(uint8_t idx, float *vbat_v, uint16_t *dead_time_us) {
+    if (idx >= INJECTOR_DEAD_TIME_BINS || !vbat_v || !dead_time_us) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL) {
+        return ESP_FAIL;
+    }
+    uint32_t map_idx;
+    const map_set_t *set = map_set_acquire(&map_idx);
+    uint16_t vbat_dv = set->injector.dead_time.x_bins[idx];
+    *dead_time_us = set->injector.dead_time.values[idx];
+    map_set_release(map_idx);
+    *vbat_v = (float)vbat_dv / 10.0f;
+    return ESP_OK;
+}
+
+esp_err_t engine_control_set_injector_short_pulse(uint8_t idx, uint16_t fuel_us, float correction_us) {
+    if (idx >= INJECTOR_SHORT_PULSE_BINS || !isfinite(correction_us)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL || xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    map_set_t *set = map_set_begin_update();
+    injector_short_pulse_curve_t curve = set->injector.short_pulse;
+    curve.x_bins[idx] = fuel_us;
+    curve.values[idx] = injector_model_short_to_raw(correction_us);
+    injector_short_pulse_curve_commit(&curve);
+    if (!injector_short_pulse_curve_validate(&curve)) {
+        xSemaphoreGive(g_map_mutex);
+        return ESP_ERR_INVALID_ARG;
+    }
+    set->injector.short_pulse = curve;
+    map_set_publish(set);
+    injector_model_config_t snapshot = set->injector;
+    xSemaphoreGive(g_map_mutex);
+    return map_storage_save_injector(&snapshot);
+}
+
+esp_err_t engine_control_get_injector_short_pulse(uint8_t idx, uint16_t *fuel_us, float *correction_us) {
+    if (idx >= INJECTOR_SHORT_PULSE_BINS || !fuel_us || !correction_us) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL) {
+        return ESP_FAIL;
+    }
+    uint32_t map_idx;
+    const map_set_t *set = map_set_acquire(&map_idx);
+    *fuel_us = set->injector.short_pulse.x_bins[idx];
+    uint16_t raw = set->injector.short_pulse.values[idx];
+    map_set_release(map_idx);
+    *correction_us = injector_model_short_from_raw(raw);
+    return ESP_OK;
+}
+
+esp_err_t engine_control_set_dwell_cell(uint8_t rpm_idx, uint8_t vbat_idx, uint16_t dwell_us) {
+    if (rpm_idx >= DWELL_RPM_BINS || vbat_idx >= DWELL_VBAT_BINS ||
+        dwell_us < DWELL_MIN_US || dwell_us > DWELL_MAX_US) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL || xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    map_set_t *set = map_set_begin_update();
+    dwell_map_set_cell(&set->dwell.map, rpm_idx, vbat_idx, dwell_us);
+    map_set_publish(set);
+    dwell_config_t snapshot = set->dwell;
+    xSemaphoreGive(g_map_mutex);
+    return map_storage_save_dwell(&snapshot);
+}
+
+esp_err_t engine_control_get_dwell_cell(uint8_t rpm_idx, uint8_t vbat_idx, uint16_t *dwell_us) {
+    if (rpm_idx >= DWELL_RPM_BINS || vbat_idx >= DWELL_VBAT_BINS || !dwell_us) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL) {
+        return ESP_FAIL;
+    }
+    uint32_t map_idx;
+    *dwell_us = map_set_acquire(&map_idx)->dwell.map.values[vbat_idx][rpm_idx];
+    map_set_release(map_idx);
+    return ESP_OK;
+}
+
+esp_err_t engine_control_set_dwell_coil(const dwell_coil_t *coil) {
+    if (!dwell_control_coil_valid(coil)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL || xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    map_set_t *set = map_set_begin_update();
+    dwell_control_fill_from_coil(&set->dwell, coil);
+    map_set_publish(set);
+    dwell_config_t snapshot = set->dwell;
+    xSemaphoreGive(g_map_mutex);
+    return map_storage_save_dwell(&snapshot);
+}
+
+esp_err_t engine_control_get_dwell_coil(dwell_coil_t *coil) {
+    if (!coil) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL) {
+        return ESP_FAIL;
+    }
+    uint32_t map_idx;
+    *coil = map_set_acquire(&map_idx)->dwell.coil;
+    map_set_release(map_idx);
+    return ESP_OK;
+}
+
+esp_err_t engine_control_set_dwell_limits(float max_duty_pct, uint16_t min_off_us) {
+    if (!isfinite(max_duty_pct) || min_off_us > DWELL_MAX_OFF_US) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    long duty_x10 = lroundf(max_duty_pct * 10.0f);
+    if (duty_x10 < (long)DWELL_MIN_DUTY_X10 || duty_x10 > (long)DWELL_MAX_DUTY_X10) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL || xSemaphoreTake(g_map_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    map_set_t *set = map_set_begin_update();
+    set->dwell.max_duty_x10 = (uint16_t)duty_x10;
+    set->dwell.min_off_us = min_off_us;
+    map_set_publish(set);
+    dwell_config_t snapshot = set->dwell;
+    xSemaphoreGive(g_map_mutex);
+    return map_storage_save_dwell(&snapshot);
+}
+
+esp_err_t engine_control_get_dwell_limits(float *max_duty_pct, uint16_t *min_off_us) {
+    if (!max_duty_pct || !min_off_us) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (g_map_mutex == NULL) {
+        return ESP_FAIL;
+    }
+    uint32_t map_idx;
+    const map_set_t *set = map_set_acquire(&map_idx);
+    uint16_t duty_x10 = set->dwell.max_duty_x10;
+    *min_off_us = set->dwell.min_off_us;
+    map_set_release(map_idx);
+    *max_duty_pct = (float)duty_x10 / 10.0f;
     return ESP_OK;
 }
 
@@ -1554,33 +2048,117 @@ bool engine_control_get_closed_loop_enabled(void) {
     return g_closed_loop_enabled;
 }
 
+void engine_control_set_isr_refine(bool enabled) {
+    angle_scheduler_set_isr_refine(enabled);
+    ESP_LOGI("ENGINE_CONTROL", "Tooth ISR refine %s", enabled ? "enabled" : "disabled");
+}
+
+bool engine_control_get_isr_refine(void) {
+    return angle_scheduler_get_isr_refine();
+}
+
+esp_err_t engine_control_set_engine_layout(const engine_layout_t *layout) {
+    if (!engine_layout_validate(layout)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (engine_layout_output_count(layout) > MCPWM_OUTPUT_MAX_CHANNELS) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    // The output channels are sized at init: a running engine keeps its layout
+    if (!g_engine_initialized) {
+        engine_layout_apply(layout);
+    }
+    return engine_layout_config_save(layout);
+}
+
+void engine_control_get_engine_layout(engine_layout_t *layout) {
+    if (layout) {
+        *layout = *engine_layout_get();
+    }
+}
+
 esp_err_t engine_control_get_perf_stats(engine_perf_stats_t *stats) {
     if (!stats) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    perf_stats_t snap = {0};
-    portENTER_CRITICAL(&g_perf_spinlock);
-    snap = g_perf_stats;
-    portEXIT_CRITICAL(&g_perf_spinlock);
-
     memset(stats, 0, sizeof(*stats));
-    stats->planner_last_us = snap.planner_last_us;
-    stats->planner_max_us = snap.planner_max_us;
-    stats->executor_last_us = snap.executor_last_us;
-    stats->executor_max_us = snap.executor_max_us;
-    stats->planner_deadline_miss = snap.planner_deadline_miss;
-    stats->executor_deadline_miss = snap.executor_deadline_miss;
-    stats->queue_overruns = snap.queue_overruns;
-    stats->queue_depth_peak = snap.queue_depth_peak;
-    stats->sample_count = snap.sample_count;
-
-    uint16_t n = snap.sample_count;
-    if (n > 0) {
-        stats->planner_p95_us = perf_percentile(snap.planner_samples, n, 95);
-        stats->planner_p99_us = perf_percentile(snap.planner_samples, n, 99);
-        stats->executor_p95_us = perf_percentile(snap.executor_samples, n, 95);
-        stats->executor_p99_us = perf_percentile(snap.executor_samples, n, 99);
+    stats->planner_last_us = __atomic_load_n(&g_perf_stats.planner_last_us, __ATOMIC_RELAXED);
+    stats->planner_max_us = __atomic_load_n(&g_perf_stats.planner_max_us, __ATOMIC_RELAXED);
+    stats->executor_last_us = __atomic_load_n(&g_perf_stats.executor_last_us, __ATOMIC_RELAXED);
+    stats->executor_max_us = __atomic_load_n(&g_perf_stats.executor_max_us, __ATOMIC_RELAXED);
+    stats->planner_deadline_miss = __atomic_load_n(&g_perf_stats.planner_deadline_miss, __ATOMIC_RELAXED);
+    stats->executor_deadline_miss = __atomic_load_n(&g_perf_stats.executor_deadline_miss, __ATOMIC_RELAXED);
+    spsc_ring_stats_t ring;
+    spsc_ring_get_stats(&g_plan_ring, &ring);
+    stats->queue_overruns = ring.dropped;
+    stats->plans_superseded = ring.superseded;
+    stats->queue_depth_peak = __atomic_load_n(&g_perf_stats.queue_depth_peak, __ATOMIC_RELAXED);
+
+    latency_summary_t planner;
+    latency_summary_t executor;
+    latency_hist_summary(&g_perf_hist[ENGINE_PERF_PLANNER], &planner);
+    latency_hist_summary(&g_perf_hist[ENGINE_PERF_EXECUTOR], &executor);
+    stats->planner_p95_us = hp_cycles_to_us_u32(planner.p95);
+    stats->planner_p99_us = hp_cycles_to_us_u32(planner.p99);
+    stats->executor_p95_us = hp_cycles_to_us_u32(executor.p95);
+    stats->executor_p99_us = hp_cycles_to_us_u32(executor.p99);
+    stats->sample_count = planner.count;
+    return ESP_OK;
+}
+
+static uint32_t perf_cycles_to_ns(uint32_t cycles) {
+    return (uint32_t)(((uint64_t)cycles * 1000U) / HP_CPU_FREQ_MHZ);
+}
+
+static uint32_t perf_us_to_ns(uint32_t us) {
+    return (us > UINT32_MAX / 1000U) ? UINT32_MAX : us * 1000U;
+}
+
+esp_err_t engine_control_get_perf_latency(engine_perf_stage_t stage, latency_summary_t *out) {
+    if (!out || stage >= ENGINE_PERF_STAGE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (stage == ENGINE_PERF_EDGE_TO_WRITE_TASK || stage == ENGINE_PERF_EDGE_TO_WRITE_ISR) {
+        // Kept by the angle scheduler on the timebase, in us
+        angle_scheduler_get_write_latency(stage == ENGINE_PERF_EDGE_TO_WRITE_ISR, out);
+        out->p50 = perf_us_to_ns(out->p50);
+        out->p95 = perf_us_to_ns(out->p95);
+        out->p99 = perf_us_to_ns(out->p99);
+        out->p999 = perf_us_to_ns(out->p999);
+        out->max = perf_us_to_ns(out->max);
+        return ESP_OK;
+    }
+    if (stage == ENGINE_PERF_CKP_ISR) {
+        sync_get_isr_latency(out);
+    } else {
+        latency_hist_summary(&g_perf_hist[stage], out);
     }
+    out->p50 = perf_cycles_to_ns(out->p50);
+    out->p95 = perf_cycles_to_ns(out->p95);
+    out->p99 = perf_cycles_to_ns(out->p99);
+    out->p999 = perf_cycles_to_ns(out->p999);
+    out->max = perf_cycles_to_ns(out->max);
     return ESP_OK;
 }
+
+const char *engine_control_perf_stage_name(engine_perf_stage_t stage) {
+    static const char *const names[ENGINE_PERF_STAGE_COUNT] = {
+        "planner", "executor", "sync_read", "sensor_read", "table_lookup", "lambda_pid", "scheduling",
+        "edge_to_write_task", "edge_to_write_isr", "planner_wake", "executor_wake", "ckp_isr",
+    };
+    return (stage < ENGINE_PERF_STAGE_COUNT) ? names[stage] : "?";
+}
+
+void engine_control_reset_perf_stats(void) {
+    for (uint32_t i = 0; i < ENGINE_PERF_STAGE_COUNT; i++) {
+        latency_hist_reset(&g_perf_hist[i]);
+    }
+    __atomic_store_n(&g_perf_stats.planner_max_us, 0U, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_perf_stats.executor_max_us, 0U, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_perf_stats.planner_deadline_miss, 0U, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_perf_stats.executor_deadline_miss, 0U, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_perf_stats.queue_depth_peak, 0U, __ATOMIC_RELAXED);
+    sync_reset_isr_latency();
+    angle_scheduler_reset_stats();
+}
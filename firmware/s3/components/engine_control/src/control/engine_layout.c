@@ -0,0 +1,117 @@
+#include "../include/engine_layout.h"
+#include <string.h>
+
+static engine_layout_t g_layout = {
+    .cylinders = 4,
+    .firing_order = {1, 3, 4, 2},
+    .wasted_spark = 0,
+};
+
+// Derived from g_layout by engine_layout_apply(), index = cylinder - 1
+static float g_tdc_deg[ENGINE_MAX_CYLINDERS] = {0.0f, 540.0f, 180.0f, 360.0f};
+static uint8_t g_coil[ENGINE_MAX_CYLINDERS] = {1, 2, 3, 4};
+static uint8_t g_coil_cylinder[ENGINE_MAX_CYLINDERS] = {1, 2, 3, 4};
+static uint8_t g_coils = 4;
+
+void engine_layout_default(engine_layout_t *layout) {
+    if (!layout) {
+        return;
+    }
+    memset(layout, 0, sizeof(*layout));
+    layout->cylinders = 4;
+    layout->firing_order[0] = 1;
+    layout->firing_order[1] = 3;
+    layout->firing_order[2] = 4;
+    layout->firing_order[3] = 2;
+}
+
+bool engine_layout_validate(const engine_layout_t *layout) {
+    if (!layout || layout->cylinders < 1U || layout->cylinders > ENGINE_MAX_CYLINDERS) {
+        return false;
+    }
+    if (layout->wasted_spark && (layout->cylinders % 2U) != 0U) {
+        return false;
+    }
+    uint8_t seen = 0;
+    for (uint8_t p = 0; p < layout->cylinders; p++) {
+        uint8_t cyl = layout->firing_order[p];
+        if (cyl < 1U || cyl > layout->cylinders || (seen & (1U << (cyl - 1U))) != 0U) {
+            return false;
+        }
+        seen |= (uint8_t)(1U << (cyl - 1U));
+    }
+    return true;
+}
+
+esp_err_t engine_layout_apply(const engine_layout_t *layout) {
+    if (!engine_layout_validate(layout)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t n = layout->cylinders;
+    uint8_t coils = (uint8_t)(engine_layout_output_count(layout) - n);
+    memset(g_tdc_deg, 0, sizeof(g_tdc_deg));
+    memset(g_coil, 0, sizeof(g_coil));
+    memset(g_coil_cylinder, 0, sizeof(g_coil_cylinder));
+    for (uint8_t p = 0; p < n; p++) {
+        uint8_t cyl = layout->firing_order[p];
+        g_tdc_deg[cyl - 1U] = (720.0f * (float)p) / (float)n;
+        if (!layout->wasted_spark) {
+            // Coil output N drives cylinder N
+            g_coil[cyl - 1U] = cyl;
+            g_coil_cylinder[cyl - 1U] = cyl;
+            continue;
+        }
+        // Cylinders 360 degrees apart sit half the firing order apart; coils
+        // are numbered by the firing position of their first cylinder
+        uint8_t coil = (uint8_t)((p % coils) + 1U);
+        g_coil[cyl - 1U] = coil;
+        if (p < coils) {
+            g_coil_cylinder[coil - 1U] = cyl;
+        }
+    }
+    g_coils = coils;
+    g_layout = *layout;
+    return ESP_OK;
+}
+
+const engine_layout_t *engine_layout_get(void) {
+    return &g_layout;
+}
+
+uint8_t engine_layout_cylinders(void) {
+    return g_layout.cylinders;
+}
+
+uint8_t engine_layout_coils(void) {
+    return g_coils;
+}
+
+uint8_t engine_layout_output_count(const engine_layout_t *layout) {
+    if (!layout) {
+        return 0;
+    }
+    uint8_t coils = layout->wasted_spark ? (uint8_t)(layout->cylinders / 2U) : layout->cylinders;
+    return (uint8_t)(layout->cylinders + coils);
+}
+
+float engine_layout_tdc_deg(uint8_t cylinder) {
+    if (cylinder < 1U || cylinder > g_layout.cylinders) {
+        return 0.0f;
+    }
+    return g_tdc_deg[cylinder - 1U];
+}
+
+uint8_t engine_layout_coil(uint8_t cylinder) {
+    if (cylinder < 1U || cylinder > g_layout.cylinders) {
+        return 0;
+    }
+    return g_coil[cylinder - 1U];
+}
+
+uint8_t engine_layout_coil_cylinder(uint8_t coil) {
+    if (coil < 1U || coil > g_coils) {
+        return 0;
+    }
+    return g_coil_cylinder[coil - 1U];
+}
@@ -1,5 +1,4 @@
 #include "../include/fuel_calc.h"
-#include "../include/table_16x16.h"
 #include "../include/s3_control_config.h"
 #include "esp_timer.h"
 #include <math.h>
@@ -14,38 +13,45 @@ typedef struct {
     uint16_t last_rpm;
     uint16_t last_load;
     uint16_t last_result;
-    uint16_t table_checksum;
+    uint32_t table_generation;
     bool valid;
+    table_cache_t recip;
 } interp_cache_t;
 
 static interp_cache_t g_fuel_cache = {0};
 static interp_cache_t g_ign_cache = {0};
 static interp_cache_t g_lambda_cache = {0};
 
+typedef struct {
+    uint16_t last_rpm;
+    uint16_t last_load;
+    uint16_t last_result[TABLE_MULTI_MAX];
+    bool valid;
+    table_multi_t multi;
+} multi_cache_t;
+
+static multi_cache_t g_multi_cache = {0};
+
 static uint16_t abs_u16_delta(uint16_t a, uint16_t b) {
     return (a > b) ? (a - b) : (b - a);
 }
 
-static uint16_t lookup_with_cache(const table_16x16_t *table,
-                                  interp_cache_t *cache,
-                                  uint16_t rpm,
-                                  uint16_t load) {
-    if (!table || !cache) {
-        return 0;
-    }
-
-    if (cache->valid &&
-        cache->table_checksum == table->checksum &&
-        abs_u16_delta(rpm, cache->last_rpm) <= INTERP_CACHE_RPM_DEADBAND &&
-        abs_u16_delta(load, cache->last_load) <= INTERP_CACHE_LOAD_DEADBAND) {
-        return cache->last_result;
-    }
+static bool cache_hit(const interp_cache_t *cache, uint32_t generation, uint16_t rpm, uint16_t load) {
+    return cache->valid &&
+           cache->table_generation == generation &&
+           abs_u16_delta(rpm, cache->last_rpm) <= INTERP_CACHE_RPM_DEADBAND &&
+           abs_u16_delta(load, cache->last_load) <= INTERP_CACHE_LOAD_DEADBAND;
+}
 
-    uint16_t result = table_16x16_interpolate(table, rpm, load);
+static uint16_t cache_store(interp_cache_t *cache,
+                            uint32_t generation,
+                            uint16_t rpm,
+                            uint16_t load,
+                            uint16_t result) {
     cache->last_rpm = rpm;
     cache->last_load = load;
     cache->last_result = result;
-    cache->table_checksum = table->checksum;
+    cache->table_generation = generation;
     cache->valid = true;
     return result;
 }
@@ -55,9 +61,9 @@ void fuel_calc_init_defaults(fuel_calc_maps_t *maps) {
         return;
     }
 
-    table_16x16_init(&maps->fuel_table, NULL, NULL, 1000);    // 100.0% VE
-    table_16x16_init(&maps->ignition_table, NULL, NULL, 150); // 15.0 deg
-    table_16x16_init(&maps->lambda_table, NULL, NULL, 1000);  // 1.000 lambda
+    fuel_ve_map_init(&maps->fuel_table, DEFAULT_RPM_BINS, 16, DEFAULT_LOAD_BINS, 16, 1000);     // 100.0% VE
+    fuel_ign_map_init(&maps->ignition_table, DEFAULT_RPM_BINS, 16, DEFAULT_LOAD_BINS, 16, 150); // 15.0 deg
+    fuel_lambda_map_init(&maps->lambda_table, DEFAULT_RPM_BINS, 16, DEFAULT_LOAD_BINS, 16, 1000); // 1.000 lambda
     fuel_calc_reset_interpolation_cache();
 }
 
@@ -65,27 +71,101 @@ void fuel_calc_reset_interpolation_cache(void) {
     memset(&g_fuel_cache, 0, sizeof(g_fuel_cache));
     memset(&g_ign_cache, 0, sizeof(g_ign_cache));
     memset(&g_lambda_cache, 0, sizeof(g_lambda_cache));
+    g_multi_cache.valid = false;
+    table_multi_reset(&g_multi_cache.multi);
 }
 
 uint16_t fuel_calc_lookup_ve(const fuel_calc_maps_t *maps, uint16_t rpm, uint16_t load) {
     if (!maps) {
         return 0;
     }
-    return lookup_with_cache(&maps->fuel_table, &g_fuel_cache, rpm, load);
+    const fuel_ve_map_t *table = &maps->fuel_table;
+    if (cache_hit(&g_fuel_cache, table->generation, rpm, load)) {
+        return g_fuel_cache.last_result;
+    }
+    return cache_store(&g_fuel_cache, table->generation, rpm, load,
+                       fuel_ve_map_interpolate(table, &g_fuel_cache.recip, rpm, load));
 }
 
 uint16_t fuel_calc_lookup_ignition(const fuel_calc_maps_t *maps, uint16_t rpm, uint16_t load) {
     if (!maps) {
         return 0;
     }
-    return lookup_with_cache(&maps->ignition_table, &g_ign_cache, rpm, load);
+    const fuel_ign_map_t *table = &maps->ignition_table;
+    if (cache_hit(&g_ign_cache, table->generation, rpm, load)) {
+        return g_ign_cache.last_result;
+    }
+    return cache_store(&g_ign_cache, table->generation, rpm, load,
+                       fuel_ign_map_interpolate(table, &g_ign_cache.recip, rpm, load));
 }
 
 uint16_t fuel_calc_lookup_lambda(const fuel_calc_maps_t *maps, uint16_t rpm, uint16_t load) {
     if (!maps) {
         return 0;
     }
-    return lookup_with_cache(&maps->lambda_table, &g_lambda_cache, rpm, load);
+    const fuel_lambda_map_t *table = &maps->lambda_table;
+    if (cache_hit(&g_lambda_cache, table->generation, rpm, load)) {
+        return g_lambda_cache.last_result;
+    }
+    return cache_store(&g_lambda_cache, table->generation, rpm, load,
+                       fuel_lambda_map_interpolate(table, &g_lambda_cache.recip, rpm, load));
+}
+
+bool fuel_calc_validate_maps(const fuel_calc_maps_t *maps) {
+    if (!maps) {
+        return false;
+    }
+    return fuel_ve_map_validate(&maps->fuel_table) &&
+           fuel_ign_map_validate(&maps->ignition_table) &&
+           fuel_lambda_map_validate(&maps->lambda_table);
+}
+
+void fuel_calc_lookup_all(const fuel_calc_maps_t *maps,
+                          const table_view_t *eoit_map,
+                          uint16_t rpm,
+                          uint16_t load,
+                          fuel_calc_lookup_t *out) {
+    if (!out) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!maps) {
+        return;
+    }
+
+    table_view_t views[TABLE_MULTI_MAX] = {
+        fuel_ve_map_view(&maps->fuel_table),
+        fuel_ign_map_view(&maps->ignition_table),
+        fuel_lambda_map_view(&maps->lambda_table),
+    };
+    uint8_t count = 3;
+    if (eoit_map) {
+        views[count++] = *eoit_map;
+    }
+
+    multi_cache_t *cache = &g_multi_cache;
+    bool hit = cache->valid &&
+               abs_u16_delta(rpm, cache->last_rpm) <= INTERP_CACHE_RPM_DEADBAND &&
+               abs_u16_delta(load, cache->last_load) <= INTERP_CACHE_LOAD_DEADBAND &&
+               table_multi_is_bound(&cache->multi, views, count);
+
+    if (!hit) {
+        if (table_multi_interpolate(&cache->multi, views, count, rpm, load,
+                                    cache->last_result) == 0U) {
+            cache->valid = false;
+            return;
+        }
+        cache->last_rpm = rpm;
+        cache->last_load = load;
+        cache->valid = true;
+    }
+
+    out->ve_x10 = cache->last_result[0];
+    out->advance_deg10 = cache->last_result[1];
+    out->lambda_target = cache->last_result[2];
+    if (eoit_map) {
+        out->eoit_normal_raw = cache->last_result[3];
+    }
 }
 
 uint16_t fuel_calc_warmup_enrichment(const sensor_data_t *sensors) {
@@ -4,71 +4,88 @@
  * 
  * Integração com drivers MCPWM HP:
  * - Timer contínuo com compare absoluto
- * - Compensação de latência de injetor
+ * - Compensação de injetor (tempo morto e pulso curto, injector_model)
  */
 
 #include "../include/fuel_injection.h"
+#include "../include/angle_scheduler.h"
 #include "../include/mcpwm_injection.h"
 #include "../include/mcpwm_injection_hp.h"
 #include "../include/sync.h"
 #include "../include/hp_state.h"
 #include "../include/math_utils.h"
+#include "../include/engine_layout.h"
+#include "../include/split_injection.h"
+#include "../include/injector_model.h"
 
-static fuel_injection_config_t g_fuel_cfg = {
-    .cyl_tdc_deg = {0.0f, 180.0f, 360.0f, 540.0f},
-};
+// Compensação nominal (13,5 V) para chamadas sem plano
+static injector_comp_t g_nominal_injector;
 
-static float compute_current_angle_deg(const sync_data_t *sync, uint32_t tooth_count) {
-    float degrees_per_tooth = 360.0f / (float)(tooth_count + 2);
-    float current_angle = (sync->revolution_index * 360.0f) + (sync->tooth_index * degrees_per_tooth);
-    return wrap_angle_720(current_angle);
-}
-
-static float sync_us_per_degree(const sync_data_t *sync, const sync_config_t *cfg) {
-    if (!sync || !cfg || sync->tooth_period == 0U || cfg->tooth_count == 0U) {
-        return 0.0f;
+// Refino na ISR de dente: reescreve a lista armada a partir do novo alvo
+IRAM_ATTR static bool fuel_injection_isr_write(uint64_t target_us, const angle_event_detail_t *detail) {
+    mcpwm_injection_pulse_t pulse[ANGLE_SCHED_MAX_PULSES];
+    for (uint8_t k = 0; k < detail->count; k++) {
+        pulse[k].start_us = target_us + detail->offset_us[k];
+        pulse[k].pulsewidth_us = detail->width_us[k];
     }
-    uint32_t total_positions = cfg->tooth_count + 2U;
-    return ((float)sync->tooth_period * (float)total_positions) / 360.0f;
+    return mcpwm_injection_hp_schedule_pulses_at(detail->channel, pulse, detail->count);
 }
 
-void fuel_injection_init(const fuel_injection_config_t *config) {
-    if (config) {
-        g_fuel_cfg = *config;
-    }
+void fuel_injection_init(void) {
     // Drivers HP já inicializados em ignition_init()
+    injector_model_prepare(NULL, 0, &g_nominal_injector);
+    angle_scheduler_set_writer(ANGLE_EVENT_INJECTION, fuel_injection_isr_write);
 }
 
-bool fuel_injection_schedule_eoi_ex(uint8_t cylinder_id,
-                                      float target_eoi_deg,
-                                      uint32_t pulsewidth_us,
-                                      const sync_data_t *sync,
-                                      fuel_injection_schedule_info_t *info) {
-    if (!sync || cylinder_id < 1 || cylinder_id > 4) {
-        return false;
-    }
+typedef struct {
+    float delta_deg;         // crank angle from the current tooth to SOI
+    float soi_deg;           // cycle angle of SOI
+    float deg_per_tooth;
+    uint8_t pulses;
+    // Injector compensated pulses on the shared timebase; pulse[0] starts at
+    // SOI (tooth capture + delay), the last one ends at EOI
+    mcpwm_injection_pulse_t pulse[SPLIT_INJ_MAX_PULSES];
+} injection_event_t;
 
-    sync_config_t sync_cfg = {0};
-    if (sync_get_config(&sync_cfg) != ESP_OK || sync_cfg.tooth_count == 0) {
+static bool compute_injection_event(uint8_t cylinder_id,
+                                    float target_eoi_deg,
+                                    uint32_t pulsewidth_us,
+                                    const split_injection_t *split,
+                                    const injector_comp_t *injector,
+                                    const sync_snapshot_t *sync,
+                                    injection_event_t *ev,
+                                    fuel_injection_schedule_info_t *info) {
+    if (!sync || cylinder_id < 1 || cylinder_id > engine_layout_cylinders()) {
         return false;
     }
-    float us_per_deg = sync_us_per_degree(sync, &sync_cfg);
+
+    float us_per_deg = sync_us_per_degree(sync);
     if (us_per_deg <= 0.0f) {
         return false;
     }
 
-    float current_angle = compute_current_angle_deg(sync, sync_cfg.tooth_count);
-    float eoi_deg = wrap_angle_720(target_eoi_deg + g_fuel_cfg.cyl_tdc_deg[cylinder_id - 1]);
+    float current_angle = sync_cycle_angle_deg(sync);
+    float eoi_deg = wrap_angle_720(target_eoi_deg + engine_layout_tdc_deg(cylinder_id));
     
     // Calcular pulso width compensado
-    float compensated_pw = (float)pulsewidth_us;
-    float battery_voltage = 13.5f;
-    float temperature = 25.0f;
-    
-    // Aplicar compensação de latência do injetor usando estado centralizado
-    mcpwm_injection_hp_apply_latency_compensation(&compensated_pw, battery_voltage, temperature);
+    if (!injector) {
+        injector = &g_nominal_injector;
+    }
+    uint32_t fuel_us[SPLIT_INJ_MAX_PULSES];
+    uint8_t pulses = split_injection_pulses(split, pulsewidth_us, fuel_us);
+    uint32_t compensated_us[SPLIT_INJ_MAX_PULSES];
+    float window_us = 0.0f;
+    for (uint8_t k = 0; k < pulses; k++) {
+        // Tempo morto na tensão da bateria do plano e correção de pulso
+        // curto (cada pulso abre o injetor de novo)
+        compensated_us[k] = injector_model_pulse_us(injector, fuel_us[k]);
+        window_us += (float)compensated_us[k];
+        if (k > 0) {
+            window_us += (float)split->gap_us;
+        }
+    }
     
-    float pw_deg = compensated_pw / us_per_deg;
+    float pw_deg = window_us / us_per_deg;
     float soi_deg = wrap_angle_720(eoi_deg - pw_deg);
 
     float delta_deg = soi_deg - current_angle;
@@ -78,50 +95,104 @@ bool fuel_injection_schedule_eoi_ex(uint8_t cylinder_id,
 
     uint32_t delay_us = (uint32_t)((delta_deg * us_per_deg) + 0.5f);
     
-    // Obter contador atual do timer MCPWM (valor real, não sintético)
-    uint32_t current_counter = mcpwm_injection_hp_get_counter((uint8_t)(cylinder_id - 1));
-    
     if (info) {
         info->eoi_deg = eoi_deg;
         info->soi_deg = soi_deg;
         info->delay_us = delay_us;
+        info->pulses = pulses;
     }
-    
+
+    ev->delta_deg = delta_deg;
+    ev->soi_deg = soi_deg;
+    ev->deg_per_tooth = sync_tooth_pitch_deg(sync);
+    ev->pulses = pulses;
+    uint64_t start_us = sync->capture_time_us + delay_us;
+    for (uint8_t k = 0; k < pulses; k++) {
+        ev->pulse[k].start_us = start_us;
+        ev->pulse[k].pulsewidth_us = compensated_us[k];
+        start_us += compensated_us[k] + ((split != NULL) ? split->gap_us : 0U);
+    }
+    return true;
+}
+
+bool fuel_injection_schedule_eoi_ex(uint8_t cylinder_id,
+                                      float target_eoi_deg,
+                                      uint32_t pulsewidth_us,
+                                      const sync_snapshot_t *sync,
+                                      fuel_injection_schedule_info_t *info) {
+    injection_event_t ev;
+    if (!compute_injection_event(cylinder_id, target_eoi_deg, pulsewidth_us, NULL, NULL, sync, &ev, info)) {
+        return false;
+    }
+
     // Usar scheduling absoluto HP
-    return mcpwm_injection_hp_schedule_one_shot_absolute(
-        (uint8_t)(cylinder_id - 1), delay_us, (uint32_t)compensated_pw, current_counter);
+    return mcpwm_injection_hp_schedule_at((uint8_t)(cylinder_id - 1), ev.pulse[0].start_us, ev.pulse[0].pulsewidth_us);
+}
+
+bool fuel_injection_schedule_eoi_angle(uint8_t cylinder_id,
+                                         float target_eoi_deg,
+                                         uint32_t pulsewidth_us,
+                                         const split_injection_t *split,
+                                         const injector_comp_t *injector,
+                                         const sync_snapshot_t *sync,
+                                         fuel_injection_schedule_info_t *info) {
+    injection_event_t ev;
+    if (!compute_injection_event(cylinder_id, target_eoi_deg, pulsewidth_us, split, injector, sync, &ev, info)) {
+        return false;
+    }
+
+    // The event is the first pulse: the driver arms the rest from its ISR
+    uint32_t start_us = (uint32_t)ev.pulse[0].start_us;
+    angle_event_action_t action = angle_scheduler_plan(ANGLE_EVENT_INJECTION, cylinder_id,
+                                                       ev.delta_deg, ev.deg_per_tooth, start_us);
+    if (action == ANGLE_EVENT_HOLD) {
+        return true;
+    }
+    bool written = mcpwm_injection_hp_schedule_pulses_at((uint8_t)(cylinder_id - 1), ev.pulse, ev.pulses);
+
+    // Pulses relative to SOI, for the refine from the tooth ISR
+    angle_event_detail_t detail = {
+        .event_angle = (uint32_t)(ev.soi_deg * (float)SYNC_ANGLE_SCALE + 0.5f) % SYNC_ANGLE_CYCLE,
+        .lead_us = 0,
+        .channel = (uint8_t)(cylinder_id - 1),
+        .count = ev.pulses,
+    };
+    for (uint8_t k = 0; k < ev.pulses; k++) {
+        detail.offset_us[k] = (uint32_t)(ev.pulse[k].start_us - ev.pulse[0].start_us);
+        detail.width_us[k] = ev.pulse[k].pulsewidth_us;
+    }
+    angle_scheduler_commit(ANGLE_EVENT_INJECTION, cylinder_id, action, start_us,
+                           sync->capture_time_us, written, &detail);
+    return true;
 }
 
 bool fuel_injection_schedule_eoi(uint8_t cylinder_id,
                                    float target_eoi_deg,
                                    uint32_t pulsewidth_us,
-                                   const sync_data_t *sync) {
+                                   const sync_snapshot_t *sync) {
     return fuel_injection_schedule_eoi_ex(cylinder_id, target_eoi_deg, pulsewidth_us, sync, NULL);
 }
 
-bool fuel_injection_schedule_sequential(uint32_t pulsewidth_us[4],
-                                          float target_eoi_deg[4],
-                                          const sync_data_t *sync) {
+bool fuel_injection_schedule_sequential(const uint32_t pulsewidth_us[ENGINE_MAX_CYLINDERS],
+                                        const float target_eoi_deg[ENGINE_MAX_CYLINDERS],
+                                        const split_injection_t *split,
+                                        const injector_comp_t *injector,
+                                        const sync_snapshot_t *sync,
+                                        fuel_injection_schedule_info_t info[ENGINE_MAX_CYLINDERS]) {
     if (!sync || !pulsewidth_us || !target_eoi_deg) {
         return false;
     }
-    
-    sync_config_t sync_cfg = {0};
-    if (sync_get_config(&sync_cfg) != ESP_OK || sync_cfg.tooth_count == 0) {
-        return false;
-    }
-    
-    uint32_t offsets[4];
-    // Obter contador atual do timer MCPWM (valor real, não sintético)
-    uint32_t current_counter = mcpwm_injection_hp_get_counter(0);
-    
-    for (int i = 0; i < 4; i++) {
-        fuel_injection_schedule_info_t info;
-        if (!fuel_injection_schedule_eoi_ex(i + 1, target_eoi_deg[i], pulsewidth_us[i], sync, &info)) {
-            return false;
+
+    // Every cylinder is attempted even if one fails, so one bad channel
+    // does not starve the others
+    bool all_ok = true;
+    uint8_t cylinders = engine_layout_cylinders();
+    for (uint8_t i = 0; i < cylinders; i++) {
+        fuel_injection_schedule_info_t *cyl_info = info ? &info[i] : NULL;
+        if (!fuel_injection_schedule_eoi_angle((uint8_t)(i + 1), target_eoi_deg[i], pulsewidth_us[i],
+                                               split, injector, sync, cyl_info)) {
+            all_ok = false;
         }
-        offsets[i] = info.delay_us;
     }
-    
-    return mcpwm_injection_hp_schedule_sequential_absolute(0, pulsewidth_us[0], offsets, current_counter);
+    return all_ok;
 }
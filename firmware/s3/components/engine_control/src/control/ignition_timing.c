@@ -6,9 +6,11 @@
  * - Timer contínuo com compare absoluto
  * - Preditor de fase adaptativo
  * - Compensação de latência física
+ * - Dwell calculado pelo planejador (dwell_control.h)
  */
 
 #include "../include/ignition_timing.h"
+#include "../include/angle_scheduler.h"
 #include "../include/logger.h"
 #include "../include/mcpwm_ignition.h"
 #include "../include/mcpwm_ignition_hp.h"
@@ -17,35 +19,15 @@
 #include "../include/sensor_processing.h"
 #include "../include/sync.h"
 #include "../include/hp_state.h"
+#include "../include/output_capture.h"
+#include "../include/timebase.h"
 #include "../include/math_utils.h"
+#include "../include/engine_layout.h"
+#include "../include/mcpwm_output.h"
 
-static const float g_cyl_tdc_deg[4] = {0.0f, 180.0f, 360.0f, 540.0f};
-
-static float apply_temp_dwell_bias(float battery_voltage, int16_t clt_c) {
-    if (clt_c >= 105) {
-        battery_voltage += 1.0f;
-    } else if (clt_c >= 95) {
-        battery_voltage += 0.5f;
-    } else if (clt_c <= 0) {
-        battery_voltage -= 0.7f;
-    } else if (clt_c <= 20) {
-        battery_voltage -= 0.4f;
-    }
-    return clamp_float(battery_voltage, 8.0f, 16.5f);
-}
-
-static float compute_current_angle_deg(const sync_data_t *sync, uint32_t tooth_count) {
-    float degrees_per_tooth = 360.0f / (float)(tooth_count + 2);
-    float current_angle = (sync->revolution_index * 360.0f) + (sync->tooth_index * degrees_per_tooth);
-    return wrap_angle_720(current_angle);
-}
-
-static float sync_us_per_degree(const sync_data_t *sync, const sync_config_t *cfg) {
-    if (!sync || !cfg || sync->tooth_period == 0U || cfg->tooth_count == 0U) {
-        return 0.0f;
-    }
-    uint32_t total_positions = cfg->tooth_count + 2U;
-    return ((float)sync->tooth_period * (float)total_positions) / 360.0f;
+// Refino na ISR de dente: a faísca vai para o novo alvo com o mesmo dwell
+IRAM_ATTR static bool ignition_isr_write(uint64_t target_us, const angle_event_detail_t *detail) {
+    return mcpwm_ignition_hp_schedule_at(detail->channel, target_us, detail->width_us[0]);
 }
 
 bool ignition_init(void) {
@@ -55,15 +37,37 @@ bool ignition_init(void) {
         return false;
     }
     
-    // Inicializar drivers HP
+    // Captura das bordas de saída antes dos drivers (bobinas registram primeiro)
+    esp_err_t cap_err = output_capture_init();
+    if (cap_err != ESP_OK) {
+        LOG_IGNITION_W("Output edge capture unavailable: %s", esp_err_to_name(cap_err));
+    }
+
+    // Base de tempo compartilhada antes dos timers MCPWM se amarrarem a ela
+    esp_err_t tb_err = timebase_init();
+    if (tb_err != ESP_OK) {
+        LOG_IGNITION_E("Failed to initialize shared timebase: %s", esp_err_to_name(tb_err));
+        return false;
+    }
+
+    // Pool de saídas: um injetor por cilindro mais as bobinas do layout
+    uint8_t outputs = (uint8_t)(engine_layout_cylinders() + engine_layout_coils());
+    esp_err_t out_err = mcpwm_output_init(outputs);
+    if (out_err != ESP_OK) {
+        LOG_IGNITION_E("Failed to reserve %u MCPWM outputs: %s", outputs, esp_err_to_name(out_err));
+        return false;
+    }
+
+    // Inicializar drivers HP (bobinas primeiro: ficam com os operadores dedicados)
     bool ign_ok = mcpwm_ignition_hp_init();
     bool inj_ok = mcpwm_injection_hp_init();
     
     if (ign_ok && inj_ok) {
+        angle_scheduler_set_writer(ANGLE_EVENT_SPARK, ignition_isr_write);
         LOG_IGNITION_I("HP Ignition timing system initialized");
         LOG_IGNITION_I("  Phase predictor: active (centralized)");
         LOG_IGNITION_I("  Hardware latency compensation: active (centralized)");
-        LOG_IGNITION_I("  Jitter measurement: active (centralized)");
+        LOG_IGNITION_I("  Jitter measurement: output edge capture");
         return true;
     }
 
@@ -71,51 +75,66 @@ bool ignition_init(void) {
     return false;
 }
 
-void ignition_apply_timing(uint16_t advance_deg10, uint16_t rpm) {
-    float advance_degrees = advance_deg10 / 10.0f;
+// advance_deg10: one advance per cylinder (index = cylinder - 1)
+// dwell_us: coil charge time of the plan, written as is
+// angle_domain: go through the angle scheduler instead of writing every coil
+// sync: snapshot of the caller's pass, NULL to take one here
+static void ignition_schedule(const uint16_t advance_deg10[ENGINE_MAX_CYLINDERS], uint16_t dwell_us, bool angle_domain,
+                              const sync_snapshot_t *sync) {
     float battery_voltage = 13.5f;
 
+    // Tensão só para a latência da bobina; o dwell já vem pronto
     sensor_data_t sensors = {0};
-    if (sensor_get_data_fast(&sensors) == ESP_OK) {
-        if (sensors.vbat_dv > 0) {
-            battery_voltage = sensors.vbat_dv / 10.0f;
-        }
-        battery_voltage = apply_temp_dwell_bias(battery_voltage, sensors.clt_c);
-    } else {
-        battery_voltage = clamp_float(battery_voltage, 8.0f, 16.5f);
+    if (sensor_get_data_fast(&sensors) == ESP_OK && sensors.vbat_dv > 0) {
+        battery_voltage = sensors.vbat_dv / 10.0f;
     }
+    battery_voltage = clamp_float(battery_voltage, 8.0f, 16.5f);
 
-    sync_data_t sync_data = {0};
-    sync_config_t sync_cfg = {0};
-    bool have_sync = (sync_get_data(&sync_data) == ESP_OK) &&
-                     (sync_get_config(&sync_cfg) == ESP_OK) &&
-                     sync_data.sync_valid &&
-                     sync_data.sync_acquired &&
-                     (sync_cfg.tooth_count > 0);
+    sync_snapshot_t sync_data = {0};
+    if (sync != NULL) {
+        sync_data = *sync;
+    } else if (sync_get_snapshot(&sync_data) != ESP_OK) {
+        sync_data.flags = 0;
+    }
+    bool have_sync = sync_snapshot_acquired(&sync_data);
     
     float us_per_deg = 0.0f;
-    uint32_t current_counter = 0;
 
     if (have_sync) {
-        us_per_deg = sync_us_per_degree(&sync_data, &sync_cfg);
+        us_per_deg = sync_us_per_degree(&sync_data);
         if (us_per_deg <= 0.0f) {
             have_sync = false;
-        } else {
-            // Obter contador atual do timer MCPWM (valor real, não sintético)
-            // Usa cilindro 0 como referência (todos os timers estão sincronizados)
-            current_counter = mcpwm_ignition_hp_get_counter(0);
         }
     }
 
     if (have_sync) {
-        float current_angle = compute_current_angle_deg(&sync_data, sync_cfg.tooth_count);
-        
-        for (uint8_t cylinder = 1; cylinder <= 4; cylinder++) {
-            float spark_deg = wrap_angle_720(g_cyl_tdc_deg[cylinder - 1] - advance_degrees);
+        float current_angle = sync_cycle_angle_deg(&sync_data);
+        float deg_per_tooth = sync_tooth_pitch_deg(&sync_data);
+        uint8_t cylinders = engine_layout_cylinders();
+        float dist_deg[ENGINE_MAX_CYLINDERS];
+        float spark_angle[ENGINE_MAX_CYLINDERS];
+        for (uint8_t cylinder = 1; cylinder <= cylinders; cylinder++) {
+            float advance_degrees = advance_deg10[cylinder - 1] / 10.0f;
+            float spark_deg = wrap_angle_720(engine_layout_tdc_deg(cylinder) - advance_degrees);
             float delta_deg = spark_deg - current_angle;
             if (delta_deg < 0.0f) {
                 delta_deg += 720.0f;
             }
+            dist_deg[cylinder - 1] = delta_deg;
+            spark_angle[cylinder - 1] = spark_deg;
+        }
+
+        for (uint8_t cylinder = 1; cylinder <= cylinders; cylinder++) {
+            float delta_deg = dist_deg[cylinder - 1];
+            uint8_t coil = engine_layout_coil(cylinder);
+
+            // Centelha perdida: a bobina segue só a próxima faísca do par
+            bool coil_owner = true;
+            for (uint8_t other = 1; other <= cylinders; other++) {
+                if (other != cylinder && engine_layout_coil(other) == coil && dist_deg[other - 1] < delta_deg) {
+                    coil_owner = false;
+                }
+            }
             
             // Calcular delay usando predição de fase centralizada
             float predicted_period = hp_state_predict_next_period(0);
@@ -126,29 +145,58 @@ void ignition_apply_timing(uint16_t advance_deg10, uint16_t rpm) {
             float latency = hp_state_get_latency(battery_voltage, (float)sensors.clt_c);
             compensated_delay += latency;
             
-            // Calcular target absoluto
+            // Target na base de tempo compartilhada, a partir da captura do dente
             uint32_t delay_us = (uint32_t)(compensated_delay + 0.5f);
-            uint32_t target_us = current_counter + delay_us;
+            uint64_t spark_us = sync_data.capture_time_us + delay_us;
             
+            if (angle_domain) {
+                angle_event_action_t action = angle_scheduler_plan(ANGLE_EVENT_SPARK, cylinder,
+                                                                   delta_deg, deg_per_tooth,
+                                                                   (uint32_t)spark_us);
+                // Sem commit o evento fica desarmado até a bobina ser dele
+                if (action != ANGLE_EVENT_HOLD && coil_owner) {
+                    bool written = mcpwm_ignition_hp_schedule_at(coil, spark_us, dwell_us);
+                    // Ângulo da faísca e latência fixa para o refino na ISR
+                    angle_event_detail_t detail = {
+                        .event_angle = (uint32_t)(spark_angle[cylinder - 1] * (float)SYNC_ANGLE_SCALE + 0.5f) %
+                                       SYNC_ANGLE_CYCLE,
+                        .lead_us = (int32_t)(latency + ((latency >= 0.0f) ? 0.5f : -0.5f)),
+                        .channel = coil,
+                        .count = 1,
+                        .width_us = {dwell_us},
+                    };
+                    angle_scheduler_commit(ANGLE_EVENT_SPARK, cylinder, action, (uint32_t)spark_us,
+                                           sync_data.capture_time_us, written, &detail);
+                }
+                continue;
+            }
+
             // Agendar com compare absoluto HP
-            mcpwm_ignition_hp_schedule_one_shot_absolute(
-                cylinder, target_us, rpm, battery_voltage, current_counter);
+            if (coil_owner) {
+                mcpwm_ignition_hp_schedule_at(coil, spark_us, dwell_us);
+            }
         }
         
         // Atualizar preditor de fase centralizado
         float measured_period = sync_data.tooth_period;
         hp_state_update_phase_predictor(measured_period, hp_get_cycle_count());
         
-        LOG_IGNITION_D("HP Scheduled ignition (sync): %u deg10, %u RPM", advance_deg10, rpm);
+        LOG_IGNITION_D("HP Scheduled ignition (sync): %u deg10 (cyl 1), dwell %u us", advance_deg10[0], dwell_us);
         return;
     }
     
     // Fallback: usar predição de fase centralizada
+    if (angle_domain) {
+        angle_scheduler_reset();
+    }
     float predicted_period = hp_state_predict_next_period(0);
     uint32_t period_us = (uint32_t)(predicted_period + 0.5f);
     
-    for (uint8_t cylinder = 1; cylinder <= 4; cylinder++) {
-        float spark_deg = wrap_angle_720(g_cyl_tdc_deg[cylinder - 1] - advance_degrees);
+    // Uma faísca por bobina, no cilindro que ela dispara primeiro no ciclo
+    for (uint8_t coil = 1; coil <= engine_layout_coils(); coil++) {
+        uint8_t cylinder = engine_layout_coil_cylinder(coil);
+        float advance_degrees = advance_deg10[cylinder - 1] / 10.0f;
+        float spark_deg = wrap_angle_720(engine_layout_tdc_deg(cylinder) - advance_degrees);
         float delay_deg = (spark_deg >= 0.0f) ? spark_deg : spark_deg + 720.0f;
         
         float us_per_rev = period_us * 2;  // Uma revolução = 2 períodos de 360°
@@ -156,10 +204,36 @@ void ignition_apply_timing(uint16_t advance_deg10, uint16_t rpm) {
         uint32_t delay_us = (uint32_t)(delay_us_f + 0.5f);
         
         mcpwm_ignition_hp_schedule_one_shot_absolute(
-            cylinder, delay_us, rpm, battery_voltage, 0);
+            coil, delay_us, dwell_us, 0);
     }
     
-    LOG_IGNITION_D("HP Applied ignition timing (fallback): %u deg10, %u RPM", advance_deg10, rpm);
+    LOG_IGNITION_D("HP Applied ignition timing (fallback): %u deg10 (cyl 1), dwell %u us", advance_deg10[0], dwell_us);
+}
+
+static void fill_advance(uint16_t advance[ENGINE_MAX_CYLINDERS], uint16_t advance_deg10) {
+    for (uint8_t i = 0; i < ENGINE_MAX_CYLINDERS; i++) {
+        advance[i] = advance_deg10;
+    }
+}
+
+void ignition_apply_timing(uint16_t advance_deg10, uint16_t dwell_us) {
+    uint16_t advance[ENGINE_MAX_CYLINDERS];
+    fill_advance(advance, advance_deg10);
+    ignition_schedule(advance, dwell_us, false, NULL);
+}
+
+void ignition_schedule_angle(uint16_t advance_deg10, uint16_t dwell_us) {
+    uint16_t advance[ENGINE_MAX_CYLINDERS];
+    fill_advance(advance, advance_deg10);
+    ignition_schedule(advance, dwell_us, true, NULL);
+}
+
+void ignition_schedule_angle_cyl(const uint16_t advance_deg10[ENGINE_MAX_CYLINDERS], uint16_t dwell_us,
+                                 const sync_snapshot_t *sync) {
+    if (advance_deg10 == NULL) {
+        return;
+    }
+    ignition_schedule(advance_deg10, dwell_us, true, sync);
 }
 
 void ignition_get_jitter_stats(float *avg_us, float *max_us, float *min_us) {
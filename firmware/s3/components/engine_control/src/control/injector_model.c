@@ -0,0 +1,129 @@
+#include "../include/injector_model.h"
+#include "../include/math_utils.h"
+#include <math.h>
+#include <string.h>
+
+// 8 .. 16 V, typical high impedance (EV14 class) injector at 3 bar
+static const uint16_t DEFAULT_VBAT_BINS_DV[INJECTOR_DEAD_TIME_BINS] = {80, 100, 110, 120, 130, 140, 150, 160};
+static const uint16_t DEFAULT_DEAD_TIME_US[INJECTOR_DEAD_TIME_BINS] = {2100, 1400, 1150, 950, 820, 720, 640, 580};
+static const uint16_t DEFAULT_SHORT_PULSE_BINS_US[INJECTOR_SHORT_PULSE_BINS] = {0, 250, 500, 750, 1000, 1500, 2000, 2500};
+
+// Dead time per 0.1 V from INJECTOR_VBAT_MIN_DV, built from one curve generation
+static uint16_t g_dead_time_lut[INJECTOR_VBAT_BUCKETS];
+static uint32_t g_lut_generation = 0;
+static bool g_lut_valid = false;
+
+static injector_model_config_t g_default_cfg;
+static bool g_default_ready = false;
+
+void injector_model_init_defaults(injector_model_config_t *cfg) {
+    if (!cfg) {
+        return;
+    }
+    injector_dead_time_curve_init(&cfg->dead_time, DEFAULT_VBAT_BINS_DV, INJECTOR_DEAD_TIME_BINS, 0);
+    memcpy(cfg->dead_time.values, DEFAULT_DEAD_TIME_US, sizeof(cfg->dead_time.values));
+    injector_dead_time_curve_commit(&cfg->dead_time);
+    injector_short_pulse_curve_init(&cfg->short_pulse, DEFAULT_SHORT_PULSE_BINS_US, INJECTOR_SHORT_PULSE_BINS,
+                                    INJECTOR_SHORT_PULSE_ZERO);
+}
+
+bool injector_model_validate(const injector_model_config_t *cfg) {
+    if (!cfg || !injector_dead_time_curve_validate(&cfg->dead_time) ||
+        !injector_short_pulse_curve_validate(&cfg->short_pulse)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < INJECTOR_DEAD_TIME_BINS; i++) {
+        if (cfg->dead_time.values[i] > INJECTOR_DEAD_TIME_MAX_US) {
+            return false;
+        }
+    }
+    for (uint8_t i = 0; i < INJECTOR_SHORT_PULSE_BINS; i++) {
+        if (cfg->short_pulse.values[i] > (2U * INJECTOR_SHORT_PULSE_ZERO)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void dead_time_lut_build(const injector_dead_time_curve_t *curve) {
+    for (uint32_t b = 0; b < INJECTOR_VBAT_BUCKETS; b++) {
+        g_dead_time_lut[b] = injector_dead_time_curve_interpolate(curve, NULL, (uint16_t)(INJECTOR_VBAT_MIN_DV + b));
+    }
+    g_lut_generation = curve->generation;
+    g_lut_valid = true;
+}
+
+void injector_model_prepare(const injector_model_config_t *cfg, uint16_t vbat_dv, injector_comp_t *out) {
+    if (!out) {
+        return;
+    }
+    if (!cfg) {
+        if (!g_default_ready) {
+            injector_model_init_defaults(&g_default_cfg);
+            g_default_ready = true;
+        }
+        cfg = &g_default_cfg;
+    }
+    if (!g_lut_valid || g_lut_generation != cfg->dead_time.generation) {
+        dead_time_lut_build(&cfg->dead_time);
+    }
+
+    if (vbat_dv == 0U) {
+        vbat_dv = INJECTOR_VBAT_NOMINAL_DV;
+    }
+    uint16_t v = vbat_dv;
+    if (v < INJECTOR_VBAT_MIN_DV) {
+        v = INJECTOR_VBAT_MIN_DV;
+    } else if (v > INJECTOR_VBAT_MAX_DV) {
+        v = INJECTOR_VBAT_MAX_DV;
+    }
+    out->vbat_dv = vbat_dv;
+    out->dead_time_us = g_dead_time_lut[v - INJECTOR_VBAT_MIN_DV];
+    for (uint8_t i = 0; i < INJECTOR_SHORT_PULSE_BINS; i++) {
+        out->short_bins_us[i] = cfg->short_pulse.x_bins[i];
+        out->short_corr_us[i] = (int16_t)((int32_t)cfg->short_pulse.values[i] - (int32_t)INJECTOR_SHORT_PULSE_ZERO);
+    }
+}
+
+static int32_t short_pulse_correction(const injector_comp_t *comp, uint32_t fuel_us) {
+    const uint8_t last = INJECTOR_SHORT_PULSE_BINS - 1U;
+    if (fuel_us >= comp->short_bins_us[last]) {
+        return comp->short_corr_us[last];
+    }
+    if (fuel_us <= comp->short_bins_us[0]) {
+        return comp->short_corr_us[0];
+    }
+    uint8_t i = 1;
+    while (fuel_us > comp->short_bins_us[i]) {
+        i++;
+    }
+    int32_t x0 = comp->short_bins_us[i - 1U];
+    int32_t x1 = comp->short_bins_us[i];
+    int32_t y0 = comp->short_corr_us[i - 1U];
+    int32_t y1 = comp->short_corr_us[i];
+    int32_t dx = (int32_t)fuel_us - x0;
+    int32_t span = x1 - x0;
+    int32_t num = (y1 - y0) * dx;
+    // Rounded to nearest, symmetric for negative slopes
+    return y0 + ((num >= 0) ? (num + span / 2) : (num - span / 2)) / span;
+}
+
+uint32_t injector_model_pulse_us(const injector_comp_t *comp, uint32_t fuel_us) {
+    if (!comp) {
+        return fuel_us;
+    }
+    int64_t pulse = (int64_t)fuel_us + comp->dead_time_us + short_pulse_correction(comp, fuel_us);
+    if (pulse < 0) {
+        return 0;
+    }
+    return (pulse > UINT32_MAX) ? UINT32_MAX : (uint32_t)pulse;
+}
+
+uint16_t injector_model_short_to_raw(float correction_us) {
+    float v = clamp_float(correction_us, INJECTOR_SHORT_PULSE_MIN_US, INJECTOR_SHORT_PULSE_MAX_US);
+    return (uint16_t)lroundf((float)INJECTOR_SHORT_PULSE_ZERO + v);
+}
+
+float injector_model_short_from_raw(uint16_t raw) {
+    return (float)raw - (float)INJECTOR_SHORT_PULSE_ZERO;
+}
@@ -0,0 +1,66 @@
+#include "../include/latency_hist.h"
+#include <string.h>
+
+// p50, p95, p99, p99.9 in 1/10000
+static const uint32_t SUMMARY_QUANTILES[4] = {5000U, 9500U, 9900U, 9990U};
+
+void latency_hist_reset(latency_hist_t *h) {
+    if (!h) {
+        return;
+    }
+    for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        __atomic_store_n(&h->counts[i], 0U, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&h->overflow, 0U, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->total, 0U, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->max, 0U, __ATOMIC_RELAXED);
+}
+
+uint32_t latency_hist_bucket_max(uint32_t bucket) {
+    if (bucket < 2U * LATENCY_HIST_SUB_COUNT) {
+        return bucket;
+    }
+    uint32_t shift = bucket / LATENCY_HIST_SUB_COUNT - 1U;
+    uint32_t mantissa = bucket % LATENCY_HIST_SUB_COUNT + LATENCY_HIST_SUB_COUNT;
+    return ((mantissa + 1U) << shift) - 1U;
+}
+
+void latency_hist_summary(const latency_hist_t *h, latency_summary_t *out) {
+    if (!out) {
+        return;
+    }
+    memset(out, 0, sizeof(*out));
+    if (!h) {
+        return;
+    }
+    out->max = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+    out->overflow = __atomic_load_n(&h->overflow, __ATOMIC_RELAXED);
+
+    // Ranks come from the buckets themselves so they add up even when
+    // recorders run concurrently; total may be a few samples ahead
+    uint64_t total = out->overflow;
+    for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        total += __atomic_load_n(&h->counts[i], __ATOMIC_RELAXED);
+    }
+    out->count = (total > UINT32_MAX) ? UINT32_MAX : (uint32_t)total;
+    if (total == 0U) {
+        return;
+    }
+
+    uint32_t *results[4] = {&out->p50, &out->p95, &out->p99, &out->p999};
+    uint64_t ranks[4];
+    for (uint32_t q = 0; q < 4U; q++) {
+        ranks[q] = (total * SUMMARY_QUANTILES[q] + 9999U) / 10000U;
+        *results[q] = out->max;  // Falls in the overflow unless found below
+    }
+    uint64_t cumulative = 0;
+    uint32_t q = 0;
+    for (uint32_t i = 0; i < LATENCY_HIST_BUCKETS && q < 4U; i++) {
+        cumulative += __atomic_load_n(&h->counts[i], __ATOMIC_RELAXED);
+        while (q < 4U && cumulative >= ranks[q]) {
+            uint32_t v = latency_hist_bucket_max(i);
+            *results[q] = (v < out->max) ? v : out->max;
+            q++;
+        }
+    }
+}
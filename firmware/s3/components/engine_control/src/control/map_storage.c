@@ -2,18 +2,116 @@
 #include "../include/config_manager.h"
 #include "esp_err.h"
 #include "esp_rom_crc.h"
+#include <stddef.h>
+#include <string.h>
 
 #define MAP_STORAGE_KEY "fuel_maps"
+// Version 1 is the original 3 x (16 x 16) layout. Other map sizes get a
+// version that encodes every dimension, so a blob saved with different sizes
+// is rejected even when its byte size happens to match.
+#define MAP_STORAGE_DEFAULT_LAYOUT                                          \
+    (VE_TABLE_RPM_BINS == 16 && VE_TABLE_LOAD_BINS == 16 &&                 \
+     IGN_TABLE_RPM_BINS == 16 && IGN_TABLE_LOAD_BINS == 16 &&               \
+     LAMBDA_TABLE_RPM_BINS == 16 && LAMBDA_TABLE_LOAD_BINS == 16)
+#if MAP_STORAGE_DEFAULT_LAYOUT
 #define MAP_STORAGE_VERSION 1U
+#else
+#define MAP_STORAGE_VERSION (0x80000000U |                                  \
+    ((uint32_t)VE_TABLE_RPM_BINS << 25) | ((uint32_t)VE_TABLE_LOAD_BINS << 20) |  \
+    ((uint32_t)IGN_TABLE_RPM_BINS << 15) | ((uint32_t)IGN_TABLE_LOAD_BINS << 10) | \
+    ((uint32_t)LAMBDA_TABLE_RPM_BINS << 5) | (uint32_t)LAMBDA_TABLE_LOAD_BINS)
+#endif
+
+// Tables are stored back to back without their runtime generation, which
+// keeps the blob identical to the original layout.
+#define MAP_STORAGE_VE_SIZE TABLE_PERSIST_SIZE(fuel_ve_map_t)
+#define MAP_STORAGE_IGN_SIZE TABLE_PERSIST_SIZE(fuel_ign_map_t)
+#define MAP_STORAGE_LAMBDA_SIZE TABLE_PERSIST_SIZE(fuel_lambda_map_t)
+#define MAP_STORAGE_DATA_SIZE (MAP_STORAGE_VE_SIZE + MAP_STORAGE_IGN_SIZE + MAP_STORAGE_LAMBDA_SIZE)
 
 typedef struct {
     uint32_t version;
-    fuel_calc_maps_t maps;
+    uint8_t data[MAP_STORAGE_DATA_SIZE];
     uint32_t crc32;
 } map_storage_blob_t;
 
+#define MAP_STORAGE_TRIM_KEY "cyl_trims"
+#define MAP_STORAGE_TRIM_VERSION 2U  // 2: one layer per cylinder up to ENGINE_MAX_CYLINDERS
+#define MAP_STORAGE_TRIM_SIZE TABLE_PERSIST_SIZE(cyl_trim_map_t)
+
+typedef struct {
+    uint32_t version;
+    uint8_t data[MAP_STORAGE_TRIM_SIZE * 2U];
+    uint32_t crc32;
+} map_storage_trim_blob_t;
+
+// Too large for a task stack; callers serialize on the map mutex or run at init
+static map_storage_trim_blob_t g_trim_blob;
+
+#define MAP_STORAGE_SPLIT_KEY "split_inj"
+#define MAP_STORAGE_SPLIT_VERSION 1U
+#define MAP_STORAGE_SPLIT_SIZE TABLE_PERSIST_SIZE(split_ratio_map_t)
+
+typedef struct {
+    uint32_t version;
+    uint8_t data[MAP_STORAGE_SPLIT_SIZE];
+    uint16_t gap_us;
+    uint16_t min_pulse_us;
+    uint32_t crc32;
+} map_storage_split_blob_t;
+
+#define MAP_STORAGE_INJECTOR_KEY "inj_model"
+#define MAP_STORAGE_INJECTOR_VERSION 1U
+#define MAP_STORAGE_DEAD_TIME_SIZE TABLE_PERSIST_SIZE(injector_dead_time_curve_t)
+#define MAP_STORAGE_SHORT_PULSE_SIZE TABLE_PERSIST_SIZE(injector_short_pulse_curve_t)
+
+typedef struct {
+    uint32_t version;
+    uint8_t data[MAP_STORAGE_DEAD_TIME_SIZE + MAP_STORAGE_SHORT_PULSE_SIZE];
+    uint32_t crc32;
+} map_storage_injector_blob_t;
+
+#define MAP_STORAGE_DWELL_KEY "dwell_cfg"
+#define MAP_STORAGE_DWELL_VERSION 1U
+#define MAP_STORAGE_DWELL_SIZE TABLE_PERSIST_SIZE(dwell_map_t)
+
+typedef struct {
+    uint32_t version;
+    uint8_t data[MAP_STORAGE_DWELL_SIZE];
+    dwell_coil_t coil;
+    uint16_t max_duty_x10;
+    uint16_t min_off_us;
+    uint32_t crc32;
+} map_storage_dwell_blob_t;
+
+static uint32_t map_storage_dwell_crc(const map_storage_dwell_blob_t *blob) {
+    return esp_rom_crc32_le(0, (const uint8_t *)blob, (uint32_t)offsetof(map_storage_dwell_blob_t, crc32));
+}
+
+static uint32_t map_storage_split_crc(const map_storage_split_blob_t *blob) {
+    return esp_rom_crc32_le(0, (const uint8_t *)blob, (uint32_t)offsetof(map_storage_split_blob_t, crc32));
+}
+
 static uint32_t map_storage_crc(const map_storage_blob_t *blob) {
-    return esp_rom_crc32_le(0, (const uint8_t *)&blob->maps, (uint32_t)sizeof(blob->maps));
+    return esp_rom_crc32_le(0, blob->data, (uint32_t)sizeof(blob->data));
+}
+
+static void map_storage_pack(map_storage_blob_t *blob, const fuel_calc_maps_t *maps) {
+    uint8_t *p = blob->data;
+    memcpy(p, &maps->fuel_table, MAP_STORAGE_VE_SIZE);
+    p += MAP_STORAGE_VE_SIZE;
+    memcpy(p, &maps->ignition_table, MAP_STORAGE_IGN_SIZE);
+    p += MAP_STORAGE_IGN_SIZE;
+    memcpy(p, &maps->lambda_table, MAP_STORAGE_LAMBDA_SIZE);
+}
+
+static void map_storage_unpack(fuel_calc_maps_t *maps, const map_storage_blob_t *blob) {
+    const uint8_t *p = blob->data;
+    memcpy(&maps->fuel_table, p, MAP_STORAGE_VE_SIZE);
+    p += MAP_STORAGE_VE_SIZE;
+    memcpy(&maps->ignition_table, p, MAP_STORAGE_IGN_SIZE);
+    p += MAP_STORAGE_IGN_SIZE;
+    memcpy(&maps->lambda_table, p, MAP_STORAGE_LAMBDA_SIZE);
 }
 
 esp_err_t map_storage_load(fuel_calc_maps_t *maps) {
@@ -36,7 +134,17 @@ esp_err_t map_storage_load(fuel_calc_maps_t *maps) {
         return ESP_ERR_INVALID_CRC;
     }
 
-    *maps = blob.maps;
+    fuel_calc_maps_t loaded = {0};
+    map_storage_unpack(&loaded, &blob);
+    if (!fuel_calc_validate_maps(&loaded)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Fresh generations so no cache built from the previous maps is reused
+    fuel_ve_map_touch(&loaded.fuel_table);
+    fuel_ign_map_touch(&loaded.ignition_table);
+    fuel_lambda_map_touch(&loaded.lambda_table);
+    *maps = loaded;
     return ESP_OK;
 }
 
@@ -47,10 +155,190 @@ esp_err_t map_storage_save(const fuel_calc_maps_t *maps) {
 
     map_storage_blob_t blob = {
         .version = MAP_STORAGE_VERSION,
-        .maps = *maps,
         .crc32 = 0,
     };
+    map_storage_pack(&blob, maps);
     blob.crc32 = map_storage_crc(&blob);
 
     return config_manager_save(MAP_STORAGE_KEY, &blob, sizeof(blob));
 }
+
+esp_err_t map_storage_load_trims(cyl_trim_maps_t *trims) {
+    if (!trims) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    map_storage_trim_blob_t *blob = &g_trim_blob;
+    memset(blob, 0, sizeof(*blob));
+    esp_err_t err = config_manager_load(MAP_STORAGE_TRIM_KEY, blob, sizeof(*blob));
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (blob->version != MAP_STORAGE_TRIM_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (esp_rom_crc32_le(0, blob->data, (uint32_t)sizeof(blob->data)) != blob->crc32) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    // Unpacked in place: on failure the caller falls back to defaults
+    memcpy(&trims->fuel, blob->data, MAP_STORAGE_TRIM_SIZE);
+    memcpy(&trims->ignition, blob->data + MAP_STORAGE_TRIM_SIZE, MAP_STORAGE_TRIM_SIZE);
+    if (!cyl_trim_validate(trims)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    cyl_trim_map_touch(&trims->fuel);
+    cyl_trim_map_touch(&trims->ignition);
+    return ESP_OK;
+}
+
+esp_err_t map_storage_save_trims(const cyl_trim_maps_t *trims) {
+    if (!trims) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    map_storage_trim_blob_t *blob = &g_trim_blob;
+    blob->version = MAP_STORAGE_TRIM_VERSION;
+    memcpy(blob->data, &trims->fuel, MAP_STORAGE_TRIM_SIZE);
+    memcpy(blob->data + MAP_STORAGE_TRIM_SIZE, &trims->ignition, MAP_STORAGE_TRIM_SIZE);
+    blob->crc32 = esp_rom_crc32_le(0, blob->data, (uint32_t)sizeof(blob->data));
+
+    return config_manager_save(MAP_STORAGE_TRIM_KEY, blob, sizeof(*blob));
+}
+
+esp_err_t map_storage_load_split(split_injection_config_t *split) {
+    if (!split) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    map_storage_split_blob_t blob = {0};
+    esp_err_t err = config_manager_load(MAP_STORAGE_SPLIT_KEY, &blob, sizeof(blob));
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (blob.version != MAP_STORAGE_SPLIT_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (map_storage_split_crc(&blob) != blob.crc32) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    split_injection_config_t loaded = {0};
+    memcpy(&loaded.ratio, blob.data, MAP_STORAGE_SPLIT_SIZE);
+    loaded.gap_us = blob.gap_us;
+    loaded.min_pulse_us = blob.min_pulse_us;
+    if (!split_injection_validate(&loaded)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    split_ratio_map_touch(&loaded.ratio);
+    *split = loaded;
+    return ESP_OK;
+}
+
+esp_err_t map_storage_save_split(const split_injection_config_t *split) {
+    if (!split) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    map_storage_split_blob_t blob = {0};
+    blob.version = MAP_STORAGE_SPLIT_VERSION;
+    memcpy(blob.data, &split->ratio, MAP_STORAGE_SPLIT_SIZE);
+    blob.gap_us = split->gap_us;
+    blob.min_pulse_us = split->min_pulse_us;
+    blob.crc32 = map_storage_split_crc(&blob);
+
+    return config_manager_save(MAP_STORAGE_SPLIT_KEY, &blob, sizeof(blob));
+}
+
+esp_err_t map_storage_load_injector(injector_model_config_t *injector) {
+    if (!injector) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    map_storage_injector_blob_t blob = {0};
+    esp_err_t err = config_manager_load(MAP_STORAGE_INJECTOR_KEY, &blob, sizeof(blob));
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (blob.version != MAP_STORAGE_INJECTOR_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (esp_rom_crc32_le(0, blob.data, (uint32_t)sizeof(blob.data)) != blob.crc32) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    injector_model_config_t loaded = {0};
+    memcpy(&loaded.dead_time, blob.data, MAP_STORAGE_DEAD_TIME_SIZE);
+    memcpy(&loaded.short_pulse, blob.data + MAP_STORAGE_DEAD_TIME_SIZE, MAP_STORAGE_SHORT_PULSE_SIZE);
+    if (!injector_model_validate(&loaded)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    injector_dead_time_curve_touch(&loaded.dead_time);
+    injector_short_pulse_curve_touch(&loaded.short_pulse);
+    *injector = loaded;
+    return ESP_OK;
+}
+
+esp_err_t map_storage_save_injector(const injector_model_config_t *injector) {
+    if (!injector) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    map_storage_injector_blob_t blob = {0};
+    blob.version = MAP_STORAGE_INJECTOR_VERSION;
+    memcpy(blob.data, &injector->dead_time, MAP_STORAGE_DEAD_TIME_SIZE);
+    memcpy(blob.data + MAP_STORAGE_DEAD_TIME_SIZE, &injector->short_pulse, MAP_STORAGE_SHORT_PULSE_SIZE);
+    blob.crc32 = esp_rom_crc32_le(0, blob.data, (uint32_t)sizeof(blob.data));
+
+    return config_manager_save(MAP_STORAGE_INJECTOR_KEY, &blob, sizeof(blob));
+}
+
+esp_err_t map_storage_load_dwell(dwell_config_t *dwell) {
+    if (!dwell) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    map_storage_dwell_blob_t blob = {0};
+    esp_err_t err = config_manager_load(MAP_STORAGE_DWELL_KEY, &blob, sizeof(blob));
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (blob.version != MAP_STORAGE_DWELL_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (map_storage_dwell_crc(&blob) != blob.crc32) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    dwell_config_t loaded = {0};
+    memcpy(&loaded.map, blob.data, MAP_STORAGE_DWELL_SIZE);
+    loaded.coil = blob.coil;
+    loaded.max_duty_x10 = blob.max_duty_x10;
+    loaded.min_off_us = blob.min_off_us;
+    if (!dwell_control_validate(&loaded)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    dwell_map_touch(&loaded.map);
+    *dwell = loaded;
+    return ESP_OK;
+}
+
+esp_err_t map_storage_save_dwell(const dwell_config_t *dwell) {
+    if (!dwell) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    map_storage_dwell_blob_t blob = {0};
+    blob.version = MAP_STORAGE_DWELL_VERSION;
+    memcpy(blob.data, &dwell->map, MAP_STORAGE_DWELL_SIZE);
+    blob.coil = dwell->coil;
+    blob.max_duty_x10 = dwell->max_duty_x10;
+    blob.min_off_us = dwell->min_off_us;
+    blob.crc32 = map_storage_dwell_crc(&blob);
+
+    return config_manager_save(MAP_STORAGE_DWELL_KEY, &blob, sizeof(blob));
+}
@@ -0,0 +1,74 @@
+#include "../include/split_injection.h"
+#include "../include/math_utils.h"
+#include <math.h>
+
+static table_cache_t g_split_axes = {0};
+
+void split_injection_init_defaults(split_injection_config_t *cfg) {
+    if (!cfg) {
+        return;
+    }
+    split_ratio_map_init(&cfg->ratio, DEFAULT_RPM_BINS, 16, DEFAULT_LOAD_BINS, 16, SPLIT_INJ_SINGLE);
+    cfg->gap_us = SPLIT_INJ_DEFAULT_GAP_US;
+    cfg->min_pulse_us = SPLIT_INJ_DEFAULT_MIN_PULSE_US;
+}
+
+bool split_injection_validate(const split_injection_config_t *cfg) {
+    if (!cfg || !split_ratio_map_validate(&cfg->ratio)) {
+        return false;
+    }
+    if (cfg->gap_us < SPLIT_INJ_MIN_GAP_US || cfg->gap_us > SPLIT_INJ_MAX_GAP_US ||
+        cfg->min_pulse_us < SPLIT_INJ_MIN_PULSE_US) {
+        return false;
+    }
+    for (uint8_t y = 0; y < SPLIT_INJ_BINS; y++) {
+        for (uint8_t x = 0; x < SPLIT_INJ_BINS; x++) {
+            if (cfg->ratio.values[y][x] > SPLIT_INJ_SINGLE) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void split_injection_lookup(const split_injection_config_t *cfg, uint16_t rpm, uint16_t load,
+                            split_injection_t *out) {
+    if (!out) {
+        return;
+    }
+    if (!cfg) {
+        out->first_x1000 = SPLIT_INJ_SINGLE;
+        out->gap_us = SPLIT_INJ_DEFAULT_GAP_US;
+        out->min_pulse_us = SPLIT_INJ_DEFAULT_MIN_PULSE_US;
+        return;
+    }
+    out->first_x1000 = split_ratio_map_interpolate(&cfg->ratio, &g_split_axes, rpm, load);
+    out->gap_us = cfg->gap_us;
+    out->min_pulse_us = cfg->min_pulse_us;
+}
+
+uint8_t split_injection_pulses(const split_injection_t *split, uint32_t pw_us,
+                               uint32_t pulse_us[SPLIT_INJ_MAX_PULSES]) {
+    pulse_us[0] = pw_us;
+    if (!split || split->first_x1000 >= SPLIT_INJ_SINGLE) {
+        return 1;
+    }
+
+    uint32_t first = (uint32_t)(((uint64_t)pw_us * split->first_x1000 + (SPLIT_INJ_SINGLE / 2U)) / SPLIT_INJ_SINGLE);
+    uint32_t second = pw_us - first;
+    if (first < split->min_pulse_us || second < split->min_pulse_us) {
+        return 1;
+    }
+    pulse_us[0] = first;
+    pulse_us[1] = second;
+    return 2;
+}
+
+uint16_t split_injection_ratio_to_raw(float first_pct) {
+    float v = clamp_float(first_pct, SPLIT_INJ_MIN_FIRST_PCT, SPLIT_INJ_MAX_FIRST_PCT);
+    return (uint16_t)lroundf(v * 10.0f);
+}
+
+float split_injection_ratio_from_raw(uint16_t raw) {
+    return (float)raw / 10.0f;
+}
@@ -0,0 +1,115 @@
+#include "../include/spsc_ring.h"
+#include <string.h>
+
+#define SPSC_RING_FRESH 0x80000000U
+
+static inline uint8_t *slot(const spsc_ring_t *ring, uint32_t idx) {
+    return ring->slots + (size_t)idx * ring->item_size;
+}
+
+esp_err_t spsc_ring_init(spsc_ring_t *ring, spsc_ring_mode_t mode,
+                         void *storage, uint32_t item_size, uint32_t capacity) {
+    if (!ring || !storage || item_size == 0U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (mode == SPSC_RING_QUEUE) {
+        if (capacity < 2U || (capacity & (capacity - 1U)) != 0U) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    } else if (mode != SPSC_RING_MAILBOX || capacity != SPSC_RING_MAILBOX_SLOTS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->slots = storage;
+    ring->item_size = item_size;
+    ring->mask = capacity - 1U;
+    ring->mode = mode;
+    ring->back = 0;
+    ring->middle = 1;
+    ring->front = 2;
+    return ESP_OK;
+}
+
+bool spsc_ring_push(spsc_ring_t *ring, const void *item) {
+    if (ring->mode == SPSC_RING_MAILBOX) {
+        memcpy(slot(ring, ring->back), item, ring->item_size);
+        // Publishes the item and takes back whichever slot was in the middle
+        uint32_t old = __atomic_exchange_n(&ring->middle, ring->back | SPSC_RING_FRESH, __ATOMIC_ACQ_REL);
+        ring->back = old & ~SPSC_RING_FRESH;
+        if (old & SPSC_RING_FRESH) {
+            __atomic_store_n(&ring->superseded, ring->superseded + 1U, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&ring->pushed, ring->pushed + 1U, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    uint32_t head = ring->head;
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail > ring->mask) {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1U, __ATOMIC_RELAXED);
+        return false;
+    }
+    memcpy(slot(ring, head & ring->mask), item, ring->item_size);
+    __atomic_store_n(&ring->head, head + 1U, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->pushed, ring->pushed + 1U, __ATOMIC_RELAXED);
+    return true;
+}
+
+static bool mailbox_take(spsc_ring_t *ring, void *out) {
+    if ((__atomic_load_n(&ring->middle, __ATOMIC_ACQUIRE) & SPSC_RING_FRESH) == 0U) {
+        return false;
+    }
+    // Only the consumer clears the flag, so the slot taken is the fresh one
+    uint32_t old = __atomic_exchange_n(&ring->middle, ring->front, __ATOMIC_ACQ_REL);
+    ring->front = old & ~SPSC_RING_FRESH;
+    memcpy(out, slot(ring, ring->front), ring->item_size);
+    __atomic_store_n(&ring->popped, ring->popped + 1U, __ATOMIC_RELAXED);
+    return true;
+}
+
+bool spsc_ring_pop(spsc_ring_t *ring, void *out) {
+    if (ring->mode == SPSC_RING_MAILBOX) {
+        return mailbox_take(ring, out);
+    }
+    uint32_t tail = ring->tail;
+    if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail) {
+        return false;
+    }
+    memcpy(out, slot(ring, tail & ring->mask), ring->item_size);
+    __atomic_store_n(&ring->tail, tail + 1U, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->popped, ring->popped + 1U, __ATOMIC_RELAXED);
+    return true;
+}
+
+bool spsc_ring_pop_latest(spsc_ring_t *ring, void *out) {
+    if (ring->mode == SPSC_RING_MAILBOX) {
+        return mailbox_take(ring, out);
+    }
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return false;
+    }
+    // The producer cannot reach slot head - 1 again before tail moves
+    memcpy(out, slot(ring, (head - 1U) & ring->mask), ring->item_size);
+    __atomic_store_n(&ring->tail, head, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->popped, ring->popped + 1U, __ATOMIC_RELAXED);
+    return true;
+}
+
+uint32_t spsc_ring_depth(const spsc_ring_t *ring) {
+    if (ring->mode == SPSC_RING_MAILBOX) {
+        return (__atomic_load_n(&ring->middle, __ATOMIC_ACQUIRE) & SPSC_RING_FRESH) ? 1U : 0U;
+    }
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+void spsc_ring_get_stats(const spsc_ring_t *ring, spsc_ring_stats_t *out) {
+    if (!ring || !out) {
+        return;
+    }
+    out->pushed = __atomic_load_n(&ring->pushed, __ATOMIC_RELAXED);
+    out->popped = __atomic_load_n(&ring->popped, __ATOMIC_RELAXED);
+    out->dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    out->superseded = __atomic_load_n(&ring->superseded, __ATOMIC_RELAXED);
+}
@@ -1,14 +1,8 @@
 #include "../include/table_16x16.h"
 #include <string.h>
 
-static uint8_t find_bin_index(const uint16_t *bins, uint16_t value) {
-    for (uint8_t i = 0; i < 15; i++) {
-        if (value < bins[i + 1]) {
-            return i;
-        }
-    }
-    return 14;
-}
+// table_16x16_t is the persisted layout of the original maps; everything
+// below is the generic kernel in table_interp.h specialized for 16 x 16.
 
 void table_16x16_init(table_16x16_t *table,
                       const uint16_t *rpm_bins,
@@ -39,45 +33,59 @@ void table_16x16_init(table_16x16_t *table,
     table->checksum = table_16x16_checksum(table);
 }
 
-uint16_t table_16x16_interpolate(const table_16x16_t *table, uint16_t rpm, uint16_t load) {
-    if (!table) {
-        return 0;
-    }
-
-    uint8_t x = find_bin_index(table->rpm_bins, rpm);
-    uint8_t y = find_bin_index(table->load_bins, load);
-
-    uint16_t x0 = table->rpm_bins[x];
-    uint16_t x1 = table->rpm_bins[x + 1];
-    uint16_t y0 = table->load_bins[y];
-    uint16_t y1 = table->load_bins[y + 1];
+table_view_t table_16x16_view(const table_16x16_t *table) {
+    table_view_t view = {
+        .x_bins = table->rpm_bins,
+        .y_bins = table->load_bins,
+        .z_bins = NULL,
+        .values = &table->values[0][0],
+        .checksum = &table->checksum,
+        .nx = 16,
+        .ny = 16,
+        .nz = 1,
+    };
+    return view;
+}
 
-    float dx = 0.0f;
-    float dy = 0.0f;
-    if (x1 > x0) {
-        dx = (float)(rpm - x0) / (float)(x1 - x0);
-    }
-    if (y1 > y0) {
-        dy = (float)(load - y0) / (float)(y1 - y0);
+void table_16x16_recip_build(const table_16x16_t *table, table_16x16_recip_t *recip) {
+    if (!table || !recip) {
+        return;
     }
+    table_view_t view = table_16x16_view(table);
+    table_cache_build(&view, recip);
+}
 
-    float v00 = (float)table->values[y][x];
-    float v10 = (float)table->values[y][x + 1];
-    float v01 = (float)table->values[y + 1][x];
-    float v11 = (float)table->values[y + 1][x + 1];
-
-    float v0 = v00 + dx * (v10 - v00);
-    float v1 = v01 + dx * (v11 - v01);
-    float v = v0 + dy * (v1 - v0);
+static void locate(const table_16x16_t *table,
+                   const table_16x16_recip_t *recip,
+                   uint16_t rpm,
+                   uint16_t load,
+                   table_axis_pos_t *px,
+                   table_axis_pos_t *py) {
+    table_axis_locate(table->rpm_bins, 16, recip ? &recip->axis[0] : NULL, rpm, px);
+    table_axis_locate(table->load_bins, 16, recip ? &recip->axis[1] : NULL, load, py);
+}
 
-    if (v < 0.0f) {
-        v = 0.0f;
-    }
-    if (v > 65535.0f) {
-        v = 65535.0f;
+uint16_t table_16x16_interpolate_float(const table_16x16_t *table, uint16_t rpm, uint16_t load) {
+    if (!table) {
+        return 0;
     }
+    table_axis_pos_t px;
+    table_axis_pos_t py;
+    locate(table, NULL, rpm, load, &px, &py);
+    return table_eval_2d_float(&table->values[0][0], 16, &px, &py);
+}
 
-    return (uint16_t)(v + 0.5f);
+uint16_t table_16x16_interpolate_fixed(const table_16x16_t *table,
+                                       const table_16x16_recip_t *recip,
+                                       uint16_t rpm,
+                                       uint16_t load) {
+    if (!table) {
+        return 0;
+    }
+    table_axis_pos_t px;
+    table_axis_pos_t py;
+    locate(table, recip, rpm, load, &px, &py);
+    return table_eval_2d_fixed(&table->values[0][0], 16, &px, &py);
 }
 
 uint16_t table_16x16_checksum(const table_16x16_t *table) {
@@ -102,5 +110,6 @@ bool table_16x16_validate(const table_16x16_t *table) {
     if (!table) {
         return false;
     }
-    return table->checksum == table_16x16_checksum(table);
+    table_view_t view = table_16x16_view(table);
+    return table_view_validate(&view);
 }
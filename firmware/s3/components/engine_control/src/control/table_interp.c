@@ -0,0 +1,287 @@
+#include "../include/table_interp.h"
+#include <string.h>
+
+static uint32_t g_table_generation = 0;
+
+uint32_t table_next_generation(void) {
+    uint32_t gen = __atomic_add_fetch(&g_table_generation, 1, __ATOMIC_RELAXED);
+    if (gen == 0U) {
+        gen = __atomic_add_fetch(&g_table_generation, 1, __ATOMIC_RELAXED);
+    }
+    return gen;
+}
+
+static uint32_t span_recip(uint16_t lo, uint16_t hi) {
+    if (hi <= lo) {
+        return 0;
+    }
+    uint32_t span = (uint32_t)(hi - lo);
+    if (span == 1U) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)(((1ULL << 32) + (span / 2U)) / span);
+}
+
+static void axis_coarse_build(const uint16_t *bins, uint8_t count, table_axis_coarse_t *coarse) {
+    uint16_t last = bins[count - 1U];
+    uint32_t range = (last > bins[0]) ? (uint32_t)(last - bins[0]) : 0U;
+    uint8_t shift = 0;
+    while ((range >> shift) >= TABLE_AXIS_COARSE_SIZE) {
+        shift++;
+    }
+    coarse->shift = shift;
+    for (uint32_t k = 0; k < TABLE_AXIS_COARSE_SIZE; k++) {
+        uint32_t value = (uint32_t)bins[0] + (k << shift);
+        coarse->start[k] = table_axis_index_linear(bins, count,
+                                                   (value > 0xFFFFU) ? 0xFFFFU : (uint16_t)value);
+    }
+}
+
+void table_axis_cache_build(const uint16_t *bins, uint8_t count, table_axis_cache_t *cache) {
+    if (!bins || !cache || count < TABLE_AXIS_MIN_BINS || count > TABLE_AXIS_MAX_BINS) {
+        return;
+    }
+    memset(cache->recip, 0, sizeof(cache->recip));
+    for (uint8_t i = 0; i + 1U < count; i++) {
+        cache->recip[i] = span_recip(bins[i], bins[i + 1]);
+    }
+    axis_coarse_build(bins, count, &cache->coarse);
+}
+
+bool table_axis_is_monotonic(const uint16_t *bins, uint8_t count) {
+    if (!bins || count < TABLE_AXIS_MIN_BINS || count > TABLE_AXIS_MAX_BINS) {
+        return false;
+    }
+    for (uint8_t i = 0; i + 1U < count; i++) {
+        if (bins[i + 1] <= bins[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void table_axis_resample(uint16_t *dst, uint8_t count, const uint16_t *src, uint8_t src_count) {
+    if (!dst || count == 0U) {
+        return;
+    }
+    if (!src || src_count == 0U) {
+        memset(dst, 0, count * sizeof(uint16_t));
+        return;
+    }
+    if (count == src_count) {
+        memcpy(dst, src, count * sizeof(uint16_t));
+        return;
+    }
+    if (count == 1U || src_count == 1U) {
+        for (uint8_t i = 0; i < count; i++) {
+            dst[i] = src[0];
+        }
+        return;
+    }
+
+    // Position i of dst maps to fractional index i * (src_count - 1) / (count - 1)
+    // of src, so both ends are kept and the spacing follows src.
+    uint32_t den = (uint32_t)(count - 1U);
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t num = (uint32_t)i * (uint32_t)(src_count - 1U);
+        uint32_t j = num / den;
+        uint32_t rem = num % den;
+        if (j >= (uint32_t)(src_count - 1U)) {
+            dst[i] = src[src_count - 1U];
+            continue;
+        }
+        int32_t a = src[j];
+        int32_t b = src[j + 1U];
+        dst[i] = (uint16_t)(a + ((b - a) * (int32_t)rem + (int32_t)(den / 2U)) / (int32_t)den);
+    }
+}
+
+uint16_t table_checksum_words(const uint16_t *words, size_t count) {
+    if (!words) {
+        return 0;
+    }
+    uint32_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += words[i];
+    }
+    return (uint16_t)(sum & 0xFFFF);
+}
+
+static size_t view_cells(const table_view_t *view) {
+    return (size_t)view->nx * view->ny * view->nz;
+}
+
+static uint16_t view_checksum(const table_view_t *view) {
+    uint32_t sum = 0;
+    sum += table_checksum_words(view->x_bins, view->nx);
+    if (view->y_bins) {
+        sum += table_checksum_words(view->y_bins, view->ny);
+    }
+    if (view->z_bins) {
+        sum += table_checksum_words(view->z_bins, view->nz);
+    }
+    sum += table_checksum_words(view->values, view_cells(view));
+    return (uint16_t)(sum & 0xFFFF);
+}
+
+void table_cache_build(const table_view_t *view, table_cache_t *cache) {
+    if (!view || !cache) {
+        return;
+    }
+    table_axis_cache_build(view->x_bins, view->nx, &cache->axis[0]);
+    if (view->y_bins) {
+        table_axis_cache_build(view->y_bins, view->ny, &cache->axis[1]);
+    }
+    if (view->z_bins) {
+        table_axis_cache_build(view->z_bins, view->nz, &cache->axis[2]);
+    }
+    cache->generation = view->generation ? *view->generation : 0U;
+    cache->checksum = view->checksum ? *view->checksum : 0U;
+    cache->valid = true;
+}
+
+bool table_view_validate(const table_view_t *view) {
+    if (!view || !view->x_bins || !view->values || !view->checksum) {
+        return false;
+    }
+    if (!table_axis_is_monotonic(view->x_bins, view->nx)) {
+        return false;
+    }
+    if (view->y_bins && !table_axis_is_monotonic(view->y_bins, view->ny)) {
+        return false;
+    }
+    if (view->z_bins && !table_axis_is_monotonic(view->z_bins, view->nz)) {
+        return false;
+    }
+    return *view->checksum == view_checksum(view);
+}
+
+static bool axis_equal(const uint16_t *a, uint8_t na, const uint16_t *b, uint8_t nb) {
+    if (na != nb) {
+        return false;
+    }
+    if (!a || !b) {
+        return a == b;
+    }
+    return memcmp(a, b, na * sizeof(uint16_t)) == 0;
+}
+
+bool table_view_same_axes(const table_view_t *a, const table_view_t *b) {
+    if (!a || !b) {
+        return false;
+    }
+    return axis_equal(a->x_bins, a->nx, b->x_bins, b->nx) &&
+           axis_equal(a->y_bins, a->ny, b->y_bins, b->ny) &&
+           axis_equal(a->z_bins, a->nz, b->z_bins, b->nz);
+}
+
+uint16_t table_view_interpolate(const table_view_t *view,
+                                table_cache_t *cache,
+                                uint16_t x,
+                                uint16_t y,
+                                uint16_t z) {
+    if (!view || !view->x_bins || !view->values) {
+        return 0;
+    }
+    if (cache && (view->generation || view->checksum) && !table_cache_matches(cache, view)) {
+        table_cache_build(view, cache);
+    }
+
+    table_axis_pos_t px;
+    table_axis_locate(view->x_bins, view->nx, cache ? &cache->axis[0] : NULL, x, &px);
+    if (!view->y_bins) {
+        return table_eval_1d(view->values, &px);
+    }
+    table_axis_pos_t py;
+    table_axis_locate(view->y_bins, view->ny, cache ? &cache->axis[1] : NULL, y, &py);
+    if (!view->z_bins) {
+        return table_eval_2d(view->values, view->nx, &px, &py);
+    }
+    table_axis_pos_t pz;
+    table_axis_locate(view->z_bins, view->nz, cache ? &cache->axis[2] : NULL, z, &pz);
+    return table_eval_3d(view->values, view->nx, view->ny, &px, &py, &pz);
+}
+
+void table_multi_reset(table_multi_t *multi) {
+    if (multi) {
+        memset(multi, 0, sizeof(*multi));
+    }
+}
+
+// Generations are unique, so a table with a generation that moved to another
+// buffer (double-buffered map sets) is still the same table. Without one, a
+// different buffer is treated as a different table.
+static bool multi_same_table(const table_multi_t *multi, const table_view_t *views, uint8_t i) {
+    return (views[i].generation || multi->values[i] == views[i].values) &&
+           table_cache_matches(&multi->cache[i], &views[i]);
+}
+
+bool table_multi_is_bound(const table_multi_t *multi, const table_view_t *views, uint8_t count) {
+    if (!multi || !views || !multi->bound || multi->count != count) {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (!multi_same_table(multi, views, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rebuilds only the caches of tables that changed since the last call. The
+// shared flags depend on the axes, so they are recomputed for a changed table,
+// or for all tables when the first one changed.
+static void multi_bind(table_multi_t *multi, const table_view_t *views, uint8_t count) {
+    bool rebind = !multi->bound || multi->count != count;
+    multi->count = count;
+
+    bool first_changed = rebind || !multi_same_table(multi, views, 0);
+    for (uint8_t i = 0; i < count; i++) {
+        bool changed = rebind || !multi_same_table(multi, views, i);
+        multi->values[i] = views[i].values;
+        if (changed) {
+            table_cache_build(&views[i], &multi->cache[i]);
+        }
+        if (changed || first_changed) {
+            multi->shared[i] = (i == 0U) || table_view_same_axes(&views[0], &views[i]);
+        }
+    }
+    multi->bound = true;
+}
+
+uint8_t table_multi_interpolate(table_multi_t *multi,
+                                const table_view_t *views,
+                                uint8_t count,
+                                uint16_t x,
+                                uint16_t y,
+                                uint16_t *out) {
+    if (!multi || !views || !out || count == 0U || count > TABLE_MULTI_MAX) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (!views[i].x_bins || !views[i].y_bins || views[i].z_bins ||
+            !views[i].values || !views[i].checksum) {
+            return 0;
+        }
+    }
+
+    if (!table_multi_is_bound(multi, views, count)) {
+        multi_bind(multi, views, count);
+    }
+
+    table_axis_pos_t px;
+    table_axis_pos_t py;
+    table_axis_locate(views[0].x_bins, views[0].nx, &multi->cache[0].axis[0], x, &px);
+    table_axis_locate(views[0].y_bins, views[0].ny, &multi->cache[0].axis[1], y, &py);
+
+    uint8_t shared = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (multi->shared[i]) {
+            out[i] = table_eval_2d(views[i].values, views[i].nx, &px, &py);
+            shared++;
+        } else {
+            out[i] = table_view_interpolate(&views[i], &multi->cache[i], x, y, 0);
+        }
+    }
+    return shared;
+}
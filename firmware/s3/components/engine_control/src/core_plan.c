@@ -0,0 +1,292 @@
+#include "../include/core_plan.h"
+#include "esp_log.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <string.h>
+
+// The radio interrupt follows the Wi-Fi task; esp_timer dispatch would
+// preempt the scheduler from its ISR
+#if defined(CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_1) && (CORE_PLAN_CONTROL_CORE == 1)
+#error "Wi-Fi task pinned to the control core"
+#endif
+#if defined(CONFIG_ESP_TIMER_ISR_AFFINITY_CPU1) && (CORE_PLAN_CONTROL_CORE == 1)
+#error "esp_timer ISR pinned to the control core"
+#endif
+#if CORE_PLAN_CONTROL_CORE == CORE_PLAN_COMM_CORE
+#error "control and comm tasks share a core"
+#endif
+
+static const char *TAG = "CORE_PLAN";
+
+static const core_task_plan_t g_task_plan[CORE_TASK_COUNT] = {
+    [CORE_TASK_ENGINE_EXEC] = {"engine_exec", CONTROL_TASK_STACK, CONTROL_TASK_PRIORITY, CORE_PLAN_CONTROL_CORE},
+    [CORE_TASK_ENGINE_PLAN] = {"engine_plan", CONTROL_TASK_STACK, CONTROL_TASK_PRIORITY, CORE_PLAN_CONTROL_CORE},
+    [CORE_TASK_ENGINE_MON] = {"engine_mon", MONITOR_TASK_STACK, MONITOR_TASK_PRIORITY, MONITOR_TASK_CORE},
+    [CORE_TASK_SENSOR] = {"sensor_task", SENSOR_TASK_STACK, SENSOR_TASK_PRIORITY, SENSOR_TASK_CORE},
+    [CORE_TASK_TWAI_RX] = {"twai_rx", COMM_TASK_STACK, COMM_TASK_PRIORITY, CORE_PLAN_COMM_CORE},
+    [CORE_TASK_ESPNOW_TX] = {"espnow_tx", ESPNOW_TASK_STACK, ESPNOW_TASK_PRIORITY, CORE_PLAN_COMM_CORE},
+    [CORE_TASK_CLI] = {"cli", CLI_TASK_STACK, CLI_TASK_PRIORITY, CORE_PLAN_COMM_CORE},
+    [CORE_TASK_LOGGER] = {"logger", LOGGER_TASK_STACK, LOGGER_TASK_PRIORITY, CORE_PLAN_COMM_CORE},
+};
+
+static const char *const g_isr_names[CORE_ISR_COUNT] = {
+    [CORE_ISR_CKP] = "ckp",
+    [CORE_ISR_CMP] = "cmp",
+    [CORE_ISR_MCPWM] = "mcpwm",
+    [CORE_ISR_OUTPUT_CAPTURE] = "out_capture",
+};
+
+uint32_t g_core_plan_isr_runs[CORE_ISR_COUNT][CORE_PLAN_CORES];
+static TaskHandle_t g_planned[CORE_TASK_COUNT];
+
+typedef struct {
+    esp_err_t (*fn)(void);
+    esp_err_t result;
+    SemaphoreHandle_t done;
+} core_plan_call_t;
+
+const core_task_plan_t *core_plan_get_task(core_task_id_t id) {
+    return ((unsigned)id < CORE_TASK_COUNT) ? &g_task_plan[id] : NULL;
+}
+
+TaskHandle_t core_plan_get_handle(core_task_id_t id) {
+    return ((unsigned)id < CORE_TASK_COUNT) ? g_planned[id] : NULL;
+}
+
+BaseType_t core_plan_get_isr_core(core_isr_id_t isr) {
+    (void)isr;
+    return CORE_PLAN_CONTROL_CORE;
+}
+
+const char *core_plan_get_isr_name(core_isr_id_t isr) {
+    return ((unsigned)isr < CORE_ISR_COUNT) ? g_isr_names[isr] : "?";
+}
+
+esp_err_t core_plan_create_task(core_task_id_t id, TaskFunction_t fn, void *arg, TaskHandle_t *out_handle) {
+    const core_task_plan_t *plan = core_plan_get_task(id);
+    if (plan == NULL || fn == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    TaskHandle_t handle = NULL;
+    if (xTaskCreatePinnedToCore(fn, plan->name, plan->stack, arg, plan->priority, &handle, plan->core) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create %s", plan->name);
+        return ESP_ERR_NO_MEM;
+    }
+    g_planned[id] = handle;
+    if (out_handle) {
+        *out_handle = handle;
+    }
+    ESP_LOGI(TAG, "%s: core %d, priority %u", plan->name, (int)plan->core, (unsigned)plan->priority);
+    return ESP_OK;
+}
+
+static void core_plan_call_task(void *arg) {
+    core_plan_call_t *call = (core_plan_call_t *)arg;
+    call->result = call->fn();
+    xSemaphoreGive(call->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t core_plan_run_on_core(BaseType_t core, esp_err_t (*fn)(void)) {
+    if (fn == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (core == tskNO_AFFINITY || (BaseType_t)esp_cpu_get_core_id() == core) {
+        return fn();
+    }
+    core_plan_call_t call = {.fn = fn, .result = ESP_FAIL, .done = xSemaphoreCreateBinary()};
+    if (call.done == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreatePinnedToCore(core_plan_call_task, "core_init", CORE_PLAN_INIT_STACK, &call,
+                                uxTaskPriorityGet(NULL), NULL, core) != pdPASS) {
+        vSemaphoreDelete(call.done);
+        return ESP_ERR_NO_MEM;
+    }
+    xSemaphoreTake(call.done, portMAX_DELAY);
+    vSemaphoreDelete(call.done);
+    return call.result;
+}
+
+static uint16_t permille(uint64_t part, uint64_t whole) {
+    if (whole == 0U) {
+        return 0U;
+    }
+    uint64_t v = part * 1000U / whole;
+    return (uint16_t)((v > 1000U) ? 1000U : v);
+}
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+// One status array for every window; the mutex keeps the main task audit and
+// the monitor task profiler out of each other's sample
+static TaskStatus_t g_status[CORE_PLAN_AUDIT_TASKS];
+static SemaphoreHandle_t g_status_mutex;
+static portMUX_TYPE g_status_init_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static SemaphoreHandle_t status_mutex(void) {
+    if (g_status_mutex == NULL) {
+        SemaphoreHandle_t m = xSemaphoreCreateMutex();
+        portENTER_CRITICAL(&g_status_init_lock);
+        if (g_status_mutex == NULL) {
+            g_status_mutex = m;
+            m = NULL;
+        }
+        portEXIT_CRITICAL(&g_status_init_lock);
+        if (m != NULL) {
+            vSemaphoreDelete(m);
+        }
+    }
+    return g_status_mutex;
+}
+
+static configRUN_TIME_COUNTER_TYPE window_delta(const core_plan_window_t *window, const TaskStatus_t *st) {
+    for (uint32_t i = 0; i < window->prev_count; i++) {
+        if (window->prev[i].handle == st->xHandle) {
+            // Lower than before: a new task under a reused handle, or reset counters
+            return (st->ulRunTimeCounter >= window->prev[i].runtime)
+                ? st->ulRunTimeCounter - window->prev[i].runtime
+                : st->ulRunTimeCounter;
+        }
+    }
+    return st->ulRunTimeCounter;
+}
+
+static int planned_index(TaskHandle_t handle) {
+    for (int i = 0; i < (int)CORE_TASK_COUNT; i++) {
+        if (g_planned[i] != NULL && g_planned[i] == handle) {
+            return i;
+        }
+    }
+    return -1;
+}
+#endif
+
+esp_err_t core_plan_sample_tasks(core_plan_window_t *window, core_plan_task_cb_t cb, void *ctx,
+                                 core_plan_load_t *load) {
+    if (window == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+    SemaphoreHandle_t mutex = status_mutex();
+    if (mutex == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t n = uxTaskGetSystemState(g_status, CORE_PLAN_AUDIT_TASKS, &total);
+    if (n == 0U) {
+        xSemaphoreGive(mutex);
+        return ESP_ERR_NO_MEM;
+    }
+    configRUN_TIME_COUNTER_TYPE span = total - window->prev_total;
+
+    TaskHandle_t idle[CORE_PLAN_CORES];
+    uint64_t busy[CORE_PLAN_CORES] = {0};
+    int64_t idle_time[CORE_PLAN_CORES];
+    for (uint32_t core = 0; core < CORE_PLAN_CORES; core++) {
+        idle[core] = xTaskGetIdleTaskHandleForCore((BaseType_t)core);
+        idle_time[core] = -1;
+    }
+
+    for (UBaseType_t i = 0; i < n; i++) {
+        const TaskStatus_t *st = &g_status[i];
+        core_plan_task_sample_t t = {
+            .status = st,
+            .runtime = window_delta(window, st),
+            .core = xTaskGetCoreID(st->xHandle),
+        };
+        bool pinned = (t.core >= 0 && t.core < (BaseType_t)CORE_PLAN_CORES);
+        if (!pinned) {
+            t.core = -1;
+        }
+        t.load_permille = permille(t.runtime, span);
+        for (uint32_t c = 0; c < CORE_PLAN_CORES; c++) {
+            if (idle[c] != NULL && st->xHandle == idle[c]) {
+                idle_time[c] = (int64_t)t.runtime;
+                t.idle = true;
+            }
+        }
+        if (pinned && !t.idle) {
+            busy[t.core] += t.runtime;
+        }
+        if (cb != NULL) {
+            cb(&t, ctx);
+        }
+        window->prev[i].handle = st->xHandle;
+        window->prev[i].runtime = st->ulRunTimeCounter;
+    }
+    window->prev_count = n;
+    window->prev_total = total;
+    xSemaphoreGive(mutex);
+
+    if (load != NULL) {
+        load->window_us = (uint32_t)span;
+        for (uint32_t core = 0; core < CORE_PLAN_CORES; core++) {
+            // Idle time is exact; the sum of pinned tasks misses unpinned ones
+            load->core_load_permille[core] = (idle_time[core] >= 0)
+                ? (uint16_t)(1000U - permille((uint64_t)idle_time[core], span))
+                : permille(busy[core], span);
+        }
+    }
+    return ESP_OK;
+#else
+    (void)cb;
+    (void)ctx;
+    (void)load;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+static core_plan_window_t g_audit_window;
+
+static void audit_task(const core_plan_task_sample_t *s, void *ctx) {
+    core_plan_audit_t *out = ctx;
+    core_plan_task_audit_t *t = &out->tasks[out->task_count++];
+    strncpy(t->name, s->status->pcTaskName, sizeof(t->name) - 1U);
+    t->core = (int8_t)s->core;
+    t->priority = (uint8_t)s->status->uxCurrentPriority;
+    t->load_permille = s->load_permille;
+    int plan = planned_index(s->status->xHandle);
+    t->planned = (plan >= 0);
+    t->misplaced = t->planned && g_task_plan[plan].core != s->core;
+    if (t->misplaced) {
+        out->violations++;
+    }
+    if (s->core < 0 || s->core == CORE_PLAN_CONTROL_CORE) {
+        out->control_core_tasks++;
+        bool planned_here = t->planned && g_task_plan[plan].core == CORE_PLAN_CONTROL_CORE;
+        if (!planned_here && !s->idle && t->load_permille > 0U) {
+            out->foreign_tasks++;
+        }
+    }
+}
+#endif
+
+esp_err_t core_plan_audit(core_plan_audit_t *out) {
+    if (out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(out, 0, sizeof(*out));
+    for (uint32_t isr = 0; isr < CORE_ISR_COUNT; isr++) {
+        for (uint32_t core = 0; core < CORE_PLAN_CORES; core++) {
+            out->isr_runs[isr][core] = __atomic_load_n(&g_core_plan_isr_runs[isr][core], __ATOMIC_RELAXED);
+            if ((BaseType_t)core != core_plan_get_isr_core((core_isr_id_t)isr)) {
+                out->violations += out->isr_runs[isr][core];
+            }
+        }
+    }
+
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+    core_plan_load_t load;
+    esp_err_t err = core_plan_sample_tasks(&g_audit_window, audit_task, out, &load);
+    if (err != ESP_OK) {
+        return err;
+    }
+    out->window_us = load.window_us;
+    memcpy(out->core_load_permille, load.core_load_permille, sizeof(out->core_load_permille));
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
@@ -7,6 +7,7 @@
  */
 
 #include "data_logger.h"
+#include "core_plan.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_crc.h"
@@ -28,12 +29,6 @@
 
 static const char *TAG = "data_logger";
 
-/** @brief Logger task stack size */
-#define LOGGER_TASK_STACK_SIZE   4096
-
-/** @brief Logger task priority */
-#define LOGGER_TASK_PRIORITY     2
-
 /*============================================================================
  * Circular Buffer Structure
  *============================================================================*/
@@ -429,16 +424,7 @@ esp_err_t data_logger_start(const char *name)
     g_logger.last_map = 0;
     
     // Create logger task
-    BaseType_t ret = xTaskCreate(
-        logger_task,
-        "logger",
-        LOGGER_TASK_STACK_SIZE,
-        NULL,
-        LOGGER_TASK_PRIORITY,
-        &g_logger.logger_task
-    );
-    
-    if (ret != pdPASS) {
+    if (core_plan_create_task(CORE_TASK_LOGGER, logger_task, NULL, &g_logger.logger_task) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to create logger task");
         return ESP_ERR_NO_MEM;
     }
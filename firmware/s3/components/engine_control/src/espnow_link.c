@@ -7,6 +7,7 @@
  */
 
 #include "espnow_link.h"
+#include "core_plan.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_netif.h"
@@ -23,12 +24,6 @@ static const char *TAG = "espnow_link";
 /** @brief Protocol version */
 #define ESPNOW_PROTOCOL_VERSION     1
 
-/** @brief TX task stack size */
-#define ESPNOW_TX_TASK_STACK_SIZE   4096
-
-/** @brief TX task priority */
-#define ESPNOW_TX_TASK_PRIORITY     5
-
 /** @brief Maximum retry count for failed transmissions */
 #define ESPNOW_MAX_RETRY            3
 
@@ -490,17 +485,8 @@ esp_err_t espnow_link_start(void)
         return ESP_ERR_INVALID_STATE;
     }
     
-    // Create TX task
-    BaseType_t ret = xTaskCreate(
-        espnow_tx_task,
-        "espnow_tx",
-        ESPNOW_TX_TASK_STACK_SIZE,
-        NULL,
-        ESPNOW_TX_TASK_PRIORITY,
-        &g_espnow.tx_task
-    );
-    
-    if (ret != pdPASS) {
+    // Create TX task (core 0, with the Wi-Fi stack)
+    if (core_plan_create_task(CORE_TASK_ESPNOW_TX, espnow_tx_task, NULL, &g_espnow.tx_task) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to create TX task");
         return ESP_ERR_NO_MEM;
     }
@@ -738,6 +724,76 @@ esp_err_t espnow_link_send_diagnostic(const espnow_diagnostic_t *diag)
     return ESP_OK;
 }
 
+esp_err_t espnow_link_send_perf_stats(const espnow_perf_stats_t *stats)
+{
+    if (!g_espnow.initialized || !g_espnow.started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    espnow_tx_item_t item;
+    esp_err_t ret = espnow_build_message(
+        ESPNOW_MSG_PERF_STATS,
+        (const uint8_t *)stats,
+        sizeof(espnow_perf_stats_t),
+        0,
+        item.data,
+        &item.len
+    );
+    
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    // Broadcast to all peers
+    memcpy(item.dest_mac, g_espnow.broadcast_mac, 6);
+    item.retry_count = 0;
+    
+    if (xQueueSend(g_espnow.tx_queue, &item, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    return ESP_OK;
+}
+
+esp_err_t espnow_link_send_task_profile(const espnow_task_profile_t *profile)
+{
+    if (!g_espnow.initialized || !g_espnow.started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    if (profile == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    espnow_tx_item_t item;
+    esp_err_t ret = espnow_build_message(
+        ESPNOW_MSG_TASK_PROFILE,
+        (const uint8_t *)profile,
+        sizeof(espnow_task_profile_t),
+        0,
+        item.data,
+        &item.len
+    );
+    
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    // Broadcast to all peers
+    memcpy(item.dest_mac, g_espnow.broadcast_mac, 6);
+    item.retry_count = 0;
+    
+    if (xQueueSend(g_espnow.tx_queue, &item, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    return ESP_OK;
+}
+
 esp_err_t espnow_link_send_config_response(const uint8_t *peer_mac, 
                                             const espnow_config_response_t *response)
 {
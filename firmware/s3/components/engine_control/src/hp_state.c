@@ -62,8 +62,7 @@ float hp_state_get_injector_latency(float battery_voltage, float temperature) {
 }
 
 void hp_state_record_jitter(uint32_t expected_us, uint32_t actual_us) {
-    int32_t jitter = (int32_t)actual_us - (int32_t)expected_us;
-    hp_record_jitter(&g_jitter_measurer, (float)jitter);
+    hp_record_jitter(&g_jitter_measurer, hp_us_to_cycles(expected_us), hp_us_to_cycles(actual_us));
 }
 
 void hp_state_get_jitter_stats(float *avg_us, float *max_us, float *min_us) {
@@ -13,18 +13,18 @@
  */
 
 #include "mcpwm_ignition.h"
-#include "driver/mcpwm_timer.h"
-#include "driver/mcpwm_oper.h"
-#include "driver/mcpwm_cmpr.h"
-#include "driver/mcpwm_gen.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_private/mcpwm.h"
 #include "math.h"
-#include "soc/soc_caps.h"
 #include "s3_control_config.h"
 #include "hp_state.h"
+#include "engine_layout.h"
+#include "mcpwm_output.h"
+#include "output_capture.h"
+#include "timebase.h"
+#include <string.h>
 
 static const char* TAG = "MCPWM_IGNITION_HP";
 
@@ -32,21 +32,18 @@ static const char* TAG = "MCPWM_IGNITION_HP";
 bool mcpwm_ignition_hp_deinit(void);
 
 // Configuração de período absoluto para janelas de timing
-#define HP_ABS_PERIOD_TICKS 30000000UL  // 30 segundos em ticks de 1us
+#define HP_ABS_PERIOD_TICKS MCPWM_OUTPUT_PERIOD_TICKS
 
 typedef struct {
-    mcpwm_timer_handle_t timer;
-    mcpwm_oper_handle_t oper;
-    mcpwm_cmpr_handle_t cmp_dwell;
-    mcpwm_cmpr_handle_t cmp_spark;
-    mcpwm_gen_handle_t gen;
-    gpio_num_t coil_pin;
-    float current_dwell_ms;
+    mcpwm_output_t *out;             // Canal do pool (timer do grupo, comparadores, gerador)
+    uint32_t current_dwell_us;
     bool is_active;
     uint32_t last_counter_value;
+    timebase_compare_stats_t sched;  // Escritas, wraps e descartes deste canal
 } mcpwm_ign_channel_hp_t;
 
-static mcpwm_ign_channel_hp_t g_channels_hp[4];
+static mcpwm_ign_channel_hp_t g_channels_hp[ENGINE_MAX_CYLINDERS];
+static uint8_t g_channel_count = 0;
 static bool g_initialized_hp = false;
 
 static bool mcpwm_ok_hp(esp_err_t err, const char *op, int channel) {
@@ -55,19 +52,6 @@ static bool mcpwm_ok_hp(esp_err_t err, const char *op, int channel) {
     return false;
 }
 
-IRAM_ATTR static float calculate_dwell_time_hp(float battery_voltage) {
-    if (battery_voltage < 11.0f) return 4.5f;
-    if (battery_voltage < 12.5f) return 3.5f;
-    if (battery_voltage < 14.0f) return 3.0f;
-    return 2.8f;
-}
-
-IRAM_ATTR static float adjust_dwell_for_rpm_hp(float base_dwell, uint16_t rpm) {
-    if (rpm > 8000) return base_dwell * 0.85f;
-    if (rpm < 1000) return base_dwell * 1.15f;
-    return base_dwell;
-}
-
 IRAM_ATTR static uint32_t calculate_spark_ticks_hp(uint16_t rpm, float advance_degrees) {
     if (rpm == 0) return 0;
     float time_per_degree = (60.0f / (rpm * 360.0f)) * 1000000.0f;
@@ -78,80 +62,41 @@ IRAM_ATTR static uint32_t calculate_spark_ticks_hp(uint16_t rpm, float advance_d
 bool mcpwm_ignition_hp_init(void) {
     if (g_initialized_hp) return true;
 
-    // NOTA: O estado HP centralizado é inicializado por ignition_init()
-    // Este driver apenas configura o hardware MCPWM
-
-    const gpio_num_t gpios[4] = {IGNITION_GPIO_1, IGNITION_GPIO_2, IGNITION_GPIO_3, IGNITION_GPIO_4};
+    // NOTA: O estado HP centralizado e o pool de saídas (mcpwm_output_init)
+    // são inicializados por ignition_init(); este driver só aloca seus canais
 
-    for (int i = 0; i < 4; i++) {
-        int group_id = i / SOC_MCPWM_TIMERS_PER_GROUP;
-        if (group_id >= SOC_MCPWM_GROUPS) {
-            ESP_LOGE(TAG, "No MCPWM group available for ignition %d", i);
-            mcpwm_ignition_hp_deinit();
-            return false;
-        }
+    const gpio_num_t gpios[ENGINE_MAX_CYLINDERS] = {
+        IGNITION_GPIO_1, IGNITION_GPIO_2, IGNITION_GPIO_3, IGNITION_GPIO_4,
+        IGNITION_GPIO_5, IGNITION_GPIO_6, IGNITION_GPIO_7, IGNITION_GPIO_8,
+    };
 
-        g_channels_hp[i].coil_pin = gpios[i];
-        g_channels_hp[i].current_dwell_ms = 3.0f;
+    // Uma bobina por cilindro, ou por par de cilindros com centelha perdida
+    g_channel_count = engine_layout_coils();
+    for (int i = 0; i < g_channel_count; i++) {
+        g_channels_hp[i].current_dwell_us = 0;
         g_channels_hp[i].is_active = false;
         g_channels_hp[i].last_counter_value = 0;
+        memset(&g_channels_hp[i].sched, 0, sizeof(g_channels_hp[i].sched));
 
-        mcpwm_timer_config_t timer_cfg = {
-            .group_id = group_id,
-            .clk_src = MCPWM_TIMER_CLK_SRC_DEFAULT,
-            .resolution_hz = 1000000,
-            .count_mode = MCPWM_TIMER_COUNT_MODE_UP,
-            .period_ticks = HP_ABS_PERIOD_TICKS,
-            .intr_priority = 0,
-            .flags = {.update_period_on_empty = 0},
-        };
-        if (!mcpwm_ok_hp(mcpwm_new_timer(&timer_cfg, &g_channels_hp[i].timer), "new_timer", i)) {
-            mcpwm_ignition_hp_deinit();
-            return false;
-        }
-
-        mcpwm_operator_config_t oper_cfg = {.group_id = group_id};
-        if (!mcpwm_ok_hp(mcpwm_new_operator(&oper_cfg, &g_channels_hp[i].oper), "new_operator", i) ||
-            !mcpwm_ok_hp(mcpwm_operator_connect_timer(g_channels_hp[i].oper, g_channels_hp[i].timer), "connect_timer", i)) {
-            mcpwm_ignition_hp_deinit();
-            return false;
-        }
-
-        mcpwm_comparator_config_t cmp_cfg = {.flags = {.update_cmp_on_tez = 1}};
-        if (!mcpwm_ok_hp(mcpwm_new_comparator(g_channels_hp[i].oper, &cmp_cfg, &g_channels_hp[i].cmp_dwell), "new_cmp_dwell", i) ||
-            !mcpwm_ok_hp(mcpwm_new_comparator(g_channels_hp[i].oper, &cmp_cfg, &g_channels_hp[i].cmp_spark), "new_cmp_spark", i)) {
-            mcpwm_ignition_hp_deinit();
-            return false;
-        }
-
-        mcpwm_generator_config_t gen_cfg = {.gen_gpio_num = g_channels_hp[i].coil_pin};
-        if (!mcpwm_ok_hp(mcpwm_new_generator(g_channels_hp[i].oper, &gen_cfg, &g_channels_hp[i].gen), "new_generator", i) ||
-            !mcpwm_ok_hp(mcpwm_generator_set_force_level(g_channels_hp[i].gen, 0, true), "generator_force_low", i) ||
-            !mcpwm_ok_hp(mcpwm_generator_set_action_on_timer_event(
-                g_channels_hp[i].gen,
-                MCPWM_GEN_TIMER_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, MCPWM_TIMER_EVENT_EMPTY, MCPWM_GEN_ACTION_LOW)), "set_action_timer", i) ||
-            !mcpwm_ok_hp(mcpwm_generator_set_actions_on_compare_event(
-                g_channels_hp[i].gen,
-                MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, g_channels_hp[i].cmp_dwell, MCPWM_GEN_ACTION_HIGH),
-                MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, g_channels_hp[i].cmp_spark, MCPWM_GEN_ACTION_LOW),
-                MCPWM_GEN_COMPARE_EVENT_ACTION_END()), "set_actions_compare", i) ||
-            !mcpwm_ok_hp(mcpwm_timer_enable(g_channels_hp[i].timer), "timer_enable", i)) {
+        if (!mcpwm_ok_hp(mcpwm_output_alloc(gpios[i], &g_channels_hp[i].out), "output_alloc", i)) {
             mcpwm_ignition_hp_deinit();
             return false;
         }
     }
 
-    for (int i = 0; i < 4; i++) {
-        if (!mcpwm_ok_hp(mcpwm_timer_start_stop(g_channels_hp[i].timer, MCPWM_TIMER_START_NO_STOP), "timer_start_continuous", i)) {
-            mcpwm_ignition_hp_deinit();
-            return false;
+    // Captura das bordas de saída; sem ela o driver funciona normalmente
+    for (int i = 0; i < g_channel_count; i++) {
+        esp_err_t err = output_capture_register(OUTPUT_CAPTURE_IGNITION, (uint8_t)i, g_channels_hp[i].out->gpio,
+                                                g_channels_hp[i].out->timer, HP_ABS_PERIOD_TICKS);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            ESP_LOGW(TAG, "Output capture unavailable on channel %d: %s", i, esp_err_to_name(err));
         }
     }
 
     g_initialized_hp = true;
     ESP_LOGI(TAG, "MCPWM ignition HP initialized with absolute compare");
     ESP_LOGI(TAG, "  Timer resolution: 1 MHz (1us per tick)");
-    ESP_LOGI(TAG, "  Using centralized HP state");
+    ESP_LOGI(TAG, "  Coils: %u", g_channel_count);
     return true;
 }
 
@@ -160,47 +105,104 @@ bool mcpwm_ignition_hp_init(void) {
  * @note IRAM_ATTR - função crítica de timing chamada em contexto de ISR
  */
 IRAM_ATTR bool mcpwm_ignition_hp_schedule_one_shot_absolute(
-    uint8_t cylinder_id, uint32_t target_us, uint16_t rpm, 
-    float battery_voltage, uint32_t current_counter)
+    uint8_t cylinder_id, uint32_t target_us, uint32_t dwell_us,
+    uint32_t current_counter)
 {
-    if (!g_initialized_hp || cylinder_id < 1 || cylinder_id > 4 || rpm == 0) {
+    if (!g_initialized_hp || cylinder_id < 1 || cylinder_id > g_channel_count || dwell_us == 0) {
         return false;
     }
 
+    // Dwell já calculado pelo planejador (dwell_control.h): 1 tick = 1 us
     mcpwm_ign_channel_hp_t *ch = &g_channels_hp[cylinder_id - 1];
-    float dwell_time_ms = calculate_dwell_time_hp(battery_voltage);
-    dwell_time_ms = adjust_dwell_for_rpm_hp(dwell_time_ms, rpm);
-    uint32_t dwell_ticks = (uint32_t)(dwell_time_ms * 1000.0f);
+    uint32_t dwell_ticks = dwell_us;
 
-    uint32_t dwell_start_ticks = (target_us > dwell_ticks) ? (target_us - dwell_ticks) : 0;
+    // Valores ABSOLUTOS no domínio do contador (0..período-1)
+    if (target_us >= HP_ABS_PERIOD_TICKS || current_counter >= HP_ABS_PERIOD_TICKS ||
+        dwell_ticks >= HP_ABS_PERIOD_TICKS / 2U) {
+        ch->sched.dropped_range++;
+        return false;
+    }
 
-    if (target_us <= current_counter) {
+    // Só a faísca precisa estar à frente: um refino durante o dwell é válido
+    if (timebase_ticks_delta(current_counter, target_us, HP_ABS_PERIOD_TICKS) <= 0) {
+        ch->sched.dropped_late++;
         return false;
     }
 
-    mcpwm_comparator_set_compare_value(ch->cmp_dwell, dwell_start_ticks);
-    mcpwm_comparator_set_compare_value(ch->cmp_spark, target_us);
-    mcpwm_generator_set_force_level(ch->gen, -1, false);
+    // O início do dwell pode cair antes do wrap (faísca logo após o zero)
+    uint32_t dwell_start_ticks = timebase_ticks_add(target_us, -(int32_t)dwell_ticks, HP_ABS_PERIOD_TICKS);
+    if (dwell_start_ticks > target_us) {
+        ch->sched.wrapped++;
+    }
+
+    mcpwm_output_arm(ch->out, dwell_start_ticks, target_us, current_counter);
 
-    ch->current_dwell_ms = dwell_time_ms;
+    ch->current_dwell_us = dwell_us;
     ch->is_active = true;
     ch->last_counter_value = current_counter;
+    ch->sched.scheduled++;
 
-    // Registra jitter usando estado centralizado
-    hp_state_record_jitter(target_us, target_us);
+    // Jitter medido nas bordas reais do pino (output_capture)
+    output_capture_arm(OUTPUT_CAPTURE_IGNITION, (uint8_t)(cylinder_id - 1), dwell_start_ticks, target_us, current_counter);
 
     return true;
 }
 
+/**
+ * @brief Agenda ignição num instante da base de tempo compartilhada
+ * @note IRAM_ATTR - função crítica de timing
+ */
+IRAM_ATTR bool mcpwm_ignition_hp_schedule_at(uint8_t cylinder_id, uint64_t spark_us, uint32_t dwell_us) {
+    if (!g_initialized_hp || cylinder_id < 1 || cylinder_id > g_channel_count) return false;
+
+    // Instante convertido para o contador deste canal, não do canal 0
+    // Instante já passado cai em dropped_late no compare absoluto
+    const timebase_mcpwm_t *tb = g_channels_hp[cylinder_id - 1].out->tb;
+    uint64_t now_us = timebase_now_us();
+    return mcpwm_ignition_hp_schedule_one_shot_absolute(cylinder_id,
+                                                        timebase_mcpwm_counter_at(tb, spark_us),
+                                                        dwell_us,
+                                                        timebase_mcpwm_counter_at(tb, now_us));
+}
+
 bool mcpwm_ignition_hp_stop_cylinder(uint8_t cylinder_id) {
-    if (!g_initialized_hp || cylinder_id < 1 || cylinder_id > 4) return false;
+    if (!g_initialized_hp || cylinder_id < 1 || cylinder_id > g_channel_count) return false;
     mcpwm_ign_channel_hp_t *ch = &g_channels_hp[cylinder_id - 1];
-    if (!mcpwm_ok_hp(mcpwm_generator_set_force_level(ch->gen, 0, true), 
-                     "generator_force_low", cylinder_id - 1)) return false;
+    if (!mcpwm_ok_hp(mcpwm_output_stop(ch->out), "output_stop", cylinder_id - 1)) return false;
     ch->is_active = false;
     return true;
 }
 
+bool mcpwm_ignition_hp_stop_all(void) {
+    for (uint8_t i = 1; i <= g_channel_count; i++) {
+        if (!mcpwm_ignition_hp_stop_cylinder(i)) return false;
+    }
+    return true;
+}
+
+bool mcpwm_ignition_hp_get_status(uint8_t cylinder_id, mcpwm_ignition_status_t *status) {
+    if (!g_initialized_hp || cylinder_id < 1 || cylinder_id > g_channel_count || status == NULL) return false;
+    mcpwm_ign_channel_hp_t *ch = &g_channels_hp[cylinder_id - 1];
+    status->is_active = ch->is_active;
+    status->last_dwell_us = ch->current_dwell_us;
+    status->last_timing_us = ch->last_counter_value;
+    status->total_fires = ch->sched.scheduled;
+    status->error_count = ch->sched.dropped_late + ch->sched.dropped_range;
+    return true;
+}
+
+bool mcpwm_ignition_hp_get_sched_stats(uint8_t cylinder_id, timebase_compare_stats_t *out) {
+    if (cylinder_id < 1 || cylinder_id > g_channel_count || out == NULL) return false;
+    *out = g_channels_hp[cylinder_id - 1].sched;
+    return true;
+}
+
+void mcpwm_ignition_hp_reset_sched_stats(void) {
+    for (int i = 0; i < g_channel_count; i++) {
+        memset(&g_channels_hp[i].sched, 0, sizeof(g_channels_hp[i].sched));
+    }
+}
+
 IRAM_ATTR void mcpwm_ignition_hp_update_phase_predictor(float measured_period_us, uint32_t timestamp) {
     hp_state_update_phase_predictor(measured_period_us, timestamp);
 }
@@ -215,12 +217,12 @@ void mcpwm_ignition_hp_apply_latency_compensation(float *timing_us, float batter
 }
 
 IRAM_ATTR uint32_t mcpwm_ignition_hp_get_counter(uint8_t cylinder_id) {
-    if (cylinder_id >= 4 || !g_initialized_hp || !g_channels_hp[cylinder_id].timer) {
+    if (cylinder_id >= g_channel_count || !g_initialized_hp || !g_channels_hp[cylinder_id].out) {
         return 0;
     }
     uint32_t counter = 0;
     mcpwm_timer_direction_t direction;
-    esp_err_t err = mcpwm_timer_get_phase(g_channels_hp[cylinder_id].timer, &counter, &direction);
+    esp_err_t err = mcpwm_timer_get_phase(g_channels_hp[cylinder_id].out->timer, &counter, &direction);
     if (err != ESP_OK) {
         return 0;
     }
@@ -228,14 +230,13 @@ IRAM_ATTR uint32_t mcpwm_ignition_hp_get_counter(uint8_t cylinder_id) {
 }
 
 bool mcpwm_ignition_hp_deinit(void) {
-    for (int i = 0; i < 4; i++) {
-        if (g_channels_hp[i].timer) { mcpwm_timer_disable(g_channels_hp[i].timer); mcpwm_del_timer(g_channels_hp[i].timer); g_channels_hp[i].timer = NULL; }
-        if (g_channels_hp[i].gen) { mcpwm_del_generator(g_channels_hp[i].gen); g_channels_hp[i].gen = NULL; }
-        if (g_channels_hp[i].cmp_dwell) { mcpwm_del_comparator(g_channels_hp[i].cmp_dwell); g_channels_hp[i].cmp_dwell = NULL; }
-        if (g_channels_hp[i].cmp_spark) { mcpwm_del_comparator(g_channels_hp[i].cmp_spark); g_channels_hp[i].cmp_spark = NULL; }
-        if (g_channels_hp[i].oper) { mcpwm_del_operator(g_channels_hp[i].oper); g_channels_hp[i].oper = NULL; }
+    // Comparadores, geradores e timers pertencem ao pool (mcpwm_output_deinit)
+    for (uint8_t i = 0; i < ENGINE_MAX_CYLINDERS; i++) {
+        if (g_channels_hp[i].out) { mcpwm_output_stop(g_channels_hp[i].out); g_channels_hp[i].out = NULL; }
+        g_channels_hp[i].current_dwell_us = 0;
+        g_channels_hp[i].is_active = false;
     }
+    g_channel_count = 0;
     g_initialized_hp = false;
-    for (int i = 0; i < 4; i++) { g_channels_hp[i].current_dwell_ms = 0.0f; g_channels_hp[i].is_active = false; }
     return true;
 }
@@ -9,50 +9,63 @@
  * 
  * Estado HP centralizado:
  * - Usa hp_state.h para estado compartilhado de alta precisão
+ *
+ * Múltiplos pulsos por ciclo:
+ * - O primeiro pulso da lista é armado na chamada, os demais ficam na fila
+ *   do canal e são armados pela ISR de fim do pulso anterior
  */
 
 #include "mcpwm_injection.h"
-#include "driver/mcpwm_timer.h"
-#include "driver/mcpwm_oper.h"
-#include "driver/mcpwm_cmpr.h"
-#include "driver/mcpwm_gen.h"
+#include "mcpwm_injection_hp.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_private/mcpwm.h"
 #include "esp_rom_sys.h"
-#include "soc/soc_caps.h"
 #include "s3_control_config.h"
 #include "hp_state.h"
+#include "engine_layout.h"
+#include "mcpwm_output.h"
+#include "output_capture.h"
+#include "timebase.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
 
 static const char* TAG = "MCPWM_INJECTION_HP";
 
 // Forward declaration
 bool mcpwm_injection_hp_deinit(void);
 
-#define HP_INJ_ABS_PERIOD_TICKS 30000000UL  // 30 segundos em ticks de 1us
+#define HP_INJ_ABS_PERIOD_TICKS MCPWM_OUTPUT_PERIOD_TICKS
 
 typedef struct {
-    mcpwm_timer_handle_t timer;
-    mcpwm_oper_handle_t oper;
-    mcpwm_cmpr_handle_t cmp_start;
-    mcpwm_cmpr_handle_t cmp_end;
-    mcpwm_gen_handle_t gen;
-    gpio_num_t gpio;
+    mcpwm_output_t *out;             // Canal do pool (timer do grupo, comparadores, gerador)
     uint32_t pulsewidth_us;
     bool is_active;
     uint32_t last_counter_value;
+    timebase_compare_stats_t sched;  // Escritas, wraps e descartes deste canal
+    // Pulsos do ciclo atual; pulses[0] é o primeiro, next o próximo a armar
+    mcpwm_injection_pulse_t pulses[MCPWM_INJECTION_MAX_PULSES];
+    volatile uint8_t pulse_count;
+    volatile uint8_t pulse_next;
+    uint64_t pulses_end_us;          // Fim do último pulso da lista
+    mcpwm_injection_pulse_stats_t pulse_stats;
 } mcpwm_injection_channel_hp_t;
 
-static mcpwm_injection_channel_hp_t g_channels_hp[4];
+static mcpwm_injection_channel_hp_t g_channels_hp[ENGINE_MAX_CYLINDERS];
+static uint8_t g_channel_count = 0;
 static bool g_initialized_hp = false;
+// Fila de pulsos: tarefa do executor x ISR de fim de pulso
+static portMUX_TYPE g_pulse_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+static void mcpwm_injection_hp_on_pulse_end(void *ctx);
 
 static mcpwm_injection_config_t g_cfg = {
     .base_frequency_hz = 1000000,
     .timer_resolution_bits = 20,
     .min_pulsewidth_us = 500,
     .max_pulsewidth_us = 18000,
-    .gpio_nums = {0, 0, 0, 0},
+    .gpio_nums = {0},
 };
 
 static bool mcpwm_ok_hp(esp_err_t err, const char *op, int channel) {
@@ -70,84 +83,46 @@ IRAM_ATTR static uint32_t clamp_u32_hp(uint32_t v, uint32_t min_v, uint32_t max_
 bool mcpwm_injection_hp_init(void) {
     if (g_initialized_hp) return true;
 
-    // NOTA: O estado HP centralizado é inicializado por ignition_init()
-    // Este driver apenas configura o hardware MCPWM
-
-    const gpio_num_t gpios[4] = {INJECTOR_GPIO_1, INJECTOR_GPIO_2, INJECTOR_GPIO_3, INJECTOR_GPIO_4};
+    // NOTA: O estado HP centralizado e o pool de saídas (mcpwm_output_init)
+    // são inicializados por ignition_init(); este driver só aloca seus canais
 
-    for (int i = 0; i < 4; i++) {
-        int group_id = i / SOC_MCPWM_TIMERS_PER_GROUP;
-        if (group_id >= SOC_MCPWM_GROUPS) {
-            ESP_LOGE(TAG, "No MCPWM group available for injector %d", i);
-            mcpwm_injection_hp_deinit();
-            return false;
-        }
+    const gpio_num_t gpios[ENGINE_MAX_CYLINDERS] = {
+        INJECTOR_GPIO_1, INJECTOR_GPIO_2, INJECTOR_GPIO_3, INJECTOR_GPIO_4,
+        INJECTOR_GPIO_5, INJECTOR_GPIO_6, INJECTOR_GPIO_7, INJECTOR_GPIO_8,
+    };
 
-        g_channels_hp[i].gpio = gpios[i];
+    // Um injetor por cilindro
+    g_channel_count = engine_layout_cylinders();
+    for (int i = 0; i < g_channel_count; i++) {
         g_channels_hp[i].pulsewidth_us = 0;
         g_channels_hp[i].is_active = false;
         g_channels_hp[i].last_counter_value = 0;
-
-        // Timer contínuo - SEM START_STOP_FULL por evento
-        mcpwm_timer_config_t timer_cfg = {
-            .group_id = group_id,
-            .clk_src = MCPWM_TIMER_CLK_SRC_DEFAULT,
-            .resolution_hz = 1000000,  // 1 MHz = 1us por tick
-            .count_mode = MCPWM_TIMER_COUNT_MODE_UP,
-            .period_ticks = HP_INJ_ABS_PERIOD_TICKS,
-            .intr_priority = 0,
-            .flags = {.update_period_on_empty = 0},  // NÃO atualizar período
-        };
-        if (!mcpwm_ok_hp(mcpwm_new_timer(&timer_cfg, &g_channels_hp[i].timer), "new_timer", i)) {
-            mcpwm_injection_hp_deinit();
-            return false;
-        }
-
-        mcpwm_operator_config_t oper_cfg = {.group_id = group_id};
-        if (!mcpwm_ok_hp(mcpwm_new_operator(&oper_cfg, &g_channels_hp[i].oper), "new_operator", i) ||
-            !mcpwm_ok_hp(mcpwm_operator_connect_timer(g_channels_hp[i].oper, g_channels_hp[i].timer), "connect_timer", i)) {
-            mcpwm_injection_hp_deinit();
-            return false;
-        }
-
-        mcpwm_comparator_config_t cmpr_cfg = {.flags = {.update_cmp_on_tez = 1}};
-        if (!mcpwm_ok_hp(mcpwm_new_comparator(g_channels_hp[i].oper, &cmpr_cfg, &g_channels_hp[i].cmp_start), "new_cmp_start", i) ||
-            !mcpwm_ok_hp(mcpwm_new_comparator(g_channels_hp[i].oper, &cmpr_cfg, &g_channels_hp[i].cmp_end), "new_cmp_end", i)) {
-            mcpwm_injection_hp_deinit();
-            return false;
-        }
-
-        mcpwm_generator_config_t gen_cfg = {.gen_gpio_num = g_channels_hp[i].gpio};
-        if (!mcpwm_ok_hp(mcpwm_new_generator(g_channels_hp[i].oper, &gen_cfg, &g_channels_hp[i].gen), "new_generator", i) ||
-            !mcpwm_ok_hp(mcpwm_generator_set_force_level(g_channels_hp[i].gen, 0, true), "generator_force_low", i) ||
-            !mcpwm_ok_hp(mcpwm_generator_set_actions_on_timer_event(
-                g_channels_hp[i].gen,
-                MCPWM_GEN_TIMER_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, MCPWM_TIMER_EVENT_EMPTY, MCPWM_GEN_ACTION_LOW),
-                MCPWM_GEN_TIMER_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, MCPWM_TIMER_EVENT_FULL, MCPWM_GEN_ACTION_LOW),
-                MCPWM_GEN_TIMER_EVENT_ACTION_END()), "set_actions_timer", i) ||
-            !mcpwm_ok_hp(mcpwm_generator_set_actions_on_compare_event(
-                g_channels_hp[i].gen,
-                MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, g_channels_hp[i].cmp_start, MCPWM_GEN_ACTION_HIGH),
-                MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, g_channels_hp[i].cmp_end, MCPWM_GEN_ACTION_LOW),
-                MCPWM_GEN_COMPARE_EVENT_ACTION_END()), "set_actions_compare", i) ||
-            !mcpwm_ok_hp(mcpwm_timer_enable(g_channels_hp[i].timer), "timer_enable", i)) {
+        memset(&g_channels_hp[i].sched, 0, sizeof(g_channels_hp[i].sched));
+        memset(&g_channels_hp[i].pulse_stats, 0, sizeof(g_channels_hp[i].pulse_stats));
+        g_channels_hp[i].pulse_count = 0;
+        g_channels_hp[i].pulse_next = 0;
+
+        if (!mcpwm_ok_hp(mcpwm_output_alloc(gpios[i], &g_channels_hp[i].out), "output_alloc", i) ||
+            !mcpwm_ok_hp(mcpwm_output_set_end_callback(g_channels_hp[i].out, mcpwm_injection_hp_on_pulse_end,
+                                                       &g_channels_hp[i]), "set_end_callback", i)) {
             mcpwm_injection_hp_deinit();
             return false;
         }
     }
 
-    // Iniciar todos os timers em modo contínuo
-    for (int i = 0; i < 4; i++) {
-        if (!mcpwm_ok_hp(mcpwm_timer_start_stop(g_channels_hp[i].timer, MCPWM_TIMER_START_NO_STOP), "timer_start_continuous", i)) {
-            mcpwm_injection_hp_deinit();
-            return false;
+    // Captura das bordas de saída; sem ela o driver funciona normalmente
+    for (int i = 0; i < g_channel_count; i++) {
+        esp_err_t err = output_capture_register(OUTPUT_CAPTURE_INJECTION, (uint8_t)i, g_channels_hp[i].out->gpio,
+                                                g_channels_hp[i].out->timer, HP_INJ_ABS_PERIOD_TICKS);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            ESP_LOGW(TAG, "Output capture unavailable on channel %d: %s", i, esp_err_to_name(err));
         }
     }
 
     g_initialized_hp = true;
     ESP_LOGI(TAG, "MCPWM injection HP initialized with absolute compare");
     ESP_LOGI(TAG, "  Timer resolution: 1 MHz (1us per tick)");
-    ESP_LOGI(TAG, "  Using centralized HP state");
+    ESP_LOGI(TAG, "  Channels: %u", g_channel_count);
     return true;
 }
 
@@ -167,36 +142,129 @@ IRAM_ATTR bool mcpwm_injection_hp_schedule_one_shot_absolute(
     uint32_t pulsewidth_us,
     uint32_t current_counter)
 {
-    if (!g_initialized_hp || cylinder_id >= 4) return false;
+    if (!g_initialized_hp || cylinder_id >= g_channel_count) return false;
 
     mcpwm_injection_channel_hp_t *ch = &g_channels_hp[cylinder_id];
     uint32_t pw = clamp_u32_hp(pulsewidth_us, g_cfg.min_pulsewidth_us, g_cfg.max_pulsewidth_us);
 
-    // Calcular valores ABSOLUTOS
-    uint32_t start_ticks = delay_us;
-    uint32_t end_ticks = delay_us + pw;
+    // Valores ABSOLUTOS no domínio do contador (0..período-1)
+    if (delay_us >= HP_INJ_ABS_PERIOD_TICKS || current_counter >= HP_INJ_ABS_PERIOD_TICKS) {
+        ch->sched.dropped_range++;
+        return false;
+    }
 
-    // Verificar se o target já passou
-    if (delay_us <= current_counter) {
+    // Verificar se o target já passou (à frente = dentro do próximo meio período)
+    if (timebase_ticks_delta(current_counter, delay_us, HP_INJ_ABS_PERIOD_TICKS) <= 0) {
+        ch->sched.dropped_late++;
         return false;
     }
 
-    mcpwm_comparator_set_compare_value(ch->cmp_start, start_ticks);
-    mcpwm_comparator_set_compare_value(ch->cmp_end, end_ticks);
-    mcpwm_generator_set_force_level(ch->gen, -1, false);
+    // O fim pode cair depois do wrap: o pulso segue de 0 até end_ticks
+    uint32_t start_ticks = delay_us;
+    uint32_t end_ticks = timebase_ticks_add(start_ticks, (int32_t)pw, HP_INJ_ABS_PERIOD_TICKS);
+    if (end_ticks < start_ticks) {
+        ch->sched.wrapped++;
+    }
+
+    mcpwm_output_arm(ch->out, start_ticks, end_ticks, current_counter);
 
     // NÃO reiniciar timer - usar timer contínuo!
 
     ch->pulsewidth_us = pw;
     ch->is_active = true;
     ch->last_counter_value = current_counter;
+    ch->sched.scheduled++;
 
-    // Registra jitter usando estado centralizado
-    hp_state_record_jitter(delay_us, delay_us);
+    // Jitter medido nas bordas reais do pino (output_capture)
+    output_capture_arm(OUTPUT_CAPTURE_INJECTION, cylinder_id, start_ticks, end_ticks, current_counter);
 
     return true;
 }
 
+/**
+ * @brief ISR de fim de pulso: arma o próximo pulso da fila do canal
+ * @note IRAM_ATTR - chamada pela ISR do comparador (mcpwm_output)
+ */
+IRAM_ATTR static void mcpwm_injection_hp_on_pulse_end(void *ctx) {
+    mcpwm_injection_channel_hp_t *ch = (mcpwm_injection_channel_hp_t *)ctx;
+    uint8_t cylinder_id = (uint8_t)(ch - g_channels_hp);
+
+    portENTER_CRITICAL_ISR(&g_pulse_spinlock);
+    if (ch->pulse_next < ch->pulse_count) {
+        const mcpwm_injection_pulse_t *p = &ch->pulses[ch->pulse_next++];
+        uint32_t counter = 0;
+        mcpwm_timer_get_phase(ch->out->timer, &counter, NULL);
+        if (mcpwm_injection_hp_schedule_one_shot_absolute(cylinder_id,
+                                                          timebase_mcpwm_counter_at(ch->out->tb, p->start_us),
+                                                          p->pulsewidth_us, counter)) {
+            ch->pulse_stats.rearmed++;
+        } else {
+            // Início já passado: o resto do ciclo também se perde
+            ch->pulse_stats.dropped += (uint32_t)(ch->pulse_count - ch->pulse_next + 1U);
+            ch->pulse_next = ch->pulse_count;
+        }
+    }
+    portEXIT_CRITICAL_ISR(&g_pulse_spinlock);
+}
+
+/**
+ * @brief Agenda os pulsos de um ciclo na base de tempo compartilhada
+ * @note IRAM_ATTR - função crítica de timing
+ */
+IRAM_ATTR bool mcpwm_injection_hp_schedule_pulses_at(uint8_t cylinder_id,
+                                                      const mcpwm_injection_pulse_t *pulses,
+                                                      uint8_t count) {
+    if (!g_initialized_hp || cylinder_id >= g_channel_count || pulses == NULL ||
+        count == 0 || count > MCPWM_INJECTION_MAX_PULSES) {
+        return false;
+    }
+
+    mcpwm_injection_channel_hp_t *ch = &g_channels_hp[cylinder_id];
+    const timebase_mcpwm_t *tb = ch->out->tb;
+    uint64_t now_us = timebase_now_us();
+    bool ok = false;
+
+    portENTER_CRITICAL_SAFE(&g_pulse_spinlock);
+    // Lista atual ainda não terminou: uma lista que começa depois dela é o
+    // próximo ciclo e espera (o angle_scheduler tenta de novo), senão o arm
+    // moveria o fim do pulso em andamento. Antes disso é um refinamento do
+    // mesmo ciclo e substitui a fila, desde que o primeiro pulso ainda não
+    // tenha começado: um pulso em andamento não é reescrito.
+    if (ch->pulse_count > 0 && now_us < ch->pulses_end_us &&
+        (pulses[0].start_us >= ch->pulses_end_us || now_us >= ch->pulses[0].start_us)) {
+        ch->pulse_stats.deferred++;
+        portEXIT_CRITICAL_SAFE(&g_pulse_spinlock);
+        return false;
+    }
+
+    // Instante convertido para o contador deste canal, não do canal 0
+    // Instante já passado cai em dropped_late no compare absoluto
+    ch->pulse_count = 0;
+    ch->pulse_next = 0;
+    ok = mcpwm_injection_hp_schedule_one_shot_absolute(cylinder_id,
+                                                       timebase_mcpwm_counter_at(tb, pulses[0].start_us),
+                                                       pulses[0].pulsewidth_us,
+                                                       timebase_mcpwm_counter_at(tb, now_us));
+    if (ok) {
+        memcpy(ch->pulses, pulses, count * sizeof(pulses[0]));
+        ch->pulses_end_us = pulses[count - 1U].start_us + pulses[count - 1U].pulsewidth_us;
+        ch->pulse_count = count;
+        ch->pulse_next = 1;
+        ch->pulse_stats.lists++;
+    }
+    portEXIT_CRITICAL_SAFE(&g_pulse_spinlock);
+    return ok;
+}
+
+/**
+ * @brief Agenda injeção num instante da base de tempo compartilhada
+ * @note IRAM_ATTR - função crítica de timing
+ */
+IRAM_ATTR bool mcpwm_injection_hp_schedule_at(uint8_t cylinder_id, uint64_t start_us, uint32_t pulsewidth_us) {
+    const mcpwm_injection_pulse_t pulse = {.start_us = start_us, .pulsewidth_us = pulsewidth_us};
+    return mcpwm_injection_hp_schedule_pulses_at(cylinder_id, &pulse, 1);
+}
+
 /**
  * @brief Agenda múltiplos injetores sequencialmente
  * @note IRAM_ATTR - função crítica de timing
@@ -204,13 +272,13 @@ IRAM_ATTR bool mcpwm_injection_hp_schedule_one_shot_absolute(
 IRAM_ATTR bool mcpwm_injection_hp_schedule_sequential_absolute(
     uint32_t base_delay_us,
     uint32_t pulsewidth_us,
-    uint32_t cylinder_offsets[4],
+    uint32_t cylinder_offsets[ENGINE_MAX_CYLINDERS],
     uint32_t current_counter)
 {
     if (!g_initialized_hp) return false;
 
     bool all_success = true;
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < g_channel_count; i++) {
         uint32_t delay_us = base_delay_us + cylinder_offsets[i];
         if (!mcpwm_injection_hp_schedule_one_shot_absolute((uint8_t)i, delay_us, pulsewidth_us, current_counter)) {
             all_success = false;
@@ -220,29 +288,52 @@ IRAM_ATTR bool mcpwm_injection_hp_schedule_sequential_absolute(
 }
 
 bool mcpwm_injection_hp_stop(uint8_t cylinder_id) {
-    if (!g_initialized_hp || cylinder_id >= 4) return false;
+    if (!g_initialized_hp || cylinder_id >= g_channel_count) return false;
     mcpwm_injection_channel_hp_t *ch = &g_channels_hp[cylinder_id];
-    if (!mcpwm_ok_hp(mcpwm_generator_set_force_level(ch->gen, 0, true), "generator_force_low", cylinder_id)) return false;
+    portENTER_CRITICAL_SAFE(&g_pulse_spinlock);
+    ch->pulse_count = 0;
+    ch->pulse_next = 0;
+    portEXIT_CRITICAL_SAFE(&g_pulse_spinlock);
+    if (!mcpwm_ok_hp(mcpwm_output_stop(ch->out), "output_stop", cylinder_id)) return false;
     ch->pulsewidth_us = 0;
     ch->is_active = false;
     return true;
 }
 
 bool mcpwm_injection_hp_stop_all(void) {
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < g_channel_count; i++) {
         if (!mcpwm_injection_hp_stop((uint8_t)i)) return false;
     }
     return true;
 }
 
 bool mcpwm_injection_hp_get_status(uint8_t cylinder_id, mcpwm_injector_channel_t *status) {
-    if (!g_initialized_hp || cylinder_id >= 4 || status == NULL) return false;
+    if (!g_initialized_hp || cylinder_id >= g_channel_count || status == NULL) return false;
     mcpwm_injection_channel_hp_t *ch = &g_channels_hp[cylinder_id];
     status->is_active = ch->is_active;
     status->last_pulsewidth_us = ch->pulsewidth_us;
     status->last_delay_us = ch->last_counter_value;
-    status->total_pulses = 0;
-    status->error_count = 0;
+    status->total_pulses = ch->sched.scheduled;
+    status->error_count = ch->sched.dropped_late + ch->sched.dropped_range;
+    return true;
+}
+
+bool mcpwm_injection_hp_get_sched_stats(uint8_t cylinder_id, timebase_compare_stats_t *out) {
+    if (cylinder_id >= g_channel_count || out == NULL) return false;
+    *out = g_channels_hp[cylinder_id].sched;
+    return true;
+}
+
+void mcpwm_injection_hp_reset_sched_stats(void) {
+    for (int i = 0; i < g_channel_count; i++) {
+        memset(&g_channels_hp[i].sched, 0, sizeof(g_channels_hp[i].sched));
+        memset(&g_channels_hp[i].pulse_stats, 0, sizeof(g_channels_hp[i].pulse_stats));
+    }
+}
+
+bool mcpwm_injection_hp_get_pulse_stats(uint8_t cylinder_id, mcpwm_injection_pulse_stats_t *out) {
+    if (cylinder_id >= g_channel_count || out == NULL) return false;
+    *out = g_channels_hp[cylinder_id].pulse_stats;
     return true;
 }
 
@@ -262,12 +353,12 @@ void mcpwm_injection_hp_apply_latency_compensation(float *pulsewidth_us, float b
 }
 
 IRAM_ATTR uint32_t mcpwm_injection_hp_get_counter(uint8_t cylinder_id) {
-    if (cylinder_id >= 4 || !g_initialized_hp || !g_channels_hp[cylinder_id].timer) {
+    if (cylinder_id >= g_channel_count || !g_initialized_hp || !g_channels_hp[cylinder_id].out) {
         return 0;
     }
     uint32_t counter = 0;
     mcpwm_timer_direction_t direction;
-    esp_err_t err = mcpwm_timer_get_phase(g_channels_hp[cylinder_id].timer, &counter, &direction);
+    esp_err_t err = mcpwm_timer_get_phase(g_channels_hp[cylinder_id].out->timer, &counter, &direction);
     if (err != ESP_OK) {
         return 0;
     }
@@ -279,14 +370,19 @@ const mcpwm_injection_config_t* mcpwm_injection_hp_get_config(void) {
 }
 
 bool mcpwm_injection_hp_deinit(void) {
-    for (int i = 0; i < 4; i++) {
-        if (g_channels_hp[i].timer) { mcpwm_timer_disable(g_channels_hp[i].timer); mcpwm_del_timer(g_channels_hp[i].timer); g_channels_hp[i].timer = NULL; }
-        if (g_channels_hp[i].gen) { mcpwm_del_generator(g_channels_hp[i].gen); g_channels_hp[i].gen = NULL; }
-        if (g_channels_hp[i].cmp_start) { mcpwm_del_comparator(g_channels_hp[i].cmp_start); g_channels_hp[i].cmp_start = NULL; }
-        if (g_channels_hp[i].cmp_end) { mcpwm_del_comparator(g_channels_hp[i].cmp_end); g_channels_hp[i].cmp_end = NULL; }
-        if (g_channels_hp[i].oper) { mcpwm_del_operator(g_channels_hp[i].oper); g_channels_hp[i].oper = NULL; }
+    // Comparadores, geradores e timers pertencem ao pool (mcpwm_output_deinit)
+    for (uint8_t i = 0; i < ENGINE_MAX_CYLINDERS; i++) {
+        if (g_channels_hp[i].out) {
+            mcpwm_output_set_end_callback(g_channels_hp[i].out, NULL, NULL);
+            mcpwm_output_stop(g_channels_hp[i].out);
+            g_channels_hp[i].out = NULL;
+        }
+        g_channels_hp[i].pulse_count = 0;
+        g_channels_hp[i].pulse_next = 0;
+        g_channels_hp[i].pulsewidth_us = 0;
+        g_channels_hp[i].is_active = false;
     }
+    g_channel_count = 0;
     g_initialized_hp = false;
-    for (int i = 0; i < 4; i++) { g_channels_hp[i].pulsewidth_us = 0; g_channels_hp[i].is_active = false; }
     return true;
 }
@@ -0,0 +1,324 @@
+/**
+ * @file mcpwm_output.c
+ * @brief Pool de canais de saída MCPWM (um timer por grupo, operadores
+ *        dedicados ou divididos entre 2 canais)
+ */
+
+#include "mcpwm_output.h"
+#include "core_plan.h"
+#include "driver/mcpwm_oper.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "MCPWM_OUTPUT";
+
+// Margem para a ISR escrever um compare à frente do contador
+#define MCPWM_OUTPUT_ISR_MARGIN_TICKS 2U
+
+enum {
+    OUTPUT_PHASE_IDLE = 0,
+    OUTPUT_PHASE_WAIT_START,
+    OUTPUT_PHASE_WAIT_END,
+};
+
+typedef struct {
+    uint8_t oper;     // Índice global do operador
+    bool shared;
+} output_slot_t;
+
+static mcpwm_output_t g_outputs[MCPWM_OUTPUT_MAX_CHANNELS];
+static output_slot_t g_slots[MCPWM_OUTPUT_MAX_CHANNELS];
+static mcpwm_oper_handle_t g_opers[MCPWM_OUTPUT_OPERATORS];
+static mcpwm_timer_handle_t g_timers[SOC_MCPWM_GROUPS];
+static timebase_mcpwm_t g_tb[SOC_MCPWM_GROUPS];
+static mcpwm_output_info_t g_info;
+static portMUX_TYPE g_output_spinlock = portMUX_INITIALIZER_UNLOCKED;
+static bool g_initialized = false;
+
+static bool mcpwm_ok(esp_err_t err, const char *op, int index) {
+    if (err == ESP_OK) return true;
+    ESP_LOGE(TAG, "%s failed on %d: %s", op, index, esp_err_to_name(err));
+    return false;
+}
+
+IRAM_ATTR static uint32_t output_counter(const mcpwm_output_t *ch) {
+    uint32_t counter = 0;
+    mcpwm_timer_get_phase(ch->timer, &counter, NULL);
+    return counter;
+}
+
+/**
+ * @brief ISR do comparador de um canal compartilhado
+ *
+ * No início o TOGGLE já subiu a saída: o comparador passa a guardar o fim.
+ * No fim a saída já desceu: fica forçada em baixo para o próximo match do
+ * mesmo valor (um período depois) não alternar de novo.
+ */
+static bool IRAM_ATTR mcpwm_output_on_reach(mcpwm_cmpr_handle_t cmpr,
+                                            const mcpwm_compare_event_data_t *edata,
+                                            void *user_ctx) {
+    (void)edata;
+    mcpwm_output_t *ch = (mcpwm_output_t *)user_ctx;
+    bool ended = false;
+    core_plan_isr_mark(CORE_ISR_MCPWM);
+    portENTER_CRITICAL_ISR(&g_output_spinlock);
+    if (ch->phase == OUTPUT_PHASE_WAIT_START) {
+        uint32_t counter = output_counter(ch);
+        uint32_t end = ch->end_ticks;
+        if (timebase_ticks_delta(counter, end, MCPWM_OUTPUT_PERIOD_TICKS) <= (int32_t)MCPWM_OUTPUT_ISR_MARGIN_TICKS) {
+            // Latência maior que o pulso: fecha pelo hardware o quanto antes
+            end = timebase_ticks_add(counter, (int32_t)MCPWM_OUTPUT_ISR_MARGIN_TICKS, MCPWM_OUTPUT_PERIOD_TICKS);
+            g_info.late_ends++;
+        }
+        mcpwm_comparator_set_compare_value(cmpr, end);
+        ch->phase = OUTPUT_PHASE_WAIT_END;
+        g_info.isr_rearms++;
+    } else if (ch->phase == OUTPUT_PHASE_WAIT_END) {
+        mcpwm_generator_set_force_level(ch->gen, 0, true);
+        ch->phase = OUTPUT_PHASE_IDLE;
+        ended = true;
+    }
+    portEXIT_CRITICAL_ISR(&g_output_spinlock);
+    // Fora da seção crítica: o callback pode armar o canal de novo
+    if (ended && ch->end_cb) {
+        ch->end_cb(ch->end_ctx);
+    }
+    return false;
+}
+
+/**
+ * @brief ISR do comparador de fim de um canal dedicado
+ *
+ * O timer é contínuo: os dois compares casam de novo a cada período e, sem
+ * um novo arm, repetiriam o pulso 30 s depois. Com o fim alcançado a saída
+ * fica forçada em baixo até o próximo arm. Um arm escrito entre o fim e a
+ * ISR já moveu end_ticks para frente e não é desfeito.
+ */
+static bool IRAM_ATTR mcpwm_output_on_end(mcpwm_cmpr_handle_t cmpr,
+                                          const mcpwm_compare_event_data_t *edata,
+                                          void *user_ctx) {
+    (void)cmpr;
+    (void)edata;
+    mcpwm_output_t *ch = (mcpwm_output_t *)user_ctx;
+    core_plan_isr_mark(CORE_ISR_MCPWM);
+    portENTER_CRITICAL_ISR(&g_output_spinlock);
+    if (timebase_ticks_delta(output_counter(ch), ch->end_ticks, MCPWM_OUTPUT_PERIOD_TICKS) <= 0) {
+        mcpwm_generator_set_force_level(ch->gen, 0, true);
+    }
+    portEXIT_CRITICAL_ISR(&g_output_spinlock);
+    // Fora da seção crítica: o callback pode armar o canal de novo
+    if (ch->end_cb) {
+        ch->end_cb(ch->end_ctx);
+    }
+    return false;
+}
+
+esp_err_t mcpwm_output_init(uint8_t channels) {
+    if (g_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (channels == 0 || channels > MCPWM_OUTPUT_MAX_CHANNELS) {
+        ESP_LOGE(TAG, "%u output channels requested, hardware has %u", channels,
+                 (unsigned)MCPWM_OUTPUT_MAX_CHANNELS);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // Menos operadores divididos possível: cada um divide só o que sobra
+    uint8_t shared_ops = (channels > MCPWM_OUTPUT_OPERATORS) ? (uint8_t)(channels - MCPWM_OUTPUT_OPERATORS) : 0U;
+    uint8_t dedicated_ops = (uint8_t)(channels - (2U * shared_ops));
+    uint8_t ops = (uint8_t)(dedicated_ops + shared_ops);
+
+    memset(&g_info, 0, sizeof(g_info));
+    memset(g_outputs, 0, sizeof(g_outputs));
+    uint8_t slot = 0;
+    for (uint8_t k = 0; k < ops; k++) {
+        bool shared = (k >= dedicated_ops);
+        for (uint8_t n = 0; n < (shared ? 2U : 1U); n++) {
+            g_slots[slot].oper = k;
+            g_slots[slot].shared = shared;
+            slot++;
+        }
+    }
+
+    uint8_t groups = (uint8_t)((ops + SOC_MCPWM_OPERATORS_PER_GROUP - 1U) / SOC_MCPWM_OPERATORS_PER_GROUP);
+    for (uint8_t g = 0; g < groups; g++) {
+        // Timer contínuo - SEM START_STOP_FULL por evento
+        mcpwm_timer_config_t timer_cfg = {
+            .group_id = g,
+            .clk_src = MCPWM_TIMER_CLK_SRC_DEFAULT,
+            .resolution_hz = 1000000,  // 1 MHz = 1us por tick
+            .count_mode = MCPWM_TIMER_COUNT_MODE_UP,
+            .period_ticks = MCPWM_OUTPUT_PERIOD_TICKS,
+            .intr_priority = 0,
+            .flags = {.update_period_on_empty = 0},
+        };
+        if (!mcpwm_ok(mcpwm_new_timer(&timer_cfg, &g_timers[g]), "new_timer", g) ||
+            !mcpwm_ok(mcpwm_timer_enable(g_timers[g]), "timer_enable", g)) {
+            mcpwm_output_deinit();
+            return ESP_FAIL;
+        }
+    }
+
+    for (uint8_t k = 0; k < ops; k++) {
+        uint8_t g = (uint8_t)(k / SOC_MCPWM_OPERATORS_PER_GROUP);
+        mcpwm_operator_config_t oper_cfg = {.group_id = g};
+        if (!mcpwm_ok(mcpwm_new_operator(&oper_cfg, &g_opers[k]), "new_operator", k) ||
+            !mcpwm_ok(mcpwm_operator_connect_timer(g_opers[k], g_timers[g]), "connect_timer", k)) {
+            mcpwm_output_deinit();
+            return ESP_FAIL;
+        }
+    }
+
+    for (uint8_t g = 0; g < groups; g++) {
+        if (!mcpwm_ok(mcpwm_timer_start_stop(g_timers[g], MCPWM_TIMER_START_NO_STOP), "timer_start_continuous", g) ||
+            // Contadores dos grupos têm fases diferentes: cada um ganha seu offset
+            !mcpwm_ok(timebase_attach_mcpwm(&g_tb[g], g_timers[g], MCPWM_OUTPUT_PERIOD_TICKS), "timebase_attach", g)) {
+            mcpwm_output_deinit();
+            return ESP_FAIL;
+        }
+    }
+
+    g_info.channels = channels;
+    g_info.timers = groups;
+    g_info.operators = ops;
+    g_info.shared_operators = shared_ops;
+    g_initialized = true;
+    ESP_LOGI(TAG, "%u output channels: %u timers, %u operators (%u shared)",
+             channels, groups, ops, shared_ops);
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_output_alloc(gpio_num_t gpio, mcpwm_output_t **out) {
+    if (!g_initialized || out == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (g_info.allocated >= g_info.channels) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t i = g_info.allocated;
+    const output_slot_t *slot = &g_slots[i];
+    mcpwm_output_t *ch = &g_outputs[i];
+    uint8_t g = (uint8_t)(slot->oper / SOC_MCPWM_OPERATORS_PER_GROUP);
+    mcpwm_oper_handle_t oper = g_opers[slot->oper];
+
+    ch->timer = g_timers[g];
+    ch->tb = &g_tb[g];
+    ch->gpio = gpio;
+    ch->group_id = g;
+    ch->shared = slot->shared;
+    ch->phase = OUTPUT_PHASE_IDLE;
+
+    // Atualização imediata: com período de 30 s, o shadow em TEZ só aplicaria o compare no wrap
+    mcpwm_comparator_config_t cmpr_cfg = {.flags = {.update_cmp_on_tez = 0}};
+    mcpwm_generator_config_t gen_cfg = {
+        .gen_gpio_num = gpio,
+        .flags = {.io_loop_back = 1},  // Lido de volta por output_capture
+    };
+    if (!mcpwm_ok(mcpwm_new_comparator(oper, &cmpr_cfg, &ch->cmp_start), "new_cmp_start", i) ||
+        (!ch->shared && !mcpwm_ok(mcpwm_new_comparator(oper, &cmpr_cfg, &ch->cmp_end), "new_cmp_end", i)) ||
+        !mcpwm_ok(mcpwm_new_generator(oper, &gen_cfg, &ch->gen), "new_generator", i) ||
+        !mcpwm_ok(mcpwm_generator_set_force_level(ch->gen, 0, true), "generator_force_low", i)) {
+        return ESP_FAIL;
+    }
+
+    // Todo canal tem ISR de fim: é ela que segura a saída em baixo após o pulso
+    mcpwm_comparator_event_callbacks_t cbs = {
+        .on_reach = ch->shared ? mcpwm_output_on_reach : mcpwm_output_on_end,
+    };
+    esp_err_t err = mcpwm_comparator_register_event_callbacks(ch->shared ? ch->cmp_start : ch->cmp_end, &cbs, ch);
+    if (ch->shared) {
+        if (err == ESP_OK) {
+            err = mcpwm_generator_set_actions_on_compare_event(
+                ch->gen,
+                MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, ch->cmp_start, MCPWM_GEN_ACTION_TOGGLE),
+                MCPWM_GEN_COMPARE_EVENT_ACTION_END());
+        }
+    } else if (err == ESP_OK) {
+        // Sem ação em TEZ/TEP: um pulso que cruza o wrap continua até o compare de fim
+        err = mcpwm_generator_set_actions_on_compare_event(
+            ch->gen,
+            MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, ch->cmp_start, MCPWM_GEN_ACTION_HIGH),
+            MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, ch->cmp_end, MCPWM_GEN_ACTION_LOW),
+            MCPWM_GEN_COMPARE_EVENT_ACTION_END());
+    }
+    if (!mcpwm_ok(err, "set_actions_compare", i)) {
+        return ESP_FAIL;
+    }
+
+    g_info.allocated++;
+    *out = ch;
+    return ESP_OK;
+}
+
+IRAM_ATTR void mcpwm_output_arm(mcpwm_output_t *ch, uint32_t start_ticks, uint32_t end_ticks,
+                                uint32_t counter) {
+    portENTER_CRITICAL_SAFE(&g_output_spinlock);
+    ch->end_ticks = end_ticks;
+    if (!ch->shared) {
+        // end_ticks antes dos compares: a ISR de fim não derruba este pulso
+        mcpwm_comparator_set_compare_value(ch->cmp_start, start_ticks);
+        mcpwm_comparator_set_compare_value(ch->cmp_end, end_ticks);
+        mcpwm_generator_set_force_level(ch->gen, -1, false);
+    } else if (ch->phase == OUTPUT_PHASE_WAIT_END) {
+        // Pulso em andamento: o comparador já guarda o fim
+        mcpwm_comparator_set_compare_value(ch->cmp_start, end_ticks);
+    } else {
+        if (timebase_ticks_delta(counter, start_ticks, MCPWM_OUTPUT_PERIOD_TICKS) <=
+            (int32_t)MCPWM_OUTPUT_ISR_MARGIN_TICKS) {
+            start_ticks = timebase_ticks_add(counter, (int32_t)MCPWM_OUTPUT_ISR_MARGIN_TICKS,
+                                             MCPWM_OUTPUT_PERIOD_TICKS);
+        }
+        ch->phase = OUTPUT_PHASE_WAIT_START;
+        mcpwm_comparator_set_compare_value(ch->cmp_start, start_ticks);
+        mcpwm_generator_set_force_level(ch->gen, -1, false);
+    }
+    portEXIT_CRITICAL_SAFE(&g_output_spinlock);
+}
+
+esp_err_t mcpwm_output_set_end_callback(mcpwm_output_t *ch, void (*cb)(void *ctx), void *ctx) {
+    if (ch == NULL || ch->gen == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL_SAFE(&g_output_spinlock);
+    ch->end_cb = cb;
+    ch->end_ctx = ctx;
+    portEXIT_CRITICAL_SAFE(&g_output_spinlock);
+    // A ISR de fim já foi registrada em mcpwm_output_alloc()
+    return ESP_OK;
+}
+
+esp_err_t mcpwm_output_stop(mcpwm_output_t *ch) {
+    if (ch == NULL || ch->gen == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL_SAFE(&g_output_spinlock);
+    ch->phase = OUTPUT_PHASE_IDLE;
+    portEXIT_CRITICAL_SAFE(&g_output_spinlock);
+    return mcpwm_generator_set_force_level(ch->gen, 0, true);
+}
+
+void mcpwm_output_get_info(mcpwm_output_info_t *out) {
+    if (out) {
+        *out = g_info;
+    }
+}
+
+void mcpwm_output_deinit(void) {
+    for (int i = 0; i < MCPWM_OUTPUT_MAX_CHANNELS; i++) {
+        mcpwm_output_t *ch = &g_outputs[i];
+        if (ch->gen) { mcpwm_generator_set_force_level(ch->gen, 0, true); mcpwm_del_generator(ch->gen); ch->gen = NULL; }
+        if (ch->cmp_start) { mcpwm_del_comparator(ch->cmp_start); ch->cmp_start = NULL; }
+        if (ch->cmp_end) { mcpwm_del_comparator(ch->cmp_end); ch->cmp_end = NULL; }
+    }
+    for (int k = 0; k < MCPWM_OUTPUT_OPERATORS; k++) {
+        if (g_opers[k]) { mcpwm_del_operator(g_opers[k]); g_opers[k] = NULL; }
+    }
+    for (int g = 0; g < SOC_MCPWM_GROUPS; g++) {
+        timebase_detach_mcpwm(&g_tb[g]);
+        if (g_timers[g]) { mcpwm_timer_disable(g_timers[g]); mcpwm_del_timer(g_timers[g]); g_timers[g] = NULL; }
+    }
+    memset(&g_info, 0, sizeof(g_info));
+    g_initialized = false;
+}
@@ -0,0 +1,431 @@
+#include "../include/output_capture.h"
+#include "../include/hp_state.h"
+#include "../include/sync.h"
+#include "../include/timebase.h"
+#include "../include/core_plan.h"
+#include "driver/gptimer.h"
+#include "driver/gptimer_etm.h"
+#include "driver/gpio_etm.h"
+#include "esp_attr.h"
+#include "esp_etm.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "soc/soc_caps.h"
+#include <string.h>
+
+static const char *TAG = "OUTPUT_CAPTURE";
+
+// Same tick as the MCPWM output timers, so capture ages are in compare ticks
+#define OUTPUT_CAPTURE_RESOLUTION_HZ 1000000U
+
+// A target this far behind the counter without its edge counts as missed
+#define OUTPUT_CAPTURE_MISS_MARGIN_TICKS 50U
+
+enum {
+    EDGE_START = 0,   // Rising: injector opens / dwell starts
+    EDGE_END,         // Falling: injector closes / spark
+    EDGE_COUNT,
+};
+
+typedef struct {
+    output_capture_kind_t kind;
+    gpio_num_t gpio;
+    mcpwm_timer_handle_t timer;
+    uint32_t period;
+    esp_etm_event_handle_t event;
+    esp_etm_channel_handle_t etm_chan;
+    bool registered;
+    bool hw_timestamp;
+
+    // Armed transitions, MCPWM ticks
+    uint32_t target[EDGE_COUNT];
+    bool pending[EDGE_COUNT];
+    uint32_t armed_counter;
+    uint32_t us_per_degree_q16;
+    // Target already reached when the channel was re-armed (next pulse armed
+    // from the end-of-pulse ISR), its edge not yet recorded
+    uint32_t late_target[EDGE_COUNT];
+    uint32_t late_armed_counter[EDGE_COUNT];
+    bool late_pending[EDGE_COUNT];
+
+    uint32_t armed;          // Expected transitions: matched + missed + outstanding
+    uint32_t matched;
+    uint32_t missed;
+    uint32_t stray;
+    uint32_t max_us;
+    uint32_t max_cdeg;
+    uint16_t err_us[OUTPUT_CAPTURE_WINDOW];
+    uint16_t err_cdeg[OUTPUT_CAPTURE_WINDOW];
+    uint16_t head;
+    uint16_t count;
+} output_channel_t;
+
+static output_channel_t g_channels[OUTPUT_CAPTURE_KIND_COUNT][OUTPUT_CAPTURE_CHANNELS];
+static gptimer_handle_t g_timers[OUTPUT_CAPTURE_KIND_COUNT];
+static esp_etm_task_handle_t g_timer_tasks[OUTPUT_CAPTURE_KIND_COUNT];
+static portMUX_TYPE g_capture_spinlock = portMUX_INITIALIZER_UNLOCKED;
+static bool g_initialized = false;
+
+IRAM_ATTR static inline uint16_t sat_u16(uint32_t v) {
+    return (v > UINT16_MAX) ? UINT16_MAX : (uint16_t)v;
+}
+
+IRAM_ATTR static void output_capture_record(output_channel_t *ch, int edge_type, uint32_t edge) {
+    portENTER_CRITICAL_ISR(&g_capture_spinlock);
+    uint32_t target;
+    uint32_t armed_counter;
+    if (ch->late_pending[edge_type]) {
+        ch->late_pending[edge_type] = false;
+        target = ch->late_target[edge_type];
+        armed_counter = ch->late_armed_counter[edge_type];
+    } else if (ch->pending[edge_type]) {
+        ch->pending[edge_type] = false;
+        target = ch->target[edge_type];
+        armed_counter = ch->armed_counter;
+    } else {
+        ch->stray++;
+        portEXIT_CRITICAL_ISR(&g_capture_spinlock);
+        return;
+    }
+
+    int32_t delta = timebase_ticks_delta(target, edge, ch->period);
+    uint32_t err_us = (delta < 0) ? (uint32_t)(-delta) : (uint32_t)delta;
+    uint32_t err_cdeg = 0;
+    if (ch->us_per_degree_q16 > 0) {
+        err_cdeg = (uint32_t)((((uint64_t)err_us * 100U) << 16) / ch->us_per_degree_q16);
+    }
+
+    ch->matched++;
+    if (err_us > ch->max_us) {
+        ch->max_us = err_us;
+    }
+    if (err_cdeg > ch->max_cdeg) {
+        ch->max_cdeg = err_cdeg;
+    }
+    ch->err_us[ch->head] = sat_u16(err_us);
+    ch->err_cdeg[ch->head] = sat_u16(err_cdeg);
+    ch->head = (uint16_t)((ch->head + 1U) % OUTPUT_CAPTURE_WINDOW);
+    if (ch->count < OUTPUT_CAPTURE_WINDOW) {
+        ch->count++;
+    }
+
+    // Relative to the arm point: absolute ticks would overflow in cycles
+    hp_state_record_jitter(timebase_ticks_between(armed_counter, target, ch->period),
+                           timebase_ticks_between(armed_counter, edge, ch->period));
+    portEXIT_CRITICAL_ISR(&g_capture_spinlock);
+}
+
+static void IRAM_ATTR output_capture_gpio_isr(void *arg) {
+    output_channel_t *ch = (output_channel_t *)arg;
+    core_plan_isr_mark(CORE_ISR_OUTPUT_CAPTURE);
+    uint32_t age = 0;
+    if (ch->hw_timestamp) {
+        uint64_t captured = 0;
+        uint64_t now = 0;
+        gptimer_get_captured_count(g_timers[ch->kind], &captured);
+        gptimer_get_raw_count(g_timers[ch->kind], &now);
+        age = (uint32_t)(now - captured);
+    }
+    uint32_t counter = 0;
+    if (mcpwm_timer_get_phase(ch->timer, &counter, NULL) != ESP_OK) {
+        return;
+    }
+
+    // Move the capture back into the channel's MCPWM counter
+    uint32_t edge = timebase_ticks_between(age % ch->period, counter, ch->period);
+    int edge_type = gpio_get_level(ch->gpio) ? EDGE_START : EDGE_END;
+    output_capture_record(ch, edge_type, edge);
+}
+
+IRAM_ATTR void output_capture_arm(output_capture_kind_t kind,
+                                  uint8_t channel,
+                                  uint32_t start_ticks,
+                                  uint32_t end_ticks,
+                                  uint32_t counter) {
+    if (!g_initialized || (unsigned)kind >= OUTPUT_CAPTURE_KIND_COUNT || channel >= OUTPUT_CAPTURE_CHANNELS) {
+        return;
+    }
+    output_channel_t *ch = &g_channels[kind][channel];
+    if (!ch->registered) {
+        return;
+    }
+    uint32_t us_per_degree_q16 = sync_get_us_per_degree_q16();
+    const uint32_t targets[EDGE_COUNT] = {start_ticks, end_ticks};
+
+    portENTER_CRITICAL_SAFE(&g_capture_spinlock);
+    for (int e = 0; e < EDGE_COUNT; e++) {
+        // An edge still pending whose target is well behind the counter never came
+        if (ch->late_pending[e]) {
+            ch->late_pending[e] = false;
+            ch->missed++;
+        }
+        if (ch->pending[e]) {
+            int32_t behind = timebase_ticks_delta(ch->target[e], counter, ch->period);
+            if (behind > (int32_t)OUTPUT_CAPTURE_MISS_MARGIN_TICKS) {
+                ch->missed++;
+            } else if (behind >= 0) {
+                // Reached but its GPIO interrupt may still be on the way
+                ch->late_target[e] = ch->target[e];
+                ch->late_armed_counter[e] = ch->armed_counter;
+                ch->late_pending[e] = true;
+            }
+        }
+        // Only transitions still ahead are expected (a refine may rewrite a
+        // dwell start that already happened). A target still ahead that is
+        // rewritten is the same transition: counted once, or dropped when
+        // the rewrite puts it behind the counter.
+        bool superseded = ch->pending[e] && timebase_ticks_delta(ch->target[e], counter, ch->period) < 0;
+        ch->target[e] = targets[e];
+        ch->pending[e] = timebase_ticks_delta(counter, targets[e], ch->period) > 0;
+        if (ch->pending[e] && !superseded) {
+            ch->armed++;
+        } else if (!ch->pending[e] && superseded) {
+            ch->armed--;
+        }
+    }
+    ch->armed_counter = counter;
+    ch->us_per_degree_q16 = us_per_degree_q16;
+    portEXIT_CRITICAL_SAFE(&g_capture_spinlock);
+}
+
+esp_err_t output_capture_init(void) {
+    if (g_initialized) {
+        return ESP_OK;
+    }
+    memset(g_channels, 0, sizeof(g_channels));
+
+#if SOC_GPTIMER_SUPPORT_ETM
+    for (int k = 0; k < OUTPUT_CAPTURE_KIND_COUNT; k++) {
+        gptimer_config_t timer_config = {
+            .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+            .direction = GPTIMER_COUNT_UP,
+            .resolution_hz = OUTPUT_CAPTURE_RESOLUTION_HZ,
+            .intr_priority = 0,
+            .flags = {
+                .intr_shared = 0,
+                .allow_pd = 0,
+            },
+        };
+        esp_err_t err = gptimer_new_timer(&timer_config, &g_timers[k]);
+        if (err == ESP_OK) {
+            err = gptimer_enable(g_timers[k]);
+        }
+        if (err == ESP_OK) {
+            gptimer_etm_task_config_t task_conf = {
+                .task_type = GPTIMER_ETM_TASK_CAPTURE,
+            };
+            err = gptimer_new_etm_task(g_timers[k], &task_conf, &g_timer_tasks[k]);
+        }
+        if (err == ESP_OK) {
+            err = gptimer_start(g_timers[k]);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Capture timer %d failed: %s", k, esp_err_to_name(err));
+            output_capture_deinit();
+            return err;
+        }
+    }
+#endif
+
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        output_capture_deinit();
+        return err;
+    }
+
+    g_initialized = true;
+    return ESP_OK;
+}
+
+void output_capture_deinit(void) {
+    g_initialized = false;
+    for (int k = 0; k < OUTPUT_CAPTURE_KIND_COUNT; k++) {
+        for (size_t c = 0; c < OUTPUT_CAPTURE_CHANNELS; c++) {
+            output_channel_t *ch = &g_channels[k][c];
+            if (ch->registered) {
+                gpio_isr_handler_remove(ch->gpio);
+            }
+            if (ch->etm_chan != NULL) {
+                esp_etm_channel_disable(ch->etm_chan);
+                esp_etm_del_channel(ch->etm_chan);
+                ch->etm_chan = NULL;
+            }
+            if (ch->event != NULL) {
+                esp_etm_del_event(ch->event);
+                ch->event = NULL;
+            }
+            ch->registered = false;
+        }
+        if (g_timer_tasks[k] != NULL) {
+            esp_etm_del_task(g_timer_tasks[k]);
+            g_timer_tasks[k] = NULL;
+        }
+        if (g_timers[k] != NULL) {
+            gptimer_stop(g_timers[k]);
+            gptimer_disable(g_timers[k]);
+            gptimer_del_timer(g_timers[k]);
+            g_timers[k] = NULL;
+        }
+    }
+}
+
+// GPIO ETM event on the pin -> capture task of the kind's timer
+static esp_err_t output_capture_connect_etm(output_channel_t *ch) {
+    if (g_timer_tasks[ch->kind] == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    gpio_etm_event_config_t event_config = {
+        .edge = GPIO_ETM_EVENT_EDGE_ANY,
+    };
+    esp_err_t err = gpio_new_etm_event(&event_config, &ch->event);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = gpio_etm_event_bind_gpio(ch->event, ch->gpio);
+    if (err == ESP_OK) {
+        esp_etm_channel_config_t etm_config = {};
+        err = esp_etm_new_channel(&etm_config, &ch->etm_chan);
+    }
+    if (err == ESP_OK) {
+        err = esp_etm_channel_connect(ch->etm_chan, ch->event, g_timer_tasks[ch->kind]);
+    }
+    if (err == ESP_OK) {
+        err = esp_etm_channel_enable(ch->etm_chan);
+    }
+    if (err != ESP_OK) {
+        if (ch->etm_chan != NULL) {
+            esp_etm_del_channel(ch->etm_chan);
+            ch->etm_chan = NULL;
+        }
+        esp_etm_del_event(ch->event);
+        ch->event = NULL;
+    }
+    return err;
+}
+
+esp_err_t output_capture_register(output_capture_kind_t kind,
+                                  uint8_t channel,
+                                  gpio_num_t gpio,
+                                  mcpwm_timer_handle_t timer,
+                                  uint32_t period_ticks) {
+    if (!g_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if ((unsigned)kind >= OUTPUT_CAPTURE_KIND_COUNT || channel >= OUTPUT_CAPTURE_CHANNELS ||
+        timer == NULL || period_ticks == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    output_channel_t *ch = &g_channels[kind][channel];
+    if (ch->registered) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    memset(ch, 0, sizeof(*ch));
+    ch->kind = kind;
+    ch->gpio = gpio;
+    ch->timer = timer;
+    ch->period = period_ticks;
+
+    // GPIO ETM event channels run out before pins do: fall back to ISR time
+    esp_err_t err = output_capture_connect_etm(ch);
+    ch->hw_timestamp = (err == ESP_OK);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "GPIO %d: no ETM capture (%s), timestamping in the ISR",
+                 (int)gpio, esp_err_to_name(err));
+    }
+
+    // The generator owns the pin; only the interrupt is set here
+    err = gpio_set_intr_type(gpio, GPIO_INTR_ANYEDGE);
+    if (err == ESP_OK) {
+        err = gpio_isr_handler_add(gpio, output_capture_gpio_isr, ch);
+    }
+    if (err == ESP_OK) {
+        err = gpio_intr_enable(gpio);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "GPIO %d interrupt failed: %s", (int)gpio, esp_err_to_name(err));
+        return err;
+    }
+    ch->registered = true;
+    return ESP_OK;
+}
+
+static uint32_t window_percentile(const uint16_t *arr, uint16_t n, uint8_t pct) {
+    if (n == 0) {
+        return 0;
+    }
+    uint16_t copy[OUTPUT_CAPTURE_WINDOW];
+    memcpy(copy, arr, sizeof(uint16_t) * n);
+
+    for (uint16_t i = 1; i < n; i++) {
+        uint16_t v = copy[i];
+        uint16_t j = i;
+        while (j > 0 && copy[j - 1] > v) {
+            copy[j] = copy[j - 1];
+            j--;
+        }
+        copy[j] = v;
+    }
+
+    uint16_t idx = (uint16_t)(((uint32_t)(n - 1) * pct) / 100U);
+    return copy[idx];
+}
+
+esp_err_t output_capture_get_stats(output_capture_kind_t kind, uint8_t cylinder, output_capture_stats_t *out) {
+    if (out == NULL || (unsigned)kind >= OUTPUT_CAPTURE_KIND_COUNT ||
+        cylinder < 1 || cylinder > OUTPUT_CAPTURE_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    output_channel_t *ch = &g_channels[kind][cylinder - 1U];
+    if (!ch->registered) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint16_t err_us[OUTPUT_CAPTURE_WINDOW];
+    uint16_t err_cdeg[OUTPUT_CAPTURE_WINDOW];
+    memset(out, 0, sizeof(*out));
+    portENTER_CRITICAL(&g_capture_spinlock);
+    out->armed = ch->armed;
+    out->matched = ch->matched;
+    for (int e = 0; e < EDGE_COUNT; e++) {
+        out->pending += (uint32_t)ch->pending[e] + (uint32_t)ch->late_pending[e];
+    }
+    out->missed = ch->missed;
+    out->stray = ch->stray;
+    out->samples = ch->count;
+    out->max_us = ch->max_us;
+    out->max_cdeg = ch->max_cdeg;
+    out->hw_timestamp = ch->hw_timestamp;
+    memcpy(err_us, ch->err_us, sizeof(err_us));
+    memcpy(err_cdeg, ch->err_cdeg, sizeof(err_cdeg));
+    portEXIT_CRITICAL(&g_capture_spinlock);
+
+    uint16_t n = (uint16_t)out->samples;
+    out->p50_us = window_percentile(err_us, n, 50);
+    out->p99_us = window_percentile(err_us, n, 99);
+    out->p50_cdeg = window_percentile(err_cdeg, n, 50);
+    out->p99_cdeg = window_percentile(err_cdeg, n, 99);
+    return ESP_OK;
+}
+
+void output_capture_reset_stats(void) {
+    portENTER_CRITICAL(&g_capture_spinlock);
+    for (int k = 0; k < OUTPUT_CAPTURE_KIND_COUNT; k++) {
+        for (size_t c = 0; c < OUTPUT_CAPTURE_CHANNELS; c++) {
+            output_channel_t *ch = &g_channels[k][c];
+            // Transitions still expected stay counted, so that each armed
+            // one resolves into matched or missed
+            ch->armed = 0;
+            for (int e = 0; e < EDGE_COUNT; e++) {
+                ch->armed += (uint32_t)ch->pending[e] + (uint32_t)ch->late_pending[e];
+            }
+            ch->matched = 0;
+            ch->missed = 0;
+            ch->stray = 0;
+            ch->max_us = 0;
+            ch->max_cdeg = 0;
+            ch->head = 0;
+            ch->count = 0;
+        }
+    }
+    portEXIT_CRITICAL(&g_capture_spinlock);
+}
@@ -0,0 +1,166 @@
+#include "../include/replay_capture.h"
+#include "../include/s3_control_config.h"
+#include "../include/timebase.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+typedef struct {
+    replay_record_t *buf;
+    uint32_t capacity;
+    uint32_t head;           // Next slot to write
+    uint32_t count;          // Valid records, up to capacity
+    uint32_t seq;
+    uint32_t dropped;
+    bool overwrite;
+    uint64_t start_us;
+    engine_layout_t layout;
+    uint16_t last_adc[REPLAY_ADC_CHANNELS];
+    bool have_adc;
+} replay_capture_t;
+
+static replay_capture_t g_capture = {0};
+static volatile bool g_capture_running = false;
+static portMUX_TYPE g_capture_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+// Caller holds g_capture_spinlock; NULL when the record is dropped
+IRAM_ATTR static replay_record_t *capture_slot(void) {
+    if (g_capture.count == g_capture.capacity) {
+        g_capture.dropped++;
+        if (!g_capture.overwrite) {
+            return NULL;
+        }
+    } else {
+        g_capture.count++;
+    }
+    replay_record_t *r = &g_capture.buf[g_capture.head];
+    g_capture.head = (g_capture.head + 1U == g_capture.capacity) ? 0U : g_capture.head + 1U;
+    r->seq = g_capture.seq++;
+    return r;
+}
+
+esp_err_t replay_capture_start(replay_record_t *buffer, uint32_t capacity, bool overwrite) {
+    if (!buffer || capacity == 0U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_capture_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    portENTER_CRITICAL(&g_capture_spinlock);
+    memset(&g_capture, 0, sizeof(g_capture));
+    g_capture.buf = buffer;
+    g_capture.capacity = capacity;
+    g_capture.overwrite = overwrite;
+    g_capture.start_us = timebase_now_us();
+    g_capture.layout = *engine_layout_get();
+    g_capture_running = true;
+    portEXIT_CRITICAL(&g_capture_spinlock);
+    return ESP_OK;
+}
+
+void replay_capture_stop(void) {
+    portENTER_CRITICAL(&g_capture_spinlock);
+    g_capture_running = false;
+    portEXIT_CRITICAL(&g_capture_spinlock);
+}
+
+bool replay_capture_is_running(void) {
+    return g_capture_running;
+}
+
+uint32_t replay_capture_copy(replay_capture_header_t *header, replay_record_t *out, uint32_t max) {
+    if (g_capture_running || (!out && max > 0U)) {
+        return 0;
+    }
+    uint32_t n = (g_capture.count < max) ? g_capture.count : max;
+    uint32_t first = (g_capture.head + g_capture.capacity - g_capture.count) % (g_capture.capacity ? g_capture.capacity : 1U);
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = g_capture.buf[(first + i) % g_capture.capacity];
+    }
+    if (header) {
+        memset(header, 0, sizeof(*header));
+        header->magic = REPLAY_CAPTURE_MAGIC;
+        header->version = REPLAY_CAPTURE_VERSION;
+        header->record_size = (uint16_t)sizeof(replay_record_t);
+        header->records = n;
+        header->dropped = g_capture.dropped + (g_capture.count - n);
+        header->start_us = g_capture.start_us;
+        header->ckp_gpio = CKP_GPIO;
+        header->cmp_gpio = CMP_GPIO;
+        header->layout = g_capture.layout;
+    }
+    return n;
+}
+
+IRAM_ATTR void replay_capture_edge(replay_record_type_t type, uint64_t time_us, bool from_isr) {
+    if (!g_capture_running) {
+        return;
+    }
+    if (from_isr) {
+        portENTER_CRITICAL_ISR(&g_capture_spinlock);
+    } else {
+        portENTER_CRITICAL(&g_capture_spinlock);
+    }
+    replay_record_t *r = g_capture_running ? capture_slot() : NULL;
+    if (r) {
+        r->time_us = time_us;
+        r->type = (uint8_t)type;
+        r->count = 0;
+        r->reserved = 0;
+        memset(&r->u, 0, sizeof(r->u));
+    }
+    if (from_isr) {
+        portEXIT_CRITICAL_ISR(&g_capture_spinlock);
+    } else {
+        portEXIT_CRITICAL(&g_capture_spinlock);
+    }
+}
+
+void replay_capture_adc(const uint16_t *raw, uint8_t channels) {
+    if (!g_capture_running || !raw) {
+        return;
+    }
+    if (channels > REPLAY_ADC_CHANNELS) {
+        channels = REPLAY_ADC_CHANNELS;
+    }
+    uint64_t now_us = timebase_now_us();
+    portENTER_CRITICAL(&g_capture_spinlock);
+    // Unchanged blocks carry no information for the replay
+    bool changed = !g_capture.have_adc || memcmp(g_capture.last_adc, raw, channels * sizeof(uint16_t)) != 0;
+    replay_record_t *r = (g_capture_running && changed) ? capture_slot() : NULL;
+    if (r) {
+        r->time_us = now_us;
+        r->type = REPLAY_RECORD_ADC;
+        r->count = channels;
+        r->reserved = 0;
+        memset(&r->u, 0, sizeof(r->u));
+        memcpy(r->u.adc_raw, raw, channels * sizeof(uint16_t));
+        memcpy(g_capture.last_adc, raw, channels * sizeof(uint16_t));
+        g_capture.have_adc = true;
+    }
+    portEXIT_CRITICAL(&g_capture_spinlock);
+}
+
+void replay_capture_can(uint32_t identifier, const uint8_t *data, uint8_t dlc) {
+    if (!g_capture_running) {
+        return;
+    }
+    if (dlc > 8U) {
+        dlc = 8U;
+    }
+    uint64_t now_us = timebase_now_us();
+    portENTER_CRITICAL(&g_capture_spinlock);
+    replay_record_t *r = g_capture_running ? capture_slot() : NULL;
+    if (r) {
+        r->time_us = now_us;
+        r->type = REPLAY_RECORD_CAN;
+        r->count = dlc;
+        r->reserved = 0;
+        memset(&r->u, 0, sizeof(r->u));
+        r->u.can.identifier = identifier;
+        if (data && dlc > 0U) {
+            memcpy(r->u.can.data, data, dlc);
+        }
+    }
+    portEXIT_CRITICAL(&g_capture_spinlock);
+}
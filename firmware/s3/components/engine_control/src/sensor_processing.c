@@ -1,5 +1,7 @@
 #include "../include/sensor_processing.h"
 #include "../include/logger.h"
+#include "../include/replay_capture.h"
+#include "../include/core_plan.h"
 #include "esp_adc/adc_continuous.h"
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
@@ -113,10 +115,7 @@ esp_err_t sensor_start(void) {
     }
 
     // Create sensor processing task
-    BaseType_t result = xTaskCreatePinnedToCore(process_sensors_task, "sensor_task",
-                                                SENSOR_TASK_STACK, NULL, SENSOR_TASK_PRIORITY, &g_sensor_task_handle,
-                                                SENSOR_TASK_CORE);
-    if (result != pdPASS) {
+    if (core_plan_create_task(CORE_TASK_SENSOR, process_sensors_task, NULL, &g_sensor_task_handle) != ESP_OK) {
         ESP_LOGE("SENSOR", "Failed to create sensor task");
         return ESP_FAIL;
     }
@@ -328,6 +327,8 @@ void process_sensors_task(void *pvParameters) {
                 low_rate_decimator++;
                 __atomic_fetch_add(&g_sensor_seq, 1U, __ATOMIC_RELEASE); // even: stable snapshot
                 xSemaphoreGive(g_sensor_mutex);
+                // Only this task writes raw_adc
+                replay_capture_adc(g_sensor_data.raw_adc, SENSOR_COUNT);
             }
         }
 
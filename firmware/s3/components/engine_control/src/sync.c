@@ -1,4 +1,8 @@
 #include "../include/sync.h"
+#include "../include/trigger_decoder.h"
+#include "../include/timebase.h"
+#include "../include/replay_capture.h"
+#include "../include/core_plan.h"
 #include "../include/logger.h"
 #include "../include/s3_control_config.h"
 #include "driver/pulse_cnt.h"
@@ -26,11 +30,15 @@ static sync_config_t g_sync_config = {
     .gap_tooth = 58,             // Gap occurs after tooth 58
     .max_rpm = 8000,
     .min_rpm = 500,
-    .enable_phase_detection = true
+    .enable_phase_detection = true,
+    .pattern = TRIGGER_PATTERN_MISSING_TOOTH,
+    .missing_teeth = 2,
+    .sync_tooth_deg = 0,
+    .cam_speed = false
 };
 static pcnt_unit_handle_t g_sync_pcnt_unit = NULL;
 static pcnt_channel_handle_t g_sync_pcnt_chan = NULL;
-static gptimer_handle_t g_sync_gptimer = NULL;
+static gptimer_handle_t g_sync_gptimer = NULL;      // Shared timebase (timebase.h), not owned
 static esp_etm_channel_handle_t g_sync_etm_chan = NULL;
 static esp_etm_event_handle_t g_sync_gpio_event = NULL;
 static esp_etm_task_handle_t g_sync_timer_task = NULL;
@@ -48,7 +56,23 @@ static bool g_hw_sync_enabled = false;
 static bool g_sync_use_watch_step = false;
 static sync_tooth_callback_t g_tooth_cb = NULL;
 static void *g_tooth_cb_ctx = NULL;
+static latency_hist_t g_ckp_isr_cycles;
 static const uint32_t SYNC_VALID_TIMEOUT_US = 200000U;
+// Seqlock: odd while the capture path rewrites g_snapshot
+#define SYNC_SNAPSHOT_RETRIES 8U
+static sync_snapshot_t g_snapshot = {0};
+static uint32_t g_snapshot_seq = 0;
+
+// Trigger decoder and its wheel table. sync_set_config() builds the new table
+// into the spare slot and swaps the pointer under the spinlock, so the
+// capture path only does table reads and multiplies.
+static const trigger_decoder_t *g_decoder = NULL;
+static trigger_wheel_t g_wheels[2];
+static const trigger_wheel_t *g_wheel = &g_wheels[0];
+static trigger_state_t g_trigger_state;
+
+// 60e6 / 360 in Q12: RPM from microseconds per degree (Q16 >> 4)
+#define SYNC_RPM_US_PER_DEG_Q12 682666667U
 
 static void sync_update_from_capture(uint64_t capture_us, bool from_isr, bool emit_log);
 static void sync_update_cmp_capture(uint64_t capture_us, bool from_isr);
@@ -59,6 +83,7 @@ static bool sync_pcnt_on_reach(pcnt_unit_handle_t unit,
                                          void *user_ctx);
 static esp_err_t sync_init_hardware_capture(void);
 static void sync_deinit_hardware_capture(void);
+static void sync_publish_snapshot(void);
 
 // Initialize SYNC module
 esp_err_t sync_init(void) {
@@ -66,6 +91,20 @@ esp_err_t sync_init(void) {
         return ESP_ERR_INVALID_STATE;
     }
 
+    g_decoder = trigger_decoder_get(g_sync_config.pattern);
+    if (g_decoder == NULL || g_decoder->build(&g_sync_config, &g_wheels[0]) != ESP_OK) {
+        ESP_LOGE("SYNC", "Invalid default trigger wheel");
+        return ESP_ERR_INVALID_ARG;
+    }
+    g_wheel = &g_wheels[0];
+    trigger_state_reset(&g_trigger_state);
+
+    // CKP captures land on the shared timebase
+    esp_err_t tb_err = timebase_init();
+    if (tb_err != ESP_OK) {
+        return tb_err;
+    }
+
     // Create mutex
     g_sync_mutex = xSemaphoreCreateMutex();
     if (g_sync_mutex == NULL) {
@@ -235,6 +274,8 @@ esp_err_t sync_start(void) {
         g_sync_data.revolution_index = 0;
         g_last_capture_us = 0;
         g_last_cmp_capture_us = 0;
+        trigger_state_reset(&g_trigger_state);
+        sync_publish_snapshot();
         portEXIT_CRITICAL(&g_sync_spinlock);
 
         // Enable PCNT counter
@@ -242,10 +283,6 @@ esp_err_t sync_start(void) {
         pcnt_unit_clear_count(g_sync_pcnt_unit);
         pcnt_unit_start(g_sync_pcnt_unit);
 
-        if (g_sync_gptimer) {
-            gptimer_set_raw_count(g_sync_gptimer, 0);
-            gptimer_start(g_sync_gptimer);
-        }
         if (g_cmp_gptimer) {
             gptimer_set_raw_count(g_cmp_gptimer, 0);
             gptimer_start(g_cmp_gptimer);
@@ -285,9 +322,6 @@ esp_err_t sync_stop(void) {
             esp_etm_channel_disable(g_cmp_etm_chan);
         }
 #endif
-        if (g_sync_gptimer) {
-            gptimer_stop(g_sync_gptimer);
-        }
         if (g_cmp_gptimer) {
             gptimer_stop(g_cmp_gptimer);
         }
@@ -320,6 +354,8 @@ esp_err_t sync_reset(void) {
         g_sync_data.revolution_index = 0;
         g_last_capture_us = 0;
         g_last_cmp_capture_us = 0;
+        trigger_state_reset(&g_trigger_state);
+        sync_publish_snapshot();
         portEXIT_CRITICAL(&g_sync_spinlock);
 
         // Clear PCNT counter
@@ -332,6 +368,63 @@ esp_err_t sync_reset(void) {
     return ESP_FAIL;
 }
 
+IRAM_ATTR uint32_t sync_get_us_per_degree_q16(void) {
+    return __atomic_load_n(&g_sync_data.us_per_degree_q16, __ATOMIC_RELAXED);
+}
+
+// Writers hold g_sync_spinlock, so there is only ever one at a time
+IRAM_ATTR static void sync_publish_snapshot(void) {
+    uint32_t seq = g_snapshot_seq;
+    __atomic_store_n(&g_snapshot_seq, seq + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    g_snapshot.capture_time_us = g_sync_data.capture_time_us;
+    g_snapshot.tooth_index = g_sync_data.tooth_index;
+    g_snapshot.cycle_angle = g_sync_data.cycle_angle;
+    g_snapshot.us_per_degree_q16 = g_sync_data.us_per_degree_q16;
+    g_snapshot.tooth_period = g_sync_data.tooth_period;
+    g_snapshot.rpm = g_sync_data.sync_valid ? g_sync_data.rpm : 0U;
+    g_snapshot.tooth_angle = g_sync_data.tooth_angle;
+    g_snapshot.tooth_pitch = g_sync_data.tooth_pitch;
+    g_snapshot.revolution_index = g_sync_data.revolution_index;
+    g_snapshot.flags = (uint8_t)((g_sync_data.sync_acquired ? SYNC_SNAP_ACQUIRED : 0U) |
+                                 (g_sync_data.phase_detected ? SYNC_SNAP_PHASE : 0U) |
+                                 (g_sync_data.gap_detected ? SYNC_SNAP_GAP : 0U));
+    __atomic_store_n(&g_snapshot_seq, seq + 2U, __ATOMIC_RELEASE);
+}
+
+IRAM_ATTR esp_err_t sync_get_snapshot(sync_snapshot_t *out) {
+    if (g_sync_mutex == NULL || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    bool copied = false;
+    for (uint32_t i = 0; i < SYNC_SNAPSHOT_RETRIES && !copied; i++) {
+        uint32_t seq1 = __atomic_load_n(&g_snapshot_seq, __ATOMIC_ACQUIRE);
+        if (seq1 & 1U) {
+            continue;
+        }
+        *out = g_snapshot;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        copied = (__atomic_load_n(&g_snapshot_seq, __ATOMIC_RELAXED) == seq1);
+    }
+    if (!copied) {
+        // Teeth kept landing mid-copy: wait for the writer once
+        portENTER_CRITICAL_SAFE(&g_sync_spinlock);
+        *out = g_snapshot;
+        portEXIT_CRITICAL_SAFE(&g_sync_spinlock);
+    }
+
+    // Same freshness rule as sync_get_data(), on the full-width timebase
+    uint64_t now_us = timebase_now_us();
+    bool fresh = out->capture_time_us != 0U && now_us >= out->capture_time_us &&
+                 (now_us - out->capture_time_us) < SYNC_VALID_TIMEOUT_US;
+    if (out->rpm > 0U && fresh) {
+        out->flags |= SYNC_SNAP_VALID;
+    } else {
+        out->flags &= (uint8_t)~(SYNC_SNAP_VALID | SYNC_SNAP_ACQUIRED);
+    }
+    return ESP_OK;
+}
+
 // Get sync data
 esp_err_t sync_get_data(sync_data_t *data) {
     if (g_sync_mutex == NULL || data == NULL) {
@@ -342,7 +435,8 @@ esp_err_t sync_get_data(sync_data_t *data) {
     memcpy(data, &g_sync_data, sizeof(sync_data_t));
     portEXIT_CRITICAL(&g_sync_spinlock);
 
-    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    // Same clock as the captures
+    uint32_t now_us = (uint32_t)timebase_now_us();
     
     // Handle timer overflow correctly
     // 32-bit µs overflow occurs every ~72 minutes
@@ -379,11 +473,34 @@ esp_err_t sync_set_config(const sync_config_t *config) {
         config->max_rpm < config->min_rpm) {
         return ESP_ERR_INVALID_ARG;
     }
+    const trigger_decoder_t *decoder = trigger_decoder_get(config->pattern);
+    if (decoder == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    portENTER_CRITICAL(&g_sync_spinlock);
-    g_sync_config = *config;
-    portEXIT_CRITICAL(&g_sync_spinlock);
-    ESP_LOGI("SYNC", "SYNC configuration updated");
+    if (xSemaphoreTake(g_sync_mutex, portMAX_DELAY) != pdTRUE) {
+        return ESP_FAIL;
+    }
+    // The capture path only reads g_wheel, so the other slot is free
+    trigger_wheel_t *spare = (g_wheel == &g_wheels[0]) ? &g_wheels[1] : &g_wheels[0];
+    esp_err_t err = decoder->build(config, spare);
+    if (err == ESP_OK) {
+        portENTER_CRITICAL(&g_sync_spinlock);
+        g_sync_config = *config;
+        g_decoder = decoder;
+        g_wheel = spare;
+        // Tooth positions of the old wheel mean nothing on the new one
+        trigger_state_reset(&g_trigger_state);
+        g_sync_data.sync_acquired = false;
+        sync_publish_snapshot();
+        portEXIT_CRITICAL(&g_sync_spinlock);
+    }
+    xSemaphoreGive(g_sync_mutex);
+    if (err != ESP_OK) {
+        return err;
+    }
+    ESP_LOGI("SYNC", "SYNC configuration updated (%s wheel, %" PRIu32 " edges)",
+             decoder->name, (uint32_t)spare->edges);
     return ESP_OK;
 }
 
@@ -414,7 +531,16 @@ void sync_unregister_tooth_callback(void) {
     portEXIT_CRITICAL(&g_sync_spinlock);
 }
 
+void sync_get_isr_latency(latency_summary_t *out) {
+    latency_hist_summary(&g_ckp_isr_cycles, out);
+}
+
+void sync_reset_isr_latency(void) {
+    latency_hist_reset(&g_ckp_isr_cycles);
+}
+
 IRAM_ATTR static void sync_update_from_capture(uint64_t capture_us, bool from_isr, bool emit_log) {
+    replay_capture_edge(REPLAY_RECORD_CKP, capture_us, from_isr);
     if (from_isr) {
         portENTER_CRITICAL_ISR(&g_sync_spinlock);
     } else {
@@ -426,6 +552,7 @@ IRAM_ATTR static void sync_update_from_capture(uint64_t capture_us, bool from_is
         g_sync_data.last_tooth_time = (uint32_t)capture_us;
         g_sync_data.last_capture_time = (uint32_t)capture_us;
         g_sync_data.last_update_time = (uint32_t)esp_timer_get_time();
+        sync_publish_snapshot();
         if (from_isr) {
             portEXIT_CRITICAL_ISR(&g_sync_spinlock);
         } else {
@@ -439,6 +566,7 @@ IRAM_ATTR static void sync_update_from_capture(uint64_t capture_us, bool from_is
         g_sync_data.last_capture_time = (uint32_t)capture_us;
         g_sync_data.sync_valid = false;
         g_sync_data.sync_acquired = false;
+        sync_publish_snapshot();
         if (from_isr) {
             portEXIT_CRITICAL_ISR(&g_sync_spinlock);
         } else {
@@ -449,20 +577,29 @@ IRAM_ATTR static void sync_update_from_capture(uint64_t capture_us, bool from_is
 
     uint32_t tooth_period = (uint32_t)(capture_us - g_last_capture_us);
     g_last_capture_us = capture_us;
+    g_sync_data.capture_time_us = capture_us;
     g_sync_data.last_tooth_time = (uint32_t)capture_us;
     g_sync_data.last_capture_time = (uint32_t)capture_us;
     g_sync_data.last_update_time = (uint32_t)esp_timer_get_time();
 
-    bool gap = false;
-    if (g_sync_data.tooth_period > 0) {
-        gap = (tooth_period > (g_sync_data.tooth_period * 3) / 2);
+    const trigger_wheel_t *wheel = g_wheel;
+    trigger_edge_t edge = g_decoder->decode(&g_trigger_state, wheel, tooth_period);
+    bool gap = (edge == TRIGGER_EDGE_REFERENCE);
+    g_sync_data.tooth_index = g_trigger_state.tooth_index;
+
+    if (edge == TRIGGER_EDGE_SYNC_LOST) {
+        g_sync_data.sync_loss_count++;
+        g_sync_data.sync_acquired = false;
     }
 
     if (gap) {
         g_sync_data.gap_detected = true;
-        g_sync_data.tooth_index = 0;
         g_sync_data.gap_period = tooth_period;
-        if (g_sync_data.cmp_seen) {
+        if (wheel->cam_speed) {
+            // The wheel itself marks the cycle
+            g_sync_data.phase_detected = true;
+            g_sync_data.phase_detected_time = (uint32_t)capture_us;
+        } else if (g_sync_data.cmp_seen) {
             g_sync_data.phase_detected = true;
             g_sync_data.phase_detected_time = (uint32_t)capture_us;
             g_sync_data.revolution_index = 0;
@@ -473,23 +610,21 @@ IRAM_ATTR static void sync_update_from_capture(uint64_t capture_us, bool from_is
         g_sync_data.cmp_seen = false;
     } else {
         g_sync_data.gap_detected = false;
-        if (g_sync_config.tooth_count > 0) {
-            g_sync_data.tooth_index = (g_sync_data.tooth_index + 1) % g_sync_config.tooth_count;
-        } else {
-            g_sync_data.tooth_index = 0;
-        }
     }
 
-    if (gap) {
-        g_sync_data.tooth_period = tooth_period / 3;
+    // Period over the angle this edge spanned, from the wheel table
+    g_sync_data.tooth_period = g_trigger_state.pitch_period;
+    g_sync_data.us_per_degree_q16 = g_trigger_state.us_per_degree_q16;
+    g_sync_data.time_per_degree = (g_sync_data.us_per_degree_q16 + 0x8000U) >> 16;
+    g_sync_data.tooth_pitch = wheel->pitch;
+    uint32_t angle = wheel->angle[g_sync_data.tooth_index % SYNC_MAX_TEETH];
+    if (wheel->cam_speed) {
+        g_sync_data.revolution_index = (angle >= 360U * SYNC_ANGLE_SCALE) ? 1U : 0U;
+        g_sync_data.cycle_angle = angle;
+        g_sync_data.tooth_angle = (uint16_t)(angle - (g_sync_data.revolution_index ? 360U * SYNC_ANGLE_SCALE : 0U));
     } else {
-        g_sync_data.tooth_period = tooth_period;
-    }
-
-    // Calculate time per degree using total positions (teeth + missing)
-    uint32_t total_positions = g_sync_config.tooth_count + 2;
-    if (total_positions > 0) {
-        g_sync_data.time_per_degree = ((g_sync_data.tooth_period * total_positions) + 180U) / 360U;
+        g_sync_data.tooth_angle = (uint16_t)angle;
+        g_sync_data.cycle_angle = angle + (g_sync_data.revolution_index ? 360U * SYNC_ANGLE_SCALE : 0U);
     }
 
     if (!g_sync_config.enable_phase_detection) {
@@ -499,16 +634,13 @@ IRAM_ATTR static void sync_update_from_capture(uint64_t capture_us, bool from_is
     if (g_sync_data.gap_detected && g_sync_data.phase_detected) {
         g_sync_data.sync_acquired = true;
     }
-    if (g_sync_data.tooth_period > 0) {
-        uint32_t positions_per_revolution = g_sync_config.tooth_count + 2;
-        uint32_t time_per_revolution = g_sync_data.tooth_period * positions_per_revolution;
-        if (time_per_revolution > 0) {
-            g_sync_data.rpm = (1000000 * 60) / time_per_revolution;
-            if (g_sync_data.rpm < g_sync_config.min_rpm) {
-                g_sync_data.rpm = 0;
-            } else if (g_sync_data.rpm > g_sync_config.max_rpm) {
-                g_sync_data.rpm = g_sync_config.max_rpm;
-            }
+    uint32_t us_per_degree_q12 = g_sync_data.us_per_degree_q16 >> 4;
+    if (us_per_degree_q12 > 0) {
+        g_sync_data.rpm = SYNC_RPM_US_PER_DEG_Q12 / us_per_degree_q12;
+        if (g_sync_data.rpm < g_sync_config.min_rpm) {
+            g_sync_data.rpm = 0;
+        } else if (g_sync_data.rpm > g_sync_config.max_rpm) {
+            g_sync_data.rpm = g_sync_config.max_rpm;
         }
     }
 
@@ -516,6 +648,7 @@ IRAM_ATTR static void sync_update_from_capture(uint64_t capture_us, bool from_is
     if (!g_sync_data.sync_valid) {
         g_sync_data.sync_acquired = false;
     }
+    sync_publish_snapshot();
 
     if (from_isr) {
         portEXIT_CRITICAL_ISR(&g_sync_spinlock);
@@ -529,6 +662,7 @@ IRAM_ATTR static void sync_update_from_capture(uint64_t capture_us, bool from_is
 }
 
 IRAM_ATTR static void sync_update_cmp_capture(uint64_t capture_us, bool from_isr) {
+    replay_capture_edge(REPLAY_RECORD_CMP, capture_us, from_isr);
     if (from_isr) {
         portENTER_CRITICAL_ISR(&g_sync_spinlock);
     } else {
@@ -550,46 +684,39 @@ IRAM_ATTR static void sync_update_cmp_capture(uint64_t capture_us, bool from_isr
 
 static void IRAM_ATTR sync_cmp_gpio_isr(void *arg) {
     (void)arg;
+    core_plan_isr_mark(CORE_ISR_CMP);
     if (!g_hw_sync_enabled) {
         return;
     }
 
+    uint64_t capture_us = timebase_now_us();
     if (g_cmp_gptimer) {
-        uint64_t capture_us = 0;
-        gptimer_get_captured_count(g_cmp_gptimer, &capture_us);
-        sync_update_cmp_capture(capture_us, true);
-        return;
+        // The CMP timer has its own capture register: carry its age over
+        uint64_t captured = 0;
+        uint64_t cmp_now = 0;
+        gptimer_get_captured_count(g_cmp_gptimer, &captured);
+        gptimer_get_raw_count(g_cmp_gptimer, &cmp_now);
+        capture_us -= (cmp_now - captured);
     }
-
-    uint64_t capture_us = esp_timer_get_time();
     sync_update_cmp_capture(capture_us, true);
 }
 
 static void IRAM_ATTR sync_ckp_gpio_isr(void *arg) {
     (void)arg;
-    if (!g_hw_sync_enabled) {
-        return;
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    core_plan_isr_mark(CORE_ISR_CKP);
+    if (g_hw_sync_enabled) {
+        sync_update_from_capture(timebase_now_us(), true, false);
     }
-    uint64_t capture_us = esp_timer_get_time();
-    sync_update_from_capture(capture_us, true, false);
+    latency_hist_record(&g_ckp_isr_cycles, esp_cpu_get_cycle_count() - t0);
 }
 
-static bool IRAM_ATTR sync_pcnt_on_reach(pcnt_unit_handle_t unit,
-                                         const pcnt_watch_event_data_t *edata,
-                                         void *user_ctx) {
-    (void)unit;
-    (void)edata;
-    (void)user_ctx;
-
-    if (!g_hw_sync_enabled) {
-        return false;
-    }
-
+static void IRAM_ATTR sync_pcnt_tooth(pcnt_unit_handle_t unit) {
     uint64_t capture_us = 0;
     if (g_sync_gptimer) {
         gptimer_get_captured_count(g_sync_gptimer, &capture_us);
     } else {
-        capture_us = esp_timer_get_time();
+        capture_us = timebase_now_us();
     }
     sync_update_from_capture(capture_us, true, false);
     if (!g_sync_use_watch_step) {
@@ -600,36 +727,34 @@ static bool IRAM_ATTR sync_pcnt_on_reach(pcnt_unit_handle_t unit,
     if (cb != NULL) {
         cb(cb_ctx);
     }
+}
+
+static bool IRAM_ATTR sync_pcnt_on_reach(pcnt_unit_handle_t unit,
+                                         const pcnt_watch_event_data_t *edata,
+                                         void *user_ctx) {
+    (void)edata;
+    (void)user_ctx;
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    core_plan_isr_mark(CORE_ISR_CKP);
+    if (g_hw_sync_enabled) {
+        sync_pcnt_tooth(unit);
+    }
+    latency_hist_record(&g_ckp_isr_cycles, esp_cpu_get_cycle_count() - t0);
     return false;
 }
 
 static esp_err_t sync_init_hardware_capture(void) {
 #if SOC_GPTIMER_SUPPORT_ETM
-    gptimer_config_t timer_config = {
-        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
-        .direction = GPTIMER_COUNT_UP,
-        .resolution_hz = g_timer_resolution_hz,
-        .intr_priority = 0,
-        .flags = {
-            .intr_shared = 0,
-            .allow_pd = 0,
-        },
-    };
-
-    esp_err_t err = gptimer_new_timer(&timer_config, &g_sync_gptimer);
-    if (err != ESP_OK) {
-        return err;
-    }
-
-    err = gptimer_enable(g_sync_gptimer);
-    if (err != ESP_OK) {
-        return err;
+    // CKP edges are captured straight into the shared timebase
+    g_sync_gptimer = timebase_get_timer();
+    if (g_sync_gptimer == NULL) {
+        return ESP_ERR_INVALID_STATE;
     }
 
     gptimer_etm_task_config_t gptimer_task_conf = {
         .task_type = GPTIMER_ETM_TASK_CAPTURE,
     };
-    err = gptimer_new_etm_task(g_sync_gptimer, &gptimer_task_conf, &g_sync_timer_task);
+    esp_err_t err = gptimer_new_etm_task(g_sync_gptimer, &gptimer_task_conf, &g_sync_timer_task);
     if (err != ESP_OK) {
         return err;
     }
@@ -773,11 +898,6 @@ static void sync_deinit_hardware_capture(void) {
         esp_etm_channel_disable(g_sync_etm_chan);
     }
 
-    if (g_sync_gptimer) {
-        gptimer_stop(g_sync_gptimer);
-        gptimer_disable(g_sync_gptimer);
-    }
-
     if (g_cmp_etm_chan) {
         esp_etm_channel_disable(g_cmp_etm_chan);
     }
@@ -802,10 +922,7 @@ static void sync_deinit_hardware_capture(void) {
         g_sync_etm_chan = NULL;
     }
 
-    if (g_sync_gptimer) {
-        gptimer_del_timer(g_sync_gptimer);
-        g_sync_gptimer = NULL;
-    }
+    g_sync_gptimer = NULL;
 
     if (g_cmp_timer_task) {
         esp_etm_del_task(g_cmp_timer_task);
@@ -0,0 +1,90 @@
+#include "../include/task_profiler.h"
+#include "../include/core_plan.h"
+#include "../include/engine_control.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const engine_perf_stage_t g_latency_stages[ESPNOW_PROFILE_LATENCIES] = {
+    ENGINE_PERF_PLANNER_WAKE,
+    ENGINE_PERF_EXECUTOR_WAKE,
+    ENGINE_PERF_CKP_ISR,
+};
+
+// Written by the monitor task, read by the CLI
+static espnow_task_profile_t g_last;
+static bool g_have_last = false;
+static portMUX_TYPE g_profile_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+// The profiler's own window, apart from the core plan audit's
+static core_plan_window_t g_window;
+
+static uint16_t clamp_u16(uint32_t v) {
+    return (v > UINT16_MAX) ? UINT16_MAX : (uint16_t)v;
+}
+
+static void profile_task(const core_plan_task_sample_t *s, void *ctx) {
+    espnow_task_profile_t *rec = ctx;
+    for (uint32_t id = 0; id < CORE_TASK_COUNT; id++) {
+        if (s->status->xHandle != core_plan_get_handle((core_task_id_t)id) ||
+            rec->task_count >= ESPNOW_PROFILE_TASKS) {
+            continue;
+        }
+        espnow_task_entry_t *t = &rec->tasks[rec->task_count++];
+        t->task = (uint8_t)id;
+        t->core = (s->core >= 0) ? (uint8_t)s->core : 0xFFU;
+        t->load_permille = s->load_permille;
+        t->stack_free = clamp_u16(s->status->usStackHighWaterMark);
+        t->stack_size = clamp_u16(core_plan_get_task((core_task_id_t)id)->stack);
+    }
+}
+
+static esp_err_t profile_tasks(espnow_task_profile_t *rec) {
+    core_plan_load_t load;
+    esp_err_t err = core_plan_sample_tasks(&g_window, profile_task, rec, &load);
+    if (err != ESP_OK) {
+        return err;
+    }
+    rec->window_ms = load.window_us / 1000U;
+    memcpy(rec->core_load_permille, load.core_load_permille, sizeof(rec->core_load_permille));
+    return ESP_OK;
+}
+
+esp_err_t task_profiler_sample(uint32_t now_ms, espnow_task_profile_t *out) {
+    espnow_task_profile_t rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.timestamp_ms = now_ms;
+    esp_err_t err = profile_tasks(&rec);
+
+    for (uint32_t i = 0; i < ESPNOW_PROFILE_LATENCIES; i++) {
+        latency_summary_t sum;
+        if (engine_control_get_perf_latency(g_latency_stages[i], &sum) == ESP_OK) {
+            rec.latency[i].p99_ns = sum.p99;
+            rec.latency[i].max_ns = sum.max;
+        }
+    }
+
+    portENTER_CRITICAL(&g_profile_spinlock);
+    g_last = rec;
+    g_have_last = true;
+    portEXIT_CRITICAL(&g_profile_spinlock);
+    if (out) {
+        *out = rec;
+    }
+    return err;
+}
+
+esp_err_t task_profiler_restart(void) {
+    return core_plan_sample_tasks(&g_window, NULL, NULL, NULL);
+}
+
+esp_err_t task_profiler_get_last(espnow_task_profile_t *out) {
+    if (out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&g_profile_spinlock);
+    bool have = g_have_last;
+    *out = g_last;
+    portEXIT_CRITICAL(&g_profile_spinlock);
+    return have ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
@@ -0,0 +1,169 @@
+#include "../include/timebase.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+
+static const char *TAG = "TIMEBASE";
+
+static gptimer_handle_t g_ref_timer = NULL;
+static bool g_initialized = false;
+static timebase_mcpwm_t *g_attached[TIMEBASE_MAX_MCPWM_TIMERS];
+static timebase_stats_t g_stats;
+static portMUX_TYPE g_timebase_spinlock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t timebase_init(void) {
+    if (g_initialized) {
+        return ESP_OK;
+    }
+    memset(g_attached, 0, sizeof(g_attached));
+    memset(&g_stats, 0, sizeof(g_stats));
+
+    gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = TIMEBASE_RESOLUTION_HZ,
+        .intr_priority = 0,
+        .flags = {
+            .intr_shared = 0,
+            .allow_pd = 0,
+        },
+    };
+    esp_err_t err = gptimer_new_timer(&timer_config, &g_ref_timer);
+    if (err == ESP_OK) {
+        err = gptimer_enable(g_ref_timer);
+    }
+    if (err == ESP_OK) {
+        err = gptimer_set_raw_count(g_ref_timer, 0);
+    }
+    if (err == ESP_OK) {
+        err = gptimer_start(g_ref_timer);
+    }
+    if (err != ESP_OK) {
+        // Still usable: time falls back to esp_timer, captures to ISR time
+        ESP_LOGW(TAG, "Reference GPTimer unavailable (%s), using esp_timer", esp_err_to_name(err));
+        if (g_ref_timer != NULL) {
+            gptimer_disable(g_ref_timer);
+            gptimer_del_timer(g_ref_timer);
+            g_ref_timer = NULL;
+        }
+    }
+    g_initialized = true;
+    return ESP_OK;
+}
+
+void timebase_deinit(void) {
+    if (!g_initialized) {
+        return;
+    }
+    if (g_ref_timer != NULL) {
+        gptimer_stop(g_ref_timer);
+        gptimer_disable(g_ref_timer);
+        gptimer_del_timer(g_ref_timer);
+        g_ref_timer = NULL;
+    }
+    memset(g_attached, 0, sizeof(g_attached));
+    g_initialized = false;
+}
+
+gptimer_handle_t timebase_get_timer(void) {
+    return g_ref_timer;
+}
+
+IRAM_ATTR uint64_t timebase_now_us(void) {
+    if (g_ref_timer == NULL) {
+        return (uint64_t)esp_timer_get_time();
+    }
+    uint64_t now = 0;
+    gptimer_get_raw_count(g_ref_timer, &now);
+    return now;
+}
+
+// Reference time at which the timer's counter last read 0
+static esp_err_t measure_origin(const timebase_mcpwm_t *tb, uint64_t *origin_us) {
+    uint32_t counter = 0;
+    portENTER_CRITICAL(&g_timebase_spinlock);
+    uint64_t before = timebase_now_us();
+    esp_err_t err = mcpwm_timer_get_phase(tb->timer, &counter, NULL);
+    uint64_t after = timebase_now_us();
+    portEXIT_CRITICAL(&g_timebase_spinlock);
+    if (err != ESP_OK) {
+        return err;
+    }
+    uint64_t mid = before + ((after - before) / 2U);
+    *origin_us = mid - counter;
+    return ESP_OK;
+}
+
+esp_err_t timebase_attach_mcpwm(timebase_mcpwm_t *tb, mcpwm_timer_handle_t timer, uint32_t period_ticks) {
+    if (tb == NULL || timer == NULL || period_ticks == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!g_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    tb->timer = timer;
+    tb->period_ticks = period_ticks;
+    esp_err_t err = measure_origin(tb, &tb->origin_us);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    for (uint32_t i = 0; i < TIMEBASE_MAX_MCPWM_TIMERS; i++) {
+        if (g_attached[i] == tb) {
+            return ESP_OK;
+        }
+    }
+    for (uint32_t i = 0; i < TIMEBASE_MAX_MCPWM_TIMERS; i++) {
+        if (g_attached[i] == NULL) {
+            g_attached[i] = tb;
+            g_stats.attached++;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+void timebase_detach_mcpwm(timebase_mcpwm_t *tb) {
+    for (uint32_t i = 0; i < TIMEBASE_MAX_MCPWM_TIMERS; i++) {
+        if (g_attached[i] == tb) {
+            g_attached[i] = NULL;
+            g_stats.attached--;
+        }
+    }
+}
+
+void timebase_check(void) {
+    for (uint32_t i = 0; i < TIMEBASE_MAX_MCPWM_TIMERS; i++) {
+        timebase_mcpwm_t *tb = g_attached[i];
+        uint64_t origin = 0;
+        if (tb == NULL || measure_origin(tb, &origin) != ESP_OK) {
+            continue;
+        }
+        // Origins are congruent modulo the period; compare the residue
+        int64_t period = (int64_t)tb->period_ticks;
+        int64_t skew = (int64_t)(origin - tb->origin_us) % period;
+        if (skew > period / 2) {
+            skew -= period;
+        } else if (skew < -(period / 2)) {
+            skew += period;
+        }
+        int32_t mag = (int32_t)((skew < 0) ? -skew : skew);
+        if (mag > g_stats.max_skew_ticks) {
+            g_stats.max_skew_ticks = mag;
+        }
+        if (mag > 1) {
+            tb->origin_us = origin;
+            g_stats.reanchors++;
+            ESP_LOGW(TAG, "MCPWM timer %u moved %ld ticks, re-anchored", (unsigned)i, (long)skew);
+        }
+    }
+    g_stats.checks++;
+}
+
+void timebase_get_stats(timebase_stats_t *out) {
+    if (out != NULL) {
+        *out = g_stats;
+    }
+}
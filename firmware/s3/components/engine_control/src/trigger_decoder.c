@@ -0,0 +1,196 @@
+#include "../include/trigger_decoder.h"
+#include "esp_attr.h"
+#include <string.h>
+
+// Span (num / den, in 1/64 deg) -> 1 / degrees, Q24
+static uint32_t span_inv_q24(uint64_t num, uint64_t den) {
+    return (uint32_t)(((den << (24 + SYNC_ANGLE_FRAC_BITS)) + (num / 2U)) / num);
+}
+
+static uint32_t wheel_revolution(const sync_config_t *config) {
+    return (config->cam_speed ? 720U : 360U) * SYNC_ANGLE_SCALE;
+}
+
+/*
+ * Shared per-edge state machine. The pattern only says whether this edge
+ * looks like its reference tooth; the count of regular teeth in between is
+ * checked here.
+ */
+IRAM_ATTR static inline trigger_edge_t decoder_step(trigger_state_t *state,
+                                                    const trigger_wheel_t *wheel,
+                                                    uint32_t period_us,
+                                                    bool reference) {
+    uint32_t next = state->tooth_index + 1U;
+    if (next >= wheel->edges) {
+        next = 0;
+    }
+
+    trigger_edge_t result;
+    if (reference) {
+        if (state->synced && next != 0) {
+            state->synced = false;
+            result = TRIGGER_EDGE_SYNC_LOST;
+        } else {
+            state->synced = true;
+            result = TRIGGER_EDGE_REFERENCE;
+        }
+        next = 0;
+    } else if (!state->synced) {
+        result = TRIGGER_EDGE_NO_SYNC;
+    } else if (next == 0) {
+        state->synced = false;
+        result = TRIGGER_EDGE_SYNC_LOST;
+    } else {
+        result = TRIGGER_EDGE_TOOTH;
+    }
+
+    // Without sync the angle an edge spans is unknown: take one nominal pitch
+    uint32_t inv_span = state->synced ? wheel->inv_span_q24[next] : wheel->inv_pitch_q24;
+    state->tooth_index = next;
+    state->us_per_degree_q16 = (uint32_t)(((uint64_t)period_us * inv_span) >> 8);
+    state->pitch_period = (uint32_t)(((uint64_t)state->us_per_degree_q16 * wheel->pitch) >>
+                                     (16 + SYNC_ANGLE_FRAC_BITS));
+    return result;
+}
+
+//=============================================================================
+// Missing-tooth wheels: N-M, reference is the first tooth after the gap
+//=============================================================================
+
+static esp_err_t missing_tooth_build(const sync_config_t *config, trigger_wheel_t *wheel) {
+    uint32_t teeth = config->tooth_count;
+    uint32_t positions = teeth + config->missing_teeth;
+    if (config->missing_teeth == 0 || teeth < 2U || teeth > SYNC_MAX_TEETH) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t revolution = wheel_revolution(config);
+    memset(wheel, 0, sizeof(*wheel));
+    for (uint32_t i = 0; i < teeth; i++) {
+        wheel->angle[i] = (uint16_t)(((i * revolution) + (positions / 2U)) / positions);
+        wheel->inv_span_q24[i] = span_inv_q24(revolution, positions);
+    }
+    // The reference edge closes the gap: missing teeth + 1 pitches
+    wheel->inv_span_q24[0] = span_inv_q24((uint64_t)revolution * (config->missing_teeth + 1U), positions);
+    wheel->edges = (uint16_t)teeth;
+    wheel->inv_pitch_q24 = span_inv_q24(revolution, positions);
+    wheel->pitch = (uint16_t)((revolution + (positions / 2U)) / positions);
+    wheel->cam_speed = config->cam_speed;
+    return ESP_OK;
+}
+
+IRAM_ATTR static trigger_edge_t missing_tooth_decode(trigger_state_t *state,
+                                                     const trigger_wheel_t *wheel,
+                                                     uint32_t period_us) {
+    // Gap: more than 1.5 pitches since the last tooth
+    bool gap = (state->pitch_period > 0) &&
+               ((uint64_t)period_us * 2U > (uint64_t)state->pitch_period * 3U);
+    return decoder_step(state, wheel, period_us, gap);
+}
+
+//=============================================================================
+// N+1 wheels: N even teeth plus a sync tooth shortly after one of them,
+// reference is the sync tooth
+//=============================================================================
+
+static esp_err_t n_plus_1_build(const sync_config_t *config, trigger_wheel_t *wheel) {
+    uint32_t teeth = config->tooth_count;
+    if (teeth < 2U || teeth + 1U > SYNC_MAX_TEETH || config->sync_tooth_deg == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t revolution = wheel_revolution(config);
+    uint32_t offset = config->sync_tooth_deg * SYNC_ANGLE_SCALE;
+    // The sync tooth is found by its short period: keep it within 40% of a pitch
+    if ((uint64_t)offset * teeth * 5U > (uint64_t)revolution * 2U) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Edges: sync tooth, then teeth 1..N; tooth N is the one before the sync tooth
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->angle[0] = 0;
+    wheel->inv_span_q24[0] = span_inv_q24(offset, 1U);
+    for (uint32_t i = 1; i <= teeth; i++) {
+        wheel->angle[i] = (uint16_t)((((i * revolution) + (teeth / 2U)) / teeth) - offset);
+        wheel->inv_span_q24[i] = span_inv_q24(revolution, teeth);
+    }
+    wheel->inv_span_q24[1] = span_inv_q24(revolution - (uint64_t)offset * teeth, teeth);
+    wheel->edges = (uint16_t)(teeth + 1U);
+    wheel->inv_pitch_q24 = span_inv_q24(revolution, teeth);
+    wheel->pitch = (uint16_t)((revolution + (teeth / 2U)) / teeth);
+    wheel->cam_speed = config->cam_speed;
+    return ESP_OK;
+}
+
+IRAM_ATTR static trigger_edge_t n_plus_1_decode(trigger_state_t *state,
+                                                const trigger_wheel_t *wheel,
+                                                uint32_t period_us) {
+    // Sync tooth: less than half a pitch since the tooth before it
+    bool extra = (uint64_t)period_us * 2U < (uint64_t)state->pitch_period;
+    return decoder_step(state, wheel, period_us, extra);
+}
+
+static const trigger_decoder_t g_decoders[TRIGGER_PATTERN_COUNT] = {
+    [TRIGGER_PATTERN_MISSING_TOOTH] = {
+        .name = "missing-tooth",
+        .build = missing_tooth_build,
+        .decode = missing_tooth_decode,
+    },
+    [TRIGGER_PATTERN_N_PLUS_1] = {
+        .name = "n+1",
+        .build = n_plus_1_build,
+        .decode = n_plus_1_decode,
+    },
+};
+
+const trigger_decoder_t *trigger_decoder_get(trigger_pattern_t pattern) {
+    if ((unsigned)pattern >= TRIGGER_PATTERN_COUNT) {
+        return NULL;
+    }
+    return &g_decoders[pattern];
+}
+
+void trigger_state_reset(trigger_state_t *state) {
+    memset(state, 0, sizeof(*state));
+}
+
+//=============================================================================
+// Presets
+//=============================================================================
+
+typedef struct {
+    const char *name;
+    trigger_pattern_t pattern;
+    uint32_t tooth_count;
+    uint32_t missing_teeth;
+    uint32_t sync_tooth_deg;
+    bool cam_speed;
+} trigger_preset_t;
+
+static const trigger_preset_t g_presets[TRIGGER_WHEEL_COUNT] = {
+    [TRIGGER_WHEEL_60_2]      = { "60-2", TRIGGER_PATTERN_MISSING_TOOTH, 58, 2, 0, false },
+    [TRIGGER_WHEEL_36_1]      = { "36-1", TRIGGER_PATTERN_MISSING_TOOTH, 35, 1, 0, false },
+    [TRIGGER_WHEEL_24_1]      = { "24-1", TRIGGER_PATTERN_MISSING_TOOTH, 23, 1, 0, false },
+    [TRIGGER_WHEEL_4_PLUS_1]  = { "4+1", TRIGGER_PATTERN_N_PLUS_1, 4, 0, 30, true },
+    [TRIGGER_WHEEL_12_PLUS_1] = { "12+1", TRIGGER_PATTERN_N_PLUS_1, 12, 0, 10, false },
+};
+
+esp_err_t trigger_wheel_preset(trigger_wheel_preset_t preset, sync_config_t *config) {
+    if ((unsigned)preset >= TRIGGER_WHEEL_COUNT || config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const trigger_preset_t *p = &g_presets[preset];
+    config->pattern = p->pattern;
+    config->tooth_count = p->tooth_count;
+    config->gap_tooth = (p->pattern == TRIGGER_PATTERN_MISSING_TOOTH) ? p->tooth_count : 0;
+    config->missing_teeth = p->missing_teeth;
+    config->sync_tooth_deg = p->sync_tooth_deg;
+    config->cam_speed = p->cam_speed;
+    return ESP_OK;
+}
+
+const char *trigger_wheel_preset_name(trigger_wheel_preset_t preset) {
+    if ((unsigned)preset >= TRIGGER_WHEEL_COUNT) {
+        return "unknown";
+    }
+    return g_presets[preset].name;
+}
@@ -6,6 +6,8 @@
 #include "freertos/task.h"
 #include "../include/s3_control_config.h"
 #include "../include/engine_control.h"
+#include "../include/replay_capture.h"
+#include "../include/core_plan.h"
 #include <stdint.h>
 
 typedef enum {
@@ -78,10 +80,7 @@ esp_err_t twai_lambda_init(void) {
     }
 
     g_can_running = true;
-    BaseType_t ok = xTaskCreatePinnedToCore(can_rx_task, "twai_rx",
-                                            COMM_TASK_STACK, NULL, COMM_TASK_PRIORITY, &g_can_task,
-                                            COMM_TASK_CORE);
-    if (ok != pdPASS) {
+    if (core_plan_create_task(CORE_TASK_TWAI_RX, can_rx_task, NULL, &g_can_task) != ESP_OK) {
         g_can_running = false;
         twai_stop();
         twai_driver_uninstall();
@@ -152,6 +151,7 @@ static void can_rx_task(void *arg) {
         if (twai_receive(&msg, pdMS_TO_TICKS(100)) != ESP_OK) {
             continue;
         }
+        replay_capture_can(msg.identifier, msg.data, msg.data_length_code);
 
         if (handle_eoit_command(&msg)) {
             continue;
@@ -1,4 +1,6 @@
 #include "engine_control.h"
+#include "cli_interface.h"
+#include "core_plan.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -19,11 +21,44 @@ void app_main(void) {
     }
     
     ESP_LOGI(TAG, "Engine control system initialized successfully");
+
+    // Serial console on the USB port; the engine runs without it
+    err = cli_init();
+    if (err == ESP_OK) {
+        err = cli_start();
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "CLI unavailable: %s", esp_err_to_name(err));
+    }
     
     // Main loop - just keep the system running
+    uint32_t loops = 0;
     while (1) {
         // System is controlled by FreeRTOS tasks
         vTaskDelay(pdMS_TO_TICKS(1000));
+
+        // Core isolation audit every 10 s, load over that window
+        if (++loops % 10U == 0U) {
+            core_plan_audit_t audit;
+            if (core_plan_audit(&audit) == ESP_OK) {
+                ESP_LOGI(TAG, "Cores load c0=%u.%u%% c1=%u.%u%% | control core tasks=%" PRIu32 " foreign=%" PRIu32
+                         " | isr ckp=%" PRIu32 "/%" PRIu32 " mcpwm=%" PRIu32 "/%" PRIu32 " (c0/c1) | violations=%" PRIu32,
+                         audit.core_load_permille[0] / 10U, audit.core_load_permille[0] % 10U,
+                         audit.core_load_permille[1] / 10U, audit.core_load_permille[1] % 10U,
+                         audit.control_core_tasks, audit.foreign_tasks,
+                         audit.isr_runs[CORE_ISR_CKP][0], audit.isr_runs[CORE_ISR_CKP][1],
+                         audit.isr_runs[CORE_ISR_MCPWM][0], audit.isr_runs[CORE_ISR_MCPWM][1],
+                         audit.violations);
+                for (uint32_t i = 0; i < audit.task_count; i++) {
+                    const core_plan_task_audit_t *t = &audit.tasks[i];
+                    if (t->misplaced || (!t->planned && t->load_permille > 0U &&
+                                         (t->core < 0 || t->core == CORE_PLAN_CONTROL_CORE))) {
+                        ESP_LOGW(TAG, "Control core: %s (core %d) %s, load %u permille",
+                                 t->name, t->core, t->misplaced ? "misplaced" : "unplanned", t->load_permille);
+                    }
+                }
+            }
+        }
         
         // Log system status periodically
         engine_params_t params = {0};
@@ -37,10 +72,16 @@ void app_main(void) {
                      params.load / 10,
                      params.is_limp_mode ? "YES" : "NO");
             ESP_LOGI(TAG,
-                     "Perf planner(us) p95=%" PRIu32 " p99=%" PRIu32 " max=%" PRIu32 " miss=%" PRIu32 " | exec(us) p95=%" PRIu32 " p99=%" PRIu32 " max=%" PRIu32 " miss=%" PRIu32 " | q_ovr=%" PRIu32 " q_peak=%" PRIu32 " n=%" PRIu32,
+                     "Perf planner(us) p95=%" PRIu32 " p99=%" PRIu32 " max=%" PRIu32 " miss=%" PRIu32 " | exec(us) p95=%" PRIu32 " p99=%" PRIu32 " max=%" PRIu32 " miss=%" PRIu32 " | q_ovr=%" PRIu32 " q_peak=%" PRIu32 " superseded=%" PRIu32 " n=%" PRIu32,
                      perf.planner_p95_us, perf.planner_p99_us, perf.planner_max_us, perf.planner_deadline_miss,
                      perf.executor_p95_us, perf.executor_p99_us, perf.executor_max_us, perf.executor_deadline_miss,
-                     perf.queue_overruns, perf.queue_depth_peak, perf.sample_count);
+                     perf.queue_overruns, perf.queue_depth_peak, perf.plans_superseded, perf.sample_count);
+            latency_summary_t plan = {0};
+            latency_summary_t sched = {0};
+            (void)engine_control_get_perf_latency(ENGINE_PERF_PLANNER, &plan);
+            (void)engine_control_get_perf_latency(ENGINE_PERF_SCHEDULING, &sched);
+            ESP_LOGI(TAG, "Latency(ns) planner p99.9=%" PRIu32 " max=%" PRIu32 " | scheduling p99=%" PRIu32 " p99.9=%" PRIu32,
+                     plan.p999, plan.max, sched.p99, sched.p999);
             if (have_inj) {
                 ESP_LOGI(TAG,
                          "EOIT diag: target=%.1fdeg fallback=%.1fdeg normal=%.2f boundary=%.2f map=%s sync=%s SOI1=%.1f d1=%uus",